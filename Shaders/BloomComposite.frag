@@ -0,0 +1,26 @@
+﻿#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D scene;
+uniform sampler2D bloomBlur;
+uniform bool bloom;
+uniform float bloomStrength;
+uniform float bloomScale;       // 1 / number of blur levels the mip chain added up, keeps the bloom's energy that of the scene
+uniform bool hdr;
+uniform float exposure;
+uniform bool gammaEnabled;
+
+void main()
+{
+    const float gamma = 2.2;
+    vec3 hdrColor = texture(scene, TexCoords).rgb;
+    // no brightness threshold, everything blooms a little and bright areas visibly (energy stays the same)
+    if (bloom)
+        hdrColor = mix(hdrColor, texture(bloomBlur, TexCoords).rgb * bloomScale, bloomStrength);
+    vec3 result = hdr ? vec3(1.0) - exp(-hdrColor * exposure) : hdrColor;
+    if (gammaEnabled)
+        result = pow(result, vec3(1.0 / gamma));
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,65 @@
+﻿#version 330 core
+layout (location = 0) out vec3 downsample;
+
+in vec2 TexCoords;
+
+uniform sampler2D srcTexture;
+uniform vec2 srcTexelSize;
+// first downsample only: weights each 2x2 box by 1 / (1 + luma), keeps single very bright pixels from flickering
+uniform bool karisAverage;
+
+float KarisWeight(vec3 c)
+{
+    return 1.0 / (1.0 + dot(c, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+// 13 bilinear taps (36 texels) around the destination texel, as five overlapping 2x2 boxes:
+// a - b - c
+// - j - k -
+// d - e - f
+// - l - m -
+// g - h - i
+void main()
+{
+    float x = srcTexelSize.x;
+    float y = srcTexelSize.y;
+
+    vec3 a = texture(srcTexture, TexCoords + vec2(-2.0 * x,  2.0 * y)).rgb;
+    vec3 b = texture(srcTexture, TexCoords + vec2( 0.0,      2.0 * y)).rgb;
+    vec3 c = texture(srcTexture, TexCoords + vec2( 2.0 * x,  2.0 * y)).rgb;
+    vec3 d = texture(srcTexture, TexCoords + vec2(-2.0 * x,  0.0)).rgb;
+    vec3 e = texture(srcTexture, TexCoords).rgb;
+    vec3 f = texture(srcTexture, TexCoords + vec2( 2.0 * x,  0.0)).rgb;
+    vec3 g = texture(srcTexture, TexCoords + vec2(-2.0 * x, -2.0 * y)).rgb;
+    vec3 h = texture(srcTexture, TexCoords + vec2( 0.0,     -2.0 * y)).rgb;
+    vec3 i = texture(srcTexture, TexCoords + vec2( 2.0 * x, -2.0 * y)).rgb;
+    vec3 j = texture(srcTexture, TexCoords + vec2(-x,  y)).rgb;
+    vec3 k = texture(srcTexture, TexCoords + vec2( x,  y)).rgb;
+    vec3 l = texture(srcTexture, TexCoords + vec2(-x, -y)).rgb;
+    vec3 m = texture(srcTexture, TexCoords + vec2( x, -y)).rgb;
+
+    if (karisAverage)
+    {
+        vec3 box0 = (a + b + d + e) * 0.25;
+        vec3 box1 = (b + c + e + f) * 0.25;
+        vec3 box2 = (d + e + g + h) * 0.25;
+        vec3 box3 = (e + f + h + i) * 0.25;
+        vec3 box4 = (j + k + l + m) * 0.25;
+        float w0 = KarisWeight(box0) * 0.125;
+        float w1 = KarisWeight(box1) * 0.125;
+        float w2 = KarisWeight(box2) * 0.125;
+        float w3 = KarisWeight(box3) * 0.125;
+        float w4 = KarisWeight(box4) * 0.5;
+        downsample = (box0 * w0 + box1 * w1 + box2 * w2 + box3 * w3 + box4 * w4) / (w0 + w1 + w2 + w3 + w4);
+    }
+    else
+    {
+        // the centre box weighs 0.5, the four corner boxes 0.125 each
+        downsample = e * 0.125;
+        downsample += (a + c + g + i) * 0.03125;
+        downsample += (b + d + f + h) * 0.0625;
+        downsample += (j + k + l + m) * 0.125;
+    }
+    // R11G11B10F has no sign bit, keep stray negatives out of the chain
+    downsample = max(downsample, vec3(0.0001));
+}
@@ -0,0 +1,29 @@
+﻿#version 330 core
+layout (location = 0) out vec3 upsample;
+
+in vec2 TexCoords;
+
+uniform sampler2D srcTexture;
+uniform float filterRadius;
+
+// 3x3 tent around the destination texel, added onto the larger mip by the blend state
+void main()
+{
+    float x = filterRadius;
+    float y = filterRadius;
+
+    vec3 a = texture(srcTexture, TexCoords + vec2(-x,  y)).rgb;
+    vec3 b = texture(srcTexture, TexCoords + vec2( 0.0, y)).rgb;
+    vec3 c = texture(srcTexture, TexCoords + vec2( x,  y)).rgb;
+    vec3 d = texture(srcTexture, TexCoords + vec2(-x, 0.0)).rgb;
+    vec3 e = texture(srcTexture, TexCoords).rgb;
+    vec3 f = texture(srcTexture, TexCoords + vec2( x, 0.0)).rgb;
+    vec3 g = texture(srcTexture, TexCoords + vec2(-x, -y)).rgb;
+    vec3 h = texture(srcTexture, TexCoords + vec2( 0.0, -y)).rgb;
+    vec3 i = texture(srcTexture, TexCoords + vec2( x, -y)).rgb;
+
+    upsample = e * 4.0;
+    upsample += (b + d + f + h) * 2.0;
+    upsample += (a + c + g + i);
+    upsample *= 1.0 / 16.0;
+}
@@ -0,0 +1,41 @@
+﻿#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices=18) out;
+
+uniform mat4 shadowMatrices[6];
+uniform int faceMask; // bit per cube face the draw's bounds touch
+
+out vec4 FragPos; // FragPos from GS (output per emitvertex)
+
+// true if all three vertices are outside the same clip plane
+bool Outside(vec4 a, vec4 b, vec4 c)
+{
+    return (a.x < -a.w && b.x < -b.w && c.x < -c.w) || (a.x > a.w && b.x > b.w && c.x > c.w) ||
+           (a.y < -a.w && b.y < -b.w && c.y < -c.w) || (a.y > a.w && b.y > b.w && c.y > c.w) ||
+           (a.z < -a.w && b.z < -b.w && c.z < -c.w) || (a.z > a.w && b.z > b.w && c.z > c.w);
+}
+
+void main()
+{
+    for(int face = 0; face < 6; ++face)
+    {
+        if ((faceMask & (1 << face)) == 0)
+            continue;
+        vec4 clip0 = shadowMatrices[face] * gl_in[0].gl_Position;
+        vec4 clip1 = shadowMatrices[face] * gl_in[1].gl_Position;
+        vec4 clip2 = shadowMatrices[face] * gl_in[2].gl_Position;
+        if (Outside(clip0, clip1, clip2))
+            continue;
+        gl_Layer = face; // built-in variable that specifies to which face we render.
+        FragPos = gl_in[0].gl_Position;
+        gl_Position = clip0;
+        EmitVertex();
+        FragPos = gl_in[1].gl_Position;
+        gl_Position = clip1;
+        EmitVertex();
+        FragPos = gl_in[2].gl_Position;
+        gl_Position = clip2;
+        EmitVertex();
+        EndPrimitive();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+﻿#version 330 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 aPos;
+
+// per draw data, sub-allocated from the dynamic ring buffer
+layout (std140) uniform PerDraw
+{
+    mat4 model;
+};
+uniform mat4 shadowMatrices[6];
+uniform int faceIndices[6]; // cube faces this draw touches, one instance each
+
+out vec4 FragPos;
+
+void main()
+{
+    int face = faceIndices[gl_InstanceID];
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+    gl_Layer = face; // written here instead of in a geometry shader
+}
\ No newline at end of file
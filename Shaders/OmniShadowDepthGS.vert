@@ -0,0 +1,13 @@
+﻿#version 330 core
+layout (location = 0) in vec3 aPos;
+
+// per draw data, sub-allocated from the dynamic ring buffer
+layout (std140) uniform PerDraw
+{
+    mat4 model;
+};
+
+void main()
+{
+    gl_Position = model * vec4(aPos, 1.0);
+}
\ No newline at end of file
@@ -8,14 +8,19 @@ uniform sampler2D gNormal;
 uniform sampler2D texNoise;
 
 uniform vec3 samples[64];
+// samples kernelPhase, kernelPhase + kernelStride, ... kernelSize of them: the whole kernel (0, 1, 64) or the
+// interleaved subset of this frame for temporal accumulation (TemporalSSAO.h), rotated by noiseAngle around the normal
+uniform int kernelSize;
+uniform int kernelStride;
+uniform int kernelPhase;
+uniform float noiseAngle;
 
 // parameters (you'd probably want to use them as uniforms to more easily tweak the effect)
-int kernelSize = 64;
 float radius = 0.5;
 float bias = 0.025;
 
 // tile noise texture over screen based on screen dimensions divided by noise size
-const vec2 noiseScale = vec2(800.0/4.0, 600.0/4.0); 
+uniform vec2 noiseScale;
 
 uniform mat4 projection;
 
@@ -25,6 +30,7 @@ void main()
     vec3 fragPos = texture(gPosition, TexCoords).xyz;
     vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
     vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
+    randomVec.xy = mat2(cos(noiseAngle), sin(noiseAngle), -sin(noiseAngle), cos(noiseAngle)) * randomVec.xy;
     // create TBN change-of-basis matrix: from tangent-space to view-space
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
     vec3 bitangent = cross(normal, tangent);
@@ -34,7 +40,7 @@ void main()
     for(int i = 0; i < kernelSize; ++i)
     {
         // get sample position
-        vec3 samplePos = TBN * samples[i]; // from tangent to view-space
+        vec3 samplePos = TBN * samples[kernelPhase + i * kernelStride]; // from tangent to view-space
         samplePos = fragPos + samplePos * radius; 
         
         // project sample position (to sample texture) (to get position on screen/texture)
@@ -2,10 +2,13 @@
 layout (location = 0) out vec3 gPosition;
 layout (location = 1) out vec3 gNormal;
 layout (location = 2) out vec3 gAlbedo;
+layout (location = 3) out vec2 gVelocity;
 
 in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
+in vec4 CurrentClip;
+in vec4 PreviousClip;
 
 void main()
 {    
@@ -15,4 +18,6 @@ void main()
     gNormal = normalize(Normal);
     // and the diffuse per-fragment color
     gAlbedo.rgb = vec3(0.95);
+    // screen space motion since the last frame, in texture coordinates (where it was = TexCoords - gVelocity)
+    gVelocity = (CurrentClip.xy / CurrentClip.w - PreviousClip.xy / PreviousClip.w) * 0.5;
 }
\ No newline at end of file
@@ -6,12 +6,22 @@ layout (location = 2) in vec2 aTexCoords;
 out vec3 FragPos;
 out vec2 TexCoords;
 out vec3 Normal;
+out vec4 CurrentClip;
+out vec4 PreviousClip;
 
 uniform bool invertedNormals;
 
-uniform mat4 model;
+// per draw data, sub-allocated from the dynamic ring buffer
+layout (std140) uniform PerDraw
+{
+    mat4 model;
+    mat4 previousModel;
+};
 uniform mat4 view;
 uniform mat4 projection;
+// without the TAA jitter, so motion vectors only hold real motion
+uniform mat4 viewProjection;
+uniform mat4 previousViewProjection;
 
 void main()
 {
@@ -23,4 +33,6 @@ void main()
     Normal = normalMatrix * (invertedNormals ? -aNormal : aNormal);
     
     gl_Position = projection * viewPos;
+    CurrentClip = viewProjection * model * vec4(aPos, 1.0);
+    PreviousClip = previousViewProjection * previousModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
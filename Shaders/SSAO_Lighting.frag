@@ -17,6 +17,172 @@ struct Light {
 };
 uniform Light light;
 
+// omnidirectional shadow map of the point light, linear distance / far plane (see PointShadowsDepth.frag)
+uniform samplerCube pointShadowMap;
+uniform float pointShadowFar;
+uniform bool pointShadowsEnabled;
+uniform mat4 inverseView; // the cube map is world space aligned, positions here are view space
+
+// array of offset direction for sampling
+vec3 gridSamplingDisk[20] = vec3[]
+(
+   vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1), 
+   vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
+   vec3(1, 1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1, 1,  0),
+   vec3(1, 0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1, 0, -1),
+   vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
+);
+
+// point and spot lights sharing the shadow atlas, see ShadowAtlas.h (sizes match ShadowAtlas::MaxLights/MaxViews)
+struct AtlasLight {
+    vec4 PositionRange;     // world space
+    vec4 ColorType;         // w: 0 point, 1 spot
+    vec4 DirectionCosOuter;
+    vec4 ShadowInfo;        // x first view, y view count (0 = unshadowed), z cos of the inner angle
+};
+struct AtlasView {
+    mat4 ViewProjection;
+    vec4 Rect;              // tile origin and size in atlas UVs
+};
+layout (std140) uniform ShadowAtlasLights
+{
+    ivec4 atlasLightCount;
+    AtlasLight atlasLights[32];
+    AtlasView atlasViews[128];
+};
+uniform sampler2DShadow shadowAtlas;
+
+float AtlasShadow(AtlasLight atlasLight, vec3 worldPos, vec3 worldNormal)
+{
+    int viewCount = int(atlasLight.ShadowInfo.y);
+    if (viewCount == 0)
+        return 1.0;
+    int view = int(atlasLight.ShadowInfo.x);
+    if (viewCount == 6)
+    {
+        // cube face by major axis, in GL face order
+        vec3 d = worldPos - atlasLight.PositionRange.xyz;
+        vec3 a = abs(d);
+        if (a.x >= a.y && a.x >= a.z)
+            view += d.x > 0.0 ? 0 : 1;
+        else if (a.y >= a.z)
+            view += d.y > 0.0 ? 2 : 3;
+        else
+            view += d.z > 0.0 ? 4 : 5;
+    }
+    vec4 lightPos = atlasViews[view].ViewProjection * vec4(worldPos + worldNormal * 0.03, 1.0);
+    vec3 projCoords = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 1.0;
+    // 3x3 PCF kept inside the tile, the neighbours belong to other lights
+    vec4 rect = atlasViews[view].Rect;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 tileMin = rect.xy + texelSize * 0.5;
+    vec2 tileMax = rect.xy + rect.zw - texelSize * 0.5;
+    vec2 uv = rect.xy + clamp(projCoords.xy, 0.0, 1.0) * rect.zw;
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            lit += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texelSize, tileMin, tileMax), projCoords.z));
+    return lit / 9.0;
+}
+
+vec3 AtlasLighting(vec3 fragPos, vec3 normal, vec3 albedo)
+{
+    vec3 worldPos = (inverseView * vec4(fragPos, 1.0)).xyz;
+    vec3 worldNormal = mat3(inverseView) * normal;
+    vec3 viewDir = normalize(inverseView[3].xyz - worldPos);
+    vec3 result = vec3(0.0);
+    for (int i = 0; i < atlasLightCount.x; ++i)
+    {
+        AtlasLight atlasLight = atlasLights[i];
+        vec3 toLight = atlasLight.PositionRange.xyz - worldPos;
+        float distance = length(toLight);
+        if (distance > atlasLight.PositionRange.w)
+            continue;
+        vec3 lightDir = toLight / distance;
+        // smooth window to zero at the range
+        float falloff = clamp(1.0 - pow(distance / atlasLight.PositionRange.w, 4.0), 0.0, 1.0);
+        float attenuation = falloff * falloff / (1.0 + distance * distance);
+        if (atlasLight.ColorType.w > 0.5)
+        {
+            float cosAngle = dot(-lightDir, atlasLight.DirectionCosOuter.xyz);
+            attenuation *= smoothstep(atlasLight.DirectionCosOuter.w, atlasLight.ShadowInfo.z, cosAngle);
+        }
+        if (attenuation <= 0.0)
+            continue;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        vec3 diffuse = max(dot(worldNormal, lightDir), 0.0) * albedo;
+        vec3 specular = vec3(pow(max(dot(worldNormal, halfwayDir), 0.0), 8.0));
+        result += (diffuse + specular) * atlasLight.ColorType.rgb * attenuation * AtlasShadow(atlasLight, worldPos, worldNormal);
+    }
+    return result;
+}
+
+float PointShadow(vec3 fragPos)
+{
+    if (!pointShadowsEnabled)
+        return 1.0;
+    vec3 fragToLight = mat3(inverseView) * (fragPos - light.Position);
+    float currentDepth = length(fragToLight);
+    if (currentDepth > pointShadowFar)
+        return 1.0;
+    float shadow = 0.0;
+    float bias = 0.15;
+    float diskRadius = (1.0 + (length(fragPos) / pointShadowFar)) / 25.0;
+    for (int i = 0; i < 20; ++i)
+    {
+        float closestDepth = texture(pointShadowMap, fragToLight + gridSamplingDisk[i] * diskRadius).r * pointShadowFar;
+        if (currentDepth - bias > closestDepth)
+            shadow += 1.0;
+    }
+    return 1.0 - shadow / 20.0;
+}
+
+// directional light, direction in view space pointing from the light into the scene
+struct DirectionalLight {
+    vec3 Direction;
+    vec3 Color;
+};
+uniform DirectionalLight sun;
+
+// cascaded shadow map of the sun, cascade i covers view depths up to cascadeSplits[i]
+uniform sampler2DArrayShadow shadowCascades;
+uniform mat4 cascadeMatrices[4]; // view space to light clip space
+uniform float cascadeSplits[4];
+uniform int cascadeCount;
+uniform bool shadowsEnabled;
+
+float SunShadow(vec3 fragPos, vec3 normal)
+{
+    if (!shadowsEnabled)
+        return 1.0;
+    int cascade = cascadeCount;
+    for (int i = 0; i < cascadeCount; ++i)
+    {
+        if (-fragPos.z < cascadeSplits[i])
+        {
+            cascade = i;
+            break;
+        }
+    }
+    if (cascade >= cascadeCount)
+        return 1.0;
+    // push the lookup off the surface, further cascades have larger texels and need more
+    vec3 offsetPos = fragPos + normal * 0.02 * float(cascade + 1);
+    vec4 lightPos = cascadeMatrices[cascade] * vec4(offsetPos, 1.0);
+    vec3 projCoords = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 1.0;
+    // 3x3 PCF, every tap is already a bilinear 2x2 compare
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowCascades, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            lit += texture(shadowCascades, vec4(projCoords.xy + vec2(x, y) * texelSize, float(cascade), projCoords.z));
+    return lit / 9.0;
+}
+
 void main()
 {             
     // retrieve data from gbuffer
@@ -41,7 +207,15 @@ void main()
     float attenuation = 1.0 / (1.0 + light.Linear * distance + light.Quadratic * distance * distance);
     diffuse *= attenuation;
     specular *= attenuation;
-    lighting += diffuse + specular;
+    lighting += (diffuse + specular) * PointShadow(FragPos);
+    // sun
+    vec3 sunDir = normalize(-sun.Direction);
+    vec3 sunHalfway = normalize(sunDir + viewDir);
+    vec3 sunDiffuse = max(dot(Normal, sunDir), 0.0) * Diffuse * sun.Color;
+    vec3 sunSpecular = sun.Color * pow(max(dot(Normal, sunHalfway), 0.0), 8.0);
+    lighting += (sunDiffuse + sunSpecular) * SunShadow(FragPos, Normal);
+    // atlas lights
+    lighting += AtlasLighting(FragPos, Normal, Diffuse);
 
     FragColor = vec4(lighting, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+﻿#version 330 core
+// running average of the SSAO subsets of the last frames: r occlusion, g view depth (for the disocclusion test of the
+// next frame), b frames accumulated
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D ssaoInput;        // this frame's occlusion
+uniform sampler2D history;          // last frame's output
+uniform sampler2D velocityBuffer;   // G-buffer motion, where it was = TexCoords - velocity
+uniform sampler2D gPosition;
+
+uniform mat4 currentToPreviousView;
+uniform bool historyValid;
+uniform float maxHistoryFrames;
+uniform float depthTolerance;       // relative
+
+void main()
+{
+    float occlusion = texture(ssaoInput, TexCoords).r;
+    vec3 fragPos = texture(gPosition, TexCoords).xyz;
+    float depth = -fragPos.z;
+    float frames = 1.0;
+
+    vec2 previousCoords = TexCoords - texture(velocityBuffer, TexCoords).xy;
+    bool inside = all(greaterThanEqual(previousCoords, vec2(0.0))) && all(lessThanEqual(previousCoords, vec2(1.0)));
+    if (historyValid && depth > 0.0 && inside)
+    {
+        vec3 previous = texture(history, previousCoords).rgb;
+        // the depth this surface had last frame if it didn't move itself. Anything else was behind or in front of it
+        // (disocclusion), or is a moving object: both start over. Filtering across an edge mixes depths and fails too.
+        float expectedDepth = -(currentToPreviousView * vec4(fragPos, 1.0)).z;
+        if (abs(previous.g - expectedDepth) <= depthTolerance * expectedDepth)
+        {
+            frames = min(previous.b + 1.0, maxHistoryFrames);
+            occlusion = mix(previous.r, occlusion, 1.0 / frames);
+        }
+    }
+    FragColor = vec4(occlusion, depth, frames, 1.0);
+}
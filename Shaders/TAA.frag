@@ -0,0 +1,120 @@
+﻿#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D currentColor;
+uniform sampler2D historyColor;  // reversibly tone mapped, like the output
+uniform sampler2D velocityBuffer;
+uniform sampler2D gPosition;
+uniform bool historyValid;
+uniform float feedbackMin;      // history weight while moving fast
+uniform float feedbackMax;      // history weight while still
+uniform float varianceGamma;    // width of the clamp box in standard deviations
+
+vec3 RGBToYCoCg(vec3 c)
+{
+    return vec3(dot(c, vec3(0.25, 0.5, 0.25)), dot(c, vec3(0.5, 0.0, -0.5)), dot(c, vec3(-0.25, 0.5, -0.25)));
+}
+
+vec3 YCoCgToRGB(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// reversible tone map (TAASharpen.frag undoes it). Filtering, clamping and blending happen in this space: in linear
+// HDR a bright side would bleed over every edge the history is resampled across, and single bright samples flicker.
+vec3 Tonemap(vec3 c)
+{
+    return c / (1.0 + max(c.r, max(c.g, c.b)));
+}
+
+// moves history towards the centre of the box until it is inside, keeps its hue better than a per channel clamp
+vec3 ClipToBox(vec3 boxMin, vec3 boxMax, vec3 history)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extents = 0.5 * (boxMax - boxMin) + 0.0001;
+    vec3 offset = history - center;
+    vec3 units = abs(offset / extents);
+    float maxUnit = max(units.x, max(units.y, units.z));
+    return maxUnit > 1.0 ? center + offset / maxUnit : history;
+}
+
+// Catmull-Rom filtered history fetch from 5 bilinear taps (the 4 corner taps of the full 9 tap version weigh almost
+// nothing). A plain bilinear fetch at a fractional offset blurs the history a little more every frame of motion.
+vec3 SampleHistory(vec2 coords, vec2 textureSize)
+{
+    vec2 samplePos = coords * textureSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    // the middle two taps merge into one bilinear fetch between them
+    vec2 w12 = w1 + w2;
+    vec2 texPos0 = (texPos1 - 1.0) / textureSize;
+    vec2 texPos3 = (texPos1 + 2.0) / textureSize;
+    vec2 texPos12 = (texPos1 + w2 / w12) / textureSize;
+
+    vec3 result = texture(historyColor, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+    result += texture(historyColor, vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y;
+    result += texture(historyColor, texPos12).rgb * w12.x * w12.y;
+    result += texture(historyColor, vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y;
+    result += texture(historyColor, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    // the negative lobes can overshoot below zero next to bright pixels
+    return max(result / weight, vec3(0.0));
+}
+
+void main()
+{
+    vec2 texelSize = 1.0 / vec2(textureSize(currentColor, 0));
+
+    // colour moments of the 3x3 neighbourhood, and the closest surface in it: edges take the foreground's motion
+    vec3 moment1 = vec3(0.0);
+    vec3 moment2 = vec3(0.0);
+    vec3 current = vec3(0.0);
+    float closestDepth = -1.0e30;
+    vec2 closestOffset = vec2(0.0);
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            vec2 offset = vec2(float(x), float(y)) * texelSize;
+            vec3 c = RGBToYCoCg(Tonemap(texture(currentColor, TexCoords + offset).rgb));
+            moment1 += c;
+            moment2 += c * c;
+            if (x == 0 && y == 0)
+                current = c;
+            // view space z, closer is larger, nothing drawn is >= 0
+            float depth = texture(gPosition, TexCoords + offset).z;
+            if (depth < 0.0 && depth > closestDepth)
+            {
+                closestDepth = depth;
+                closestOffset = offset;
+            }
+        }
+    }
+
+    vec2 velocity = texture(velocityBuffer, TexCoords + closestOffset).rg;
+    vec2 historyCoords = TexCoords - velocity;
+    if (!historyValid || any(lessThan(historyCoords, vec2(0.0))) || any(greaterThan(historyCoords, vec2(1.0))))
+    {
+        FragColor = vec4(YCoCgToRGB(current), 1.0);
+        return;
+    }
+
+    // variance clipping: history outside mean +- gamma * sigma of the current neighbourhood is stale
+    vec3 mean = moment1 / 9.0;
+    vec3 sigma = sqrt(max(moment2 / 9.0 - mean * mean, vec3(0.0)));
+    vec3 history = RGBToYCoCg(SampleHistory(historyCoords, vec2(textureSize(historyColor, 0))));
+    history = ClipToBox(mean - varianceGamma * sigma, mean + varianceGamma * sigma, history);
+
+    // less history while moving, resampling still softens it a little every frame
+    float pixelsMoved = length(velocity / texelSize);
+    float feedback = mix(feedbackMax, feedbackMin, clamp(pixelsMoved / 4.0, 0.0, 1.0));
+
+    vec3 result = YCoCgToRGB(mix(current, history, feedback));
+    FragColor = vec4(clamp(result, vec3(0.0), vec3(0.999)), 1.0);
+}
@@ -0,0 +1,30 @@
+﻿#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;       // TAA history, reversibly tone mapped
+uniform float sharpness;
+
+vec3 InverseTonemap(vec3 c)
+{
+    return c / max(1.0 - max(c.r, max(c.g, c.b)), 0.001);
+}
+
+// unsharp mask over the 4 neighbours, against the softness the history accumulates, limited to the neighbourhood's
+// range so edges don't ring. Then back to linear HDR for bloom and the final tone map.
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(image, 0) - 1;
+    vec3 center = texelFetch(image, pixel, 0).rgb;
+    vec3 left = texelFetch(image, clamp(pixel + ivec2(-1, 0), ivec2(0), size), 0).rgb;
+    vec3 right = texelFetch(image, clamp(pixel + ivec2(1, 0), ivec2(0), size), 0).rgb;
+    vec3 down = texelFetch(image, clamp(pixel + ivec2(0, -1), ivec2(0), size), 0).rgb;
+    vec3 up = texelFetch(image, clamp(pixel + ivec2(0, 1), ivec2(0), size), 0).rgb;
+
+    vec3 result = center + (4.0 * center - left - right - down - up) * sharpness;
+    vec3 lowest = min(center, min(min(left, right), min(down, up)));
+    vec3 highest = max(center, max(max(left, right), max(down, up)));
+    FragColor = vec4(InverseTonemap(clamp(result, lowest, highest)), 1.0);
+}
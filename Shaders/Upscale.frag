@@ -0,0 +1,33 @@
+﻿#version 330 core
+// the scene rendered at the dynamic resolution, stretched to the output size with a Catmull-Rom filter, sharper than
+// bilinear. The texture has to be filtered linearly, the 16 taps merge into 5 bilinear fetches (as in TAA.frag).
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+
+void main()
+{
+    vec2 textureSize = vec2(textureSize(image, 0));
+    vec2 samplePos = TexCoords * textureSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+    vec2 texPos0 = (texPos1 - 1.0) / textureSize;
+    vec2 texPos3 = (texPos1 + 2.0) / textureSize;
+    vec2 texPos12 = (texPos1 + w2 / w12) / textureSize;
+
+    vec3 result = texture(image, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+    result += texture(image, vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y;
+    result += texture(image, texPos12).rgb * w12.x * w12.y;
+    result += texture(image, vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y;
+    result += texture(image, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    // the negative lobes can overshoot below zero next to bright pixels
+    FragColor = vec4(max(result / weight, vec3(0.0)), 1.0);
+}
@@ -0,0 +1,431 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define GENIX_BVH_SSE 1
+#else
+#define GENIX_BVH_SSE 0
+#endif
+
+namespace
+{
+	float SurfaceArea(const glm::vec3& Min, const glm::vec3& Max)
+	{
+		const glm::vec3 Extent = Max - Min;
+		return Extent.x * Extent.y + Extent.y * Extent.z + Extent.z * Extent.x;
+	}
+
+	struct Bin
+	{
+		glm::vec3 Min = glm::vec3(FLT_MAX);
+		glm::vec3 Max = glm::vec3(-FLT_MAX);
+		uint32_t Count = 0;
+	};
+
+	// result of testing a box against all planes
+	enum FrustumOverlap
+	{
+		FRUSTUM_OUTSIDE,
+		FRUSTUM_INTERSECTS,
+		FRUSTUM_INSIDE
+	};
+
+#if GENIX_BVH_SSE
+	// planes transposed into structure of arrays, four planes per register. The last two are padded with planes no
+	// box can fail (0, 0, 0, +inf).
+	struct FrustumSIMD
+	{
+		__m128 X[2], Y[2], Z[2], W[2];
+
+		explicit FrustumSIMD(const Frustum& Source)
+		{
+			float Values[4][8];
+			for (int i = 0; i < 8; i++)
+			{
+				const glm::vec4 Plane = i < 6 ? Source.Planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, FLT_MAX);
+				Values[0][i] = Plane.x;
+				Values[1][i] = Plane.y;
+				Values[2][i] = Plane.z;
+				Values[3][i] = Plane.w;
+			}
+			for (int Group = 0; Group < 2; Group++)
+			{
+				X[Group] = _mm_loadu_ps(&Values[0][Group * 4]);
+				Y[Group] = _mm_loadu_ps(&Values[1][Group * 4]);
+				Z[Group] = _mm_loadu_ps(&Values[2][Group * 4]);
+				W[Group] = _mm_loadu_ps(&Values[3][Group * 4]);
+			}
+		}
+
+		// the distance to the box corner furthest along each normal is the sum of the larger per axis products,
+		// the nearest corner the sum of the smaller ones
+		FrustumOverlap Test(const glm::vec3& Min, const glm::vec3& Max) const
+		{
+			const __m128 MinX = _mm_set1_ps(Min.x), MinY = _mm_set1_ps(Min.y), MinZ = _mm_set1_ps(Min.z);
+			const __m128 MaxX = _mm_set1_ps(Max.x), MaxY = _mm_set1_ps(Max.y), MaxZ = _mm_set1_ps(Max.z);
+			int bAllInside = 1;
+			for (int Group = 0; Group < 2; Group++)
+			{
+				const __m128 X0 = _mm_mul_ps(X[Group], MinX), X1 = _mm_mul_ps(X[Group], MaxX);
+				const __m128 Y0 = _mm_mul_ps(Y[Group], MinY), Y1 = _mm_mul_ps(Y[Group], MaxY);
+				const __m128 Z0 = _mm_mul_ps(Z[Group], MinZ), Z1 = _mm_mul_ps(Z[Group], MaxZ);
+				const __m128 Furthest = _mm_add_ps(_mm_add_ps(_mm_max_ps(X0, X1), _mm_max_ps(Y0, Y1)), _mm_add_ps(_mm_max_ps(Z0, Z1), W[Group]));
+				if (_mm_movemask_ps(_mm_cmplt_ps(Furthest, _mm_setzero_ps())) != 0)
+				{
+					return FRUSTUM_OUTSIDE;
+				}
+				const __m128 Nearest = _mm_add_ps(_mm_add_ps(_mm_min_ps(X0, X1), _mm_min_ps(Y0, Y1)), _mm_add_ps(_mm_min_ps(Z0, Z1), W[Group]));
+				bAllInside &= _mm_movemask_ps(_mm_cmplt_ps(Nearest, _mm_setzero_ps())) == 0;
+			}
+			return bAllInside ? FRUSTUM_INSIDE : FRUSTUM_INTERSECTS;
+		}
+	};
+#else
+	struct FrustumSIMD
+	{
+		const Frustum& Source;
+
+		explicit FrustumSIMD(const Frustum& InSource) : Source(InSource) {}
+
+		FrustumOverlap Test(const glm::vec3& Min, const glm::vec3& Max) const
+		{
+			bool bAllInside = true;
+			for (const glm::vec4& Plane : Source.Planes)
+			{
+				const glm::vec3 Normal(Plane);
+				const glm::vec3 Low = Normal * Min;
+				const glm::vec3 High = Normal * Max;
+				const glm::vec3 Furthest = glm::max(Low, High);
+				if (Furthest.x + Furthest.y + Furthest.z + Plane.w < 0.0f)
+				{
+					return FRUSTUM_OUTSIDE;
+				}
+				const glm::vec3 Nearest = glm::min(Low, High);
+				bAllInside = bAllInside && Nearest.x + Nearest.y + Nearest.z + Plane.w >= 0.0f;
+			}
+			return bAllInside ? FRUSTUM_INSIDE : FRUSTUM_INTERSECTS;
+		}
+	};
+#endif
+
+	// slab test, returns the entry distance or FLT_MAX for a miss
+	float IntersectRayBox(const glm::vec3& Origin, const glm::vec3& InverseDirection, float MaxDistance, const glm::vec3& Min, const glm::vec3& Max)
+	{
+		const glm::vec3 T0 = (Min - Origin) * InverseDirection;
+		const glm::vec3 T1 = (Max - Origin) * InverseDirection;
+		const glm::vec3 Near = glm::min(T0, T1);
+		const glm::vec3 Far = glm::max(T0, T1);
+		const float Enter = std::max(std::max(Near.x, Near.y), std::max(Near.z, 0.0f));
+		const float Exit = std::min(std::min(Far.x, Far.y), std::min(Far.z, MaxDistance));
+		return Enter <= Exit ? Enter : FLT_MAX;
+	}
+}
+
+const uint32_t BVH::MaxLeafItems;
+const int BVH::BinCount;
+
+void BVH::Build(const std::vector<AABB>& boxes)
+{
+	Nodes.clear();
+	ItemBoxes = boxes;
+	Items.resize(boxes.size());
+	if (boxes.empty())
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> Centroids(boxes.size());
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		Items[i] = static_cast<uint32_t>(i);
+		Centroids[i] = (boxes[i].Min + boxes[i].Max) * 0.5f;
+	}
+
+	// a binary tree over N leaves has at most 2N - 1 nodes
+	Nodes.reserve(boxes.size() * 2);
+	BVHNode Root;
+	Root.LeftOrFirst = 0;
+	Root.Count = static_cast<uint32_t>(boxes.size());
+	Nodes.push_back(Root);
+	UpdateNodeBounds(Nodes[0], boxes);
+	Subdivide(0, boxes, Centroids);
+	Nodes.shrink_to_fit();
+}
+
+void BVH::UpdateNodeBounds(BVHNode& Node, const std::vector<AABB>& Boxes) const
+{
+	Node.Min = glm::vec3(FLT_MAX);
+	Node.Max = glm::vec3(-FLT_MAX);
+	for (uint32_t i = 0; i < Node.Count; i++)
+	{
+		const AABB& Box = Boxes[Items[Node.LeftOrFirst + i]];
+		Node.Min = glm::min(Node.Min, Box.Min);
+		Node.Max = glm::max(Node.Max, Box.Max);
+	}
+}
+
+void BVH::Subdivide(uint32_t NodeIndex, const std::vector<AABB>& Boxes, const std::vector<glm::vec3>& Centroids)
+{
+	// explicit stack, degenerate inputs could otherwise recurse as deep as the item count
+	std::vector<uint32_t> Stack(1, NodeIndex);
+	while (!Stack.empty())
+	{
+		const uint32_t Current = Stack.back();
+		Stack.pop_back();
+		const uint32_t First = Nodes[Current].LeftOrFirst;
+		const uint32_t Count = Nodes[Current].Count;
+		if (Count <= 1)
+		{
+			continue;
+		}
+
+		glm::vec3 CentroidMin(FLT_MAX), CentroidMax(-FLT_MAX);
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			CentroidMin = glm::min(CentroidMin, Centroids[Items[First + i]]);
+			CentroidMax = glm::max(CentroidMax, Centroids[Items[First + i]]);
+		}
+
+		// binned SAH: cost of a split is area(left) * count(left) + area(right) * count(right)
+		int BestAxis = -1;
+		int BestSplit = 0;
+		float BestCost = FLT_MAX;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			const float Extent = CentroidMax[Axis] - CentroidMin[Axis];
+			if (Extent <= 0.0f)
+			{
+				continue;
+			}
+			Bin Bins[BinCount];
+			const float Scale = BinCount / Extent;
+			for (uint32_t i = 0; i < Count; i++)
+			{
+				const uint32_t Item = Items[First + i];
+				const int Index = std::min(BinCount - 1, static_cast<int>((Centroids[Item][Axis] - CentroidMin[Axis]) * Scale));
+				Bins[Index].Count++;
+				Bins[Index].Min = glm::min(Bins[Index].Min, Boxes[Item].Min);
+				Bins[Index].Max = glm::max(Bins[Index].Max, Boxes[Item].Max);
+			}
+
+			// sweep from both sides so every split plane is evaluated in linear time
+			float LeftArea[BinCount - 1], RightArea[BinCount - 1];
+			uint32_t LeftCount[BinCount - 1], RightCount[BinCount - 1];
+			Bin LeftBox, RightBox;
+			uint32_t LeftSum = 0, RightSum = 0;
+			for (int i = 0; i < BinCount - 1; i++)
+			{
+				LeftSum += Bins[i].Count;
+				LeftCount[i] = LeftSum;
+				LeftBox.Min = glm::min(LeftBox.Min, Bins[i].Min);
+				LeftBox.Max = glm::max(LeftBox.Max, Bins[i].Max);
+				LeftArea[i] = LeftSum > 0 ? SurfaceArea(LeftBox.Min, LeftBox.Max) : 0.0f;
+
+				RightSum += Bins[BinCount - 1 - i].Count;
+				RightCount[BinCount - 2 - i] = RightSum;
+				RightBox.Min = glm::min(RightBox.Min, Bins[BinCount - 1 - i].Min);
+				RightBox.Max = glm::max(RightBox.Max, Bins[BinCount - 1 - i].Max);
+				RightArea[BinCount - 2 - i] = RightSum > 0 ? SurfaceArea(RightBox.Min, RightBox.Max) : 0.0f;
+			}
+			for (int i = 0; i < BinCount - 1; i++)
+			{
+				if (LeftCount[i] == 0 || RightCount[i] == 0)
+				{
+					continue;
+				}
+				const float Cost = LeftArea[i] * LeftCount[i] + RightArea[i] * RightCount[i];
+				if (Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestAxis = Axis;
+					BestSplit = i;
+				}
+			}
+		}
+
+		// keeping the leaf is cheaper unless it is too big anyway
+		const float LeafCost = SurfaceArea(Nodes[Current].Min, Nodes[Current].Max) * Count;
+		if (BestAxis < 0 || (BestCost >= LeafCost && Count <= MaxLeafItems))
+		{
+			continue;
+		}
+
+		// partition the item range around the chosen bin boundary
+		const float Scale = BinCount / (CentroidMax[BestAxis] - CentroidMin[BestAxis]);
+		uint32_t* Begin = Items.data() + First;
+		uint32_t* Middle = std::partition(Begin, Begin + Count, [&](uint32_t Item)
+		{
+			const int Index = std::min(BinCount - 1, static_cast<int>((Centroids[Item][BestAxis] - CentroidMin[BestAxis]) * Scale));
+			return Index <= BestSplit;
+		});
+		const uint32_t LeftItems = static_cast<uint32_t>(Middle - Begin);
+		if (LeftItems == 0 || LeftItems == Count)
+		{
+			continue;
+		}
+
+		const uint32_t LeftChild = static_cast<uint32_t>(Nodes.size());
+		BVHNode Left, Right;
+		Left.LeftOrFirst = First;
+		Left.Count = LeftItems;
+		Right.LeftOrFirst = First + LeftItems;
+		Right.Count = Count - LeftItems;
+		UpdateNodeBounds(Left, Boxes);
+		UpdateNodeBounds(Right, Boxes);
+		Nodes.push_back(Left);
+		Nodes.push_back(Right);
+		Nodes[Current].LeftOrFirst = LeftChild;
+		Nodes[Current].Count = 0;
+		Stack.push_back(LeftChild);
+		Stack.push_back(LeftChild + 1);
+	}
+}
+
+void BVH::Refit(const std::vector<AABB>& boxes)
+{
+	if (boxes.size() != Items.size())
+	{
+		Build(boxes);
+		return;
+	}
+	ItemBoxes = boxes;
+	// children come after their parents, so walking backwards visits both children before the parent
+	for (size_t i = Nodes.size(); i-- > 0;)
+	{
+		BVHNode& Node = Nodes[i];
+		if (Node.Count > 0)
+		{
+			UpdateNodeBounds(Node, boxes);
+		}
+		else
+		{
+			const BVHNode& Left = Nodes[Node.LeftOrFirst];
+			const BVHNode& Right = Nodes[Node.LeftOrFirst + 1];
+			Node.Min = glm::min(Left.Min, Right.Min);
+			Node.Max = glm::max(Left.Max, Right.Max);
+		}
+	}
+}
+
+void BVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& outItems) const
+{
+	if (Nodes.empty())
+	{
+		return;
+	}
+	const FrustumSIMD Planes(frustum);
+
+	// second member: the subtree is known to be fully inside, no more tests needed
+	std::vector<std::pair<uint32_t, bool>> Stack;
+	Stack.reserve(64);
+	Stack.push_back(std::make_pair(0u, false));
+	while (!Stack.empty())
+	{
+		const std::pair<uint32_t, bool> Entry = Stack.back();
+		Stack.pop_back();
+		const BVHNode& Node = Nodes[Entry.first];
+		bool bInside = Entry.second;
+		if (!bInside)
+		{
+			const FrustumOverlap Overlap = Planes.Test(Node.Min, Node.Max);
+			if (Overlap == FRUSTUM_OUTSIDE)
+			{
+				continue;
+			}
+			bInside = Overlap == FRUSTUM_INSIDE;
+		}
+		if (Node.Count > 0)
+		{
+			for (uint32_t i = Node.LeftOrFirst; i < Node.LeftOrFirst + Node.Count; i++)
+			{
+				if (bInside || Node.Count == 1 || Planes.Test(ItemBoxes[Items[i]].Min, ItemBoxes[Items[i]].Max) != FRUSTUM_OUTSIDE)
+				{
+					outItems.push_back(Items[i]);
+				}
+			}
+			continue;
+		}
+		Stack.push_back(std::make_pair(Node.LeftOrFirst + 1, bInside));
+		Stack.push_back(std::make_pair(Node.LeftOrFirst, bInside));
+	}
+}
+
+bool BVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& outItem, float& outDistance,
+	const std::function<bool(uint32_t item, float& distance)>& intersect) const
+{
+	if (Nodes.empty())
+	{
+		return false;
+	}
+	// a zero component becomes +-inf, the slab test handles that
+	const glm::vec3 InverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	float Closest = maxDistance;
+	bool bHit = false;
+
+	std::vector<uint32_t> Stack;
+	Stack.reserve(64);
+	if (IntersectRayBox(origin, InverseDirection, Closest, Nodes[0].Min, Nodes[0].Max) != FLT_MAX)
+	{
+		Stack.push_back(0);
+	}
+	while (!Stack.empty())
+	{
+		const BVHNode& Node = Nodes[Stack.back()];
+		Stack.pop_back();
+		if (Node.Count > 0)
+		{
+			for (uint32_t i = 0; i < Node.Count; i++)
+			{
+				const uint32_t Item = Items[Node.LeftOrFirst + i];
+				float Distance = FLT_MAX;
+				if (intersect)
+				{
+					if (IntersectRayBox(origin, InverseDirection, Closest, ItemBoxes[Item].Min, ItemBoxes[Item].Max) == FLT_MAX)
+					{
+						continue;
+					}
+					if (!intersect(Item, Distance))
+					{
+						continue;
+					}
+				}
+				else
+				{
+					Distance = IntersectRayBox(origin, InverseDirection, Closest, ItemBoxes[Item].Min, ItemBoxes[Item].Max);
+				}
+				if (Distance < Closest)
+				{
+					Closest = Distance;
+					outItem = Item;
+					bHit = true;
+				}
+			}
+			continue;
+		}
+
+		// visit the nearer child first so the far one is often rejected by the shrunken Closest
+		const uint32_t Left = Node.LeftOrFirst;
+		const uint32_t Right = Node.LeftOrFirst + 1;
+		const float LeftDistance = IntersectRayBox(origin, InverseDirection, Closest, Nodes[Left].Min, Nodes[Left].Max);
+		const float RightDistance = IntersectRayBox(origin, InverseDirection, Closest, Nodes[Right].Min, Nodes[Right].Max);
+		const bool bLeftFirst = LeftDistance <= RightDistance;
+		const uint32_t Near = bLeftFirst ? Left : Right;
+		const uint32_t Far = bLeftFirst ? Right : Left;
+		const float NearDistance = bLeftFirst ? LeftDistance : RightDistance;
+		const float FarDistance = bLeftFirst ? RightDistance : LeftDistance;
+		if (FarDistance != FLT_MAX)
+		{
+			Stack.push_back(Far);
+		}
+		if (NearDistance != FLT_MAX)
+		{
+			Stack.push_back(Near);
+		}
+	}
+	outDistance = Closest;
+	return bHit;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+
+// 32 bytes, two nodes per cache line. Count == 0 marks an inner node whose children are LeftOrFirst and
+// LeftOrFirst + 1, otherwise the node is a leaf holding Count items starting at LeftOrFirst.
+struct BVHNode
+{
+    glm::vec3 Min;
+    uint32_t LeftOrFirst;
+    glm::vec3 Max;
+    uint32_t Count;
+};
+
+static_assert(sizeof(BVHNode) == 32, "BVHNode should stay 32 bytes");
+
+// bounding volume hierarchy over a list of boxes, built with the binned surface area heuristic. Items are identified
+// by their index in the list given to Build. Children are always stored after their parent, Refit relies on that.
+class BVH
+{
+public:
+
+    // leaves get split until they hold at most this many items, or splitting stops paying off
+    static const uint32_t MaxLeafItems = 4;
+    // centroid bins per axis the SAH evaluates
+    static const int BinCount = 16;
+
+    void Build(const std::vector<AABB>& boxes);
+
+    // updates the node boxes bottom up for moved items without changing the topology. boxes must have the same
+    // count and order as in Build. Quality degrades as items move far from where they were built, rebuild then.
+    void Refit(const std::vector<AABB>& boxes);
+
+    // appends the items whose box intersects the frustum (conservatively). Subtrees fully inside skip the plane tests.
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& outItems) const;
+
+    // nearest item hit by the ray within maxDistance. Without intersect the item's box is the hit, intersect can
+    // refine it: it gets an item whose box was hit and returns false for a miss or true with the distance.
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& outItem, float& outDistance,
+        const std::function<bool(uint32_t item, float& distance)>& intersect = nullptr) const;
+
+    bool IsEmpty() const { return Nodes.empty(); }
+    size_t GetNodeCount() const { return Nodes.size(); }
+    size_t GetItemCount() const { return Items.size(); }
+    const std::vector<BVHNode>& GetNodes() const { return Nodes; }
+
+private:
+
+    void Subdivide(uint32_t NodeIndex, const std::vector<AABB>& Boxes, const std::vector<glm::vec3>& Centroids);
+    void UpdateNodeBounds(BVHNode& Node, const std::vector<AABB>& Boxes) const;
+
+    std::vector<BVHNode> Nodes;
+    std::vector<uint32_t> Items;        // item indices, leaves reference ranges of this
+    std::vector<AABB> ItemBoxes;        // per item, in Build order
+};
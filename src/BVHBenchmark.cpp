@@ -0,0 +1,177 @@
+#include "BVHBenchmark.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "BVH.h"
+#include "Culling.h"
+
+namespace
+{
+	const float SceneExtent = 100.0f;
+	const int QueryRuns = 20;
+	const int RayCount = 10000;
+	// testing every box is slow enough that only these first rays are checked that way
+	const int BruteForceRayCount = 200;
+	const float RayLength = 2.0f * SceneExtent;
+
+	struct Ray
+	{
+		glm::vec3 Origin;
+		glm::vec3 Direction;
+	};
+
+	double ElapsedMs(const std::chrono::steady_clock::time_point& Start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+	}
+
+	void PrintTiming(const char* Name, double Ms, size_t Count, const char* What)
+	{
+		std::cout << std::left << std::setw(20) << Name << std::right << std::fixed << std::setprecision(3) << std::setw(11) << Ms << " ms"
+			<< std::setw(10) << Count << " " << What << std::endl;
+	}
+
+	// same slab test as the tree's, so hit distances compare exactly
+	float IntersectRayBox(const Ray& Test, const glm::vec3& InverseDirection, float MaxDistance, const AABB& Box)
+	{
+		const glm::vec3 T0 = (Box.Min - Test.Origin) * InverseDirection;
+		const glm::vec3 T1 = (Box.Max - Test.Origin) * InverseDirection;
+		const glm::vec3 Near = glm::min(T0, T1);
+		const glm::vec3 Far = glm::max(T0, T1);
+		const float Enter = std::max(std::max(Near.x, Near.y), std::max(Near.z, 0.0f));
+		const float Exit = std::min(std::min(Far.x, Far.y), std::min(Far.z, MaxDistance));
+		return Enter <= Exit ? Enter : FLT_MAX;
+	}
+
+	// frustum queries on the tree and on every box, sorted item lists of the last run of each
+	bool CompareFrustumQueries(const BVH& Tree, const std::vector<AABB>& Boxes, const Frustum& CameraFrustum, const char* Label)
+	{
+		std::vector<uint32_t> TreeItems;
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int Run = 0; Run < QueryRuns; Run++)
+		{
+			TreeItems.clear();
+			Tree.QueryFrustum(CameraFrustum, TreeItems);
+		}
+		const double TreeMs = ElapsedMs(Start) / QueryRuns;
+
+		std::vector<uint32_t> BruteForceItems;
+		Start = std::chrono::steady_clock::now();
+		for (int Run = 0; Run < QueryRuns; Run++)
+		{
+			BruteForceItems.clear();
+			for (uint32_t i = 0; i < Boxes.size(); i++)
+			{
+				if (CameraFrustum.IntersectsAABB(Boxes[i].Min, Boxes[i].Max))
+				{
+					BruteForceItems.push_back(i);
+				}
+			}
+		}
+		const double BruteForceMs = ElapsedMs(Start) / QueryRuns;
+
+		std::sort(TreeItems.begin(), TreeItems.end());
+		const bool bMatched = TreeItems == BruteForceItems;
+		PrintTiming(Label, TreeMs, TreeItems.size(), "visible");
+		PrintTiming("  brute force", BruteForceMs, BruteForceItems.size(), bMatched ? "visible, identical" : "visible, DIFFERS");
+		return bMatched;
+	}
+}
+
+bool RunBVHBenchmark(int itemCount)
+{
+	itemCount = std::max(itemCount, 1);
+	std::cout << "BVH benchmark, " << itemCount << " boxes, " << QueryRuns << " frustum queries, " << RayCount << " rays" << std::endl;
+
+	std::default_random_engine Generator;
+	std::uniform_real_distribution<float> Position(-SceneExtent, SceneExtent);
+	std::uniform_real_distribution<float> Size(0.1f, 1.0f);
+	std::vector<AABB> Boxes(itemCount);
+	for (AABB& Box : Boxes)
+	{
+		const glm::vec3 Center(Position(Generator), Position(Generator), Position(Generator));
+		const glm::vec3 HalfSize(Size(Generator), Size(Generator), Size(Generator));
+		Box = { Center - HalfSize, Center + HalfSize };
+	}
+
+	BVH Tree;
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	Tree.Build(Boxes);
+	PrintTiming("build", ElapsedMs(Start), Tree.GetNodeCount(), "nodes");
+
+	// a camera in the middle of the scene looking down -z, it sees a small part of it
+	const glm::mat4 Projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 0.5f * SceneExtent);
+	const glm::mat4 View = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const Frustum CameraFrustum = Frustum::FromMatrix(Projection * View);
+	bool bMatched = CompareFrustumQueries(Tree, Boxes, CameraFrustum, "frustum query");
+
+	// rays from random points in random directions, the nearest hit must have the same distance either way
+	std::uniform_real_distribution<float> Direction(-1.0f, 1.0f);
+	std::vector<Ray> Rays(RayCount);
+	for (Ray& Test : Rays)
+	{
+		Test.Origin = glm::vec3(Position(Generator), Position(Generator), Position(Generator));
+		Test.Direction = glm::normalize(glm::vec3(Direction(Generator), Direction(Generator), Direction(Generator)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+	}
+	std::vector<float> TreeDistances(RayCount, FLT_MAX);
+	Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < RayCount; i++)
+	{
+		uint32_t Item = 0;
+		float Distance = FLT_MAX;
+		if (Tree.Raycast(Rays[i].Origin, Rays[i].Direction, RayLength, Item, Distance))
+		{
+			TreeDistances[i] = Distance;
+		}
+	}
+	const double TreeRayMs = ElapsedMs(Start);
+
+	std::vector<float> BruteForceDistances(BruteForceRayCount, FLT_MAX);
+	Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BruteForceRayCount; i++)
+	{
+		const glm::vec3 InverseDirection(1.0f / Rays[i].Direction.x, 1.0f / Rays[i].Direction.y, 1.0f / Rays[i].Direction.z);
+		float Closest = RayLength;
+		for (const AABB& Box : Boxes)
+		{
+			const float Distance = IntersectRayBox(Rays[i], InverseDirection, Closest, Box);
+			if (Distance < Closest)
+			{
+				Closest = Distance;
+				BruteForceDistances[i] = Distance;
+			}
+		}
+	}
+	const double BruteForceRayMs = ElapsedMs(Start);
+
+	const bool bRaysMatched = std::equal(BruteForceDistances.begin(), BruteForceDistances.end(), TreeDistances.begin());
+	bMatched = bMatched && bRaysMatched;
+	PrintTiming("rays", TreeRayMs, RayCount - std::count(TreeDistances.begin(), TreeDistances.end(), FLT_MAX), "hits");
+	// scaled up to RayCount rays
+	PrintTiming("  brute force", BruteForceRayMs * RayCount / BruteForceRayCount,
+		BruteForceRayCount - std::count(BruteForceDistances.begin(), BruteForceDistances.end(), FLT_MAX),
+		bRaysMatched ? "hits of the first rays, identical distances" : "hits of the first rays, distances DIFFER");
+
+	// everything drifts a little, the topology stays and the queries must still be exact
+	std::uniform_real_distribution<float> Drift(-2.0f, 2.0f);
+	for (AABB& Box : Boxes)
+	{
+		const glm::vec3 Offset(Drift(Generator), Drift(Generator), Drift(Generator));
+		Box.Min += Offset;
+		Box.Max += Offset;
+	}
+	Start = std::chrono::steady_clock::now();
+	Tree.Refit(Boxes);
+	PrintTiming("refit", ElapsedMs(Start), Tree.GetNodeCount(), "nodes");
+	bMatched = CompareFrustumQueries(Tree, Boxes, CameraFrustum, "query after refit") && bMatched;
+
+	std::cout << "tree results " << (bMatched ? "match brute force" : "DIFFER from brute force") << std::endl;
+	return bMatched;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// builds a BVH over itemCount random boxes in a 200 unit cube and times the build, frustum queries against testing
+// every box, nearest hit raycasts against testing every box (only the first 200 rays, scaled up), and a refit after
+// moving every box. Checks that the tree returns the same items and hit distances as the brute force loops, before and
+// after the refit. CPU only, no GL context needed. Returns false if anything differs.
+bool RunBVHBenchmark(int itemCount);
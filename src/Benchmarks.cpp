@@ -0,0 +1,111 @@
+#include "Benchmarks.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "BVHBenchmark.h"
+#include "BlurBenchmark.h"
+#include "ECSBenchmark.h"
+#include "ImportBenchmark.h"
+#include "MemoryBenchmark.h"
+#include "MipBenchmark.h"
+#include "PointShadowBenchmark.h"
+#include "SSAOBenchmark.h"
+#include "SceneGraphBenchmark.h"
+#include "TextureStreamerTest.h"
+#include "stb_image.h"
+
+namespace
+{
+	bool RunImport(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunImportBenchmark(std::atoi(argument));
+	}
+
+	bool RunMip(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunMipBenchmark(2048, std::atoi(argument));
+	}
+
+	bool RunStreamerTest(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunTextureStreamerTest(std::atoi(argument));
+	}
+
+	bool RunSceneGraph(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunSceneGraphBenchmark(std::atoi(argument), 20);
+	}
+
+	bool RunECS(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunECSBenchmark(std::atoi(argument), 20);
+	}
+
+	bool RunBVH(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunBVHBenchmark(std::atoi(argument));
+	}
+
+	bool RunBlur(const char* argument, const BenchmarkEnvironment& environment)
+	{
+		return RunBlurBenchmark(environment.Width, environment.Height, std::atoi(argument), environment.DrawQuad);
+	}
+
+	bool RunSSAO(const char* argument, const BenchmarkEnvironment& environment)
+	{
+		return RunSSAOBenchmark(environment.Width, environment.Height, std::atoi(argument), environment.DrawQuad);
+	}
+
+	bool RunPointShadow(const char* argument, const BenchmarkEnvironment&)
+	{
+		return RunPointShadowBenchmark(std::atoi(argument));
+	}
+
+	bool RunMemory(const char* argument, const BenchmarkEnvironment&)
+	{
+		// same texture orientation as the renderer's model loads
+		stbi_set_flip_vertically_on_load(true);
+		return RunMemoryBenchmark(argument);
+	}
+
+	const CommandLineBenchmark Benchmarks[] =
+	{
+		// <meshes>: time the model import's mesh conversion serial and parallel on a synthetic scene
+		{ "--import-bench", false, RunImport },
+		// <iterations>: time the CPU mip chain filters, threaded and SSE against serial and scalar
+		{ "--mip-bench", false, RunMip },
+		// <textures>: check the texture streamer's budget and eviction on a fake backend
+		{ "--streamer-test", false, RunStreamerTest },
+		// <nodes>: time full, subtree and clean scene graph updates, check the world matrices
+		{ "--scenegraph-bench", false, RunSceneGraph },
+		// <entities>: time the registry iteration, world bounds and draw list systems
+		{ "--ecs-bench", false, RunECS },
+		// <items>: time the BVH build, frustum queries, raycasts and refit against brute force
+		{ "--bvh-bench", false, RunBVH },
+		// <iterations>: time the fragment and compute blurs against each other, check they match
+		{ "--blur-bench", true, RunBlur },
+		// <frames>: compare the temporal SSAO modes with the full kernel against a reference
+		{ "--ssao-bench", true, RunSSAO },
+		// <iterations>: time the vertex layer and geometry shader point shadow paths, compare them
+		{ "--point-shadow-bench", true, RunPointShadow },
+		// <model>: print the memory a model load adds with and without keeping the CPU geometry
+		{ "--memory-bench", true, RunMemory },
+	};
+}
+
+const CommandLineBenchmark* FindCommandLineBenchmark(int argc, char** argv, const char** outArgument)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		for (const CommandLineBenchmark& Benchmark : Benchmarks)
+		{
+			if (std::strcmp(argv[i], Benchmark.Flag) == 0)
+			{
+				*outArgument = argv[i + 1];
+				return &Benchmark;
+			}
+		}
+	}
+	return nullptr;
+}
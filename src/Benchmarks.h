@@ -0,0 +1,23 @@
+#pragma once
+
+// what a benchmark that draws gets from main: the size of the hidden window and a full screen quad (renderQuad)
+struct BenchmarkEnvironment
+{
+    int Width = 0;
+    int Height = 0;
+    void (*DrawQuad)() = nullptr;
+};
+
+// a benchmark or self test run from the command line (--blur-bench <iterations> etc.) instead of the renderer.
+// The process exits with its result. All of them are listed in the table in Benchmarks.cpp, main only looks the flag
+// up and calls Run before (no GL) or after (hidden window, GL 3.3 context) creating the context.
+struct CommandLineBenchmark
+{
+    const char* Flag;
+    bool bNeedsContext;
+    // argument is the value after the flag, returns false if a check failed
+    bool (*Run)(const char* argument, const BenchmarkEnvironment& environment);
+};
+
+// the first benchmark flag in argv followed by a value, which is returned in outArgument. nullptr if there is none.
+const CommandLineBenchmark* FindCommandLineBenchmark(int argc, char** argv, const char** outArgument);
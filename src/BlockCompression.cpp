@@ -0,0 +1,254 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "JobSystem.h"
+
+namespace
+{
+	unsigned short PackRGB565(const float* Color)
+	{
+		const int R = std::min(31, std::max(0, static_cast<int>(std::lround(Color[0] * 31.0f / 255.0f))));
+		const int G = std::min(63, std::max(0, static_cast<int>(std::lround(Color[1] * 63.0f / 255.0f))));
+		const int B = std::min(31, std::max(0, static_cast<int>(std::lround(Color[2] * 31.0f / 255.0f))));
+		return static_cast<unsigned short>((R << 11) | (G << 5) | B);
+	}
+
+	// expands a 565 color back to 8 bits per channel the same way the hardware does
+	void UnpackRGB565(unsigned short Packed, int* OutColor)
+	{
+		const int R = (Packed >> 11) & 31;
+		const int G = (Packed >> 5) & 63;
+		const int B = Packed & 31;
+		OutColor[0] = (R << 3) | (R >> 2);
+		OutColor[1] = (G << 2) | (G >> 4);
+		OutColor[2] = (B << 3) | (B >> 2);
+	}
+}
+
+size_t GetBlockBytes(BlockFormat Format)
+{
+	return Format == BLOCK_BC1 ? 8 : 16;
+}
+
+size_t GetCompressedSize(BlockFormat Format, int Width, int Height)
+{
+	const size_t BlocksX = (std::max(Width, 1) + 3) / 4;
+	const size_t BlocksY = (std::max(Height, 1) + 3) / 4;
+	return BlocksX * BlocksY * GetBlockBytes(Format);
+}
+
+void EncodeBC1Block(const unsigned char* Texels, unsigned char* OutBlock)
+{
+	// 1. find the principal axis of the colors (mean + covariance + a few power iterations)
+	float Mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			Mean[c] += Texels[i * 4 + c];
+		}
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		Mean[c] /= 16.0f;
+	}
+
+	float Cov[3][3] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		const float D[3] = { Texels[i * 4] - Mean[0], Texels[i * 4 + 1] - Mean[1], Texels[i * 4 + 2] - Mean[2] };
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				Cov[r][c] += D[r] * D[c];
+			}
+		}
+	}
+
+	// start with the covariance column of largest magnitude, converges much faster than a fixed guess
+	float Axis[3] = { 1.0f, 1.0f, 1.0f };
+	float BestNorm = 0.0f;
+	for (int c = 0; c < 3; c++)
+	{
+		const float Norm = Cov[0][c] * Cov[0][c] + Cov[1][c] * Cov[1][c] + Cov[2][c] * Cov[2][c];
+		if (Norm > BestNorm)
+		{
+			BestNorm = Norm;
+			Axis[0] = Cov[0][c]; Axis[1] = Cov[1][c]; Axis[2] = Cov[2][c];
+		}
+	}
+	for (int Iteration = 0; Iteration < 4; Iteration++)
+	{
+		float Next[3];
+		for (int r = 0; r < 3; r++)
+		{
+			Next[r] = Cov[r][0] * Axis[0] + Cov[r][1] * Axis[1] + Cov[r][2] * Axis[2];
+		}
+		const float Largest = std::max(std::fabs(Next[0]), std::max(std::fabs(Next[1]), std::fabs(Next[2])));
+		if (Largest < 1e-6f)
+		{
+			break; // flat block, keep the previous axis
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			Axis[c] = Next[c] / Largest;
+		}
+	}
+	const float Length = std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+	for (int c = 0; c < 3; c++)
+	{
+		Axis[c] /= Length;
+	}
+
+	// 2. the extremes along the axis are the endpoints, pulled in a bit since the end points are rarely hit exactly
+	float MinT = 0.0f, MaxT = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		const float T = (Texels[i * 4] - Mean[0]) * Axis[0] + (Texels[i * 4 + 1] - Mean[1]) * Axis[1] + (Texels[i * 4 + 2] - Mean[2]) * Axis[2];
+		MinT = std::min(MinT, T);
+		MaxT = std::max(MaxT, T);
+	}
+	const float Inset = (MaxT - MinT) / 16.0f;
+	MinT += Inset;
+	MaxT -= Inset;
+
+	float End0[3], End1[3];
+	for (int c = 0; c < 3; c++)
+	{
+		End0[c] = std::min(255.0f, std::max(0.0f, Mean[c] + Axis[c] * MaxT));
+		End1[c] = std::min(255.0f, std::max(0.0f, Mean[c] + Axis[c] * MinT));
+	}
+
+	unsigned short Color0 = PackRGB565(End0);
+	unsigned short Color1 = PackRGB565(End1);
+	// color0 > color1 selects the opaque 4 color mode
+	if (Color0 < Color1)
+	{
+		std::swap(Color0, Color1);
+	}
+
+	unsigned int Indices = 0;
+	if (Color0 != Color1)
+	{
+		// 3. pick the closest of the 4 palette entries for each texel
+		int Palette[4][3];
+		UnpackRGB565(Color0, Palette[0]);
+		UnpackRGB565(Color1, Palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			Palette[2][c] = (2 * Palette[0][c] + Palette[1][c]) / 3;
+			Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int Best = 0;
+			int BestError = 1 << 30;
+			for (int p = 0; p < 4; p++)
+			{
+				const int DR = Texels[i * 4] - Palette[p][0];
+				const int DG = Texels[i * 4 + 1] - Palette[p][1];
+				const int DB = Texels[i * 4 + 2] - Palette[p][2];
+				const int Error = DR * DR + DG * DG + DB * DB;
+				if (Error < BestError)
+				{
+					BestError = Error;
+					Best = p;
+				}
+			}
+			Indices |= static_cast<unsigned int>(Best) << (i * 2);
+		}
+	}
+	// else: a single color block, every index 0 picks color0
+
+	OutBlock[0] = static_cast<unsigned char>(Color0 & 0xFF);
+	OutBlock[1] = static_cast<unsigned char>(Color0 >> 8);
+	OutBlock[2] = static_cast<unsigned char>(Color1 & 0xFF);
+	OutBlock[3] = static_cast<unsigned char>(Color1 >> 8);
+	for (int b = 0; b < 4; b++)
+	{
+		OutBlock[4 + b] = static_cast<unsigned char>((Indices >> (b * 8)) & 0xFF);
+	}
+}
+
+void EncodeBC4Block(const unsigned char* Values, int Stride, unsigned char* OutBlock)
+{
+	int Min = 255, Max = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		Min = std::min(Min, static_cast<int>(Values[i * Stride]));
+		Max = std::max(Max, static_cast<int>(Values[i * Stride]));
+	}
+
+	// value0 > value1 selects the 8 value mode: index 0 = max, 1 = min, 2..7 = interpolated from max down to min
+	unsigned long long Indices = 0;
+	if (Max > Min)
+	{
+		const int Range = Max - Min;
+		for (int i = 0; i < 16; i++)
+		{
+			// position on the 0 (min) .. 7 (max) ramp, rounded to nearest
+			const int Step = ((Values[i * Stride] - Min) * 14 + Range) / (2 * Range);
+			const int Index = Step == 7 ? 0 : (Step == 0 ? 1 : 8 - Step);
+			Indices |= static_cast<unsigned long long>(Index) << (i * 3);
+		}
+	}
+
+	OutBlock[0] = static_cast<unsigned char>(Max);
+	OutBlock[1] = static_cast<unsigned char>(Min);
+	for (int b = 0; b < 6; b++)
+	{
+		OutBlock[2 + b] = static_cast<unsigned char>((Indices >> (b * 8)) & 0xFF);
+	}
+}
+
+std::vector<unsigned char> CompressImage(const unsigned char* Rgba, int Width, int Height, BlockFormat Format)
+{
+	const int BlocksX = (Width + 3) / 4;
+	const int BlocksY = (Height + 3) / 4;
+	const size_t BlockBytes = GetBlockBytes(Format);
+	std::vector<unsigned char> Result(GetCompressedSize(Format, Width, Height));
+
+	// one job per row of blocks, every row writes to its own part of Result
+	JobSystem::Get().ParallelFor(static_cast<size_t>(BlocksY), [&](size_t Begin, size_t End)
+	{
+		unsigned char Texels[16 * 4];
+		for (size_t BlockY = Begin; BlockY < End; BlockY++)
+		{
+			for (int BlockX = 0; BlockX < BlocksX; BlockX++)
+			{
+				// gather the 4x4 texels, blocks hanging over the border repeat the last row/column
+				for (int y = 0; y < 4; y++)
+				{
+					const int SourceY = std::min(static_cast<int>(BlockY) * 4 + y, Height - 1);
+					for (int x = 0; x < 4; x++)
+					{
+						const int SourceX = std::min(BlockX * 4 + x, Width - 1);
+						const unsigned char* Source = Rgba + (static_cast<size_t>(SourceY) * Width + SourceX) * 4;
+						std::copy(Source, Source + 4, Texels + (y * 4 + x) * 4);
+					}
+				}
+
+				unsigned char* Block = Result.data() + (BlockY * BlocksX + BlockX) * BlockBytes;
+				switch (Format)
+				{
+				case BLOCK_BC1:
+					EncodeBC1Block(Texels, Block);
+					break;
+				case BLOCK_BC3:
+					EncodeBC4Block(Texels + 3, 4, Block);
+					EncodeBC1Block(Texels, Block + 8);
+					break;
+				case BLOCK_BC5:
+					EncodeBC4Block(Texels, 4, Block);
+					EncodeBC4Block(Texels + 1, 4, Block + 8);
+					break;
+				}
+			}
+		}
+	});
+
+	return Result;
+}
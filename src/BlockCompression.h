@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// block compressed (BCn / S3TC / RGTC) formats produced by the CPU encoder. Every format works on 4x4 texel blocks.
+enum BlockFormat {
+    BLOCK_BC1,  // RGB, 8 bytes per block. opaque albedo / specular
+    BLOCK_BC3,  // RGBA (BC1 color + BC4 alpha), 16 bytes per block. albedo with alpha
+    BLOCK_BC5   // two channel RG (2x BC4), 16 bytes per block. tangent space normal maps, z is rebuilt in the shader
+};
+
+// bytes of one 4x4 block
+size_t GetBlockBytes(BlockFormat Format);
+
+// bytes of a whole Width x Height image (partial blocks at the border count as full blocks)
+size_t GetCompressedSize(BlockFormat Format, int Width, int Height);
+
+// encodes 16 RGBA8 texels (row major, 4 bytes each) into one BC1 block. Always uses the opaque 4 color mode.
+void EncodeBC1Block(const unsigned char* Texels, unsigned char* OutBlock);
+
+// encodes 16 single channel values read with the given byte stride into one BC4 block
+void EncodeBC4Block(const unsigned char* Values, int Stride, unsigned char* OutBlock);
+
+// compresses a tightly packed RGBA8 image. Does not touch GL, the work is spread over the JobSystem.
+std::vector<unsigned char> CompressImage(const unsigned char* Rgba, int Width, int Height, BlockFormat Format);
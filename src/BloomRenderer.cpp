@@ -0,0 +1,246 @@
+#include "BloomRenderer.h"
+
+#include <algorithm>
+
+#include "ComputeBlur.h"
+#include "Profiler.h"
+
+constexpr int BloomRenderer::MaxMips;
+
+namespace
+{
+	GLuint CreateColorTarget(GLint internalFormat, int Width, int Height)
+	{
+		GLuint Texture = 0;
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, Width, Height, 0, GL_RGB, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return Texture;
+	}
+
+	void DeleteProgram(std::unique_ptr<Shader>& Program)
+	{
+		if (Program)
+		{
+			glDeleteProgram(Program->ID);
+			Program.reset();
+		}
+	}
+}
+
+BloomRenderer::~BloomRenderer()
+{
+	Shutdown();
+}
+
+bool BloomRenderer::Init(int width, int height, int mipCount)
+{
+	Shutdown();
+	Width = std::max(1, width);
+	Height = std::max(1, height);
+	glGenFramebuffers(1, &Framebuffer);
+	CreateTargets(mipCount);
+
+	DownsampleShader.reset(new Shader("Shaders/SSAO.vert", "Shaders/BloomDownsample.frag"));
+	UpsampleShader.reset(new Shader("Shaders/SSAO.vert", "Shaders/BloomUpsample.frag"));
+	BlurShader.reset(new Shader("Shaders/SSAO.vert", "Shaders/Blur.frag"));
+	DownsampleShader->Use();
+	DownsampleShader->SetInt("srcTexture", 0);
+	UpsampleShader->Use();
+	UpsampleShader->SetInt("srcTexture", 0);
+	BlurShader->Use();
+	BlurShader->SetInt("image", 0);
+	return true;
+}
+
+void BloomRenderer::Shutdown()
+{
+	DeleteTargets();
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		Framebuffer = 0;
+	}
+	DeleteProgram(DownsampleShader);
+	DeleteProgram(UpsampleShader);
+	DeleteProgram(BlurShader);
+}
+
+void BloomRenderer::SetMipCount(int mipCount)
+{
+	if (Framebuffer && mipCount != GetMipCount())
+	{
+		DeleteTargets();
+		CreateTargets(mipCount);
+	}
+}
+
+void BloomRenderer::CreateTargets(int mipCount)
+{
+	// R11G11B10F: half the bandwidth of RGBA16F, bloom needs neither alpha nor the precision
+	mipCount = std::min(std::max(mipCount, 1), MaxMips);
+	int MipWidth = Width;
+	int MipHeight = Height;
+	for (int i = 0; i < mipCount && (MipWidth > 1 || MipHeight > 1); i++)
+	{
+		MipWidth = std::max(1, MipWidth / 2);
+		MipHeight = std::max(1, MipHeight / 2);
+		Mip Level;
+		Level.Width = MipWidth;
+		Level.Height = MipHeight;
+		Level.Texture = CreateColorTarget(GL_R11F_G11F_B10F, MipWidth, MipHeight);
+		Mips.push_back(Level);
+	}
+	for (GLuint& Target : PingPong)
+	{
+		Target = CreateColorTarget(GL_RGBA16F, Width, Height);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BloomRenderer::DeleteTargets()
+{
+	for (Mip& Level : Mips)
+	{
+		glDeleteTextures(1, &Level.Texture);
+	}
+	Mips.clear();
+	for (GLuint& Target : PingPong)
+	{
+		if (Target)
+		{
+			glDeleteTextures(1, &Target);
+			Target = 0;
+		}
+	}
+}
+
+GLuint BloomRenderer::Render(GLuint sceneTexture, void (*drawQuad)())
+{
+	BloomStats = Stats();
+	if (!Framebuffer || Mips.empty())
+	{
+		return 0;
+	}
+
+	GENIX_PROFILE_GPU("Bloom");
+	GLint PreviousViewport[4];
+	GLint PreviousFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+	const GLboolean bBlendWasEnabled = glIsEnabled(GL_BLEND);
+	// the upsample chain blends additively, whatever the caller had set is put back at the end
+	GLint PreviousBlendFunc[4];
+	GLint PreviousBlendEquation[2];
+	glGetIntegerv(GL_BLEND_SRC_RGB, &PreviousBlendFunc[0]);
+	glGetIntegerv(GL_BLEND_DST_RGB, &PreviousBlendFunc[1]);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &PreviousBlendFunc[2]);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &PreviousBlendFunc[3]);
+	glGetIntegerv(GL_BLEND_EQUATION_RGB, &PreviousBlendEquation[0]);
+	glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &PreviousBlendEquation[1]);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glActiveTexture(GL_TEXTURE0);
+
+	GLuint Result = 0;
+	if (Mode == BLOOM_GAUSSIAN && Compute && Compute->IsSupported())
+	{
+		GLuint Source = sceneTexture;
+		for (int Pass = 0; Pass < BlurPasses / 2; Pass++)
+		{
+			const int Target = Pass % 2;
+			Compute->BlurGaussian(Source, PingPong[Target], Width, Height);
+			BloomStats.Passes++;
+			BloomStats.PixelsWritten += static_cast<size_t>(Width) * Height;
+			Source = PingPong[Target];
+		}
+		Result = Source;
+	}
+	else if (Mode == BLOOM_GAUSSIAN)
+	{
+		glDisable(GL_BLEND);
+		glViewport(0, 0, Width, Height);
+		BlurShader->Use();
+		GLuint Source = sceneTexture;
+		for (int Pass = 0; Pass < BlurPasses; Pass++)
+		{
+			const int Target = Pass % 2;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, PingPong[Target], 0);
+			BlurShader->SetBool("horizontal", Target == 0);
+			glBindTexture(GL_TEXTURE_2D, Source);
+			drawQuad();
+			BloomStats.Passes++;
+			BloomStats.PixelsWritten += static_cast<size_t>(Width) * Height;
+			Source = PingPong[Target];
+		}
+		Result = Source;
+	}
+	else
+	{
+		// down: every mip is the 13 tap filtered half of the one above. The first step also Karis averages the
+		// samples, so single very bright pixels don't turn into flickering blobs.
+		{
+			GENIX_PROFILE_GPU("Bloom Downsample");
+			glDisable(GL_BLEND);
+			DownsampleShader->Use();
+			GLuint Source = sceneTexture;
+			int SourceWidth = Width;
+			int SourceHeight = Height;
+			for (size_t i = 0; i < Mips.size(); i++)
+			{
+				const Mip& Level = Mips[i];
+				glViewport(0, 0, Level.Width, Level.Height);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Level.Texture, 0);
+				DownsampleShader->SetVec2("srcTexelSize", 1.0f / SourceWidth, 1.0f / SourceHeight);
+				DownsampleShader->SetBool("karisAverage", i == 0);
+				glBindTexture(GL_TEXTURE_2D, Source);
+				drawQuad();
+				BloomStats.Passes++;
+				BloomStats.PixelsWritten += static_cast<size_t>(Level.Width) * Level.Height;
+				Source = Level.Texture;
+				SourceWidth = Level.Width;
+				SourceHeight = Level.Height;
+			}
+		}
+
+		// up: each mip is tent filtered and added onto the next larger one, mip 0 ends up with the sum of all
+		{
+			GENIX_PROFILE_GPU("Bloom Upsample");
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE);
+			glBlendEquation(GL_FUNC_ADD);
+			UpsampleShader->Use();
+			UpsampleShader->SetFloat("filterRadius", FilterRadius);
+			for (size_t i = Mips.size() - 1; i > 0; i--)
+			{
+				const Mip& Target = Mips[i - 1];
+				glViewport(0, 0, Target.Width, Target.Height);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Target.Texture, 0);
+				glBindTexture(GL_TEXTURE_2D, Mips[i].Texture);
+				drawQuad();
+				BloomStats.Passes++;
+				BloomStats.PixelsWritten += static_cast<size_t>(Target.Width) * Target.Height;
+			}
+		}
+		Result = Mips[0].Texture;
+	}
+
+	BloomStats.FullResolutionPasses = static_cast<float>(BloomStats.PixelsWritten) / (static_cast<float>(Width) * Height);
+
+	glBlendFuncSeparate(PreviousBlendFunc[0], PreviousBlendFunc[1], PreviousBlendFunc[2], PreviousBlendFunc[3]);
+	glBlendEquationSeparate(PreviousBlendEquation[0], PreviousBlendEquation[1]);
+	if (bBlendWasEnabled)
+	{
+		glEnable(GL_BLEND);
+	}
+	else
+	{
+		glDisable(GL_BLEND);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+	return Result;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+class ComputeBlur;
+
+enum BloomMode
+{
+    BLOOM_MIP_CHAIN,    // 13 tap downsample into half resolution mips, tent upsample back with additive blending
+    BLOOM_GAUSSIAN      // the old separable 9 tap Gaussian (Blur.frag) ping-ponged at full resolution, for comparison
+};
+
+// bloom of an HDR scene texture without a brightness threshold, composited with a small strength instead
+// (BloomComposite.frag). The mip chain writes 1/4 + 1/16 + ... of the screen on the way down and the same on the way
+// up, together less than one full resolution pass, where the Gaussian path writes BlurPasses full resolution passes.
+// GPU time is reported under the "Bloom" profiler marker for both modes.
+class BloomRenderer
+{
+public:
+
+    static constexpr int MaxMips = 8;
+
+    struct Stats
+    {
+        int Passes = 0;                 // full screen quads drawn by the last Render
+        size_t PixelsWritten = 0;
+        float FullResolutionPasses = 0.0f;  // PixelsWritten in units of the scene size
+    };
+
+    BloomRenderer() = default;
+    ~BloomRenderer();
+
+    BloomRenderer(const BloomRenderer&) = delete;
+    BloomRenderer& operator=(const BloomRenderer&) = delete;
+
+    // width/height of the scene texture, mipCount half resolution steps (the first mip is already half size)
+    bool Init(int width, int height, int mipCount = 6);
+    void Shutdown();
+
+    // recreates the chain with another mip count, keeps the size
+    void SetMipCount(int mipCount);
+    int GetMipCount() const { return static_cast<int>(Mips.size()); }
+
+    // blurs sceneTexture and returns the texture holding the bloom (valid until the next Render). drawQuad draws a
+    // full screen quad with positions at location 0 and texture coordinates at location 1 (renderQuad).
+    // Leaves the framebuffer, viewport and blend state as they were.
+    GLuint Render(GLuint sceneTexture, void (*drawQuad)());
+
+    const Stats& GetStats() const { return BloomStats; }
+    // factor for the texture Render returned: the upsample chain adds every mip's blur on top of each other, so the
+    // mip chain result holds GetMipCount() times the scene's energy
+    float GetIntensityScale() const { return Mode == BLOOM_MIP_CHAIN && !Mips.empty() ? 1.0f / Mips.size() : 1.0f; }
+
+    BloomMode Mode = BLOOM_MIP_CHAIN;
+    // how far the composite lerps the scene towards the bloom
+    float Strength = 0.04f;
+    // upsample tent radius in UV units of the mip being read
+    float FilterRadius = 0.005f;
+    // full resolution passes of the Gaussian mode (horizontal and vertical count separately)
+    int BlurPasses = 10;
+    // when set and supported, the Gaussian mode runs each horizontal + vertical pair as one compute dispatch
+    ComputeBlur* Compute = nullptr;
+
+private:
+
+    struct Mip
+    {
+        GLuint Texture = 0;
+        int Width = 0;
+        int Height = 0;
+    };
+
+    void CreateTargets(int mipCount);
+    void DeleteTargets();
+
+    int Width = 0;
+    int Height = 0;
+    GLuint Framebuffer = 0;
+    std::vector<Mip> Mips;
+    GLuint PingPong[2] = { 0, 0 };          // Gaussian mode, full resolution
+    std::unique_ptr<Shader> DownsampleShader;
+    std::unique_ptr<Shader> UpsampleShader;
+    std::unique_ptr<Shader> BlurShader;
+    Stats BloomStats;
+};
@@ -0,0 +1,159 @@
+#include "BlurBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glad/glad.h>
+
+#include "ComputeBlur.h"
+#include "Shader.h"
+
+namespace
+{
+	// both paths write half floats, the fragment Gaussian rounds once more in between, so allow a few half ulps
+	const float RelativeTolerance = 4.0f / 1024.0f;
+
+	GLuint CreateTarget(GLint internalFormat, GLenum format, int Width, int Height, const float* Pixels)
+	{
+		GLuint Texture = 0;
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, Width, Height, 0, format, GL_FLOAT, Pixels);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return Texture;
+	}
+
+	std::vector<float> ReadBack(GLuint Texture, GLenum format, int Width, int Height)
+	{
+		std::vector<float> Pixels(static_cast<size_t>(Width) * Height * (format == GL_RGBA ? 4 : 1));
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glGetTexImage(GL_TEXTURE_2D, 0, format, GL_FLOAT, Pixels.data());
+		return Pixels;
+	}
+
+	// ms per run, averaged over iterations. Wall clock up to glFinish rather than a timer query: software drivers
+	// defer the rasterization of draws to the flush, so their GL_TIME_ELAPSED misses most of the work.
+	double TimeRuns(int iterations, const std::function<void()>& Run)
+	{
+		Run();
+		glFinish();
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			Run();
+		}
+		glFinish();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / std::max(iterations, 1);
+	}
+
+	float MaxRelativeError(const std::vector<float>& Reference, const std::vector<float>& Result)
+	{
+		float MaxError = 0.0f;
+		for (size_t i = 0; i < Reference.size(); i++)
+		{
+			MaxError = std::max(MaxError, std::abs(Reference[i] - Result[i]) / std::max(1.0f, std::abs(Reference[i])));
+		}
+		return MaxError;
+	}
+
+	void PrintResult(const char* Name, double FragmentMs, double ComputeMs, float Error, bool bCompared)
+	{
+		std::cout << std::left << std::setw(16) << Name << std::right << std::fixed << std::setprecision(3)
+			<< "fragment " << std::setw(9) << FragmentMs << " ms";
+		if (bCompared)
+		{
+			std::cout << "  compute " << std::setw(9) << ComputeMs << " ms  max error " << std::setprecision(6) << Error
+				<< (Error <= RelativeTolerance ? "  OK" : "  MISMATCH");
+		}
+		std::cout << std::endl;
+	}
+}
+
+bool RunBlurBenchmark(int width, int height, int iterations, void (*drawQuad)())
+{
+	ComputeBlur Compute;
+	const bool bCompute = Compute.Init();
+	std::cout << "Blur benchmark " << width << "x" << height << ", " << iterations << " iterations on " << glGetString(GL_RENDERER)
+		<< (bCompute ? "" : " (no GL 4.3, fragment only)") << std::endl;
+
+	std::default_random_engine Generator;
+	std::uniform_real_distribution<float> Occlusion(0.0f, 1.0f);
+	std::uniform_real_distribution<float> Radiance(0.0f, 4.0f);
+	std::vector<float> OcclusionPixels(static_cast<size_t>(width) * height);
+	std::vector<float> RadiancePixels(OcclusionPixels.size() * 4);
+	std::generate(OcclusionPixels.begin(), OcclusionPixels.end(), [&]() { return Occlusion(Generator); });
+	std::generate(RadiancePixels.begin(), RadiancePixels.end(), [&]() { return Radiance(Generator); });
+
+	const GLuint OcclusionInput = CreateTarget(GL_R16F, GL_RED, width, height, OcclusionPixels.data());
+	const GLuint OcclusionFragment = CreateTarget(GL_R16F, GL_RED, width, height, nullptr);
+	const GLuint OcclusionCompute = CreateTarget(GL_R16F, GL_RED, width, height, nullptr);
+	const GLuint RadianceInput = CreateTarget(GL_RGBA16F, GL_RGBA, width, height, RadiancePixels.data());
+	const GLuint RadianceHorizontal = CreateTarget(GL_RGBA16F, GL_RGBA, width, height, nullptr);
+	const GLuint RadianceFragment = CreateTarget(GL_RGBA16F, GL_RGBA, width, height, nullptr);
+	const GLuint RadianceCompute = CreateTarget(GL_RGBA16F, GL_RGBA, width, height, nullptr);
+
+	GLuint Framebuffer = 0;
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glViewport(0, 0, width, height);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glActiveTexture(GL_TEXTURE0);
+
+	Shader SSAOBlurShader("Shaders/SSAO.vert", "Shaders/SSAO_Blur.frag");
+	SSAOBlurShader.Use();
+	SSAOBlurShader.SetInt("ssaoInput", 0);
+	Shader GaussianShader("Shaders/SSAO.vert", "Shaders/Blur.frag");
+	GaussianShader.Use();
+	GaussianShader.SetInt("image", 0);
+
+	const double SSAOFragmentMs = TimeRuns(iterations, [&]()
+	{
+		SSAOBlurShader.Use();
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, OcclusionFragment, 0);
+		glBindTexture(GL_TEXTURE_2D, OcclusionInput);
+		drawQuad();
+	});
+	const double GaussianFragmentMs = TimeRuns(iterations, [&]()
+	{
+		GaussianShader.Use();
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, RadianceHorizontal, 0);
+		GaussianShader.SetBool("horizontal", true);
+		glBindTexture(GL_TEXTURE_2D, RadianceInput);
+		drawQuad();
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, RadianceFragment, 0);
+		GaussianShader.SetBool("horizontal", false);
+		glBindTexture(GL_TEXTURE_2D, RadianceHorizontal);
+		drawQuad();
+	});
+
+	double SSAOComputeMs = 0.0;
+	double GaussianComputeMs = 0.0;
+	float SSAOError = 0.0f;
+	float GaussianError = 0.0f;
+	if (bCompute)
+	{
+		SSAOComputeMs = TimeRuns(iterations, [&]() { Compute.BlurSSAO(OcclusionInput, OcclusionCompute, width, height); });
+		GaussianComputeMs = TimeRuns(iterations, [&]() { Compute.BlurGaussian(RadianceInput, RadianceCompute, width, height); });
+		SSAOError = MaxRelativeError(ReadBack(OcclusionFragment, GL_RED, width, height), ReadBack(OcclusionCompute, GL_RED, width, height));
+		GaussianError = MaxRelativeError(ReadBack(RadianceFragment, GL_RGBA, width, height), ReadBack(RadianceCompute, GL_RGBA, width, height));
+	}
+	PrintResult("SSAO blur", SSAOFragmentMs, SSAOComputeMs, SSAOError, bCompute);
+	PrintResult("Gaussian H+V", GaussianFragmentMs, GaussianComputeMs, GaussianError, bCompute);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &Framebuffer);
+	const GLuint Textures[] = { OcclusionInput, OcclusionFragment, OcclusionCompute, RadianceInput, RadianceHorizontal, RadianceFragment, RadianceCompute };
+	glDeleteTextures(7, Textures);
+	glDeleteProgram(SSAOBlurShader.ID);
+	glDeleteProgram(GaussianShader.ID);
+	return SSAOError <= RelativeTolerance && GaussianError <= RelativeTolerance;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// runs the fragment and compute versions of the SSAO blur and the Gaussian bloom blur on the same random input,
+// prints their times and the largest difference between their outputs. Works on any GL 3.3 context, the compute
+// side is skipped without 4.3; meant to also run on software drivers (LIBGL_ALWAYS_SOFTWARE=1 on Mesa's llvmpipe)
+// as a correctness check. drawQuad draws a full screen quad (renderQuad). Returns false if the outputs differ.
+bool RunBlurBenchmark(int width, int height, int iterations, void (*drawQuad)());
@@ -1,6 +1,6 @@
 #include "Camera.h"
 
-Camera::Camera(glm::vec3 InPosition, glm::vec3 InUp, float InYaw, float InPitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+Camera::Camera(glm::vec3 InPosition, glm::vec3 InUp, float InYaw, float InPitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Jitter(0.0f)
 {
 	Position = InPosition;
 	WorldUp = InUp;
@@ -14,6 +14,36 @@ glm::mat4 Camera::GetViewMatrix() const
 	return glm::lookAt(Position, Position + Front, Up);
 }
 
+glm::mat4 Camera::GetProjectionMatrix(float Width, float Height, float Near, float Far, bool bJittered) const
+{
+	const glm::mat4 Projection = glm::perspective(glm::radians(Zoom), Width / Height, Near, Far);
+	if (!bJittered)
+	{
+		return Projection;
+	}
+	// offsetting clip space x/y by Jitter * w moves every projected point by the same amount of NDC
+	return glm::translate(glm::mat4(1.0f), glm::vec3(2.0f * Jitter.x / Width, 2.0f * Jitter.y / Height, 0.0f)) * Projection;
+}
+
+void Camera::UpdateJitter(unsigned int FrameIndex)
+{
+	// low discrepancy, so any run of consecutive frames covers the pixel evenly
+	const auto Halton = [](unsigned int Index, unsigned int Base)
+	{
+		float Fraction = 1.0f;
+		float Result = 0.0f;
+		while (Index > 0)
+		{
+			Fraction /= Base;
+			Result += Fraction * (Index % Base);
+			Index /= Base;
+		}
+		return Result;
+	};
+	const unsigned int Phase = FrameIndex % JITTER_PHASES + 1;
+	Jitter = glm::vec2(Halton(Phase, 2) - 0.5f, Halton(Phase, 3) - 0.5f);
+}
+
 void Camera::ProcessKeyboard(const Camera_Movement Direction, const float DeltaTime)
 {
 	const float Velocity = MovementSpeed * DeltaTime * 8;
@@ -17,6 +17,8 @@ const float PITCH = 0.0f;
 const float SPEED = 2.5f;
 const float SENSITIVITY = 0.1f;
 const float ZOOM = 45.0f;
+// sub-pixel positions the jitter cycles through
+const unsigned int JITTER_PHASES = 8;
 
 class Camera
 {
@@ -36,6 +38,13 @@ public:
     // returns the view matrix calculated using Euler Angles and the LookAt Matrix
     glm::mat4 GetViewMatrix() const;
 
+    // returns the perspective projection for a Width x Height target, with bJittered shifted by Jitter pixels
+    glm::mat4 GetProjectionMatrix(float Width, float Height, float Near, float Far, bool bJittered = false) const;
+
+    // moves Jitter to the frame's position of a Halton(2, 3) sequence, for temporal anti-aliasing
+    void UpdateJitter(unsigned int FrameIndex);
+    void ResetJitter() { Jitter = glm::vec2(0.0f); }
+
     // camera Attributes
     glm::vec3 Position;
     glm::vec3 Front;
@@ -51,6 +60,8 @@ public:
     float MovementSpeed;
     float MouseSensitivity;
     float Zoom;
+    // sub-pixel projection offset in pixels, within -0.5..0.5
+    glm::vec2 Jitter;
 
 private:
 
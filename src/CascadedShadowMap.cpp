@@ -0,0 +1,224 @@
+#include "CascadedShadowMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Profiler.h"
+#include "Shader.h"
+
+constexpr int CascadedShadowMap::MaxCascades;
+
+namespace
+{
+	// profiler markers need names that outlive the frame
+	const char* const CascadeMarkerNames[CascadedShadowMap::MaxCascades] = { "Shadow Cascade 0", "Shadow Cascade 1", "Shadow Cascade 2", "Shadow Cascade 3" };
+
+	// radii are rounded up to this, so float noise in the fit doesn't change the texel size between frames
+	const float RadiusQuantum = 1.0f / 16.0f;
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+	Shutdown();
+}
+
+bool CascadedShadowMap::Init(int resolution, int cascadeCount)
+{
+	Shutdown();
+	Resolution = std::max(1, resolution);
+	CascadeCount = std::max(1, std::min(cascadeCount, MaxCascades));
+	FrameIndex = 0;
+	ShadowStats = Stats();
+	for (Cascade& Slice : Cascades)
+	{
+		Slice = Cascade();
+	}
+
+	// linear filtering with a compare mode gives hardware 2x2 PCF per tap
+	glGenTextures(1, &DepthArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, DepthArray);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, Resolution, Resolution, CascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, DepthArray, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	const bool bComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!bComplete)
+	{
+		std::cout << "ERROR::CASCADED_SHADOW_MAP:: Framebuffer is not complete!" << std::endl;
+		Shutdown();
+		return false;
+	}
+	return true;
+}
+
+void CascadedShadowMap::Shutdown()
+{
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		Framebuffer = 0;
+	}
+	if (DepthArray)
+	{
+		glDeleteTextures(1, &DepthArray);
+		DepthArray = 0;
+	}
+}
+
+void CascadedShadowMap::Update(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, const glm::vec3& lightDirection)
+{
+	LightDirection = glm::normalize(lightDirection);
+	const glm::vec3 Up = std::abs(LightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 LightView = glm::lookAt(glm::vec3(0.0f), LightDirection, Up);
+	const glm::mat4 InverseView = glm::inverse(view);
+	const float TanY = std::tan(fovY * 0.5f);
+	const float TanX = TanY * aspect;
+
+	// practical split scheme: logarithmic splits keep the texel density even, uniform ones keep the near cascades
+	// from getting tiny, SplitLambda blends the two
+	const float Near = nearPlane;
+	const float Far = std::max(Near + 0.01f, std::min(farPlane, ShadowDistance));
+	for (int i = 0; i < CascadeCount; i++)
+	{
+		const float Fraction = static_cast<float>(i + 1) / CascadeCount;
+		const float Logarithmic = Near * std::pow(Far / Near, Fraction);
+		const float Uniform = Near + (Far - Near) * Fraction;
+		SplitFar[i] = SplitLambda * Logarithmic + (1.0f - SplitLambda) * Uniform;
+	}
+
+	for (int i = 0; i < CascadeCount; i++)
+	{
+		Cascade& Slice = Cascades[i];
+		const bool bCached = i >= FirstCachedCascade;
+
+		// bounding sphere of the slice's corners. It is computed in view space, so it only depends on the projection
+		// and the cascade keeps its size (and texel size) however the camera turns.
+		const float SliceNear = i == 0 ? Near : SplitFar[i - 1];
+		const float SliceFar = SplitFar[i];
+		glm::vec3 Corners[8];
+		glm::vec3 Center(0.0f);
+		for (int Corner = 0; Corner < 8; Corner++)
+		{
+			const float Depth = (Corner & 4) ? SliceFar : SliceNear;
+			Corners[Corner] = glm::vec3((Corner & 1 ? 1.0f : -1.0f) * TanX * Depth, (Corner & 2 ? 1.0f : -1.0f) * TanY * Depth, -Depth);
+			Center += Corners[Corner];
+		}
+		Center /= 8.0f;
+		float Radius = 0.0f;
+		for (const glm::vec3& Corner : Corners)
+		{
+			Radius = std::max(Radius, glm::length(Corner - Center));
+		}
+		Radius = std::ceil(Radius / RadiusQuantum) * RadiusQuantum;
+		if (bCached)
+		{
+			Radius *= 1.0f + CachePadding;
+		}
+		Slice.Center = glm::vec3(InverseView * glm::vec4(Center, 1.0f));
+		Slice.Radius = Radius;
+
+		// snap the light space origin to whole texels, moving the camera then shifts the map by whole texels and
+		// the rasterized depths of static geometry stay the same
+		const float TexelSize = 2.0f * Radius / Resolution;
+		glm::vec3 LightCenter = glm::vec3(LightView * glm::vec4(Slice.Center, 1.0f));
+		LightCenter.x = std::floor(LightCenter.x / TexelSize) * TexelSize;
+		LightCenter.y = std::floor(LightCenter.y / TexelSize) * TexelSize;
+		const glm::mat4 Projection = glm::ortho(LightCenter.x - Radius, LightCenter.x + Radius, LightCenter.y - Radius, LightCenter.y + Radius,
+			-LightCenter.z - Radius - CasterDistance, -LightCenter.z + Radius);
+		Slice.ViewProjection = Projection * LightView;
+
+		// a cached layer stays usable while the unpadded slice is still inside the sphere it was rendered for
+		Slice.bDue = true;
+		if (bCached && Slice.bValid)
+		{
+			const float AllowedShift = Slice.RenderedRadius * CachePadding / (1.0f + CachePadding);
+			const bool bLightMoved = glm::dot(LightDirection, Slice.RenderedLightDirection) < 0.99999f;
+			const bool bLeftPadding = glm::length(Slice.Center - Slice.RenderedCenter) > AllowedShift;
+			const bool bResized = Slice.Radius != Slice.RenderedRadius;
+			const bool bScheduled = (FrameIndex + i) % static_cast<unsigned int>(std::max(1, CacheInterval)) == 0;
+			Slice.bDue = bLightMoved || bLeftPadding || bResized || bScheduled;
+		}
+	}
+	FrameIndex++;
+}
+
+void CascadedShadowMap::Render(const std::function<size_t(int cascade, const glm::mat4& lightViewProjection, const Frustum& cascadeFrustum)>& drawCasters)
+{
+	ShadowStats.CascadesRendered = 0;
+	ShadowStats.CascadesCached = 0;
+	ShadowStats.TotalDrawCalls = 0;
+	if (!Framebuffer)
+	{
+		return;
+	}
+
+	GLint PreviousViewport[4];
+	GLint PreviousFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glViewport(0, 0, Resolution, Resolution);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(DepthBiasFactor, DepthBiasUnits);
+	for (int i = 0; i < CascadeCount; i++)
+	{
+		Cascade& Slice = Cascades[i];
+		if (!Slice.bDue)
+		{
+			ShadowStats.CascadesCached++;
+			ShadowStats.CacheHits++;
+			continue;
+		}
+
+		Profiler::Get().PushMarker(CascadeMarkerNames[i]);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, DepthArray, 0, i);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		const size_t DrawCalls = drawCasters(i, Slice.ViewProjection, Frustum::FromMatrix(Slice.ViewProjection));
+		Profiler::Get().PopMarker();
+
+		Slice.RenderedViewProjection = Slice.ViewProjection;
+		Slice.RenderedCenter = Slice.Center;
+		Slice.RenderedRadius = Slice.Radius;
+		Slice.RenderedLightDirection = LightDirection;
+		Slice.bValid = true;
+		Slice.bDue = false;
+		ShadowStats.DrawCalls[i] = DrawCalls;
+		ShadowStats.TotalDrawCalls += DrawCalls;
+		ShadowStats.CascadesRendered++;
+	}
+	glDisable(GL_POLYGON_OFFSET_FILL);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+}
+
+void CascadedShadowMap::Bind(Shader& shader, int textureUnit, const glm::mat4& view) const
+{
+	const glm::mat4 InverseView = glm::inverse(view);
+	shader.SetInt("shadowCascades", textureUnit);
+	shader.SetInt("cascadeCount", CascadeCount);
+	for (int i = 0; i < CascadeCount; i++)
+	{
+		const std::string Index = "[" + std::to_string(i) + "]";
+		glm::mat4 ViewToLight = Cascades[i].RenderedViewProjection * InverseView;
+		shader.SetMat4("cascadeMatrices" + Index, ViewToLight);
+		shader.SetFloat("cascadeSplits" + Index, SplitFar[i]);
+	}
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, DepthArray);
+}
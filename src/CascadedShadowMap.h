@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+
+class Shader;
+
+// directional light shadows split along the view depth, one layer of a depth texture array per cascade.
+// cascades are fit around a bounding sphere of their view frustum slice, so their size doesn't change as the camera
+// rotates, and their origin is snapped to whole shadow texels, so edges don't shimmer as it moves. The far cascades
+// cover a lot of ground at low detail and change little from frame to frame, they are only re-rendered every
+// CacheInterval frames unless the light turned or the camera left the padding they were rendered with.
+class CascadedShadowMap
+{
+public:
+
+    static constexpr int MaxCascades = 4;
+
+    struct Stats
+    {
+        int CascadesRendered = 0;               // this frame
+        int CascadesCached = 0;                 // this frame, reused from an earlier one
+        size_t DrawCalls[MaxCascades] = {};     // of the last time each cascade was rendered
+        size_t TotalDrawCalls = 0;              // this frame
+        size_t CacheHits = 0;                   // since Init
+    };
+
+    CascadedShadowMap() = default;
+    ~CascadedShadowMap();
+
+    CascadedShadowMap(const CascadedShadowMap&) = delete;
+    CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+    // creates the depth texture array, resolution per cascade
+    bool Init(int resolution = 2048, int cascadeCount = MaxCascades);
+    void Shutdown();
+
+    // fits the cascades to the camera frustum and decides which of them are due this frame. lightDirection points
+    // from the light into the scene (world space).
+    void Update(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, const glm::vec3& lightDirection);
+
+    // renders the due cascades. drawCasters binds its depth shader, draws the casters intersecting the cascade frustum
+    // with lightViewProjection and returns the number of draw calls it made. Each cascade is a GPU profiler marker
+    // ("Shadow Cascade N") below the caller's marker. Leaves the framebuffer and viewport as they were.
+    void Render(const std::function<size_t(int cascade, const glm::mat4& lightViewProjection, const Frustum& cascadeFrustum)>& drawCasters);
+
+    // sets the lighting shader's shadow uniforms and binds the array to the texture unit. view must be the matrix
+    // of the current frame, the shader gets view space to light space matrices to go with its view space positions.
+    void Bind(Shader& shader, int textureUnit, const glm::mat4& view) const;
+
+    int GetCascadeCount() const { return CascadeCount; }
+    int GetResolution() const { return Resolution; }
+    float GetSplitDistance(int cascade) const { return SplitFar[cascade]; }
+    GLuint GetTexture() const { return DepthArray; }
+    const Stats& GetStats() const { return ShadowStats; }
+
+    // blend between logarithmic (1) and uniform (0) split distances
+    float SplitLambda = 0.75f;
+    // shadows end here (or at the far plane if that is closer)
+    float ShadowDistance = 50.0f;
+    // cascades from this index on are cached
+    int FirstCachedCascade = 2;
+    // cached cascades are re-rendered at least every this many frames, staggered so they don't all land on one frame
+    int CacheInterval = 4;
+    // extra radius around the cached cascades, the camera may move this fraction of it before they're re-rendered
+    float CachePadding = 0.1f;
+    // how far behind a cascade (towards the light) casters are still captured
+    float CasterDistance = 30.0f;
+    // glPolygonOffset during the depth pass
+    float DepthBiasFactor = 2.0f;
+    float DepthBiasUnits = 4.0f;
+
+private:
+
+    struct Cascade
+    {
+        glm::vec3 Center = glm::vec3(0.0f);     // world space, of the slice's bounding sphere
+        float Radius = 0.0f;
+        glm::mat4 ViewProjection = glm::mat4(1.0f);
+
+        // what the layer currently holds
+        glm::mat4 RenderedViewProjection = glm::mat4(1.0f);
+        glm::vec3 RenderedCenter = glm::vec3(0.0f);
+        float RenderedRadius = 0.0f;
+        glm::vec3 RenderedLightDirection = glm::vec3(0.0f);
+        bool bValid = false;
+        bool bDue = false;
+    };
+
+    GLuint DepthArray = 0;
+    GLuint Framebuffer = 0;
+    int Resolution = 0;
+    int CascadeCount = 0;
+    unsigned int FrameIndex = 0;
+    float SplitFar[MaxCascades] = {};
+    glm::vec3 LightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    Cascade Cascades[MaxCascades];
+    Stats ShadowStats;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "SceneGraph.h"
+
+class Model;
+
+// component types stored by the EntityRegistry. Plain data only, the behaviour lives in the systems (RenderSystems.h).
+
+// world matrix of an entity. With a scene node it is copied from the SceneGraph every frame, otherwise set directly.
+struct Transform
+{
+    glm::mat4 World = glm::mat4(1.0f);
+    // World as of the previous SyncSceneTransforms, for motion vectors
+    glm::mat4 PreviousWorld = glm::mat4(1.0f);
+    uint32_t SceneNode = SceneGraph::InvalidNode;
+};
+
+// what to draw: a loaded model, or a function drawing a built-in primitive (cube, quad)
+struct MeshRef
+{
+    Model* SourceModel = nullptr;
+    void (*DrawPrimitive)() = nullptr;
+};
+
+struct Material
+{
+    // draw lists are sorted by this, entities sharing state should share a key
+    uint32_t SortKey = 0;
+    // for geometry seen from the inside (the room cube)
+    bool bInvertedNormals = false;
+    // rendered into the shadow maps
+    bool bCastShadows = true;
+};
+
+// local space box and its world space version (updated by UpdateWorldBounds)
+struct Bounds
+{
+    glm::vec3 LocalMin = glm::vec3(-1.0f);
+    glm::vec3 LocalMax = glm::vec3(1.0f);
+    glm::vec3 WorldMin = glm::vec3(-1.0f);
+    glm::vec3 WorldMax = glm::vec3(1.0f);
+    // set when the last UpdateWorldBounds changed the world box, Swept* then covers the old and the new box
+    bool bMoved = false;
+    glm::vec3 SweptMin = glm::vec3(-1.0f);
+    glm::vec3 SweptMax = glm::vec3(1.0f);
+};
+
+enum LightType
+{
+    LIGHT_POINT,
+    LIGHT_DIRECTIONAL,
+    LIGHT_SPOT
+};
+
+// point light (Position, attenuation), directional light (Direction, pointing into the scene) or spot light (both,
+// plus the cone), world space
+struct Light
+{
+    LightType Type = LIGHT_POINT;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 Color = glm::vec3(1.0f);
+    float Linear = 0.09f;
+    float Quadratic = 0.032f;
+    // the first shadowed point light gets a dedicated cube map, the sun the cascaded shadow map
+    bool bCastShadows = false;
+
+    // lit in the lighting pass's light loop and shadowed through the ShadowAtlas (point and spot lights). These
+    // fade out at Range instead of using Linear/Quadratic.
+    bool bInAtlas = false;
+    float Range = 10.0f;
+    float InnerAngle = 20.0f;   // degrees from Direction, spot lights only
+    float OuterAngle = 30.0f;
+    // a static light keeps its cached shadow until something moves inside its range
+    bool bStatic = true;
+};
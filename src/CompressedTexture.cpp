@@ -0,0 +1,189 @@
+#include "CompressedTexture.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <sys/stat.h>
+
+#include "BlockCompression.h"
+#include "GLExtensions.h"
+#include "KTX2.h"
+#include "MipmapBuilder.h"
+#include "Trace.h"
+#include "stb_image.h"
+
+namespace
+{
+	// modification time of a file, 0 if it doesn't exist
+	long long GetFileTime(const std::string& Path)
+	{
+		struct stat Info;
+		if (stat(Path.c_str(), &Info) != 0)
+		{
+			return 0;
+		}
+		return static_cast<long long>(Info.st_mtime);
+	}
+
+	const char* GetFormatSuffix(BlockFormat Format, bool bSRGB)
+	{
+		switch (Format)
+		{
+		case BLOCK_BC1: return bSRGB ? ".bc1_srgb.ktx2" : ".bc1.ktx2";
+		case BLOCK_BC3: return bSRGB ? ".bc3_srgb.ktx2" : ".bc3.ktx2";
+		default:        return ".bc5.ktx2";
+		}
+	}
+
+	GLenum GetGLFormat(unsigned int VkFormat)
+	{
+		switch (VkFormat)
+		{
+		case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+		case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+		case 141: return GL_COMPRESSED_RG_RGTC2;
+		default:  return 0;
+		}
+	}
+
+	// decodes the source image and encodes its whole mip chain, CPU only
+	bool EncodeTexture(const std::string& Path, bool bSRGB, bool bNormalMap, KTX2Image& OutImage, BlockFormat& OutFormat)
+	{
+		GENIX_TRACE_ZONE("Encode Compressed Texture");
+		int Width, Height, NrComponents;
+		unsigned char* Data = stbi_load(Path.c_str(), &Width, &Height, &NrComponents, 4);
+		if (!Data)
+		{
+			return false;
+		}
+		BlockFormat Format = BLOCK_BC1;
+		if (bNormalMap)
+		{
+			Format = BLOCK_BC5;
+		}
+		else if (NrComponents == 4)
+		{
+			const size_t Size = static_cast<size_t>(Width) * Height * 4;
+			for (size_t i = 3; i < Size; i += 4)
+			{
+				if (Data[i] != 255)
+				{
+					Format = BLOCK_BC3;
+					break;
+				}
+			}
+		}
+
+		// filtered in linear space for sRGB color, renormalized for normal maps
+		MipChainSettings Settings;
+		Settings.Filter = bNormalMap ? MIP_FILTER_BOX : MIP_FILTER_KAISER;
+		Settings.bSRGB = bSRGB && !bNormalMap;
+		Settings.bNormalMap = bNormalMap;
+		const std::vector<MipLevel> Chain = BuildMipChain(Data, Width, Height, 4, Settings);
+		stbi_image_free(Data);
+
+		OutImage.VkFormat = GetVkFormat(Format, bSRGB && Format != BLOCK_BC5);
+		OutImage.Width = Width;
+		OutImage.Height = Height;
+		OutImage.Levels.clear();
+		for (const MipLevel& Level : Chain)
+		{
+			OutImage.Levels.push_back(CompressImage(Level.Data.data(), Level.Width, Level.Height, Format));
+		}
+		OutFormat = Format;
+		return true;
+	}
+
+	// path of the cache file, tries the formats the source could have been encoded to
+	std::string FindCacheFile(const std::string& Path, bool bSRGB, bool bNormalMap)
+	{
+		const long long SourceTime = GetFileTime(Path);
+		const BlockFormat Candidates[2] = { bNormalMap ? BLOCK_BC5 : BLOCK_BC1, bNormalMap ? BLOCK_BC5 : BLOCK_BC3 };
+		for (BlockFormat Candidate : Candidates)
+		{
+			const std::string CachePath = Path + GetFormatSuffix(Candidate, bSRGB && !bNormalMap);
+			const long long CacheTime = GetFileTime(CachePath);
+			// a cache older than its source is stale
+			if (CacheTime != 0 && CacheTime >= SourceTime)
+			{
+				return CachePath;
+			}
+		}
+		return std::string();
+	}
+}
+
+bool IsTextureCompressionSupported()
+{
+	// RGTC (BC4/BC5) is core since GL 3.0, S3TC is still an extension
+	return HasGLExtension("GL_EXT_texture_compression_s3tc");
+}
+
+unsigned int CompressedTextureFromFile(const std::string &path, bool gamma, bool normalMap, GLint wrap, size_t *outBytes)
+{
+	if (!IsTextureCompressionSupported())
+	{
+		return 0;
+	}
+	if (gamma && !normalMap && !HasGLExtension("GL_EXT_texture_sRGB"))
+	{
+		return 0;
+	}
+
+	KTX2Image Image;
+	const std::string CachePath = FindCacheFile(path, gamma, normalMap);
+	bool bCacheRead = false;
+	if (!CachePath.empty())
+	{
+		GENIX_TRACE_ZONE("Read KTX2");
+		bCacheRead = ReadKTX2(CachePath, Image);
+	}
+	if (!bCacheRead)
+	{
+		// import step: encode once, then keep the result on disk for the next run
+		BlockFormat Format;
+		if (!EncodeTexture(path, gamma, normalMap, Image, Format))
+		{
+			return 0;
+		}
+		if (!WriteKTX2(path + GetFormatSuffix(Format, gamma && !normalMap), Image))
+		{
+			std::cout << "Failed to write compressed texture cache for: " << path << std::endl;
+		}
+	}
+
+	const GLenum InternalFormat = GetGLFormat(Image.VkFormat);
+	if (InternalFormat == 0 || Image.Levels.empty())
+	{
+		return 0;
+	}
+
+	unsigned int TextureId;
+	glGenTextures(1, &TextureId);
+	glBindTexture(GL_TEXTURE_2D, TextureId);
+
+	size_t Bytes = 0;
+	int LevelWidth = Image.Width, LevelHeight = Image.Height;
+	for (size_t Level = 0; Level < Image.Levels.size(); Level++)
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(Level), InternalFormat, LevelWidth, LevelHeight, 0,
+			static_cast<GLsizei>(Image.Levels[Level].size()), Image.Levels[Level].data());
+		Bytes += Image.Levels[Level].size();
+		LevelWidth = std::max(1, LevelWidth / 2);
+		LevelHeight = std::max(1, LevelHeight / 2);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(Image.Levels.size()) - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	if (outBytes)
+	{
+		*outBytes = Bytes;
+	}
+	return TextureId;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <glad/glad.h>
+
+// true if the context can sample every block format the compressed path may pick (S3TC for color, RGTC for normals)
+bool IsTextureCompressionSupported();
+
+// loads a 2D texture through the block compressed path. On the first load the image is decoded, its mip chain is built
+// and encoded on the CPU (BC5 for normal maps, BC1 for opaque color, BC3 for color with alpha) and the result is written as
+// "<file>.<format>.ktx2" next to the source. Later loads upload that file straight away with glCompressedTexImage2D.
+// returns 0 if the texture can't go through this path, the caller is expected to fall back to TextureFromFile.
+// note: normal maps only keep x/y, shaders sampling them have to rebuild z = sqrt(1 - x*x - y*y).
+unsigned int CompressedTextureFromFile(const std::string &path, bool gamma, bool normalMap, GLint wrap = GL_REPEAT, size_t *outBytes = nullptr);
@@ -0,0 +1,106 @@
+#include "ComputeBlur.h"
+
+#include <iostream>
+
+#include "GLCapture.h"
+
+namespace
+{
+	// local_size of both compute shaders
+	const int TileSize = 16;
+
+	bool IsLinked(const Shader& Program)
+	{
+		GLint Success = 0;
+		glGetProgramiv(Program.ID, GL_LINK_STATUS, &Success);
+		return Success != 0;
+	}
+
+	void DeleteProgram(std::unique_ptr<Shader>& Program)
+	{
+		if (Program)
+		{
+			glDeleteProgram(Program->ID);
+			Program.reset();
+		}
+	}
+}
+
+ComputeBlur::~ComputeBlur()
+{
+	Shutdown();
+}
+
+bool ComputeBlur::Init()
+{
+	Shutdown();
+	// the shaders are #version 430, so the ARB extensions on a 3.3 context aren't enough
+	if (!HasGLVersion(4, 3))
+	{
+		return false;
+	}
+	// the dispatch, image binding and barrier entry points aren't traced, a replay of the capture would miss the blur.
+	// Callers fall back to the fragment passes.
+	if (GLCapture::Get().IsRecording())
+	{
+		return false;
+	}
+
+	DispatchCompute = reinterpret_cast<PFNGLDISPATCHCOMPUTEPROC>(LoadGLFunction("glDispatchCompute"));
+	ImageBarrier = reinterpret_cast<PFNGLMEMORYBARRIERPROC>(LoadGLFunction("glMemoryBarrier"));
+	BindImageTexture = reinterpret_cast<PFNGLBINDIMAGETEXTUREPROC>(LoadGLFunction("glBindImageTexture"));
+	if (!DispatchCompute || !ImageBarrier || !BindImageTexture)
+	{
+		std::cout << "ERROR::COMPUTE_BLUR:: Compute entry points missing" << std::endl;
+		return false;
+	}
+
+	SSAOBlurShader.reset(new Shader("Shaders/SSAO_Blur.comp"));
+	GaussianShader.reset(new Shader("Shaders/Blur.comp"));
+	if (!IsLinked(*SSAOBlurShader) || !IsLinked(*GaussianShader))
+	{
+		Shutdown();
+		return false;
+	}
+	SSAOBlurShader->Use();
+	SSAOBlurShader->SetInt("ssaoInput", 0);
+	GaussianShader->Use();
+	GaussianShader->SetInt("image", 0);
+	bSupported = true;
+	return true;
+}
+
+void ComputeBlur::Shutdown()
+{
+	DeleteProgram(SSAOBlurShader);
+	DeleteProgram(GaussianShader);
+	bSupported = false;
+}
+
+void ComputeBlur::BlurSSAO(GLuint input, GLuint output, int width, int height)
+{
+	if (bSupported)
+	{
+		Dispatch(*SSAOBlurShader, input, output, GL_R16F, width, height);
+	}
+}
+
+void ComputeBlur::BlurGaussian(GLuint input, GLuint output, int width, int height)
+{
+	if (bSupported)
+	{
+		Dispatch(*GaussianShader, input, output, GL_RGBA16F, width, height);
+	}
+}
+
+void ComputeBlur::Dispatch(Shader& program, GLuint input, GLuint output, GLenum format, int width, int height)
+{
+	program.Use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, input);
+	BindImageTexture(0, output, 0, GL_FALSE, 0, GL_WRITE_ONLY, format);
+	DispatchCompute((width + TileSize - 1) / TileSize, (height + TileSize - 1) / TileSize, 1);
+	// image stores aren't coherent with later texture fetches or image loads until a barrier says so
+	ImageBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	BlurStats.Dispatches++;
+}
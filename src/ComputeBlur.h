@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+#include "Shader.h"
+
+// compute versions of SSAO_Blur.frag and Blur.frag. A work group loads its 16x16 tile plus the filter's apron into
+// shared memory once and runs the horizontal and vertical pass from there, so every texel is fetched about once
+// instead of once per tap, and the separable Gaussian writes its result once instead of once per direction.
+// Needs a GL 4.3 context (most drivers return their newest core version for the 3.3 request), callers keep the fragment passes as fallback.
+class ComputeBlur
+{
+public:
+
+    struct Stats
+    {
+        size_t Dispatches = 0;      // since the last ResetStats
+    };
+
+    ComputeBlur() = default;
+    ~ComputeBlur();
+
+    ComputeBlur(const ComputeBlur&) = delete;
+    ComputeBlur& operator=(const ComputeBlur&) = delete;
+
+    // false if the context can't run compute shaders or a GL capture is recording, the blurs then do nothing
+    bool Init();
+    void Shutdown();
+
+    bool IsSupported() const { return bSupported; }
+
+    // the 4x4 box of SSAO_Blur.frag from input (any format, sampled with texelFetch) into output, which must be R16F
+    void BlurSSAO(GLuint input, GLuint output, int width, int height);
+
+    // one horizontal plus one vertical pass of Blur.frag from input into output, which must be RGBA16F
+    void BlurGaussian(GLuint input, GLuint output, int width, int height);
+
+    const Stats& GetStats() const { return BlurStats; }
+    void ResetStats() { BlurStats = Stats(); }
+
+private:
+
+    void Dispatch(Shader& program, GLuint input, GLuint output, GLenum format, int width, int height);
+
+    bool bSupported = false;
+    PFNGLDISPATCHCOMPUTEPROC DispatchCompute = nullptr;
+    PFNGLMEMORYBARRIERPROC ImageBarrier = nullptr;   // glMemoryBarrier (MemoryBarrier is a macro in winnt.h)
+    PFNGLBINDIMAGETEXTUREPROC BindImageTexture = nullptr;
+    std::unique_ptr<Shader> SSAOBlurShader;
+    std::unique_ptr<Shader> GaussianShader;
+    Stats BlurStats;
+};
@@ -0,0 +1,67 @@
+#include "Culling.h"
+
+#include <cmath>
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	// Gribb/Hartmann: each plane is the fourth row plus or minus one of the others (glm is column major, so rows are gathered by hand)
+	const glm::mat4& M = viewProjection;
+	const glm::vec4 Row0(M[0][0], M[1][0], M[2][0], M[3][0]);
+	const glm::vec4 Row1(M[0][1], M[1][1], M[2][1], M[3][1]);
+	const glm::vec4 Row2(M[0][2], M[1][2], M[2][2], M[3][2]);
+	const glm::vec4 Row3(M[0][3], M[1][3], M[2][3], M[3][3]);
+
+	Frustum Result;
+	Result.Planes[0] = Row3 + Row0;     // left
+	Result.Planes[1] = Row3 - Row0;     // right
+	Result.Planes[2] = Row3 + Row1;     // bottom
+	Result.Planes[3] = Row3 - Row1;     // top
+	Result.Planes[4] = Row3 + Row2;     // near
+	Result.Planes[5] = Row3 - Row2;     // far
+	for (glm::vec4& Plane : Result.Planes)
+	{
+		Plane /= glm::length(glm::vec3(Plane));
+	}
+	return Result;
+}
+
+bool Frustum::IntersectsAABB(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+	for (const glm::vec4& Plane : Planes)
+	{
+		// the box corner furthest along the plane normal
+		const glm::vec3 Positive(Plane.x >= 0.0f ? boxMax.x : boxMin.x, Plane.y >= 0.0f ? boxMax.y : boxMin.y, Plane.z >= 0.0f ? boxMax.z : boxMin.z);
+		if (glm::dot(glm::vec3(Plane), Positive) + Plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+Frustum Frustum::ToLocalSpace(const glm::mat4& toWorld) const
+{
+	// a world point is toWorld * p, so plane . (toWorld * p) = (transpose(toWorld) * plane) . p
+	const glm::mat4 Transposed = glm::transpose(toWorld);
+	Frustum Result;
+	for (int i = 0; i < 6; i++)
+	{
+		Result.Planes[i] = Transposed * Planes[i];
+	}
+	return Result;
+}
+
+void TransformAABB(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& transform, glm::vec3& outMin, glm::vec3& outMax)
+{
+	// Arvo: transform the center, the extents grow by the absolute value of the rotation/scale part
+	const glm::vec3 Center = (boxMin + boxMax) * 0.5f;
+	const glm::vec3 Extents = (boxMax - boxMin) * 0.5f;
+	const glm::vec3 NewCenter = glm::vec3(transform * glm::vec4(Center, 1.0f));
+	glm::vec3 NewExtents(0.0f);
+	for (int Column = 0; Column < 3; Column++)
+	{
+		NewExtents += glm::abs(glm::vec3(transform[Column])) * Extents[Column];
+	}
+	outMin = NewCenter - NewExtents;
+	outMax = NewCenter + NewExtents;
+}
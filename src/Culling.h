@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct AABB
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+};
+
+// view frustum as six inward facing planes (xyz normal, w distance), extracted from a view projection matrix
+struct Frustum
+{
+    glm::vec4 Planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+    // conservative: boxes crossing a corner region just outside the frustum still count as visible
+    bool IntersectsAABB(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    // the same frustum expressed in the space that toWorld maps into world space (e.g. a model's local space)
+    Frustum ToLocalSpace(const glm::mat4& toWorld) const;
+};
+
+// axis aligned box enclosing the box (boxMin, boxMax) after transform
+void TransformAABB(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& transform, glm::vec3& outMin, glm::vec3& outMax);
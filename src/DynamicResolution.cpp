@@ -0,0 +1,68 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool DynamicResolution::Update(const Profiler::Frame& frame)
+{
+	if (!bEnabled)
+	{
+		WindowCount = 0;
+		WindowGpuMs = 0.0;
+		return SetScale(1.0f);
+	}
+	if (frame.GpuMs <= 0.0 || (bHasFrame && frame.Index == LastFrameIndex))
+	{
+		return false;
+	}
+	bHasFrame = true;
+	LastFrameIndex = frame.Index;
+	if (FramesToSkip > 0)
+	{
+		FramesToSkip--;
+		return false;
+	}
+	WindowGpuMs += frame.GpuMs;
+	if (++WindowCount < std::max(WindowFrames, 1))
+	{
+		return false;
+	}
+
+	const double AverageMs = WindowGpuMs / WindowCount;
+	ResolutionStats.AverageGpuMs = AverageMs;
+	WindowCount = 0;
+	WindowGpuMs = 0.0;
+
+	// the scale that would put the frame in the middle of the band, rounded down to a step
+	const double TargetMs = BudgetMs * 0.5 * (DecreaseAbove + IncreaseBelow);
+	const float Step = std::max(ScaleStep, 0.01f);
+	const float Ideal = Scale * static_cast<float>(std::sqrt(TargetMs / AverageMs));
+	const float Quantized = std::floor(Ideal / Step + 1e-3f) * Step;
+	if (AverageMs > BudgetMs * DecreaseAbove)
+	{
+		return SetScale(std::min(Quantized, Scale - Step));
+	}
+	if (AverageMs < BudgetMs * IncreaseBelow && Quantized > Scale)
+	{
+		return SetScale(Quantized);
+	}
+	return false;
+}
+
+int DynamicResolution::GetScaledSize(int outputSize) const
+{
+	return std::max(1, static_cast<int>(std::lround(outputSize * Scale)));
+}
+
+bool DynamicResolution::SetScale(float NewScale)
+{
+	NewScale = std::min(std::max(NewScale, std::min(MinScale, 1.0f)), 1.0f);
+	if (std::abs(NewScale - Scale) < 1e-4f)
+	{
+		return false;
+	}
+	Scale = NewScale;
+	FramesToSkip = SettleFrames;
+	ResolutionStats.ScaleChanges++;
+	return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Profiler.h"
+
+// picks the scale of the internal render resolution that keeps the GPU frame time inside a budget, from the frame
+// times the Profiler reads back. Frames are averaged over a window, then the scale moves to where the time would
+// land in the middle of the band between IncreaseBelow and DecreaseAbove, assuming it is proportional to the pixel
+// count. Inside the band nothing changes, and after a change the frames still in flight at the old size are skipped,
+// so the scale doesn't oscillate around the budget. Scales are multiples of ScaleStep, which also bounds how often the
+// scaled targets get reallocated.
+class DynamicResolution
+{
+public:
+
+    struct Stats
+    {
+        double AverageGpuMs = 0.0;      // of the last complete window
+        int ScaleChanges = 0;
+    };
+
+    DynamicResolution() = default;
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // feeds the newest profiled frame (Profiler::GetLastFrame), frames already seen are ignored. True when the scale
+    // changed and the scaled targets have to be resized.
+    bool Update(const Profiler::Frame& frame);
+
+    float GetScale() const { return Scale; }
+
+    // a dimension of the scaled targets for the output's, at least 1
+    int GetScaledSize(int outputSize) const;
+
+    const Stats& GetStats() const { return ResolutionStats; }
+
+    // off holds the scale at 1
+    bool bEnabled = true;
+    double BudgetMs = 1000.0 / 60.0;
+    // hysteresis band, fractions of the budget
+    double DecreaseAbove = 1.0;
+    double IncreaseBelow = 0.8;
+    float MinScale = 0.5f;
+    float ScaleStep = 0.05f;
+    // frames per averaging window
+    int WindowFrames = 16;
+    // frames ignored after a change: more than the Profiler's read back latency, so none of them ran at the old size
+    int SettleFrames = 6;
+
+private:
+
+    bool SetScale(float NewScale);
+
+    float Scale = 1.0f;
+    bool bHasFrame = false;
+    unsigned long long LastFrameIndex = 0;
+    int FramesToSkip = 0;
+    int WindowCount = 0;
+    double WindowGpuMs = 0.0;
+    Stats ResolutionStats;
+};
@@ -0,0 +1,155 @@
+#include "DynamicRingBuffer.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "GLCapture.h"
+#include "GLExtensions.h"
+
+DynamicRingBuffer::~DynamicRingBuffer()
+{
+	Shutdown();
+}
+
+bool DynamicRingBuffer::Init(GLenum target, size_t frameBytes, unsigned int frameCount)
+{
+	Shutdown();
+
+	Target = target;
+	FrameBytes = frameBytes;
+	Fences.assign(frameCount > 0 ? frameCount : 1, nullptr);
+	Frame = 0;
+	Head = 0;
+	RingStats = Stats();
+
+	GLint Alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &Alignment);
+	UniformAlignment = Alignment > 0 ? static_cast<size_t>(Alignment) : 256;
+
+	const GLsizeiptr TotalBytes = static_cast<GLsizeiptr>(FrameBytes * Fences.size());
+	glGenBuffers(1, &Buffer);
+	glBindBuffer(Target, Buffer);
+
+	// a persistent mapping is never unmapped, so a GL capture could not see what is written to it
+	PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;
+	if ((HasGLVersion(4, 4) || HasGLExtension("GL_ARB_buffer_storage")) && !GLCapture::Get().IsRecording())
+	{
+		BufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(LoadGLFunction("glBufferStorage"));
+	}
+	if (BufferStorage)
+	{
+		const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		BufferStorage(Target, TotalBytes, nullptr, Flags);
+		Mapped = static_cast<unsigned char*>(glMapBufferRange(Target, 0, TotalBytes, Flags));
+	}
+	if (!Mapped)
+	{
+		// plain GL 3.3: mutable storage, mapped per Upload
+		glBufferData(Target, TotalBytes, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(Target, 0);
+	return Buffer != 0;
+}
+
+void DynamicRingBuffer::Shutdown()
+{
+	for (GLsync& Fence : Fences)
+	{
+		if (Fence)
+		{
+			glDeleteSync(Fence);
+			Fence = nullptr;
+		}
+	}
+	if (Buffer)
+	{
+		if (Mapped)
+		{
+			glBindBuffer(Target, Buffer);
+			glUnmapBuffer(Target);
+			glBindBuffer(Target, 0);
+			Mapped = nullptr;
+		}
+		glDeleteBuffers(1, &Buffer);
+		Buffer = 0;
+	}
+}
+
+void DynamicRingBuffer::BeginFrame()
+{
+	if (!Buffer)
+	{
+		return;
+	}
+	Frame = (Frame + 1) % Fences.size();
+	Head = 0;
+
+	GLsync& Fence = Fences[Frame];
+	if (Fence)
+	{
+		if (glClientWaitSync(Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			// the CPU is FrameCount frames ahead, nothing to do but wait
+			const auto Start = std::chrono::steady_clock::now();
+			while (glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+			RingStats.FenceWaits++;
+			RingStats.WaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		}
+		glDeleteSync(Fence);
+		Fence = nullptr;
+	}
+}
+
+void DynamicRingBuffer::EndFrame()
+{
+	if (!Buffer)
+	{
+		return;
+	}
+	Fences[Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	RingStats.BytesLastFrame = Head;
+	if (Head > RingStats.PeakFrameBytes)
+	{
+		RingStats.PeakFrameBytes = Head;
+	}
+}
+
+DynamicRingBuffer::Allocation DynamicRingBuffer::Upload(const void* data, size_t bytes, size_t alignment)
+{
+	Allocation Result;
+	const size_t Start = alignment > 1 ? (Head + alignment - 1) / alignment * alignment : Head;
+	if (!Buffer || Start + bytes > FrameBytes)
+	{
+		RingStats.Overflows++;
+		return Result;
+	}
+
+	const size_t Offset = Frame * FrameBytes + Start;
+	if (Mapped)
+	{
+		std::memcpy(Mapped + Offset, data, bytes);
+	}
+	else
+	{
+		// the fence waited on in BeginFrame already guarantees the range is idle
+		glBindBuffer(Target, Buffer);
+		void* Range = glMapBufferRange(Target, static_cast<GLintptr>(Offset), static_cast<GLsizeiptr>(bytes),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (!Range)
+		{
+			glBindBuffer(Target, 0);
+			return Result;
+		}
+		std::memcpy(Range, data, bytes);
+		glUnmapBuffer(Target);
+		glBindBuffer(Target, 0);
+	}
+
+	Head = Start + bytes;
+	Result.Buffer = Buffer;
+	Result.Offset = static_cast<GLintptr>(Offset);
+	Result.Size = static_cast<GLsizeiptr>(bytes);
+	return Result;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+// per frame dynamic data (transforms, instance data, uniform block chunks) without driver synchronization.
+// one buffer is split into FrameCount regions, each frame sub-allocates linearly from its own region and a fence set in
+// EndFrame tells when the GPU is done with it, so writing is a plain memcpy into memory the GPU isn't reading.
+// with GL 4.4 / ARB_buffer_storage the buffer stays persistently mapped (coherent), otherwise every Upload maps its range
+// with GL_MAP_UNSYNCHRONIZED_BIT, which is safe for the same reason.
+// must only be used from the thread owning the GL context.
+class DynamicRingBuffer
+{
+public:
+
+    // a sub range of the buffer, bind it with glBindBufferRange or use Offset as attribute/index offset
+    struct Allocation
+    {
+        GLuint Buffer = 0;
+        GLintptr Offset = 0;
+        GLsizeiptr Size = 0;
+
+        bool IsValid() const { return Buffer != 0; }
+    };
+
+    struct Stats
+    {
+        size_t BytesLastFrame = 0;      // bytes allocated by the last finished frame
+        size_t PeakFrameBytes = 0;      // most bytes a frame has used so far
+        size_t Overflows = 0;           // allocations that didn't fit into the frame region
+        size_t FenceWaits = 0;          // BeginFrames that had to wait for the GPU
+        double WaitMs = 0.0;            // total time spent in those waits
+    };
+
+    DynamicRingBuffer() = default;
+    ~DynamicRingBuffer();
+
+    DynamicRingBuffer(const DynamicRingBuffer&) = delete;
+    DynamicRingBuffer& operator=(const DynamicRingBuffer&) = delete;
+
+    // target is only used for binding while creating/mapping (GL_UNIFORM_BUFFER, GL_ARRAY_BUFFER, ...)
+    bool Init(GLenum target, size_t frameBytes, unsigned int frameCount = 3);
+    void Shutdown();
+
+    bool IsPersistent() const { return Mapped != nullptr; }
+
+    // moves to the next region, waiting for the GPU if it still reads from it
+    void BeginFrame();
+
+    // fences the region of this frame
+    void EndFrame();
+
+    // copies Bytes into the current frame region at an offset aligned to Alignment (e.g. GetUniformAlignment()).
+    // returns an invalid Allocation if the region is full, the caller has to fall back to a regular upload then.
+    Allocation Upload(const void* data, size_t bytes, size_t alignment = 16);
+
+    GLuint GetBuffer() const { return Buffer; }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, offsets passed to glBindBufferRange for uniform blocks need it
+    size_t GetUniformAlignment() const { return UniformAlignment; }
+
+    const Stats& GetStats() const { return RingStats; }
+
+private:
+
+    GLenum Target = 0;
+    GLuint Buffer = 0;
+    unsigned char* Mapped = nullptr;    // persistent mapping of the whole buffer, null in fallback mode
+    size_t FrameBytes = 0;
+    size_t UniformAlignment = 256;
+    std::vector<GLsync> Fences;         // one per region
+    unsigned int Frame = 0;             // current region
+    size_t Head = 0;                    // next free byte in the current region
+    Stats RingStats;
+};
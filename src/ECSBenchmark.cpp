@@ -0,0 +1,143 @@
+#include "ECSBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "EntityRegistry.h"
+#include "JobSystem.h"
+#include "RenderSystems.h"
+
+namespace
+{
+	const float SceneExtent = 100.0f;
+	const uint32_t MaterialCount = 16;
+
+	void DrawNothing()
+	{
+	}
+
+	// one untimed call first, so page faults and first touch effects stay out of the average
+	template <typename Func>
+	double AverageMs(int Iterations, Func Body)
+	{
+		Body();
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < Iterations; i++)
+		{
+			Body();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / Iterations;
+	}
+
+	void PrintTiming(const char* Name, double Ms, size_t Count, const char* What)
+	{
+		std::cout << std::left << std::setw(22) << Name << std::right << std::fixed << std::setprecision(3) << std::setw(10) << Ms << " ms"
+			<< std::setw(10) << Count << " " << What << std::endl;
+	}
+
+	std::vector<Entity> SortedIds(const std::vector<DrawItem>& Items)
+	{
+		std::vector<Entity> Ids;
+		Ids.reserve(Items.size());
+		for (const DrawItem& Item : Items)
+		{
+			Ids.push_back(Item.Id);
+		}
+		std::sort(Ids.begin(), Ids.end());
+		return Ids;
+	}
+}
+
+bool RunECSBenchmark(int entityCount, int iterations)
+{
+	entityCount = std::max(entityCount, 1);
+	iterations = std::max(iterations, 1);
+	std::cout << "ECS benchmark, " << entityCount << " entities, " << iterations << " iterations, "
+		<< JobSystem::Get().GetThreadCount() << " threads" << std::endl;
+
+	std::default_random_engine Generator;
+	std::uniform_real_distribution<float> Position(-SceneExtent, SceneExtent);
+	std::uniform_real_distribution<float> Size(0.2f, 2.0f);
+	std::uniform_real_distribution<float> Angle(0.0f, 6.2831853f);
+	EntityRegistry Registry;
+	for (int i = 0; i < entityCount; i++)
+	{
+		const Entity Current = Registry.Create();
+		Transform Placement;
+		Placement.World = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(Position(Generator), Position(Generator), Position(Generator))),
+			Angle(Generator), glm::vec3(0.0f, 1.0f, 0.0f));
+		Registry.Add<Transform>(Current, Placement);
+		MeshRef Mesh;
+		Mesh.DrawPrimitive = DrawNothing;
+		Registry.Add<MeshRef>(Current, Mesh);
+		Material Surface;
+		Surface.SortKey = static_cast<uint32_t>(i) % MaterialCount;
+		Registry.Add<Material>(Current, Surface);
+		// some entities without bounds, those are never culled
+		if (i % 8 != 7)
+		{
+			Bounds Box;
+			Box.LocalMax = glm::vec3(Size(Generator), Size(Generator), Size(Generator));
+			Box.LocalMin = -Box.LocalMax;
+			Registry.Add<Bounds>(Current, Box);
+		}
+	}
+
+	// the same write through both iterations, every entity with both components must be visited exactly once
+	std::vector<uint8_t> Visits[2];
+	for (std::vector<uint8_t>& Visited : Visits)
+	{
+		Visited.assign(entityCount, 0);
+	}
+	const double ForEachMs = AverageMs(iterations, [&]()
+	{
+		Registry.ForEach<Bounds, Transform>([&](Entity Current, Bounds& Box, Transform& Placement)
+		{
+			Box.SweptMax = glm::vec3(Placement.World[3]);
+			Visits[0][GetEntityIndex(Current)]++;
+		});
+	});
+	const double ParallelForEachMs = AverageMs(iterations, [&]()
+	{
+		Registry.ParallelForEach<Bounds, Transform>([&](Entity Current, Bounds& Box, Transform& Placement)
+		{
+			Box.SweptMax = glm::vec3(Placement.World[3]);
+			Visits[1][GetEntityIndex(Current)]++;
+		});
+	});
+	const bool bSameVisits = Visits[0] == Visits[1];
+	const size_t Visited = Registry.GetPool<Bounds>().Size();
+
+	// the transforms don't change between iterations, so only the untimed first call moves boxes
+	const double BoundsMs = AverageMs(iterations, [&]() { UpdateWorldBounds(Registry); });
+
+	// a camera in the middle of the scene sees a small part of it, which is where the tree pays off
+	const glm::mat4 Projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 0.5f * SceneExtent);
+	const glm::mat4 View = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const Frustum CameraFrustum = Frustum::FromMatrix(Projection * View);
+
+	std::vector<DrawItem> BruteForce;
+	size_t Culled = 0;
+	const double BruteForceMs = AverageMs(iterations, [&]() { Culled = BuildDrawList(Registry, CameraFrustum, BruteForce); });
+
+	SceneBVH SceneTree;
+	const double BuildTreeMs = AverageMs(1, [&]() { BuildSceneBVH(Registry, SceneTree); });
+	std::vector<DrawItem> WithTree;
+	const double WithTreeMs = AverageMs(iterations, [&]() { BuildDrawList(Registry, CameraFrustum, WithTree, &SceneTree); });
+	const bool bSameDrawList = SortedIds(BruteForce) == SortedIds(WithTree);
+
+	PrintTiming("ForEach", ForEachMs, Visited, "entities");
+	PrintTiming("ParallelForEach", ParallelForEachMs, Visited, "entities");
+	PrintTiming("UpdateWorldBounds", BoundsMs, Visited, "boxes");
+	PrintTiming("BuildDrawList", BruteForceMs, BruteForce.size(), "drawn");
+	PrintTiming("BuildSceneBVH", BuildTreeMs, SceneTree.Tree.GetNodeCount(), "nodes");
+	PrintTiming("BuildDrawList (BVH)", WithTreeMs, WithTree.size(), "drawn");
+	std::cout << Culled << " culled, iteration visits " << (bSameVisits ? "identical" : "DIFFER")
+		<< ", draw lists " << (bSameDrawList ? "identical" : "DIFFER") << std::endl;
+	return bSameVisits && bSameDrawList;
+}
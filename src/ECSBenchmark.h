@@ -0,0 +1,8 @@
+#pragma once
+
+// fills an EntityRegistry with entityCount entities scattered through a 200 unit cube (Transform, MeshRef, Material,
+// and Bounds on all but every eighth) and times, averaged over iterations: a two component ForEach and the same
+// ParallelForEach, UpdateWorldBounds, and BuildDrawList against a camera frustum both brute force and through a
+// SceneBVH. Checks that both iterations visit the same entities and both draw lists hold the same ones. CPU only, no
+// GL context needed. Returns false if anything differs.
+bool RunECSBenchmark(int entityCount, int iterations);
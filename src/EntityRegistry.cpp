@@ -0,0 +1,40 @@
+#include "EntityRegistry.h"
+
+Entity EntityRegistry::Create()
+{
+	uint32_t Index;
+	if (!FreeIndices.empty())
+	{
+		Index = FreeIndices.back();
+		FreeIndices.pop_back();
+	}
+	else
+	{
+		Index = static_cast<uint32_t>(Generations.size());
+		Generations.push_back(0);
+	}
+	return (static_cast<uint32_t>(Generations[Index]) << 24) | Index;
+}
+
+void EntityRegistry::Destroy(Entity entity)
+{
+	if (!IsAlive(entity))
+	{
+		return;
+	}
+	GetPool<Transform>().Remove(entity);
+	GetPool<MeshRef>().Remove(entity);
+	GetPool<Material>().Remove(entity);
+	GetPool<Bounds>().Remove(entity);
+	GetPool<Light>().Remove(entity);
+
+	const uint32_t Index = GetEntityIndex(entity);
+	Generations[Index]++;
+	FreeIndices.push_back(Index);
+}
+
+bool EntityRegistry::IsAlive(Entity entity) const
+{
+	const uint32_t Index = GetEntityIndex(entity);
+	return entity != NullEntity && Index < Generations.size() && Generations[Index] == GetEntityGeneration(entity);
+}
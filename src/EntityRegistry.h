@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Components.h"
+#include "JobSystem.h"
+
+// 24 bit index + 8 bit generation, a destroyed entity's handle stops matching once its index is reused
+using Entity = uint32_t;
+
+const Entity NullEntity = 0xFFFFFFFFu;
+
+inline uint32_t GetEntityIndex(Entity entity) { return entity & 0x00FFFFFFu; }
+inline uint32_t GetEntityGeneration(Entity entity) { return entity >> 24; }
+
+// sparse set: Sparse maps an entity index to a slot in the packed Dense/Data arrays. Iteration walks the packed
+// arrays only, removal swaps the last element into the hole so they stay packed.
+template <typename T>
+class ComponentPool
+{
+public:
+
+    T& Add(Entity entity, const T& value)
+    {
+        const uint32_t Index = GetEntityIndex(entity);
+        if (Index >= Sparse.size())
+        {
+            Sparse.resize(Index + 1, InvalidSlot);
+        }
+        if (Sparse[Index] != InvalidSlot && Dense[Sparse[Index]] == entity)
+        {
+            return Data[Sparse[Index]] = value;
+        }
+        Sparse[Index] = static_cast<uint32_t>(Dense.size());
+        Dense.push_back(entity);
+        Data.push_back(value);
+        return Data.back();
+    }
+
+    void Remove(Entity entity)
+    {
+        if (!Has(entity))
+        {
+            return;
+        }
+        const uint32_t Slot = Sparse[GetEntityIndex(entity)];
+        const uint32_t Last = static_cast<uint32_t>(Dense.size()) - 1;
+        if (Slot != Last)
+        {
+            Dense[Slot] = Dense[Last];
+            Data[Slot] = std::move(Data[Last]);
+            Sparse[GetEntityIndex(Dense[Slot])] = Slot;
+        }
+        Dense.pop_back();
+        Data.pop_back();
+        Sparse[GetEntityIndex(entity)] = InvalidSlot;
+    }
+
+    bool Has(Entity entity) const
+    {
+        const uint32_t Index = GetEntityIndex(entity);
+        return Index < Sparse.size() && Sparse[Index] != InvalidSlot && Dense[Sparse[Index]] == entity;
+    }
+
+    T* Get(Entity entity)
+    {
+        return Has(entity) ? &Data[Sparse[GetEntityIndex(entity)]] : nullptr;
+    }
+
+    size_t Size() const { return Dense.size(); }
+    const std::vector<Entity>& GetEntities() const { return Dense; }
+    std::vector<T>& GetData() { return Data; }
+
+private:
+
+    static const uint32_t InvalidSlot = 0xFFFFFFFFu;
+
+    std::vector<uint32_t> Sparse;
+    std::vector<Entity> Dense;
+    std::vector<T> Data;
+};
+
+template <typename T>
+const uint32_t ComponentPool<T>::InvalidSlot;
+
+// owns the entities and one ComponentPool per component type (Components.h).
+// not thread safe for structural changes (Create/Destroy/Add/Remove), ParallelForEach may only modify component values.
+class EntityRegistry
+{
+public:
+
+    Entity Create();
+
+    // removes the entity's components and recycles its index
+    void Destroy(Entity entity);
+
+    bool IsAlive(Entity entity) const;
+    size_t GetAliveCount() const { return Generations.size() - FreeIndices.size(); }
+
+    template <typename T>
+    T& Add(Entity entity, const T& value = T()) { return GetPool<T>().Add(entity, value); }
+
+    template <typename T>
+    void Remove(Entity entity) { GetPool<T>().Remove(entity); }
+
+    template <typename T>
+    T* Get(Entity entity) { return GetPool<T>().Get(entity); }
+
+    template <typename T>
+    bool Has(Entity entity) const { return std::get<ComponentPool<T>>(Pools).Has(entity); }
+
+    template <typename T>
+    ComponentPool<T>& GetPool() { return std::get<ComponentPool<T>>(Pools); }
+
+    // calls func(Entity, First&, Rest&...) for every entity owning all the listed components. Walks First's packed
+    // array, so list the rarest component first.
+    template <typename First, typename... Rest, typename Func>
+    void ForEach(Func func)
+    {
+        ForEachInRange<First, Rest...>(func, 0, GetPool<First>().Size());
+    }
+
+    // ForEach split over the JobSystem in chunks of grain entities. func runs concurrently and must only touch the
+    // components it is handed (or its own per entity output slot).
+    template <typename First, typename... Rest, typename Func>
+    void ParallelForEach(Func func, size_t grain = 1024)
+    {
+        JobSystem::Get().ParallelFor(GetPool<First>().Size(), [&](size_t Begin, size_t End)
+        {
+            ForEachInRange<First, Rest...>(func, Begin, End);
+        }, grain);
+    }
+
+    // ForEach over the packed slots [begin, end) of First's pool
+    template <typename First, typename... Rest, typename Func>
+    void ForEachInRange(Func& func, size_t begin, size_t end)
+    {
+        ComponentPool<First>& Pool = GetPool<First>();
+        const std::vector<Entity>& Entities = Pool.GetEntities();
+        std::vector<First>& Data = Pool.GetData();
+        for (size_t i = begin; i < end; i++)
+        {
+            const Entity Current = Entities[i];
+            Invoke(func, Current, Data[i], GetPool<Rest>().Get(Current)...);
+        }
+    }
+
+private:
+
+    template <typename Func, typename First, typename... Rest>
+    static void Invoke(Func& func, Entity entity, First& first, Rest*... rest)
+    {
+        if (AllPresent(rest...))
+        {
+            func(entity, first, *rest...);
+        }
+    }
+
+    static bool AllPresent() { return true; }
+
+    template <typename T, typename... Rest>
+    static bool AllPresent(const T* first, const Rest*... rest) { return first != nullptr && AllPresent(rest...); }
+
+    // generation of every index ever handed out, FreeIndices are the destroyed ones waiting for reuse
+    std::vector<uint8_t> Generations;
+    std::vector<uint32_t> FreeIndices;
+
+    std::tuple<ComponentPool<Transform>, ComponentPool<MeshRef>, ComponentPool<Material>, ComponentPool<Bounds>, ComponentPool<Light>> Pools;
+};
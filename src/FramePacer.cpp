@@ -0,0 +1,132 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr size_t FramePacer::HistorySize;
+
+FramePacer::~FramePacer()
+{
+	Shutdown();
+}
+
+void FramePacer::Init(unsigned int maxFramesInFlight, double simulationStep)
+{
+	Shutdown();
+	MaxFramesInFlight = std::max(1u, maxFramesInFlight);
+	SimulationStep = simulationStep > 0.0 ? simulationStep : 1.0 / 120.0;
+	Accumulator = 0.0;
+	bStarted = false;
+	bHasPresented = false;
+	PresentIntervals.clear();
+	PacerStats = Stats();
+}
+
+void FramePacer::Shutdown()
+{
+	for (FrameFence& Frame : InFlight)
+	{
+		glDeleteSync(Frame.Fence);
+	}
+	InFlight.clear();
+}
+
+int FramePacer::BeginFrame()
+{
+	RetireFinishedFrames();
+
+	// a full queue means the CPU is ahead, block on the oldest frame
+	PacerStats.WaitMs = 0.0;
+	if (InFlight.size() >= MaxFramesInFlight)
+	{
+		const Clock::time_point WaitStart = Clock::now();
+		while (InFlight.size() >= MaxFramesInFlight)
+		{
+			while (glClientWaitSync(InFlight.front().Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+			RetireFinishedFrames();
+		}
+		PacerStats.FenceWaits++;
+		PacerStats.WaitMs = std::chrono::duration<double, std::milli>(Clock::now() - WaitStart).count();
+	}
+	PacerStats.FramesInFlight = InFlight.size();
+
+	// the simulation consumes the real elapsed time in fixed slices
+	FrameStart = Clock::now();
+	if (!bStarted)
+	{
+		LastBegin = FrameStart;
+		bStarted = true;
+	}
+	Accumulator += std::chrono::duration<double>(FrameStart - LastBegin).count();
+	LastBegin = FrameStart;
+
+	int Steps = static_cast<int>(Accumulator / SimulationStep);
+	if (Steps > MaxSimulationSteps)
+	{
+		PacerStats.DroppedSimulationSteps += Steps - MaxSimulationSteps;
+		Steps = MaxSimulationSteps;
+		Accumulator = 0.0;
+	}
+	else
+	{
+		Accumulator -= Steps * SimulationStep;
+	}
+	return Steps;
+}
+
+void FramePacer::EndFrame()
+{
+	InFlight.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), FrameStart });
+}
+
+void FramePacer::MarkPresent()
+{
+	const Clock::time_point Now = Clock::now();
+	if (bHasPresented)
+	{
+		const double Interval = std::chrono::duration<double, std::milli>(Now - LastPresent).count();
+		if (!PresentIntervals.empty() && Interval > SpikeFactor * PacerStats.AveragePresentIntervalMs)
+		{
+			PacerStats.Spikes++;
+			PacerStats.WorstSpikeMs = std::max(PacerStats.WorstSpikeMs, Interval);
+		}
+		PresentIntervals.push_back(Interval);
+		if (PresentIntervals.size() > HistorySize)
+		{
+			PresentIntervals.pop_front();
+		}
+
+		double Sum = 0.0, Worst = 0.0;
+		for (double Sample : PresentIntervals)
+		{
+			Sum += Sample;
+			Worst = std::max(Worst, Sample);
+		}
+		const double Mean = Sum / PresentIntervals.size();
+		double Variance = 0.0;
+		for (double Sample : PresentIntervals)
+		{
+			Variance += (Sample - Mean) * (Sample - Mean);
+		}
+
+		PacerStats.PresentIntervalMs = Interval;
+		PacerStats.AveragePresentIntervalMs = Mean;
+		PacerStats.JitterMs = std::sqrt(Variance / PresentIntervals.size());
+		PacerStats.WorstPresentIntervalMs = Worst;
+	}
+	LastPresent = Now;
+	bHasPresented = true;
+}
+
+void FramePacer::RetireFinishedFrames()
+{
+	while (!InFlight.empty() && glClientWaitSync(InFlight.front().Fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+	{
+		// polled, so this is an upper bound of when the GPU actually finished
+		PacerStats.LatencyMs = std::chrono::duration<double, std::milli>(Clock::now() - InFlight.front().Start).count();
+		glDeleteSync(InFlight.front().Fence);
+		InFlight.pop_front();
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <glad/glad.h>
+
+// keeps the CPU at most MaxFramesInFlight frames ahead of the GPU and decouples the simulation from rendering.
+// every frame gets a fence after its last GL command (EndFrame). BeginFrame waits for the fence of the frame that is
+// MaxFramesInFlight frames old, so the driver queue can't grow and input latency stays bounded. The simulation
+// advances in fixed steps (BeginFrame returns how many are due), so a jittery frame time doesn't leak into movement.
+// must only be used from the thread owning the GL context.
+class FramePacer
+{
+public:
+
+    struct Stats
+    {
+        double PresentIntervalMs = 0.0;         // last present to present time
+        double AveragePresentIntervalMs = 0.0;  // over the last HistorySize frames
+        double JitterMs = 0.0;                  // standard deviation of the present interval over the same window
+        double WorstPresentIntervalMs = 0.0;    // over the same window
+        size_t Spikes = 0;                      // present intervals over SpikeFactor times the window's average, since Init
+        double WorstSpikeMs = 0.0;              // longest of those
+        double LatencyMs = 0.0;                 // frame start (input sampled) until its fence was seen signaled
+        size_t FramesInFlight = 0;              // fenced frames not finished by the GPU yet
+        size_t FenceWaits = 0;                  // BeginFrames that had to block
+        double WaitMs = 0.0;                    // time spent blocking in the last BeginFrame
+        size_t DroppedSimulationSteps = 0;      // steps skipped because a frame took longer than MaxSimulationSteps steps
+    };
+
+    FramePacer() = default;
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    void Init(unsigned int maxFramesInFlight = 2, double simulationStep = 1.0 / 120.0);
+
+    // deletes the fences still pending, call while the context is alive
+    void Shutdown();
+
+    // call at the top of the frame: waits for a free frame slot, then returns the number of simulation steps due
+    int BeginFrame();
+
+    // call after the last GL command of the frame, right before SwapBuffers
+    void EndFrame();
+
+    // call right after SwapBuffers
+    void MarkPresent();
+
+    double GetSimulationStep() const { return SimulationStep; }
+
+    // how far (0..1) the render time is between the last and the next simulation step, for interpolating state
+    double GetInterpolation() const { return Accumulator / SimulationStep; }
+
+    const Stats& GetStats() const { return PacerStats; }
+
+    // caps the steps run per frame so a long hitch doesn't snowball into an even longer frame
+    int MaxSimulationSteps = 8;
+
+    // a present interval this many times the average of the frames before it counts as a spike
+    double SpikeFactor = 2.0;
+
+    // frames the present interval statistics are taken over
+    static constexpr size_t HistorySize = 120;
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameFence
+    {
+        GLsync Fence;
+        Clock::time_point Start;
+    };
+
+    // drops the fences the GPU has passed, records the latency of the newest one
+    void RetireFinishedFrames();
+
+    unsigned int MaxFramesInFlight = 2;
+    double SimulationStep = 1.0 / 120.0;
+    double Accumulator = 0.0;
+    bool bStarted = false;
+    Clock::time_point LastBegin;
+    Clock::time_point FrameStart;
+    Clock::time_point LastPresent;
+    bool bHasPresented = false;
+    std::deque<FrameFence> InFlight;
+    std::deque<double> PresentIntervals;
+    Stats PacerStats;
+};
@@ -0,0 +1,442 @@
+#include "GLCapture.h"
+
+#include <cstddef>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "GLTraceFormat.h"
+
+namespace
+{
+	struct Mapping
+	{
+		GLenum Target;
+		GLintptr Offset;
+		GLsizeiptr Length;
+		void* Pointer;
+	};
+
+	struct CaptureState
+	{
+		bool bRecording = false;
+		std::string Path;
+		std::ofstream File;
+		std::vector<unsigned char> Pending;
+		unsigned int FramesLeft = 0;
+		unsigned long long FrameIndex = 0;
+		std::vector<Mapping> Mappings;     // open glMapBufferRange write mappings
+	};
+
+	CaptureState State;
+
+	void FlushPending()
+	{
+		State.File.write(reinterpret_cast<const char*>(State.Pending.data()), static_cast<std::streamsize>(State.Pending.size()));
+		State.Pending.clear();
+	}
+
+	void Record(GLTraceCall Call, std::initializer_list<uint64_t> Scalars, const void* Blob = nullptr, size_t BlobBytes = 0)
+	{
+		GLTraceRecordHeader Header;
+		Header.Call = Call;
+		Header.ScalarCount = static_cast<uint16_t>(Scalars.size());
+		Header.BlobBytes = static_cast<uint32_t>(Blob ? BlobBytes : 0);
+
+		const unsigned char* HeaderBytes = reinterpret_cast<const unsigned char*>(&Header);
+		State.Pending.insert(State.Pending.end(), HeaderBytes, HeaderBytes + sizeof(Header));
+		for (uint64_t Scalar : Scalars)
+		{
+			const unsigned char* ScalarBytes = reinterpret_cast<const unsigned char*>(&Scalar);
+			State.Pending.insert(State.Pending.end(), ScalarBytes, ScalarBytes + sizeof(Scalar));
+		}
+		if (Header.BlobBytes > 0)
+		{
+			const unsigned char* BlobStart = static_cast<const unsigned char*>(Blob);
+			State.Pending.insert(State.Pending.end(), BlobStart, BlobStart + Header.BlobBytes);
+		}
+		if (State.Pending.size() > 8 * 1024 * 1024)
+		{
+			FlushPending();
+		}
+	}
+
+	// pixel uploads read from the bound unpack buffer instead of client memory when there is one
+	bool IsUnpackBufferBound()
+	{
+		GLint Buffer = 0;
+		glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &Buffer);
+		return Buffer != 0;
+	}
+
+	GLint GetUnpackAlignment()
+	{
+		GLint Alignment = 4;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &Alignment);
+		return Alignment;
+	}
+
+	// wrapper for calls taking plain values only, one instantiation per glad pointer
+	template <typename Fn, Fn* Slot, GLTraceCall Call>
+	struct ScalarHook;
+
+	template <typename R, typename... A, R (APIENTRYP* Slot)(A...), GLTraceCall Call>
+	struct ScalarHook<R (APIENTRYP)(A...), Slot, Call>
+	{
+		static R (APIENTRYP Original)(A...);
+
+		static R APIENTRY Hook(A... Args)
+		{
+			Record(Call, { ToTraceSlot(Args)... });
+			return Original(Args...);
+		}
+
+		static void Install()
+		{
+			if (*Slot)
+			{
+				Original = *Slot;
+				*Slot = &Hook;
+			}
+		}
+
+		static void Uninstall()
+		{
+			if (Original)
+			{
+				*Slot = Original;
+				Original = nullptr;
+			}
+		}
+	};
+
+	template <typename R, typename... A, R (APIENTRYP* Slot)(A...), GLTraceCall Call>
+	R (APIENTRYP ScalarHook<R (APIENTRYP)(A...), Slot, Call>::Original)(A...) = nullptr;
+
+	#define GENIX_GL_CAPTURE_SCALAR_HOOK(Name, ...) ScalarHook<decltype(glad_gl##Name), &glad_gl##Name, GL_TRACE_##Name>
+
+	// the real entry points behind the custom hooks
+	#define GENIX_GL_CAPTURE_ORIGINAL(Name) decltype(glad_gl##Name) Original##Name = nullptr;
+	GENIX_GL_TRACE_CUSTOM_CALLS(GENIX_GL_CAPTURE_ORIGINAL)
+	GENIX_GL_CAPTURE_ORIGINAL(MapBufferRange)
+	GENIX_GL_CAPTURE_ORIGINAL(UnmapBuffer)
+
+	// the names only exist after the real call, so they are recorded after it
+	#define GENIX_GL_CAPTURE_GEN_HOOK(Name) \
+		void APIENTRY Hook##Name(GLsizei n, GLuint* names) \
+		{ \
+			Original##Name(n, names); \
+			Record(GL_TRACE_##Name, { ToTraceSlot(n) }, names, n * sizeof(GLuint)); \
+		}
+	#define GENIX_GL_CAPTURE_DELETE_HOOK(Name) \
+		void APIENTRY Hook##Name(GLsizei n, const GLuint* names) \
+		{ \
+			Record(GL_TRACE_##Name, { ToTraceSlot(n) }, names, n * sizeof(GLuint)); \
+			Original##Name(n, names); \
+		}
+	GENIX_GL_CAPTURE_GEN_HOOK(GenTextures)
+	GENIX_GL_CAPTURE_GEN_HOOK(GenBuffers)
+	GENIX_GL_CAPTURE_GEN_HOOK(GenVertexArrays)
+	GENIX_GL_CAPTURE_GEN_HOOK(GenFramebuffers)
+	GENIX_GL_CAPTURE_GEN_HOOK(GenRenderbuffers)
+	GENIX_GL_CAPTURE_DELETE_HOOK(DeleteTextures)
+	GENIX_GL_CAPTURE_DELETE_HOOK(DeleteBuffers)
+	GENIX_GL_CAPTURE_DELETE_HOOK(DeleteVertexArrays)
+	GENIX_GL_CAPTURE_DELETE_HOOK(DeleteFramebuffers)
+	GENIX_GL_CAPTURE_DELETE_HOOK(DeleteRenderbuffers)
+
+	GLuint APIENTRY HookCreateShader(GLenum type)
+	{
+		const GLuint Shader = OriginalCreateShader(type);
+		Record(GL_TRACE_CreateShader, { ToTraceSlot(type), ToTraceSlot(Shader) });
+		return Shader;
+	}
+
+	GLuint APIENTRY HookCreateProgram()
+	{
+		const GLuint Program = OriginalCreateProgram();
+		Record(GL_TRACE_CreateProgram, { ToTraceSlot(Program) });
+		return Program;
+	}
+
+	void APIENTRY HookShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+	{
+		// blob: uint32 length + characters, per string
+		std::vector<unsigned char> Sources;
+		for (GLsizei i = 0; i < count; i++)
+		{
+			const uint32_t Length = static_cast<uint32_t>(length && length[i] >= 0 ? length[i] : std::char_traits<char>::length(string[i]));
+			const unsigned char* LengthBytes = reinterpret_cast<const unsigned char*>(&Length);
+			Sources.insert(Sources.end(), LengthBytes, LengthBytes + sizeof(Length));
+			Sources.insert(Sources.end(), string[i], string[i] + Length);
+		}
+		Record(GL_TRACE_ShaderSource, { ToTraceSlot(shader), ToTraceSlot(count) }, Sources.data(), Sources.size());
+		OriginalShaderSource(shader, count, string, length);
+	}
+
+	GLint APIENTRY HookGetUniformLocation(GLuint program, const GLchar* name)
+	{
+		const GLint Location = OriginalGetUniformLocation(program, name);
+		Record(GL_TRACE_GetUniformLocation, { ToTraceSlot(program), ToTraceSlot(Location) }, name, std::char_traits<char>::length(name));
+		return Location;
+	}
+
+	GLuint APIENTRY HookGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName)
+	{
+		const GLuint Index = OriginalGetUniformBlockIndex(program, uniformBlockName);
+		Record(GL_TRACE_GetUniformBlockIndex, { ToTraceSlot(program), ToTraceSlot(Index) }, uniformBlockName, std::char_traits<char>::length(uniformBlockName));
+		return Index;
+	}
+
+	void APIENTRY HookBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		Record(GL_TRACE_BufferData, { ToTraceSlot(target), ToTraceSlot(size), ToTraceSlot(usage), ToTraceSlot(data != nullptr) }, data, static_cast<size_t>(size));
+		OriginalBufferData(target, size, data, usage);
+	}
+
+	void APIENTRY HookBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		Record(GL_TRACE_BufferSubData, { ToTraceSlot(target), ToTraceSlot(offset), ToTraceSlot(size) }, data, static_cast<size_t>(size));
+		OriginalBufferSubData(target, offset, size, data);
+	}
+
+	// pixel source mode of an upload: 0 no data, 1 data in the blob, 2 offset into the bound unpack buffer
+	uint64_t GetPixelMode(const void* Pixels, bool bUnpackBuffer)
+	{
+		return bUnpackBuffer ? 2 : (Pixels ? 1 : 0);
+	}
+
+	void APIENTRY HookTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		const bool bUnpackBuffer = IsUnpackBufferBound();
+		const uint64_t Mode = GetPixelMode(pixels, bUnpackBuffer);
+		Record(GL_TRACE_TexImage2D, { ToTraceSlot(target), ToTraceSlot(level), ToTraceSlot(internalformat), ToTraceSlot(width), ToTraceSlot(height),
+			ToTraceSlot(border), ToTraceSlot(format), ToTraceSlot(type), Mode, ToTraceSlot(pixels) },
+			Mode == 1 ? pixels : nullptr, GetGLTraceImageBytes(width, height, 1, format, type, GetUnpackAlignment()));
+		OriginalTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+	}
+
+	void APIENTRY HookTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+	{
+		const bool bUnpackBuffer = IsUnpackBufferBound();
+		const uint64_t Mode = GetPixelMode(pixels, bUnpackBuffer);
+		Record(GL_TRACE_TexSubImage2D, { ToTraceSlot(target), ToTraceSlot(level), ToTraceSlot(xoffset), ToTraceSlot(yoffset), ToTraceSlot(width),
+			ToTraceSlot(height), ToTraceSlot(format), ToTraceSlot(type), Mode, ToTraceSlot(pixels) },
+			Mode == 1 ? pixels : nullptr, GetGLTraceImageBytes(width, height, 1, format, type, GetUnpackAlignment()));
+		OriginalTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+	}
+
+	void APIENTRY HookTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		const bool bUnpackBuffer = IsUnpackBufferBound();
+		const uint64_t Mode = GetPixelMode(pixels, bUnpackBuffer);
+		Record(GL_TRACE_TexImage3D, { ToTraceSlot(target), ToTraceSlot(level), ToTraceSlot(internalformat), ToTraceSlot(width), ToTraceSlot(height),
+			ToTraceSlot(depth), ToTraceSlot(border), ToTraceSlot(format), ToTraceSlot(type), Mode, ToTraceSlot(pixels) },
+			Mode == 1 ? pixels : nullptr, GetGLTraceImageBytes(width, height, depth, format, type, GetUnpackAlignment()));
+		OriginalTexImage3D(target, level, internalformat, width, height, depth, border, format, type, pixels);
+	}
+
+	void APIENTRY HookCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data)
+	{
+		const bool bUnpackBuffer = IsUnpackBufferBound();
+		const uint64_t Mode = GetPixelMode(data, bUnpackBuffer);
+		Record(GL_TRACE_CompressedTexImage2D, { ToTraceSlot(target), ToTraceSlot(level), ToTraceSlot(internalformat), ToTraceSlot(width), ToTraceSlot(height),
+			ToTraceSlot(border), ToTraceSlot(imageSize), Mode, ToTraceSlot(data) },
+			Mode == 1 ? data : nullptr, static_cast<size_t>(imageSize));
+		OriginalCompressedTexImage2D(target, level, internalformat, width, height, border, imageSize, data);
+	}
+
+	void APIENTRY HookDrawBuffers(GLsizei n, const GLenum* bufs)
+	{
+		Record(GL_TRACE_DrawBuffers, { ToTraceSlot(n) }, bufs, n * sizeof(GLenum));
+		OriginalDrawBuffers(n, bufs);
+	}
+
+	void APIENTRY HookClearBufferfv(GLenum buffer, GLint drawbuffer, const GLfloat* value)
+	{
+		// a color clear reads four floats, a depth clear one
+		Record(GL_TRACE_ClearBufferfv, { ToTraceSlot(buffer), ToTraceSlot(drawbuffer) }, value, (buffer == GL_COLOR ? 4 : 1) * sizeof(GLfloat));
+		OriginalClearBufferfv(buffer, drawbuffer, value);
+	}
+
+	#define GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Name, Type, Components) \
+		void APIENTRY Hook##Name(GLint location, GLsizei count, const Type* value) \
+		{ \
+			Record(GL_TRACE_##Name, { ToTraceSlot(location), ToTraceSlot(count) }, value, count * Components * sizeof(Type)); \
+			Original##Name(location, count, value); \
+		}
+	#define GENIX_GL_CAPTURE_UNIFORM_MATRIX_HOOK(Name, Components) \
+		void APIENTRY Hook##Name(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) \
+		{ \
+			Record(GL_TRACE_##Name, { ToTraceSlot(location), ToTraceSlot(count), ToTraceSlot(transpose) }, value, count * Components * sizeof(GLfloat)); \
+			Original##Name(location, count, transpose, value); \
+		}
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform1fv, GLfloat, 1)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform2fv, GLfloat, 2)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform3fv, GLfloat, 3)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform4fv, GLfloat, 4)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform1iv, GLint, 1)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform2iv, GLint, 2)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform3iv, GLint, 3)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform4iv, GLint, 4)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform1uiv, GLuint, 1)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform2uiv, GLuint, 2)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform3uiv, GLuint, 3)
+	GENIX_GL_CAPTURE_UNIFORM_ARRAY_HOOK(Uniform4uiv, GLuint, 4)
+	GENIX_GL_CAPTURE_UNIFORM_MATRIX_HOOK(UniformMatrix2fv, 4)
+	GENIX_GL_CAPTURE_UNIFORM_MATRIX_HOOK(UniformMatrix3fv, 9)
+	GENIX_GL_CAPTURE_UNIFORM_MATRIX_HOOK(UniformMatrix4fv, 16)
+
+	// what the application writes into a mapping is only known once it unmaps
+	void* APIENTRY HookMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		void* Pointer = OriginalMapBufferRange(target, offset, length, access);
+		if (Pointer && (access & GL_MAP_WRITE_BIT))
+		{
+			State.Mappings.push_back({ target, offset, length, Pointer });
+		}
+		return Pointer;
+	}
+
+	GLboolean APIENTRY HookUnmapBuffer(GLenum target)
+	{
+		for (auto It = State.Mappings.rbegin(); It != State.Mappings.rend(); ++It)
+		{
+			if (It->Target == target)
+			{
+				Record(GL_TRACE_MapWrite, { ToTraceSlot(target), ToTraceSlot(It->Offset), ToTraceSlot(It->Length) }, It->Pointer, static_cast<size_t>(It->Length));
+				State.Mappings.erase(std::next(It).base());
+				break;
+			}
+		}
+		return OriginalUnmapBuffer(target);
+	}
+
+	#define GENIX_GL_CAPTURE_INSTALL_SCALAR(Name, ...) GENIX_GL_CAPTURE_SCALAR_HOOK(Name)::Install();
+	#define GENIX_GL_CAPTURE_UNINSTALL_SCALAR(Name, ...) GENIX_GL_CAPTURE_SCALAR_HOOK(Name)::Uninstall();
+	#define GENIX_GL_CAPTURE_INSTALL_CUSTOM(Name) \
+		if (glad_gl##Name) \
+		{ \
+			Original##Name = glad_gl##Name; \
+			glad_gl##Name = Hook##Name; \
+		}
+	#define GENIX_GL_CAPTURE_UNINSTALL_CUSTOM(Name) \
+		if (Original##Name) \
+		{ \
+			glad_gl##Name = Original##Name; \
+			Original##Name = nullptr; \
+		}
+}
+
+const char* GetGLTraceCallName(unsigned int call)
+{
+	#define GENIX_GL_TRACE_NAME_ENTRY(Name, ...) "gl" #Name,
+	static const char* Names[GL_TRACE_CALL_COUNT] =
+	{
+		GENIX_GL_TRACE_SCALAR_CALLS(GENIX_GL_TRACE_NAME_ENTRY)
+		GENIX_GL_TRACE_CUSTOM_CALLS(GENIX_GL_TRACE_NAME_ENTRY)
+		"glMapBufferRange (write)",
+		"Frame"
+	};
+	return call < GL_TRACE_CALL_COUNT ? Names[call] : "unknown";
+}
+
+size_t GetGLTraceImageBytes(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLint alignment)
+{
+	size_t Components = 4;
+	switch (format)
+	{
+	case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: case GL_DEPTH_STENCIL: Components = 1; break;
+	case GL_RG: case GL_RG_INTEGER: Components = 2; break;
+	case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: Components = 3; break;
+	default: Components = 4; break;
+	}
+	size_t ComponentBytes = 1;
+	switch (type)
+	{
+	case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: ComponentBytes = 2; break;
+	case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: ComponentBytes = 4; break;
+	// packed types hold a whole texel
+	case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV: case GL_UNSIGNED_INT_2_10_10_10_REV: Components = 1; ComponentBytes = 4; break;
+	default: ComponentBytes = 1; break;
+	}
+	if (width <= 0 || height <= 0 || depth <= 0)
+	{
+		return 0;
+	}
+	const size_t RowBytes = static_cast<size_t>(width) * Components * ComponentBytes;
+	const size_t Align = alignment > 0 ? static_cast<size_t>(alignment) : 1;
+	const size_t RowStride = (RowBytes + Align - 1) / Align * Align;
+	// the last row isn't padded
+	return RowStride * (static_cast<size_t>(height) * depth - 1) + RowBytes;
+}
+
+GLCapture& GLCapture::Get()
+{
+	static GLCapture Instance;
+	return Instance;
+}
+
+bool GLCapture::Start(const std::string& path, unsigned int frameCount)
+{
+	if (State.bRecording)
+	{
+		return false;
+	}
+	State.File.open(path, std::ios::binary);
+	if (!State.File)
+	{
+		std::cout << "Failed to open GL capture file: " << path << std::endl;
+		return false;
+	}
+	State.File.write(GENIX_GL_TRACE_MAGIC, 8);
+	State.Path = path;
+	State.FramesLeft = frameCount;
+	State.FrameIndex = 0;
+	State.Mappings.clear();
+	State.bRecording = true;
+
+	GENIX_GL_TRACE_SCALAR_CALLS(GENIX_GL_CAPTURE_INSTALL_SCALAR)
+	GENIX_GL_TRACE_CUSTOM_CALLS(GENIX_GL_CAPTURE_INSTALL_CUSTOM)
+	GENIX_GL_CAPTURE_INSTALL_CUSTOM(MapBufferRange)
+	GENIX_GL_CAPTURE_INSTALL_CUSTOM(UnmapBuffer)
+	return true;
+}
+
+void GLCapture::Stop()
+{
+	if (!State.bRecording)
+	{
+		return;
+	}
+	GENIX_GL_TRACE_SCALAR_CALLS(GENIX_GL_CAPTURE_UNINSTALL_SCALAR)
+	GENIX_GL_TRACE_CUSTOM_CALLS(GENIX_GL_CAPTURE_UNINSTALL_CUSTOM)
+	GENIX_GL_CAPTURE_UNINSTALL_CUSTOM(MapBufferRange)
+	GENIX_GL_CAPTURE_UNINSTALL_CUSTOM(UnmapBuffer)
+
+	FlushPending();
+	State.File.close();
+	State.bRecording = false;
+	std::cout << "GL capture written: " << State.Path << " (" << State.FrameIndex << " frames)" << std::endl;
+}
+
+void GLCapture::MarkFrame()
+{
+	if (!State.bRecording)
+	{
+		return;
+	}
+	Record(GL_TRACE_Frame, { State.FrameIndex++ });
+	if (State.FramesLeft > 0 && --State.FramesLeft == 0)
+	{
+		Stop();
+	}
+}
+
+bool GLCapture::IsRecording() const
+{
+	return State.bRecording;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+// records every GL call the renderer makes through glad, plus the memory those calls read (buffer and texture uploads,
+// uniform arrays, shader sources), into a binary trace (GLTraceFormat.h) that GLReplay can re-execute on another
+// context. Recording works by swapping glad's function pointers for recording wrappers, so it costs nothing while off.
+// calls made through other loaders (the imgui backend has its own) are not seen. Those leave the GL state as they
+// found it, so the replay stays consistent, their draws are just missing.
+// main thread only.
+class GLCapture
+{
+public:
+
+    static GLCapture& Get();
+
+    GLCapture(const GLCapture&) = delete;
+    GLCapture& operator=(const GLCapture&) = delete;
+
+    // starts recording into path and stops by itself after frameCount MarkFrame calls. glad has to be loaded already.
+    // objects created before Start are unknown to the trace, so start before any resources are created.
+    bool Start(const std::string& path, unsigned int frameCount);
+
+    // restores glad's pointers and closes the file
+    void Stop();
+
+    // call right after SwapBuffers
+    void MarkFrame();
+
+    bool IsRecording() const;
+
+private:
+
+    GLCapture() = default;
+};
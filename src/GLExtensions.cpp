@@ -0,0 +1,40 @@
+#include "GLExtensions.h"
+
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <unordered_set>
+
+bool HasGLExtension(const char* Name)
+{
+	static std::unordered_set<std::string> Extensions;
+	static bool bQueried = false;
+	if (!bQueried)
+	{
+		GLint Count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &Count);
+		for (GLint i = 0; i < Count; i++)
+		{
+			const GLubyte* Extension = glGetStringi(GL_EXTENSIONS, i);
+			if (Extension)
+			{
+				Extensions.insert(reinterpret_cast<const char*>(Extension));
+			}
+		}
+		bQueried = true;
+	}
+	return Extensions.count(Name) > 0;
+}
+
+bool HasGLVersion(int Major, int Minor)
+{
+	GLint ContextMajor = 0, ContextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &ContextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &ContextMinor);
+	return ContextMajor > Major || (ContextMajor == Major && ContextMinor >= Minor);
+}
+
+void* LoadGLFunction(const char* Name)
+{
+	return reinterpret_cast<void*>(glfwGetProcAddress(Name));
+}
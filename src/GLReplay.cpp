@@ -0,0 +1,500 @@
+#include "GLReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	struct ReplayState
+	{
+		std::unordered_map<GLuint, GLuint> Names[GL_TRACE_OBJECT_COUNT];
+		std::map<std::pair<GLuint, GLint>, GLint> Locations;      // (captured program, captured location)
+		std::map<std::pair<GLuint, GLuint>, GLuint> Blocks;       // (captured program, captured block index)
+		GLuint CurrentProgram = 0;                                  // captured name of the program in use
+	};
+
+	double ElapsedMs(std::chrono::steady_clock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+	}
+
+	GLuint MapName(const ReplayState& State, GLTraceObject Kind, GLuint Name)
+	{
+		if (Name == 0)
+		{
+			return 0;
+		}
+		auto Found = State.Names[Kind].find(Name);
+		return Found != State.Names[Kind].end() ? Found->second : Name;
+	}
+
+	// rewrites one captured object argument to its name in this context
+	void RemapSlot(const ReplayState& State, uint64_t* Slots, const uint64_t* Captured, size_t Count, int Index, GLTraceObject Kind)
+	{
+		if (Index < 0 || static_cast<size_t>(Index) >= Count)
+		{
+			return;
+		}
+		uint64_t& Slot = Slots[Index];
+		switch (Kind)
+		{
+		case GL_TRACE_OBJECT_NONE:
+			break;
+		case GL_TRACE_OBJECT_UNIFORM_LOCATION:
+		{
+			const GLint Location = FromTraceSlot<GLint>(Captured[Index]);
+			auto Found = State.Locations.find({ State.CurrentProgram, Location });
+			Slot = ToTraceSlot(Found != State.Locations.end() ? Found->second : -1);
+			break;
+		}
+		case GL_TRACE_OBJECT_UNIFORM_BLOCK:
+		{
+			auto Found = State.Blocks.find({ FromTraceSlot<GLuint>(Captured[0]), FromTraceSlot<GLuint>(Captured[Index]) });
+			Slot = ToTraceSlot(Found != State.Blocks.end() ? Found->second : GL_INVALID_INDEX);
+			break;
+		}
+		default:
+			Slot = ToTraceSlot(MapName(State, Kind, FromTraceSlot<GLuint>(Captured[Index])));
+			break;
+		}
+	}
+
+	// calls a glad pointer with the arguments stored in the slots
+	template <typename Fn, Fn* Slot>
+	struct ScalarReplay;
+
+	template <typename R, typename... A, R (APIENTRYP* Slot)(A...)>
+	struct ScalarReplay<R (APIENTRYP)(A...), Slot>
+	{
+		static void Call(const uint64_t* Slots, size_t Count)
+		{
+			if (Count == sizeof...(A) && *Slot)
+			{
+				Invoke(Slots, std::index_sequence_for<A...>());
+			}
+		}
+
+		template <size_t... I>
+		static void Invoke(const uint64_t* Slots, std::index_sequence<I...>)
+		{
+			(void)Slots;
+			(*Slot)(FromTraceSlot<A>(Slots[I])...);
+		}
+	};
+
+	void ReplayGen(ReplayState& State, GLTraceObject Kind, void (APIENTRYP Gen)(GLsizei, GLuint*), const uint64_t* Scalars, const unsigned char* Blob)
+	{
+		const GLsizei Count = FromTraceSlot<GLsizei>(Scalars[0]);
+		const GLuint* Captured = reinterpret_cast<const GLuint*>(Blob);
+		std::vector<GLuint> Created(Count);
+		Gen(Count, Created.data());
+		for (GLsizei i = 0; i < Count; i++)
+		{
+			State.Names[Kind][Captured[i]] = Created[i];
+		}
+	}
+
+	void ReplayDelete(ReplayState& State, GLTraceObject Kind, void (APIENTRYP Delete)(GLsizei, const GLuint*), const uint64_t* Scalars, const unsigned char* Blob)
+	{
+		const GLsizei Count = FromTraceSlot<GLsizei>(Scalars[0]);
+		const GLuint* Captured = reinterpret_cast<const GLuint*>(Blob);
+		std::vector<GLuint> Names(Count);
+		for (GLsizei i = 0; i < Count; i++)
+		{
+			Names[i] = MapName(State, Kind, Captured[i]);
+			State.Names[Kind].erase(Captured[i]);
+		}
+		Delete(Count, Names.data());
+	}
+
+	// pixel source of an upload, see the modes in GLCapture.cpp
+	const void* GetPixels(uint64_t Mode, uint64_t Offset, const unsigned char* Blob)
+	{
+		return Mode == 2 ? FromTraceSlot<const void*>(Offset) : (Mode == 1 ? Blob : nullptr);
+	}
+
+	void ReplayCustom(ReplayState& State, unsigned int Call, const uint64_t* S, const unsigned char* Blob, uint32_t BlobBytes)
+	{
+		switch (Call)
+		{
+		case GL_TRACE_GenTextures: ReplayGen(State, GL_TRACE_OBJECT_TEXTURE, glGenTextures, S, Blob); break;
+		case GL_TRACE_GenBuffers: ReplayGen(State, GL_TRACE_OBJECT_BUFFER, glGenBuffers, S, Blob); break;
+		case GL_TRACE_GenVertexArrays: ReplayGen(State, GL_TRACE_OBJECT_VERTEX_ARRAY, glGenVertexArrays, S, Blob); break;
+		case GL_TRACE_GenFramebuffers: ReplayGen(State, GL_TRACE_OBJECT_FRAMEBUFFER, glGenFramebuffers, S, Blob); break;
+		case GL_TRACE_GenRenderbuffers: ReplayGen(State, GL_TRACE_OBJECT_RENDERBUFFER, glGenRenderbuffers, S, Blob); break;
+		case GL_TRACE_DeleteTextures: ReplayDelete(State, GL_TRACE_OBJECT_TEXTURE, glDeleteTextures, S, Blob); break;
+		case GL_TRACE_DeleteBuffers: ReplayDelete(State, GL_TRACE_OBJECT_BUFFER, glDeleteBuffers, S, Blob); break;
+		case GL_TRACE_DeleteVertexArrays: ReplayDelete(State, GL_TRACE_OBJECT_VERTEX_ARRAY, glDeleteVertexArrays, S, Blob); break;
+		case GL_TRACE_DeleteFramebuffers: ReplayDelete(State, GL_TRACE_OBJECT_FRAMEBUFFER, glDeleteFramebuffers, S, Blob); break;
+		case GL_TRACE_DeleteRenderbuffers: ReplayDelete(State, GL_TRACE_OBJECT_RENDERBUFFER, glDeleteRenderbuffers, S, Blob); break;
+		case GL_TRACE_CreateShader:
+			State.Names[GL_TRACE_OBJECT_SHADER][FromTraceSlot<GLuint>(S[1])] = glCreateShader(FromTraceSlot<GLenum>(S[0]));
+			break;
+		case GL_TRACE_CreateProgram:
+			State.Names[GL_TRACE_OBJECT_PROGRAM][FromTraceSlot<GLuint>(S[0])] = glCreateProgram();
+			break;
+		case GL_TRACE_ShaderSource:
+		{
+			std::vector<const GLchar*> Strings;
+			std::vector<GLint> Lengths;
+			for (uint32_t Offset = 0; Offset + sizeof(uint32_t) <= BlobBytes;)
+			{
+				uint32_t Length;
+				std::memcpy(&Length, Blob + Offset, sizeof(Length));
+				Offset += sizeof(Length);
+				if (Length > BlobBytes - Offset)
+				{
+					break;
+				}
+				Strings.push_back(reinterpret_cast<const GLchar*>(Blob + Offset));
+				Lengths.push_back(static_cast<GLint>(Length));
+				Offset += Length;
+			}
+			glShaderSource(MapName(State, GL_TRACE_OBJECT_SHADER, FromTraceSlot<GLuint>(S[0])), static_cast<GLsizei>(Strings.size()), Strings.data(), Lengths.data());
+			break;
+		}
+		case GL_TRACE_GetUniformLocation:
+		{
+			const std::string Name(reinterpret_cast<const char*>(Blob), BlobBytes);
+			const GLuint Program = FromTraceSlot<GLuint>(S[0]);
+			State.Locations[{ Program, FromTraceSlot<GLint>(S[1]) }] = glGetUniformLocation(MapName(State, GL_TRACE_OBJECT_PROGRAM, Program), Name.c_str());
+			break;
+		}
+		case GL_TRACE_GetUniformBlockIndex:
+		{
+			const std::string Name(reinterpret_cast<const char*>(Blob), BlobBytes);
+			const GLuint Program = FromTraceSlot<GLuint>(S[0]);
+			State.Blocks[{ Program, FromTraceSlot<GLuint>(S[1]) }] = glGetUniformBlockIndex(MapName(State, GL_TRACE_OBJECT_PROGRAM, Program), Name.c_str());
+			break;
+		}
+		case GL_TRACE_BufferData:
+			glBufferData(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLsizeiptr>(S[1]), S[3] ? Blob : nullptr, FromTraceSlot<GLenum>(S[2]));
+			break;
+		case GL_TRACE_BufferSubData:
+		case GL_TRACE_MapWrite:
+			glBufferSubData(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLintptr>(S[1]), FromTraceSlot<GLsizeiptr>(S[2]), Blob);
+			break;
+		case GL_TRACE_TexImage2D:
+			glTexImage2D(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLint>(S[1]), FromTraceSlot<GLint>(S[2]), FromTraceSlot<GLsizei>(S[3]), FromTraceSlot<GLsizei>(S[4]),
+				FromTraceSlot<GLint>(S[5]), FromTraceSlot<GLenum>(S[6]), FromTraceSlot<GLenum>(S[7]), GetPixels(S[8], S[9], Blob));
+			break;
+		case GL_TRACE_TexSubImage2D:
+			glTexSubImage2D(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLint>(S[1]), FromTraceSlot<GLint>(S[2]), FromTraceSlot<GLint>(S[3]), FromTraceSlot<GLsizei>(S[4]),
+				FromTraceSlot<GLsizei>(S[5]), FromTraceSlot<GLenum>(S[6]), FromTraceSlot<GLenum>(S[7]), GetPixels(S[8], S[9], Blob));
+			break;
+		case GL_TRACE_TexImage3D:
+			glTexImage3D(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLint>(S[1]), FromTraceSlot<GLint>(S[2]), FromTraceSlot<GLsizei>(S[3]), FromTraceSlot<GLsizei>(S[4]),
+				FromTraceSlot<GLsizei>(S[5]), FromTraceSlot<GLint>(S[6]), FromTraceSlot<GLenum>(S[7]), FromTraceSlot<GLenum>(S[8]), GetPixels(S[9], S[10], Blob));
+			break;
+		case GL_TRACE_CompressedTexImage2D:
+			glCompressedTexImage2D(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLint>(S[1]), FromTraceSlot<GLenum>(S[2]), FromTraceSlot<GLsizei>(S[3]), FromTraceSlot<GLsizei>(S[4]),
+				FromTraceSlot<GLint>(S[5]), FromTraceSlot<GLsizei>(S[6]), GetPixels(S[7], S[8], Blob));
+			break;
+		case GL_TRACE_DrawBuffers:
+			glDrawBuffers(FromTraceSlot<GLsizei>(S[0]), reinterpret_cast<const GLenum*>(Blob));
+			break;
+		case GL_TRACE_ClearBufferfv:
+			glClearBufferfv(FromTraceSlot<GLenum>(S[0]), FromTraceSlot<GLint>(S[1]), reinterpret_cast<const GLfloat*>(Blob));
+			break;
+		default:
+		{
+			// uniform arrays, the location is the only argument to remap
+			const GLint Location = FromTraceSlot<GLint>(S[0]);
+			auto Found = State.Locations.find({ State.CurrentProgram, Location });
+			const GLint Mapped = Found != State.Locations.end() ? Found->second : -1;
+			const GLsizei Count = FromTraceSlot<GLsizei>(S[1]);
+			const GLfloat* Floats = reinterpret_cast<const GLfloat*>(Blob);
+			const GLint* Ints = reinterpret_cast<const GLint*>(Blob);
+			const GLuint* Uints = reinterpret_cast<const GLuint*>(Blob);
+			switch (Call)
+			{
+			case GL_TRACE_Uniform1fv: glUniform1fv(Mapped, Count, Floats); break;
+			case GL_TRACE_Uniform2fv: glUniform2fv(Mapped, Count, Floats); break;
+			case GL_TRACE_Uniform3fv: glUniform3fv(Mapped, Count, Floats); break;
+			case GL_TRACE_Uniform4fv: glUniform4fv(Mapped, Count, Floats); break;
+			case GL_TRACE_Uniform1iv: glUniform1iv(Mapped, Count, Ints); break;
+			case GL_TRACE_Uniform2iv: glUniform2iv(Mapped, Count, Ints); break;
+			case GL_TRACE_Uniform3iv: glUniform3iv(Mapped, Count, Ints); break;
+			case GL_TRACE_Uniform4iv: glUniform4iv(Mapped, Count, Ints); break;
+			case GL_TRACE_Uniform1uiv: glUniform1uiv(Mapped, Count, Uints); break;
+			case GL_TRACE_Uniform2uiv: glUniform2uiv(Mapped, Count, Uints); break;
+			case GL_TRACE_Uniform3uiv: glUniform3uiv(Mapped, Count, Uints); break;
+			case GL_TRACE_Uniform4uiv: glUniform4uiv(Mapped, Count, Uints); break;
+			case GL_TRACE_UniformMatrix2fv: glUniformMatrix2fv(Mapped, Count, FromTraceSlot<GLboolean>(S[2]), Floats); break;
+			case GL_TRACE_UniformMatrix3fv: glUniformMatrix3fv(Mapped, Count, FromTraceSlot<GLboolean>(S[2]), Floats); break;
+			case GL_TRACE_UniformMatrix4fv: glUniformMatrix4fv(Mapped, Count, FromTraceSlot<GLboolean>(S[2]), Floats); break;
+			default: break;
+			}
+			break;
+		}
+		}
+	}
+
+	// smallest scalar count each custom record needs, shorter records are corrupt
+	size_t GetRequiredScalars(unsigned int Call)
+	{
+		switch (Call)
+		{
+		case GL_TRACE_CreateProgram: return 1;
+		case GL_TRACE_CreateShader: case GL_TRACE_ShaderSource: case GL_TRACE_GetUniformLocation: case GL_TRACE_GetUniformBlockIndex: return 2;
+		case GL_TRACE_ClearBufferfv: return 2;
+		case GL_TRACE_BufferData: return 4;
+		case GL_TRACE_BufferSubData: case GL_TRACE_MapWrite: return 3;
+		case GL_TRACE_TexImage2D: case GL_TRACE_TexSubImage2D: return 10;
+		case GL_TRACE_TexImage3D: return 11;
+		case GL_TRACE_CompressedTexImage2D: return 9;
+		case GL_TRACE_UniformMatrix2fv: case GL_TRACE_UniformMatrix3fv: case GL_TRACE_UniformMatrix4fv: return 3;
+		case GL_TRACE_Uniform1fv: case GL_TRACE_Uniform2fv: case GL_TRACE_Uniform3fv: case GL_TRACE_Uniform4fv: return 2;
+		case GL_TRACE_Uniform1iv: case GL_TRACE_Uniform2iv: case GL_TRACE_Uniform3iv: case GL_TRACE_Uniform4iv: return 2;
+		case GL_TRACE_Uniform1uiv: case GL_TRACE_Uniform2uiv: case GL_TRACE_Uniform3uiv: case GL_TRACE_Uniform4uiv: return 2;
+		default: return 1;
+		}
+	}
+
+	// bytes of count elements, negative counts can't come from a valid call
+	size_t GetArrayBytes(uint64_t CountSlot, size_t ElementBytes)
+	{
+		const int64_t Count = static_cast<int64_t>(CountSlot);
+		return Count >= 0 ? static_cast<size_t>(Count) * ElementBytes : std::numeric_limits<size_t>::max();
+	}
+
+	// pixels of an upload are only in the blob in mode 1 (see GLCapture.cpp), sized with the replay's unpack alignment,
+	// which the replayed glPixelStorei calls keep equal to the captured one
+	size_t GetPixelBytes(uint64_t Mode, GLsizei Width, GLsizei Height, GLsizei Depth, GLenum Format, GLenum Type)
+	{
+		if (Mode != 1)
+		{
+			return 0;
+		}
+		GLint Alignment = 4;
+		glGetIntegerv(GL_UNPACK_ALIGNMENT, &Alignment);
+		return GetGLTraceImageBytes(Width, Height, Depth, Format, Type, Alignment);
+	}
+
+	// blob bytes a custom record has to carry for what its scalars say, shorter blobs would be read past their end
+	size_t GetRequiredBlobBytes(unsigned int Call, const uint64_t* S)
+	{
+		switch (Call)
+		{
+		case GL_TRACE_GenTextures: case GL_TRACE_GenBuffers: case GL_TRACE_GenVertexArrays: case GL_TRACE_GenFramebuffers: case GL_TRACE_GenRenderbuffers:
+		case GL_TRACE_DeleteTextures: case GL_TRACE_DeleteBuffers: case GL_TRACE_DeleteVertexArrays: case GL_TRACE_DeleteFramebuffers: case GL_TRACE_DeleteRenderbuffers:
+			return GetArrayBytes(S[0], sizeof(GLuint));
+		case GL_TRACE_BufferData: return S[3] ? GetArrayBytes(S[1], 1) : 0;
+		case GL_TRACE_BufferSubData: case GL_TRACE_MapWrite: return GetArrayBytes(S[2], 1);
+		case GL_TRACE_TexImage2D:
+			return GetPixelBytes(S[8], FromTraceSlot<GLsizei>(S[3]), FromTraceSlot<GLsizei>(S[4]), 1, FromTraceSlot<GLenum>(S[6]), FromTraceSlot<GLenum>(S[7]));
+		case GL_TRACE_TexSubImage2D:
+			return GetPixelBytes(S[8], FromTraceSlot<GLsizei>(S[4]), FromTraceSlot<GLsizei>(S[5]), 1, FromTraceSlot<GLenum>(S[6]), FromTraceSlot<GLenum>(S[7]));
+		case GL_TRACE_TexImage3D:
+			return GetPixelBytes(S[9], FromTraceSlot<GLsizei>(S[3]), FromTraceSlot<GLsizei>(S[4]), FromTraceSlot<GLsizei>(S[5]), FromTraceSlot<GLenum>(S[7]), FromTraceSlot<GLenum>(S[8]));
+		case GL_TRACE_CompressedTexImage2D: return S[7] == 1 ? GetArrayBytes(S[6], 1) : 0;
+		case GL_TRACE_DrawBuffers: return GetArrayBytes(S[0], sizeof(GLenum));
+		case GL_TRACE_ClearBufferfv: return (FromTraceSlot<GLenum>(S[0]) == GL_COLOR ? 4 : 1) * sizeof(GLfloat);
+		// uniform arrays, every component is 4 bytes
+		case GL_TRACE_Uniform1fv: case GL_TRACE_Uniform1iv: case GL_TRACE_Uniform1uiv: return GetArrayBytes(S[1], 4);
+		case GL_TRACE_Uniform2fv: case GL_TRACE_Uniform2iv: case GL_TRACE_Uniform2uiv: return GetArrayBytes(S[1], 2 * 4);
+		case GL_TRACE_Uniform3fv: case GL_TRACE_Uniform3iv: case GL_TRACE_Uniform3uiv: return GetArrayBytes(S[1], 3 * 4);
+		case GL_TRACE_Uniform4fv: case GL_TRACE_Uniform4iv: case GL_TRACE_Uniform4uiv: case GL_TRACE_UniformMatrix2fv: return GetArrayBytes(S[1], 4 * 4);
+		case GL_TRACE_UniformMatrix3fv: return GetArrayBytes(S[1], 9 * 4);
+		case GL_TRACE_UniformMatrix4fv: return GetArrayBytes(S[1], 16 * 4);
+		default: return 0;
+		}
+	}
+
+	// false for records that are too short to replay, they are skipped
+	bool Dispatch(ReplayState& State, unsigned int Call, std::vector<uint64_t>& Scalars, const unsigned char* Blob, uint32_t BlobBytes)
+	{
+		const std::vector<uint64_t> Captured = Scalars;
+		uint64_t* Slots = Scalars.data();
+		const size_t Count = Scalars.size();
+
+		#define GENIX_GL_REPLAY_SCALAR_CASE(Name, IndexA, KindA, IndexB, KindB) \
+			case GL_TRACE_##Name: \
+				RemapSlot(State, Slots, Captured.data(), Count, IndexA, KindA); \
+				RemapSlot(State, Slots, Captured.data(), Count, IndexB, KindB); \
+				ScalarReplay<decltype(glad_gl##Name), &glad_gl##Name>::Call(Slots, Count); \
+				break;
+
+		bool bReplayed = true;
+		switch (Call)
+		{
+		GENIX_GL_TRACE_SCALAR_CALLS(GENIX_GL_REPLAY_SCALAR_CASE)
+		default:
+			bReplayed = Count >= GetRequiredScalars(Call) && BlobBytes >= GetRequiredBlobBytes(Call, Slots);
+			if (bReplayed)
+			{
+				ReplayCustom(State, Call, Slots, Blob, BlobBytes);
+			}
+			break;
+		}
+
+		#undef GENIX_GL_REPLAY_SCALAR_CASE
+
+		if (Call == GL_TRACE_UseProgram && Count == 1)
+		{
+			State.CurrentProgram = FromTraceSlot<GLuint>(Captured[0]);
+		}
+		return bReplayed;
+	}
+}
+
+double GLReplayReport::GetAverageFrameMs() const
+{
+	double Total = 0.0;
+	for (double Ms : FrameMs)
+	{
+		Total += Ms;
+	}
+	return FrameMs.empty() ? 0.0 : Total / FrameMs.size();
+}
+
+double GLReplayReport::GetMedianFrameMs() const
+{
+	if (FrameMs.empty())
+	{
+		return 0.0;
+	}
+	std::vector<double> Sorted = FrameMs;
+	std::sort(Sorted.begin(), Sorted.end());
+	return Sorted[Sorted.size() / 2];
+}
+
+bool ReplayGLTrace(const std::string& path, GLReplayReport& outReport)
+{
+	std::ifstream File(path, std::ios::binary);
+	char Magic[8] = {};
+	if (!File || !File.read(Magic, sizeof(Magic)) || std::memcmp(Magic, GENIX_GL_TRACE_MAGIC, sizeof(Magic)) != 0)
+	{
+		std::cout << "Not a GL trace: " << path << std::endl;
+		return false;
+	}
+
+	outReport = GLReplayReport();
+	outReport.Path = path;
+
+	ReplayState State;
+	GLTraceRecordHeader Header;
+	std::vector<uint64_t> Scalars;
+	std::vector<unsigned char> Blob;
+	bool bInFrames = false;
+	double Accumulated = 0.0;       // issue time since the last frame marker, file reads excluded
+
+	while (File.read(reinterpret_cast<char*>(&Header), sizeof(Header)))
+	{
+		Scalars.resize(Header.ScalarCount);
+		Blob.resize(Header.BlobBytes);
+		if (!File.read(reinterpret_cast<char*>(Scalars.data()), Scalars.size() * sizeof(uint64_t)) ||
+			!File.read(reinterpret_cast<char*>(Blob.data()), Blob.size()))
+		{
+			std::cout << "GL trace is truncated: " << path << std::endl;
+			return false;
+		}
+
+		if (Header.Call == GL_TRACE_Frame)
+		{
+			const auto FinishStart = std::chrono::steady_clock::now();
+			glFinish();
+			Accumulated += ElapsedMs(FinishStart);
+			if (bInFrames)
+			{
+				outReport.FrameMs.push_back(Accumulated);
+			}
+			else
+			{
+				outReport.SetupMs = Accumulated;
+				bInFrames = true;
+			}
+			Accumulated = 0.0;
+			continue;
+		}
+		if (Header.Call >= GL_TRACE_CALL_COUNT)
+		{
+			std::cout << "Unknown call " << Header.Call << " in GL trace: " << path << std::endl;
+			return false;
+		}
+
+		const auto Start = std::chrono::steady_clock::now();
+		if (!Dispatch(State, Header.Call, Scalars, Blob.data(), Header.BlobBytes))
+		{
+			outReport.SkippedRecords++;
+		}
+		const double Ms = ElapsedMs(Start);
+		Accumulated += Ms;
+		if (bInFrames)
+		{
+			GLReplayReport::CallStats& Stats = outReport.Calls[Header.Call];
+			Stats.Count++;
+			Stats.CpuMs += Ms;
+			outReport.UploadBytes += Header.BlobBytes;
+		}
+	}
+	glFinish();
+	return true;
+}
+
+void PrintGLReplayReport(const GLReplayReport& report)
+{
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << report.Path << ": " << report.FrameMs.size() << " frames, setup " << report.SetupMs << " ms, frame avg "
+		<< report.GetAverageFrameMs() << " ms, median " << report.GetMedianFrameMs() << " ms, "
+		<< report.UploadBytes / 1024 << " KB passed to GL in frames" << std::endl;
+	if (report.SkippedRecords > 0)
+	{
+		std::cout << report.SkippedRecords << " corrupt records skipped" << std::endl;
+	}
+
+	std::vector<unsigned int> Order;
+	for (unsigned int Call = 0; Call < report.Calls.size(); Call++)
+	{
+		if (report.Calls[Call].Count > 0)
+		{
+			Order.push_back(Call);
+		}
+	}
+	std::sort(Order.begin(), Order.end(), [&](unsigned int A, unsigned int B) { return report.Calls[A].CpuMs > report.Calls[B].CpuMs; });
+
+	const double Frames = report.FrameMs.empty() ? 1.0 : static_cast<double>(report.FrameMs.size());
+	std::cout << std::left << std::setw(32) << "call" << std::right << std::setw(14) << "per frame" << std::setw(14) << "ms/frame" << std::endl;
+	for (unsigned int Call : Order)
+	{
+		const GLReplayReport::CallStats& Stats = report.Calls[Call];
+		std::cout << std::left << std::setw(32) << GetGLTraceCallName(Call) << std::right << std::setw(14) << Stats.Count / Frames
+			<< std::setw(14) << Stats.CpuMs / Frames << std::endl;
+	}
+}
+
+void PrintGLReplayDiff(const GLReplayReport& before, const GLReplayReport& after)
+{
+	const double FramesBefore = before.FrameMs.empty() ? 1.0 : static_cast<double>(before.FrameMs.size());
+	const double FramesAfter = after.FrameMs.empty() ? 1.0 : static_cast<double>(after.FrameMs.size());
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << before.Path << " -> " << after.Path << std::endl;
+	std::cout << "frame median " << before.GetMedianFrameMs() << " -> " << after.GetMedianFrameMs() << " ms ("
+		<< std::showpos << after.GetMedianFrameMs() - before.GetMedianFrameMs() << std::noshowpos << "), setup "
+		<< before.SetupMs << " -> " << after.SetupMs << " ms" << std::endl;
+
+	std::cout << std::left << std::setw(32) << "call" << std::right << std::setw(16) << "calls/frame" << std::setw(16) << "ms/frame" << std::endl;
+	for (unsigned int Call = 0; Call < GL_TRACE_CALL_COUNT; Call++)
+	{
+		const double CountBefore = before.Calls[Call].Count / FramesBefore;
+		const double CountAfter = after.Calls[Call].Count / FramesAfter;
+		const double MsBefore = before.Calls[Call].CpuMs / FramesBefore;
+		const double MsAfter = after.Calls[Call].CpuMs / FramesAfter;
+		if (CountBefore == CountAfter && std::abs(MsAfter - MsBefore) < 0.001)
+		{
+			continue;
+		}
+		std::cout << std::left << std::setw(32) << GetGLTraceCallName(Call) << std::right << std::showpos
+			<< std::setw(16) << CountAfter - CountBefore << std::setw(16) << MsAfter - MsBefore << std::noshowpos << std::endl;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "GLTraceFormat.h"
+
+// what a replay of a GLCapture trace measured. Calls and frame times only cover the recorded frames, everything
+// before the first frame marker (resource creation, uploads, the first frame) is SetupMs.
+struct GLReplayReport
+{
+    struct CallStats
+    {
+        unsigned long long Count = 0;
+        double CpuMs = 0.0;     // time spent issuing the call on the CPU
+    };
+
+    std::string Path;
+    std::vector<CallStats> Calls = std::vector<CallStats>(GL_TRACE_CALL_COUNT);
+    std::vector<double> FrameMs;    // CPU issue + glFinish per frame
+    double SetupMs = 0.0;
+    unsigned long long UploadBytes = 0;
+    unsigned long long SkippedRecords = 0;  // too few arguments or a blob shorter than they say, not replayed
+
+    double GetAverageFrameMs() const;
+    double GetMedianFrameMs() const;
+};
+
+// re-executes the trace at path on the current context and measures it. The context must be fresh, object names in
+// the trace are remapped to the ones this context hands out. Rendering goes to whatever framebuffer 0 is.
+bool ReplayGLTrace(const std::string& path, GLReplayReport& outReport);
+
+void PrintGLReplayReport(const GLReplayReport& report);
+
+// per call count and time differences of after against before, for spotting what a change added or removed
+void PrintGLReplayDiff(const GLReplayReport& before, const GLReplayReport& after);
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <glad/glad.h>
+
+// binary GL trace shared by GLCapture (writer) and GLReplay (reader).
+// file: the 8 byte magic, then one record per call:
+//     uint16 call id, uint16 scalar count, uint32 blob bytes, scalar count * uint64 arguments, blob
+// scalars hold the call's plain arguments (floats bit cast, pointers as offsets), the blob the memory they point to
+// (buffer/texture contents, uniform arrays, shader sources, generated object names).
+
+#define GENIX_GL_TRACE_MAGIC "GXGLTRC4"
+
+// objects whose names differ between the capture and the replay context
+enum GLTraceObject
+{
+    GL_TRACE_OBJECT_NONE,
+    GL_TRACE_OBJECT_TEXTURE,
+    GL_TRACE_OBJECT_BUFFER,
+    GL_TRACE_OBJECT_VERTEX_ARRAY,
+    GL_TRACE_OBJECT_FRAMEBUFFER,
+    GL_TRACE_OBJECT_RENDERBUFFER,
+    GL_TRACE_OBJECT_PROGRAM,
+    GL_TRACE_OBJECT_SHADER,
+    GL_TRACE_OBJECT_UNIFORM_LOCATION,   // keyed by the program in use
+    GL_TRACE_OBJECT_UNIFORM_BLOCK,      // keyed by the program in argument 0
+    GL_TRACE_OBJECT_COUNT
+};
+
+// calls whose arguments are all plain values, recorded and replayed generically.
+// X(Name, argument index, object kind, argument index, object kind) lists up to two arguments naming objects (-1 = none)
+#define GENIX_GL_TRACE_SCALAR_CALLS(X) \
+    X(ActiveTexture, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(AttachShader, 0, GL_TRACE_OBJECT_PROGRAM, 1, GL_TRACE_OBJECT_SHADER) \
+    X(BindBuffer, 1, GL_TRACE_OBJECT_BUFFER, -1, GL_TRACE_OBJECT_NONE) \
+    X(BindBufferRange, 2, GL_TRACE_OBJECT_BUFFER, -1, GL_TRACE_OBJECT_NONE) \
+    X(BindFramebuffer, 1, GL_TRACE_OBJECT_FRAMEBUFFER, -1, GL_TRACE_OBJECT_NONE) \
+    X(BindRenderbuffer, 1, GL_TRACE_OBJECT_RENDERBUFFER, -1, GL_TRACE_OBJECT_NONE) \
+    X(BindTexture, 1, GL_TRACE_OBJECT_TEXTURE, -1, GL_TRACE_OBJECT_NONE) \
+    X(BindVertexArray, 0, GL_TRACE_OBJECT_VERTEX_ARRAY, -1, GL_TRACE_OBJECT_NONE) \
+    X(BlendEquation, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(BlendFunc, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(BlitFramebuffer, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(Clear, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(ClearColor, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(ColorMask, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(CompileShader, 0, GL_TRACE_OBJECT_SHADER, -1, GL_TRACE_OBJECT_NONE) \
+    X(CullFace, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DeleteProgram, 0, GL_TRACE_OBJECT_PROGRAM, -1, GL_TRACE_OBJECT_NONE) \
+    X(DeleteShader, 0, GL_TRACE_OBJECT_SHADER, -1, GL_TRACE_OBJECT_NONE) \
+    X(DepthFunc, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DepthMask, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(Disable, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DisableVertexAttribArray, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DrawArrays, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DrawArraysInstanced, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DrawBuffer, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DrawElements, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(DrawElementsInstanced, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(Enable, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(EnableVertexAttribArray, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(FramebufferRenderbuffer, 3, GL_TRACE_OBJECT_RENDERBUFFER, -1, GL_TRACE_OBJECT_NONE) \
+    X(FramebufferTexture, 2, GL_TRACE_OBJECT_TEXTURE, -1, GL_TRACE_OBJECT_NONE) \
+    X(FramebufferTexture2D, 3, GL_TRACE_OBJECT_TEXTURE, -1, GL_TRACE_OBJECT_NONE) \
+    X(FramebufferTextureLayer, 2, GL_TRACE_OBJECT_TEXTURE, -1, GL_TRACE_OBJECT_NONE) \
+    X(GenerateMipmap, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(LinkProgram, 0, GL_TRACE_OBJECT_PROGRAM, -1, GL_TRACE_OBJECT_NONE) \
+    X(PixelStorei, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(PolygonOffset, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(ReadBuffer, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(RenderbufferStorage, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(Scissor, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(TexParameterf, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(TexParameteri, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(Uniform1f, 0, GL_TRACE_OBJECT_UNIFORM_LOCATION, -1, GL_TRACE_OBJECT_NONE) \
+    X(Uniform1i, 0, GL_TRACE_OBJECT_UNIFORM_LOCATION, -1, GL_TRACE_OBJECT_NONE) \
+    X(Uniform2f, 0, GL_TRACE_OBJECT_UNIFORM_LOCATION, -1, GL_TRACE_OBJECT_NONE) \
+    X(Uniform3f, 0, GL_TRACE_OBJECT_UNIFORM_LOCATION, -1, GL_TRACE_OBJECT_NONE) \
+    X(Uniform4f, 0, GL_TRACE_OBJECT_UNIFORM_LOCATION, -1, GL_TRACE_OBJECT_NONE) \
+    X(UniformBlockBinding, 0, GL_TRACE_OBJECT_PROGRAM, 1, GL_TRACE_OBJECT_UNIFORM_BLOCK) \
+    X(UseProgram, 0, GL_TRACE_OBJECT_PROGRAM, -1, GL_TRACE_OBJECT_NONE) \
+    X(VertexAttribDivisor, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(VertexAttribIPointer, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(VertexAttribPointer, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE) \
+    X(Viewport, -1, GL_TRACE_OBJECT_NONE, -1, GL_TRACE_OBJECT_NONE)
+
+// calls that pass or return memory, each has its own record layout (see GLCapture.cpp)
+#define GENIX_GL_TRACE_CUSTOM_CALLS(X) \
+    X(GenTextures) X(GenBuffers) X(GenVertexArrays) X(GenFramebuffers) X(GenRenderbuffers) \
+    X(DeleteTextures) X(DeleteBuffers) X(DeleteVertexArrays) X(DeleteFramebuffers) X(DeleteRenderbuffers) \
+    X(CreateShader) X(CreateProgram) X(ShaderSource) X(GetUniformLocation) X(GetUniformBlockIndex) \
+    X(BufferData) X(BufferSubData) X(TexImage2D) X(TexSubImage2D) X(TexImage3D) X(CompressedTexImage2D) X(DrawBuffers) X(ClearBufferfv) \
+    X(Uniform1fv) X(Uniform2fv) X(Uniform3fv) X(Uniform4fv) \
+    X(Uniform1iv) X(Uniform2iv) X(Uniform3iv) X(Uniform4iv) X(Uniform1uiv) X(Uniform2uiv) X(Uniform3uiv) X(Uniform4uiv) \
+    X(UniformMatrix2fv) X(UniformMatrix3fv) X(UniformMatrix4fv)
+
+#define GENIX_GL_TRACE_ENUM_ENTRY(Name, ...) GL_TRACE_##Name,
+
+enum GLTraceCall : uint16_t
+{
+    GENIX_GL_TRACE_SCALAR_CALLS(GENIX_GL_TRACE_ENUM_ENTRY)
+    GENIX_GL_TRACE_CUSTOM_CALLS(GENIX_GL_TRACE_ENUM_ENTRY)
+    GL_TRACE_MapWrite,      // bytes written through glMapBufferRange, replayed as glBufferSubData
+    GL_TRACE_Frame,         // end of a frame (SwapBuffers)
+    GL_TRACE_CALL_COUNT
+};
+
+// display name of a call id
+const char* GetGLTraceCallName(unsigned int call);
+
+struct GLTraceRecordHeader
+{
+    uint16_t Call;
+    uint16_t ScalarCount;
+    uint32_t BlobBytes;
+};
+
+// argument <-> 64 bit slot, floats keep their bits, pointers are offsets into bound buffers
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, uint64_t>::type ToTraceSlot(T Value)
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(Value));
+}
+
+inline uint64_t ToTraceSlot(float Value)
+{
+    uint32_t Bits;
+    std::memcpy(&Bits, &Value, sizeof(Bits));
+    return Bits;
+}
+
+inline uint64_t ToTraceSlot(const void* Value)
+{
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(Value));
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, T>::type FromTraceSlot(uint64_t Slot)
+{
+    return static_cast<T>(static_cast<int64_t>(Slot));
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, T>::type FromTraceSlot(uint64_t Slot)
+{
+    const uint32_t Bits = static_cast<uint32_t>(Slot);
+    float Value;
+    std::memcpy(&Value, &Bits, sizeof(Value));
+    return Value;
+}
+
+template <typename T>
+typename std::enable_if<std::is_pointer<T>::value, T>::type FromTraceSlot(uint64_t Slot)
+{
+    return reinterpret_cast<T>(static_cast<uintptr_t>(Slot));
+}
+
+// bytes a glTexImage/glTexSubImage upload reads for the given unpack alignment (row length is never changed here)
+size_t GetGLTraceImageBytes(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, GLint alignment);
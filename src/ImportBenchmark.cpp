@@ -0,0 +1,163 @@
+#include "ImportBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <assimp/scene.h>
+
+#include "JobSystem.h"
+#include "Model.h"
+
+namespace
+{
+	// vertices per grid side, every mesh has GridSize^2 vertices and 2 (GridSize - 1)^2 triangles
+	const unsigned int GridSize = 9;
+	const int MeshesPerNode = 100;
+	const int Runs = 3;
+
+	aiMesh* CreateGridMesh(int Index)
+	{
+		aiMesh* Mesh = new aiMesh();
+		Mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		Mesh->mNumVertices = GridSize * GridSize;
+		Mesh->mVertices = new aiVector3D[Mesh->mNumVertices];
+		Mesh->mNormals = new aiVector3D[Mesh->mNumVertices];
+		Mesh->mTangents = new aiVector3D[Mesh->mNumVertices];
+		Mesh->mBitangents = new aiVector3D[Mesh->mNumVertices];
+		Mesh->mTextureCoords[0] = new aiVector3D[Mesh->mNumVertices];
+		Mesh->mNumUVComponents[0] = 2;
+		// every mesh sits somewhere else, so meshes that end up in the wrong slot are told apart
+		const float Offset = static_cast<float>(Index);
+		for (unsigned int y = 0; y < GridSize; y++)
+		{
+			for (unsigned int x = 0; x < GridSize; x++)
+			{
+				const unsigned int i = y * GridSize + x;
+				const float U = static_cast<float>(x) / (GridSize - 1);
+				const float V = static_cast<float>(y) / (GridSize - 1);
+				Mesh->mVertices[i] = aiVector3D(U + Offset, 0.1f * U * V, V);
+				Mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+				Mesh->mTangents[i] = aiVector3D(1.0f, 0.0f, 0.0f);
+				Mesh->mBitangents[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+				Mesh->mTextureCoords[0][i] = aiVector3D(U, V, 0.0f);
+			}
+		}
+		Mesh->mNumFaces = 2 * (GridSize - 1) * (GridSize - 1);
+		Mesh->mFaces = new aiFace[Mesh->mNumFaces];
+		unsigned int Face = 0;
+		for (unsigned int y = 0; y + 1 < GridSize; y++)
+		{
+			for (unsigned int x = 0; x + 1 < GridSize; x++)
+			{
+				const unsigned int Corner = y * GridSize + x;
+				const unsigned int Triangles[2][3] = { { Corner, Corner + GridSize, Corner + 1 }, { Corner + 1, Corner + GridSize, Corner + GridSize + 1 } };
+				for (const unsigned int* Triangle : Triangles)
+				{
+					aiFace& Out = Mesh->mFaces[Face++];
+					Out.mNumIndices = 3;
+					Out.mIndices = new unsigned int[3];
+					std::copy(Triangle, Triangle + 3, Out.mIndices);
+				}
+			}
+		}
+		return Mesh;
+	}
+
+	// a root with one child per MeshesPerNode meshes. The children reference the scene's meshes back to front, so
+	// the node walk order differs from the scene's mesh array.
+	std::unique_ptr<aiScene> CreateScene(int MeshCount)
+	{
+		std::unique_ptr<aiScene> Scene(new aiScene());
+		Scene->mNumMeshes = static_cast<unsigned int>(MeshCount);
+		Scene->mMeshes = new aiMesh*[MeshCount];
+		for (int i = 0; i < MeshCount; i++)
+		{
+			Scene->mMeshes[i] = CreateGridMesh(i);
+		}
+
+		aiNode* Root = new aiNode("Root");
+		const int ChildCount = (MeshCount + MeshesPerNode - 1) / MeshesPerNode;
+		Root->mNumChildren = static_cast<unsigned int>(ChildCount);
+		Root->mChildren = new aiNode*[ChildCount];
+		int Next = MeshCount;
+		for (int Child = 0; Child < ChildCount; Child++)
+		{
+			aiNode* Node = new aiNode("Part");
+			Node->mParent = Root;
+			aiMatrix4x4::Translation(aiVector3D(0.0f, static_cast<float>(Child), 0.0f), Node->mTransformation);
+			Node->mNumMeshes = static_cast<unsigned int>(std::min(MeshesPerNode, Next));
+			Node->mMeshes = new unsigned int[Node->mNumMeshes];
+			for (unsigned int i = 0; i < Node->mNumMeshes; i++)
+			{
+				Node->mMeshes[i] = static_cast<unsigned int>(--Next);
+			}
+			Root->mChildren[Child] = Node;
+		}
+		Scene->mRootNode = Root;
+		return Scene;
+	}
+
+	bool SameVertices(const std::vector<Vertex>& A, const std::vector<Vertex>& B)
+	{
+		// the importer leaves the bone slots uninitialized, only the attributes it writes are compared
+		if (A.size() != B.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < A.size(); i++)
+		{
+			if (A[i].Position != B[i].Position || A[i].Normal != B[i].Normal || A[i].TexCoords != B[i].TexCoords
+				|| A[i].Tangent != B[i].Tangent || A[i].Bitangent != B[i].Bitangent)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+bool RunImportBenchmark(int meshCount)
+{
+	meshCount = std::max(meshCount, 1);
+	const std::unique_ptr<aiScene> Scene = CreateScene(meshCount);
+	std::cout << "Import benchmark, " << meshCount << " meshes of " << GridSize * GridSize << " vertices, "
+		<< JobSystem::Get().GetThreadCount() << " threads" << std::endl;
+
+	// best of Runs, each into a fresh model
+	double BestMs[2] = { 1e30, 1e30 };
+	std::vector<aiMesh*> Queues[2];
+	std::vector<Model::MeshImportData> Results[2];
+	std::vector<uint32_t> Nodes[2];
+	for (int Parallel = 0; Parallel < 2; Parallel++)
+	{
+		for (int Run = 0; Run < Runs; Run++)
+		{
+			Model Imported;
+			Queues[Parallel].clear();
+			Results[Parallel].clear();
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+			Imported.ImportMeshes(Scene.get(), Queues[Parallel], Results[Parallel], Parallel == 1);
+			BestMs[Parallel] = std::min(BestMs[Parallel], std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+			Nodes[Parallel] = Imported.MeshNodes;
+		}
+	}
+
+	// same meshes in the same slots, and the slots follow the node walk (back to front through the scene's array)
+	bool bMatched = Queues[0] == Queues[1] && Nodes[0] == Nodes[1] && Results[0].size() == Results[1].size();
+	for (size_t i = 0; bMatched && i < Results[0].size(); i++)
+	{
+		bMatched = Queues[0][i] == Scene->mMeshes[Results[0].size() - 1 - i]
+			&& SameVertices(Results[0][i].Vertices, Results[1][i].Vertices) && Results[0][i].Indices == Results[1][i].Indices
+			&& Results[0][i].BoundsMin == Results[1][i].BoundsMin && Results[0][i].BoundsMax == Results[1][i].BoundsMax;
+	}
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< "serial    " << std::setw(9) << BestMs[0] << " ms" << std::endl
+		<< "parallel  " << std::setw(9) << BestMs[1] << " ms  (" << std::setprecision(2) << BestMs[0] / std::max(BestMs[1], 1e-6) << "x)" << std::endl
+		<< "output order " << (bMatched ? "identical" : "DIFFERS") << std::endl;
+	return bMatched;
+}
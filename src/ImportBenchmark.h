@@ -0,0 +1,6 @@
+#pragma once
+
+// times the CPU side of Model's import (the node walk and the vertex/index conversion) on a synthetic assimp scene of
+// meshCount small grid meshes, converted on the calling thread and on the JobSystem, and checks that both produce the
+// same meshes in the same order. Needs no assets or GL context. Returns false if the outputs differ.
+bool RunImportBenchmark(int meshCount);
@@ -0,0 +1,122 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#include "Trace.h"
+
+namespace
+{
+	// set on pool threads so nested ParallelFor calls run inline instead of waiting on themselves
+	thread_local bool bIsPoolThread = false;
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem Instance;
+	return Instance;
+}
+
+JobSystem::JobSystem()
+{
+	const unsigned int HardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	// the calling thread always takes part, so one worker less than there are cores
+	for (unsigned int i = 1; i < HardwareThreads; i++)
+	{
+		Workers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Quit = true;
+	}
+	WakeCondition.notify_all();
+	for (auto& Worker : Workers)
+	{
+		Worker.join();
+	}
+}
+
+void JobSystem::ParallelFor(size_t Count, const RangeFunc& Func, size_t Grain)
+{
+	if (Count == 0)
+	{
+		return;
+	}
+	Grain = std::max<size_t>(Grain, 1);
+
+	// not worth waking anybody up (or we are a job ourselves)
+	if (Workers.empty() || bIsPoolThread || Count <= Grain)
+	{
+		Func(0, Count);
+		return;
+	}
+
+	std::lock_guard<std::mutex> BatchLock(BatchMutex);
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		BatchFunc = &Func;
+		BatchCount = Count;
+		BatchGrain = Grain;
+		BatchChunks = (Count + Grain - 1) / Grain;
+		NextChunk = 0;
+		DoneChunks = 0;
+		Generation++;
+	}
+	WakeCondition.notify_all();
+
+	bIsPoolThread = true;
+	RunChunks();
+	bIsPoolThread = false;
+
+	// wait for the chunks other threads picked up, and for every worker to let go of Func
+	std::unique_lock<std::mutex> Lock(Mutex);
+	DoneCondition.wait(Lock, [this] { return DoneChunks == BatchChunks && BusyWorkers == 0; });
+	BatchFunc = nullptr;
+}
+
+void JobSystem::WorkerLoop()
+{
+	bIsPoolThread = true;
+	GENIX_TRACE_THREAD_NAME("Job Worker");
+	unsigned long long SeenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			WakeCondition.wait(Lock, [&] { return Quit || (BatchFunc != nullptr && Generation != SeenGeneration); });
+			if (Quit)
+			{
+				return;
+			}
+			SeenGeneration = Generation;
+			BusyWorkers++;
+		}
+
+		RunChunks();
+
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			BusyWorkers--;
+		}
+		DoneCondition.notify_all();
+	}
+}
+
+void JobSystem::RunChunks()
+{
+	while (true)
+	{
+		const size_t Chunk = NextChunk.fetch_add(1);
+		if (Chunk >= BatchChunks)
+		{
+			return;
+		}
+		const size_t Begin = Chunk * BatchGrain;
+		const size_t End = std::min(Begin + BatchGrain, BatchCount);
+		(*BatchFunc)(Begin, End);
+		DoneChunks.fetch_add(1);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// small fork/join thread pool. Worker threads are created once and sleep until ParallelFor hands them a range to chew on.
+class JobSystem
+{
+public:
+
+    // range callback, processes the items in [Begin, End)
+    using RangeFunc = std::function<void(size_t Begin, size_t End)>;
+
+    // returns the process-wide pool (created on first use)
+    static JobSystem& Get();
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // number of threads that take part in a ParallelFor (workers + the calling thread)
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(Workers.size()) + 1; }
+
+    // splits [0, Count) into chunks of Grain items and runs Func on them from all threads. Blocks until every chunk is done.
+    // the calling thread helps out, so calling this from inside a job simply runs the whole range inline.
+    void ParallelFor(size_t Count, const RangeFunc& Func, size_t Grain = 1);
+
+private:
+
+    JobSystem();
+
+    void WorkerLoop();
+
+    // grabs chunks of the current batch until there are none left
+    void RunChunks();
+
+    std::vector<std::thread> Workers;
+
+    std::mutex Mutex;
+    std::condition_variable WakeCondition;
+    std::condition_variable DoneCondition;
+
+    // serializes ParallelFor calls coming from different threads
+    std::mutex BatchMutex;
+
+    // current batch
+    const RangeFunc* BatchFunc = nullptr;
+    size_t BatchCount = 0;
+    size_t BatchGrain = 1;
+    size_t BatchChunks = 0;
+    std::atomic<size_t> NextChunk{ 0 };
+    std::atomic<size_t> DoneChunks{ 0 };
+    unsigned long long Generation = 0;
+    unsigned int BusyWorkers = 0;
+    bool Quit = false;
+};
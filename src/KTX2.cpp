@@ -0,0 +1,214 @@
+#include "KTX2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const unsigned char KTX2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	// Khronos Data Format values used in the descriptor
+	const unsigned int KHR_DF_MODEL_BC1A = 128;
+	const unsigned int KHR_DF_MODEL_BC3 = 130;
+	const unsigned int KHR_DF_MODEL_BC5 = 132;
+	const unsigned int KHR_DF_PRIMARIES_BT709 = 1;
+	const unsigned int KHR_DF_TRANSFER_LINEAR = 1;
+	const unsigned int KHR_DF_TRANSFER_SRGB = 2;
+	const unsigned int KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+
+	void PutU32(std::vector<unsigned char>& Out, unsigned int Value)
+	{
+		for (int b = 0; b < 4; b++)
+		{
+			Out.push_back(static_cast<unsigned char>((Value >> (b * 8)) & 0xFF));
+		}
+	}
+
+	void PutU64(std::vector<unsigned char>& Out, unsigned long long Value)
+	{
+		for (int b = 0; b < 8; b++)
+		{
+			Out.push_back(static_cast<unsigned char>((Value >> (b * 8)) & 0xFF));
+		}
+	}
+
+	unsigned int GetU32(const unsigned char* Data)
+	{
+		return Data[0] | (Data[1] << 8) | (Data[2] << 16) | (static_cast<unsigned int>(Data[3]) << 24);
+	}
+
+	unsigned long long GetU64(const unsigned char* Data)
+	{
+		return GetU32(Data) | (static_cast<unsigned long long>(GetU32(Data + 4)) << 32);
+	}
+
+	// one sample of the data format descriptor: which bits of the block hold which channel
+	void PutSample(std::vector<unsigned char>& Out, unsigned int BitOffset, unsigned int Channel)
+	{
+		PutU32(Out, BitOffset | (63u << 16) | (Channel << 24));
+		PutU32(Out, 0);             // sample position
+		PutU32(Out, 0);             // lower
+		PutU32(Out, 0xFFFFFFFFu);   // upper
+	}
+
+	// basic data format descriptor for the block formats we write
+	std::vector<unsigned char> BuildDescriptor(unsigned int VkFormat)
+	{
+		unsigned int Model = KHR_DF_MODEL_BC1A;
+		unsigned int BlockBytes = 8;
+		bool bSRGB = false;
+		switch (VkFormat)
+		{
+		case 132: bSRGB = true; // fall through
+		case 131: Model = KHR_DF_MODEL_BC1A; BlockBytes = 8; break;
+		case 138: bSRGB = true; // fall through
+		case 137: Model = KHR_DF_MODEL_BC3; BlockBytes = 16; break;
+		default:  Model = KHR_DF_MODEL_BC5; BlockBytes = 16; break;
+		}
+		const unsigned int SampleCount = Model == KHR_DF_MODEL_BC1A ? 1 : 2;
+
+		std::vector<unsigned char> Block;
+		PutU32(Block, 0); // vendor Khronos, basic descriptor type
+		PutU32(Block, 2 | ((24 + 16 * SampleCount) << 16)); // version 2, block size
+		PutU32(Block, Model | (KHR_DF_PRIMARIES_BT709 << 8) | ((bSRGB ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16));
+		PutU32(Block, 3 | (3 << 8)); // 4x4x1x1 texel block, stored minus one
+		PutU32(Block, BlockBytes);
+		PutU32(Block, 0);
+		if (Model == KHR_DF_MODEL_BC1A)
+		{
+			PutSample(Block, 0, 0);
+		}
+		else if (Model == KHR_DF_MODEL_BC3)
+		{
+			// alpha is never sRGB encoded
+			PutSample(Block, 0, 15 | KHR_DF_SAMPLE_DATATYPE_LINEAR);
+			PutSample(Block, 64, 0);
+		}
+		else
+		{
+			PutSample(Block, 0, 0);
+			PutSample(Block, 64, 1);
+		}
+
+		std::vector<unsigned char> Descriptor;
+		PutU32(Descriptor, static_cast<unsigned int>(Block.size()) + 4);
+		Descriptor.insert(Descriptor.end(), Block.begin(), Block.end());
+		return Descriptor;
+	}
+}
+
+unsigned int GetVkFormat(BlockFormat Format, bool bSRGB)
+{
+	switch (Format)
+	{
+	case BLOCK_BC1: return bSRGB ? 132 : 131;   // VK_FORMAT_BC1_RGB_SRGB_BLOCK / VK_FORMAT_BC1_RGB_UNORM_BLOCK
+	case BLOCK_BC3: return bSRGB ? 138 : 137;   // VK_FORMAT_BC3_SRGB_BLOCK / VK_FORMAT_BC3_UNORM_BLOCK
+	default:        return 141;                 // VK_FORMAT_BC5_UNORM_BLOCK
+	}
+}
+
+bool WriteKTX2(const std::string& Path, const KTX2Image& Image)
+{
+	const unsigned int LevelCount = static_cast<unsigned int>(Image.Levels.size());
+	const std::vector<unsigned char> Descriptor = BuildDescriptor(Image.VkFormat);
+	// mip levels are aligned to lcm(block size, 4)
+	const size_t Alignment = (Image.VkFormat == 131 || Image.VkFormat == 132) ? 8 : 16;
+
+	const size_t DescriptorOffset = 12 + 9 * 4 + 4 * 4 + 2 * 8 + LevelCount * 3 * 8;
+
+	// levels are stored smallest first, so compute their offsets from the back
+	std::vector<unsigned long long> LevelOffsets(LevelCount);
+	size_t Offset = DescriptorOffset + Descriptor.size();
+	for (int Level = static_cast<int>(LevelCount) - 1; Level >= 0; Level--)
+	{
+		Offset = (Offset + Alignment - 1) / Alignment * Alignment;
+		LevelOffsets[Level] = Offset;
+		Offset += Image.Levels[Level].size();
+	}
+
+	std::vector<unsigned char> File(KTX2Identifier, KTX2Identifier + 12);
+	PutU32(File, Image.VkFormat);
+	PutU32(File, 1);    // typeSize, 1 for block compressed data
+	PutU32(File, static_cast<unsigned int>(Image.Width));
+	PutU32(File, static_cast<unsigned int>(Image.Height));
+	PutU32(File, 0);    // pixelDepth
+	PutU32(File, 0);    // layerCount
+	PutU32(File, 1);    // faceCount
+	PutU32(File, LevelCount);
+	PutU32(File, 0);    // no supercompression
+
+	PutU32(File, static_cast<unsigned int>(DescriptorOffset));
+	PutU32(File, static_cast<unsigned int>(Descriptor.size()));
+	PutU32(File, 0);    // no key/value data
+	PutU32(File, 0);
+	PutU64(File, 0);    // no supercompression global data
+	PutU64(File, 0);
+
+	for (unsigned int Level = 0; Level < LevelCount; Level++)
+	{
+		PutU64(File, LevelOffsets[Level]);
+		PutU64(File, Image.Levels[Level].size());
+		PutU64(File, Image.Levels[Level].size());
+	}
+	File.insert(File.end(), Descriptor.begin(), Descriptor.end());
+
+	for (int Level = static_cast<int>(LevelCount) - 1; Level >= 0; Level--)
+	{
+		File.resize(LevelOffsets[Level], 0);
+		File.insert(File.end(), Image.Levels[Level].begin(), Image.Levels[Level].end());
+	}
+
+	std::ofstream Stream(Path, std::ios::binary | std::ios::trunc);
+	if (!Stream)
+	{
+		return false;
+	}
+	Stream.write(reinterpret_cast<const char*>(File.data()), static_cast<std::streamsize>(File.size()));
+	return static_cast<bool>(Stream);
+}
+
+bool ReadKTX2(const std::string& Path, KTX2Image& OutImage)
+{
+	std::ifstream Stream(Path, std::ios::binary);
+	if (!Stream)
+	{
+		return false;
+	}
+	std::vector<unsigned char> File((std::istreambuf_iterator<char>(Stream)), std::istreambuf_iterator<char>());
+
+	const size_t HeaderSize = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+	if (File.size() < HeaderSize || std::memcmp(File.data(), KTX2Identifier, 12) != 0)
+	{
+		return false;
+	}
+
+	const unsigned char* Header = File.data() + 12;
+	const unsigned int LevelCount = std::max(1u, GetU32(Header + 28));
+	if (GetU32(Header + 32) != 0 || GetU32(Header + 20) > 1 || GetU32(Header + 24) != 1)
+	{
+		return false; // supercompressed, array or cube map: not something we write
+	}
+	if (File.size() < HeaderSize + LevelCount * 3 * 8)
+	{
+		return false;
+	}
+
+	OutImage.VkFormat = GetU32(Header);
+	OutImage.Width = static_cast<int>(GetU32(Header + 8));
+	OutImage.Height = static_cast<int>(GetU32(Header + 12));
+	OutImage.Levels.assign(LevelCount, std::vector<unsigned char>());
+
+	const unsigned char* LevelIndex = File.data() + HeaderSize;
+	for (unsigned int Level = 0; Level < LevelCount; Level++)
+	{
+		const unsigned long long Offset = GetU64(LevelIndex + Level * 24);
+		const unsigned long long Length = GetU64(LevelIndex + Level * 24 + 8);
+		if (Offset + Length > File.size())
+		{
+			return false;
+		}
+		OutImage.Levels[Level].assign(File.begin() + static_cast<size_t>(Offset), File.begin() + static_cast<size_t>(Offset + Length));
+	}
+	return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+// minimal KTX2 container support for the compressed texture cache: single 2D image, full mip chain,
+// block compressed formats only, no supercompression and no key/value data.
+struct KTX2Image
+{
+    unsigned int VkFormat = 0;               // VK_FORMAT_* of the data
+    int Width = 0;
+    int Height = 0;
+    std::vector<std::vector<unsigned char>> Levels;   // level 0 is the full size image
+};
+
+// VK_FORMAT_* value for a block format (sRGB variants only exist for color formats)
+unsigned int GetVkFormat(BlockFormat Format, bool bSRGB);
+
+// writes the image to disk, returns false if the file can't be written
+bool WriteKTX2(const std::string& Path, const KTX2Image& Image);
+
+// reads a file written by WriteKTX2 (or any other KTX2 file without supercompression), returns false if it can't be used
+bool ReadKTX2(const std::string& Path, KTX2Image& OutImage);
@@ -0,0 +1,109 @@
+#include "MemoryBenchmark.h"
+
+#include <cstddef>
+#include <fstream>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <glad/glad.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "Model.h"
+
+namespace
+{
+	struct MemoryUsage
+	{
+		size_t Resident = 0;
+		size_t Peak = 0;
+	};
+
+	MemoryUsage QueryMemory()
+	{
+		MemoryUsage Usage;
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS Counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+		{
+			Usage.Resident = Counters.WorkingSetSize;
+			Usage.Peak = Counters.PeakWorkingSetSize;
+		}
+#else
+		// "VmRSS:     1234 kB"
+		std::ifstream Status("/proc/self/status");
+		std::string Line;
+		while (std::getline(Status, Line))
+		{
+			std::istringstream Fields(Line);
+			std::string Key;
+			size_t Kilobytes = 0;
+			Fields >> Key >> Kilobytes;
+			if (Key == "VmRSS:")
+			{
+				Usage.Resident = Kilobytes * 1024;
+			}
+			else if (Key == "VmHWM:")
+			{
+				Usage.Peak = Kilobytes * 1024;
+			}
+		}
+#endif
+		return Usage;
+	}
+
+	// hands freed heap back to the system and restarts the peak where the platform allows it
+	void ResetPeak()
+	{
+#ifdef __GLIBC__
+		malloc_trim(0);
+#endif
+#ifdef __linux__
+		std::ofstream ClearRefs("/proc/self/clear_refs");
+		ClearRefs << "5";
+#endif
+	}
+
+	double Megabytes(double Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+}
+
+bool RunMemoryBenchmark(const std::string& path)
+{
+	std::cout << "Memory benchmark, " << path << std::endl;
+	bool bLoaded = true;
+	for (const bool bKeepCpuData : { false, true })
+	{
+		glFinish();
+		ResetPeak();
+		const MemoryUsage Before = QueryMemory();
+		size_t CpuGeometry = 0;
+		size_t MeshCount = 0;
+		MemoryUsage After;
+		{
+			Model Loaded(path, false, bKeepCpuData);
+			glFinish();
+			After = QueryMemory();
+			MeshCount = Loaded.Meshes.size();
+			for (const Mesh& Part : Loaded.Meshes)
+			{
+				CpuGeometry += Part.Vertices.capacity() * sizeof(Vertex) + Part.Indices.capacity() * sizeof(unsigned int);
+			}
+		}
+		bLoaded = bLoaded && MeshCount > 0;
+		std::cout << std::left << std::setw(18) << (bKeepCpuData ? "keep CPU data" : "free CPU data") << std::right << std::fixed << std::setprecision(1)
+			<< "resident +" << std::setw(7) << Megabytes(static_cast<double>(After.Resident) - Before.Resident) << " MB"
+			<< "  peak +" << std::setw(7) << Megabytes(static_cast<double>(After.Peak) - Before.Resident) << " MB"
+			<< " (" << Megabytes(static_cast<double>(After.Peak)) << " MB total)"
+			<< "  CPU geometry " << std::setw(6) << Megabytes(static_cast<double>(CpuGeometry)) << " MB in " << MeshCount << " meshes" << std::endl;
+	}
+	return bLoaded;
+}
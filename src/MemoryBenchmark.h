@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+// loads the model at path twice, with Model's keepCpuData off and on, and prints the resident memory each load adds
+// and its peak, plus the CPU geometry the model keeps. Needs the GL context (the meshes are uploaded). On Linux the
+// peak is reset before each load (/proc/self/clear_refs), elsewhere it is the peak of the process so far, which is why
+// the load without CPU data runs first. Returns false if the model has no meshes.
+bool RunMemoryBenchmark(const std::string& path);
@@ -1,17 +1,52 @@
 ﻿#include "Mesh.h"
 #include "Shader.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned> indices, std::vector<Texture> textures)
-{
-	this->Vertices = vertices;
-	this->Indices = indices;
-	this->Textures = textures;
+#include <utility>
 
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned> indices, std::vector<Texture> textures, bool keepCpuData)
+	: Vertices(std::move(vertices)), Indices(std::move(indices)), Textures(std::move(textures)), IndexCount(static_cast<unsigned int>(Indices.size()))
+{
 	// now that we have all the required data, set the vertex buffers and its attribute pointers.
 	SetupMesh();
+
+	if (!keepCpuData)
+	{
+		ReleaseCpuData();
+	}
+}
+
+void Mesh::ReleaseCpuData()
+{
+	// swap with empty vectors, clear() alone would keep the capacity around
+	std::vector<Vertex>().swap(Vertices);
+	std::vector<unsigned int>().swap(Indices);
 }
 
 void Mesh::Draw(Shader& Shader)
+{
+	BindTextures(Shader);
+
+	// draw mesh
+	glBindVertexArray(VAO);
+	glDrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+
+	// always good practice to set everything back to defaults once configured.
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::DrawLayers(Shader& Shader, unsigned int layerCount)
+{
+	BindTextures(Shader);
+
+	glBindVertexArray(VAO);
+	glDrawElementsInstanced(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, 0, layerCount);
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::BindTextures(Shader& Shader)
 {
 	// bind appropriate textures
 	unsigned int DiffuseNr  = 1;
@@ -42,18 +77,10 @@ void Mesh::Draw(Shader& Shader)
 		}
 
 		// now set the sampler to the correct texture unit
-		glUniform1i(glGetUniformLocation(Shader.ID, (Name + Number).c_str()), i);
+		Shader.SetInt(Name + Number, i);
 		// and finally bind the texture
 		glBindTexture(GL_TEXTURE_2D, Textures[i].ID);
 	}
-        
-	// draw mesh
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(Indices.size()), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
-
-	// always good practice to set everything back to defaults once configured.
-	glActiveTexture(GL_TEXTURE0);
 }
 
 void Mesh::SetupMesh()
@@ -36,16 +36,27 @@ struct Texture {
 class Mesh {
 public:
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
+    // takes the data by value and moves it into the members, so callers passing temporaries (std::move) never copy the geometry.
+    // with keepCpuData = false the vertex/index arrays are freed as soon as they are uploaded to the GPU.
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, bool keepCpuData = true);
 
     // render the mesh
     void Draw(Shader &Shader);
 
+    // renders layerCount copies without per instance attributes, the shader tells them apart by gl_InstanceID
+    // (layered rendering, e.g. one copy per cube map face).
+    void DrawLayers(Shader &Shader, unsigned int layerCount);
+
+    // frees the CPU copy of the vertex/index data. The GPU buffers stay untouched, so the mesh can still be drawn.
+    void ReleaseCpuData();
+
     // mesh Data
     std::vector<Vertex>       Vertices;
     std::vector<unsigned int> Indices;
     std::vector<Texture>      Textures;
     unsigned int VAO;
+    // number of indices uploaded to the EBO (still valid after ReleaseCpuData)
+    unsigned int IndexCount;
 
 private:
     // render data 
@@ -53,4 +64,7 @@ private:
 
     // initializes all the buffer objects/arrays
     void SetupMesh();
+
+    // binds the textures and sets the sampler uniforms
+    void BindTextures(Shader &Shader);
 };
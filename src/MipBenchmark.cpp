@@ -0,0 +1,90 @@
+#include "MipBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MipmapBuilder.h"
+
+namespace
+{
+	// largest difference of any byte of any level, the chains have the same shape
+	int MaxLevelDifference(const std::vector<MipLevel>& A, const std::vector<MipLevel>& B)
+	{
+		if (A.size() != B.size())
+		{
+			return 256;
+		}
+		int MaxDifference = 0;
+		for (size_t Level = 0; Level < A.size(); Level++)
+		{
+			for (size_t i = 0; i < A[Level].Data.size(); i++)
+			{
+				MaxDifference = std::max(MaxDifference, std::abs(A[Level].Data[i] - B[Level].Data[i]));
+			}
+		}
+		return MaxDifference;
+	}
+}
+
+bool RunMipBenchmark(int size, int iterations)
+{
+	size = std::max(size, 1);
+	iterations = std::max(iterations, 1);
+	std::cout << "Mip chain benchmark " << size << "x" << size << " RGBA sRGB, " << iterations << " iterations, "
+		<< JobSystem::Get().GetThreadCount() << " threads" << (IsMipChainSIMDAvailable() ? "" : " (no SSE in this build)") << std::endl;
+
+	std::default_random_engine Generator;
+	std::uniform_int_distribution<int> Byte(0, 255);
+	std::vector<unsigned char> Pixels(static_cast<size_t>(size) * size * 4);
+	std::generate(Pixels.begin(), Pixels.end(), [&]() { return static_cast<unsigned char>(Byte(Generator)); });
+
+	bool bMatched = true;
+	for (const MipFilter Filter : { MIP_FILTER_BOX, MIP_FILTER_KAISER })
+	{
+		std::vector<MipLevel> Reference;
+		for (int Variant = 0; Variant < 4; Variant++)
+		{
+			MipChainSettings Settings;
+			Settings.Filter = Filter;
+			Settings.bSRGB = true;
+			Settings.bParallel = (Variant & 1) != 0;
+			Settings.bSIMD = (Variant & 2) != 0;
+			if (Settings.bSIMD && !IsMipChainSIMDAvailable())
+			{
+				continue;
+			}
+
+			std::vector<MipLevel> Levels = BuildMipChain(Pixels.data(), size, size, 4, Settings);
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; i++)
+			{
+				Levels = BuildMipChain(Pixels.data(), size, size, 4, Settings);
+			}
+			const double Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / iterations;
+
+			// the first variant (scalar on the calling thread) is the reference
+			int Difference = 0;
+			if (Reference.empty())
+			{
+				Reference = std::move(Levels);
+			}
+			else
+			{
+				Difference = MaxLevelDifference(Reference, Levels);
+			}
+			// the SSE path runs the same float operations in the same order, only the scheduling may differ
+			bMatched = bMatched && Difference == 0;
+			std::cout << std::left << std::setw(7) << (Filter == MIP_FILTER_BOX ? "box" : "Kaiser") << std::setw(9) << (Settings.bParallel ? "jobs" : "serial")
+				<< std::setw(7) << (Settings.bSIMD ? "SSE" : "scalar") << std::right << std::fixed << std::setprecision(3) << std::setw(10) << Ms << " ms"
+				<< "  max difference " << Difference << std::endl;
+		}
+	}
+	return bMatched;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// times BuildMipChain on a random sRGB RGBA image of size x size for every combination of filter (box, Kaiser), row
+// scheduling (calling thread, JobSystem) and texel math (scalar, SSE where the build has it), averaged over
+// iterations, and checks that all variants of a filter produce the same levels. CPU only, no GL context needed.
+// Returns false if any variant differs.
+bool RunMipBenchmark(int size, int iterations);
@@ -0,0 +1,427 @@
+#include "MipmapBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "JobSystem.h"
+#include "Trace.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GENIX_MIPMAP_SSE 1
+#else
+#define GENIX_MIPMAP_SSE 0
+#endif
+
+namespace
+{
+	// one RGBA texel in float, filtered as a whole. The filters are templates over the texel type, so the SSE version
+	// (a single register) and the portable one can both be built and compared (--mip-bench)
+	struct ScalarTexel
+	{
+		float V[4];
+
+		static ScalarTexel Load(const float* Source)
+		{
+			ScalarTexel Result;
+			for (int c = 0; c < 4; c++) Result.V[c] = Source[c];
+			return Result;
+		}
+
+		void Store(float* Dest) const
+		{
+			for (int c = 0; c < 4; c++) Dest[c] = V[c];
+		}
+
+		static ScalarTexel Zero()
+		{
+			ScalarTexel Result;
+			for (int c = 0; c < 4; c++) Result.V[c] = 0.0f;
+			return Result;
+		}
+
+		static ScalarTexel Add(const ScalarTexel& A, const ScalarTexel& B)
+		{
+			ScalarTexel Result;
+			for (int c = 0; c < 4; c++) Result.V[c] = A.V[c] + B.V[c];
+			return Result;
+		}
+
+		// Accum + Texel * Weight
+		static ScalarTexel MultiplyAdd(const ScalarTexel& Accum, const ScalarTexel& Texel, float Weight)
+		{
+			ScalarTexel Result;
+			for (int c = 0; c < 4; c++) Result.V[c] = Accum.V[c] + Texel.V[c] * Weight;
+			return Result;
+		}
+	};
+
+#if GENIX_MIPMAP_SSE
+	struct SSETexel
+	{
+		__m128 V;
+
+		static SSETexel Load(const float* Source)
+		{
+			SSETexel Result;
+			Result.V = _mm_loadu_ps(Source);
+			return Result;
+		}
+
+		void Store(float* Dest) const
+		{
+			_mm_storeu_ps(Dest, V);
+		}
+
+		static SSETexel Zero()
+		{
+			SSETexel Result;
+			Result.V = _mm_setzero_ps();
+			return Result;
+		}
+
+		static SSETexel Add(const SSETexel& A, const SSETexel& B)
+		{
+			SSETexel Result;
+			Result.V = _mm_add_ps(A.V, B.V);
+			return Result;
+		}
+
+		static SSETexel MultiplyAdd(const SSETexel& Accum, const SSETexel& Texel, float Weight)
+		{
+			SSETexel Result;
+			Result.V = _mm_add_ps(Accum.V, _mm_mul_ps(Texel.V, _mm_set1_ps(Weight)));
+			return Result;
+		}
+	};
+#endif
+
+	// a float RGBA image, the working format while filtering
+	struct FloatImage
+	{
+		int Width = 0;
+		int Height = 0;
+		std::vector<float> Texels;
+
+		const float* At(int X, int Y) const { return &Texels[(static_cast<size_t>(Y) * Width + X) * 4]; }
+		float* At(int X, int Y) { return &Texels[(static_cast<size_t>(Y) * Width + X) * 4]; }
+	};
+
+	// rows per job: roughly the same amount of texels per chunk no matter how wide the level is
+	size_t GetRowGrain(int Width)
+	{
+		return static_cast<size_t>(std::max(1, 16384 / std::max(Width, 1)));
+	}
+
+	// rows [0, Count) on the JobSystem, or in order on this thread
+	void ForRows(bool bParallel, size_t Count, const JobSystem::RangeFunc& Func, size_t Grain)
+	{
+		if (bParallel)
+		{
+			JobSystem::Get().ParallelFor(Count, Func, Grain);
+		}
+		else
+		{
+			Func(0, Count);
+		}
+	}
+
+	float SRGBToLinear(float Value)
+	{
+		return Value <= 0.04045f ? Value / 12.92f : std::pow((Value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float Value)
+	{
+		return Value <= 0.0031308f ? Value * 12.92f : 1.055f * std::pow(Value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// lookup tables so the per texel conversions are a load
+	struct ColorTables
+	{
+		float ToLinear[256];
+		unsigned char ToSRGB[4096];
+
+		ColorTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				ToLinear[i] = SRGBToLinear(i / 255.0f);
+			}
+			for (int i = 0; i < 4096; i++)
+			{
+				ToSRGB[i] = static_cast<unsigned char>(LinearToSRGB(i / 4095.0f) * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	const ColorTables& GetColorTables()
+	{
+		static const ColorTables Tables;
+		return Tables;
+	}
+
+	// zeroth order modified Bessel function of the first kind, series expansion
+	double BesselI0(double X)
+	{
+		double Sum = 1.0, Term = 1.0;
+		for (int k = 1; k < 20; k++)
+		{
+			Term *= (X / (2.0 * k)) * (X / (2.0 * k));
+			Sum += Term;
+		}
+		return Sum;
+	}
+
+	// taps of the 2:1 Kaiser windowed sinc, source texels 2i-2 .. 2i+3 for destination texel i
+	const int KaiserTaps = 6;
+	struct KaiserKernel
+	{
+		float Weights[KaiserTaps];
+
+		KaiserKernel()
+		{
+			const double Alpha = 4.0;
+			const double Support = 1.5; // in destination texels
+			double Sum = 0.0;
+			for (int t = 0; t < KaiserTaps; t++)
+			{
+				// distance of the source texel center from the destination texel center, in destination texels
+				const double D = (t - 2 + 0.5 - 1.0) / 2.0;
+				const double Sinc = D == 0.0 ? 1.0 : std::sin(3.14159265358979 * D) / (3.14159265358979 * D);
+				const double X = D / Support;
+				const double Window = std::fabs(X) < 1.0 ? BesselI0(Alpha * std::sqrt(1.0 - X * X)) / BesselI0(Alpha) : 0.0;
+				Weights[t] = static_cast<float>(Sinc * Window);
+				Sum += Weights[t];
+			}
+			for (int t = 0; t < KaiserTaps; t++)
+			{
+				Weights[t] = static_cast<float>(Weights[t] / Sum);
+			}
+		}
+	};
+
+	const KaiserKernel& GetKaiserKernel()
+	{
+		static const KaiserKernel Kernel;
+		return Kernel;
+	}
+
+	void DecodeLevel(const unsigned char* Pixels, int Components, const MipChainSettings& Settings, FloatImage& Out)
+	{
+		const ColorTables& Tables = GetColorTables();
+		ForRows(Settings.bParallel, static_cast<size_t>(Out.Height), [&](size_t Begin, size_t End)
+		{
+			for (size_t y = Begin; y < End; y++)
+			{
+				for (int x = 0; x < Out.Width; x++)
+				{
+					const unsigned char* Source = Pixels + (y * Out.Width + x) * Components;
+					float* Dest = Out.At(x, static_cast<int>(y));
+					Dest[0] = Dest[1] = Dest[2] = 0.0f;
+					Dest[3] = 1.0f;
+					for (int c = 0; c < Components; c++)
+					{
+						if (c < 3 && Settings.bNormalMap)
+						{
+							Dest[c] = Source[c] / 127.5f - 1.0f;
+						}
+						else if (c < 3 && Settings.bSRGB)
+						{
+							Dest[c] = Tables.ToLinear[Source[c]];
+						}
+						else
+						{
+							Dest[c] = Source[c] / 255.0f;
+						}
+					}
+				}
+			}
+		}, GetRowGrain(Out.Width));
+	}
+
+	void EncodeLevel(const FloatImage& Source, int Components, const MipChainSettings& Settings, MipLevel& Out)
+	{
+		const ColorTables& Tables = GetColorTables();
+		Out.Width = Source.Width;
+		Out.Height = Source.Height;
+		Out.Data.resize(static_cast<size_t>(Source.Width) * Source.Height * Components);
+		ForRows(Settings.bParallel, static_cast<size_t>(Source.Height), [&](size_t Begin, size_t End)
+		{
+			for (size_t y = Begin; y < End; y++)
+			{
+				for (int x = 0; x < Source.Width; x++)
+				{
+					float Texel[4];
+					std::copy(Source.At(x, static_cast<int>(y)), Source.At(x, static_cast<int>(y)) + 4, Texel);
+					if (Settings.bNormalMap)
+					{
+						// averaged unit vectors get shorter, push them back onto the sphere
+						const float Length = std::sqrt(Texel[0] * Texel[0] + Texel[1] * Texel[1] + Texel[2] * Texel[2]);
+						for (int c = 0; c < 3; c++)
+						{
+							Texel[c] = (Length > 1e-6f ? Texel[c] / Length : (c == 2 ? 1.0f : 0.0f)) * 0.5f + 0.5f;
+						}
+					}
+
+					unsigned char* Dest = &Out.Data[(y * Source.Width + x) * Components];
+					for (int c = 0; c < Components; c++)
+					{
+						const float Value = std::min(1.0f, std::max(0.0f, Texel[c]));
+						if (c < 3 && Settings.bSRGB && !Settings.bNormalMap)
+						{
+							Dest[c] = Tables.ToSRGB[static_cast<int>(Value * 4095.0f + 0.5f)];
+						}
+						else
+						{
+							Dest[c] = static_cast<unsigned char>(Value * 255.0f + 0.5f);
+						}
+					}
+				}
+			}
+		}, GetRowGrain(Source.Width));
+	}
+
+	template <typename Texel>
+	void DownsampleBox(const FloatImage& Source, FloatImage& Dest, bool bParallel)
+	{
+		ForRows(bParallel, static_cast<size_t>(Dest.Height), [&](size_t Begin, size_t End)
+		{
+			for (size_t y = Begin; y < End; y++)
+			{
+				const int Y0 = std::min(static_cast<int>(y) * 2, Source.Height - 1);
+				const int Y1 = std::min(static_cast<int>(y) * 2 + 1, Source.Height - 1);
+				for (int x = 0; x < Dest.Width; x++)
+				{
+					const int X0 = std::min(x * 2, Source.Width - 1);
+					const int X1 = std::min(x * 2 + 1, Source.Width - 1);
+					const Texel Sum = Texel::Add(Texel::Add(Texel::Load(Source.At(X0, Y0)), Texel::Load(Source.At(X1, Y0))),
+						Texel::Add(Texel::Load(Source.At(X0, Y1)), Texel::Load(Source.At(X1, Y1))));
+					Texel::MultiplyAdd(Texel::Zero(), Sum, 0.25f).Store(Dest.At(x, static_cast<int>(y)));
+				}
+			}
+		}, GetRowGrain(Dest.Width));
+	}
+
+	template <typename Texel>
+	void DownsampleKaiser(const FloatImage& Source, FloatImage& Dest, bool bParallel)
+	{
+		const KaiserKernel& Kernel = GetKaiserKernel();
+
+		// horizontal pass into a half width image, then vertical into the destination
+		FloatImage Horizontal;
+		Horizontal.Width = Dest.Width;
+		Horizontal.Height = Source.Height;
+		Horizontal.Texels.resize(static_cast<size_t>(Horizontal.Width) * Horizontal.Height * 4);
+
+		ForRows(bParallel, static_cast<size_t>(Source.Height), [&](size_t Begin, size_t End)
+		{
+			for (size_t y = Begin; y < End; y++)
+			{
+				for (int x = 0; x < Horizontal.Width; x++)
+				{
+					Texel Sum = Texel::Zero();
+					for (int t = 0; t < KaiserTaps; t++)
+					{
+						const int SourceX = std::min(std::max(x * 2 - 2 + t, 0), Source.Width - 1);
+						Sum = Texel::MultiplyAdd(Sum, Texel::Load(Source.At(SourceX, static_cast<int>(y))), Kernel.Weights[t]);
+					}
+					Sum.Store(Horizontal.At(x, static_cast<int>(y)));
+				}
+			}
+		}, GetRowGrain(Horizontal.Width));
+
+		ForRows(bParallel, static_cast<size_t>(Dest.Height), [&](size_t Begin, size_t End)
+		{
+			for (size_t y = Begin; y < End; y++)
+			{
+				for (int x = 0; x < Dest.Width; x++)
+				{
+					Texel Sum = Texel::Zero();
+					for (int t = 0; t < KaiserTaps; t++)
+					{
+						const int SourceY = std::min(std::max(static_cast<int>(y) * 2 - 2 + t, 0), Horizontal.Height - 1);
+						Sum = Texel::MultiplyAdd(Sum, Texel::Load(Horizontal.At(x, SourceY)), Kernel.Weights[t]);
+					}
+					Sum.Store(Dest.At(x, static_cast<int>(y)));
+				}
+			}
+		}, GetRowGrain(Dest.Width));
+	}
+
+	template <typename Texel>
+	void DownsampleWith(const FloatImage& Source, FloatImage& Dest, const MipChainSettings& Settings)
+	{
+		if (Settings.Filter == MIP_FILTER_KAISER)
+		{
+			DownsampleKaiser<Texel>(Source, Dest, Settings.bParallel);
+		}
+		else
+		{
+			DownsampleBox<Texel>(Source, Dest, Settings.bParallel);
+		}
+	}
+
+	void Downsample(const FloatImage& Source, FloatImage& Dest, const MipChainSettings& Settings)
+	{
+#if GENIX_MIPMAP_SSE
+		if (Settings.bSIMD)
+		{
+			DownsampleWith<SSETexel>(Source, Dest, Settings);
+			return;
+		}
+#endif
+		DownsampleWith<ScalarTexel>(Source, Dest, Settings);
+	}
+}
+
+bool IsMipChainSIMDAvailable()
+{
+	return GENIX_MIPMAP_SSE != 0;
+}
+
+std::vector<MipLevel> BuildMipChain(const unsigned char* Pixels, int Width, int Height, int Components, const MipChainSettings& Settings)
+{
+	GENIX_TRACE_ZONE("Build Mip Chain");
+	std::vector<MipLevel> Levels;
+	if (!Pixels || Width <= 0 || Height <= 0 || Components < 1 || Components > 4)
+	{
+		return Levels;
+	}
+
+	// sRGB only makes sense for color channels
+	MipChainSettings LevelSettings = Settings;
+	LevelSettings.bSRGB = Settings.bSRGB && Components >= 3;
+	LevelSettings.bNormalMap = Settings.bNormalMap && Components >= 3;
+
+	// level 0 is the source itself
+	MipLevel Base;
+	Base.Width = Width;
+	Base.Height = Height;
+	Base.Data.assign(Pixels, Pixels + static_cast<size_t>(Width) * Height * Components);
+	Levels.push_back(std::move(Base));
+
+	FloatImage Current;
+	Current.Width = Width;
+	Current.Height = Height;
+	Current.Texels.resize(static_cast<size_t>(Width) * Height * 4);
+	DecodeLevel(Pixels, Components, LevelSettings, Current);
+
+	// every level is filtered from the float version of the previous one, so rounding errors don't pile up
+	while (Current.Width > 1 || Current.Height > 1)
+	{
+		FloatImage Next;
+		Next.Width = std::max(1, Current.Width / 2);
+		Next.Height = std::max(1, Current.Height / 2);
+		Next.Texels.resize(static_cast<size_t>(Next.Width) * Next.Height * 4);
+
+		Downsample(Current, Next, Settings);
+
+		MipLevel Level;
+		EncodeLevel(Next, Components, LevelSettings, Level);
+		Levels.push_back(std::move(Level));
+		Current = std::move(Next);
+	}
+	return Levels;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+// filter used to shrink one mip level into the next
+enum MipFilter {
+    MIP_FILTER_BOX,     // 2x2 average, cheap and good enough for most textures
+    MIP_FILTER_KAISER   // Kaiser windowed sinc, keeps smaller mips sharper
+};
+
+struct MipChainSettings
+{
+    MipFilter Filter = MIP_FILTER_BOX;
+    // the rgb channels are sRGB encoded: filter in linear space and encode the result again
+    bool bSRGB = false;
+    // rgb holds a tangent space normal (0..255 -> -1..1): every texel is renormalized after filtering
+    bool bNormalMap = false;
+    // spread the rows of every level over the JobSystem
+    bool bParallel = true;
+    // filter with SSE where the build has it (IsMipChainSIMDAvailable)
+    bool bSIMD = true;
+};
+
+struct MipLevel
+{
+    int Width = 0;
+    int Height = 0;
+    std::vector<unsigned char> Data;    // tightly packed, same component count as the source
+};
+
+// true when BuildMipChain was compiled with its SSE path
+bool IsMipChainSIMDAvailable();
+
+// builds the complete mip chain (level 0 = copy of the source, down to 1x1) of an 8 bit image with 1 to 4 components.
+// CPU only: rows are spread over the JobSystem and texels are filtered 4 channels at a time with SSE where available.
+std::vector<MipLevel> BuildMipChain(const unsigned char* Pixels, int Width, int Height, int Components, const MipChainSettings& Settings);
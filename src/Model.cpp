@@ -1,15 +1,64 @@
 ﻿#include "Model.h"
 
+#include <algorithm>
 #include <iostream>
 #include <assimp/postprocess.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Culling.h"
+#include "JobSystem.h"
 #include "Mesh.h"
+#include "TextureCache.h"
+#include "TextureUploader.h"
+#include "Trace.h"
 #include "stb_image.h"
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma)
+bool DecodeTextureFile(const std::string &filename, bool gamma, DecodedTexture &outTexture)
+{
+	int Width, Height, NrComponents;
+	unsigned char *Data;
+	{
+		GENIX_TRACE_ZONE("Decode Texture");
+		Data = stbi_load(filename.c_str(), &Width, &Height, &NrComponents, 0);
+	}
+	if (!Data)
+	{
+		return false;
+	}
+
+	if (NrComponents == 1)
+	{
+		outTexture.InternalFormat = outTexture.Format = GL_RED;
+	}
+	else if (NrComponents == 2)
+	{
+		outTexture.InternalFormat = outTexture.Format = GL_RG;
+	}
+	else if (NrComponents == 3)
+	{
+		outTexture.InternalFormat = gamma ? GL_SRGB : GL_RGB;
+		outTexture.Format = GL_RGB;
+	}
+	else
+	{
+		outTexture.InternalFormat = gamma ? GL_SRGB_ALPHA : GL_RGBA;
+		outTexture.Format = GL_RGBA;
+	}
+	outTexture.Components = NrComponents;
+
+	// the mips are built on the CPU (filtered in linear space for sRGB) instead of glGenerateMipmap on the render thread
+	MipChainSettings Settings;
+	Settings.Filter = MIP_FILTER_KAISER;
+	Settings.bSRGB = gamma;
+	outTexture.Levels = BuildMipChain(Data, Width, Height, NrComponents, Settings);
+
+	stbi_image_free(Data);
+	return true;
+}
+
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma, GLint wrap, size_t *outBytes)
 {
 	std::string Filename = std::string(path);
 	Filename = directory + '/' + Filename;
@@ -17,49 +66,69 @@ unsigned int TextureFromFile(const char *path, const std::string &directory, boo
 	unsigned int TextureId;
 	glGenTextures(1, &TextureId);
 
-	int Width, Height, NrComponents;
-	unsigned char *Data = stbi_load(Filename.c_str(), &Width, &Height, &NrComponents, 0);
-	if (Data)
+	DecodedTexture Decoded;
+	if (DecodeTextureFile(Filename, gamma, Decoded))
 	{
-		GLenum Format;
-		if (NrComponents == 1)
-		{
-			Format = GL_RED;
-		}
-		else if (NrComponents == 3)
-		{
-			Format = GL_RGB;
-		}
-		else if (NrComponents == 4)
+		if (outBytes)
 		{
-			Format = GL_RGBA;
+			// drivers pad RGB to 4 bytes per texel, the mip chain adds another third
+			const size_t BytesPerTexel = Decoded.Components == 3 ? 4 : Decoded.Components;
+			*outBytes = static_cast<size_t>(Decoded.Levels[0].Width) * Decoded.Levels[0].Height * BytesPerTexel * 4 / 3;
 		}
 
-		glBindTexture(GL_TEXTURE_2D, TextureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, Format, Width, Height, 0, Format, GL_UNSIGNED_BYTE, Data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		UploadMipChain(TextureId, Decoded.InternalFormat, Decoded.Format, Decoded.Components, std::move(Decoded.Levels));
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(Data);
 	}
 	else
 	{
 		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(Data);
 	}
 
 	return TextureId;
 }
 
-Model::Model(std::string const& path, bool gamma): GammaCorrection(gamma)
+void UploadMipChain(GLuint texture, GLint internalFormat, GLenum format, int components, std::vector<MipLevel> levels)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// rows of 1/3 channel levels are not 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	const bool bStreamed = TextureUploader::Get().IsEnabled();
+	for (size_t Level = 0; Level < levels.size(); Level++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(Level), internalFormat, levels[Level].Width, levels[Level].Height, 0, format, GL_UNSIGNED_BYTE,
+			bStreamed ? nullptr : levels[Level].Data.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.empty() ? 0 : static_cast<GLint>(levels.size()) - 1);
+
+	if (bStreamed)
+	{
+		// smallest level first, so there is something to sample after the first frame
+		for (size_t Level = levels.size(); Level-- > 0;)
+		{
+			TextureUploader::Get().QueueLevel(texture, GL_TEXTURE_2D, GL_TEXTURE_2D, static_cast<GLint>(Level), levels[Level].Width, levels[Level].Height,
+				format, components, std::move(levels[Level].Data));
+		}
+	}
+}
+
+Model::Model(std::string const& path, bool gamma, bool keepCpuData): GammaCorrection(gamma), KeepCpuData(keepCpuData)
 {
 	LoadModel(path);
 }
 
+Model::~Model()
+{
+	for (const Texture& Texture : TexturesLoaded)
+	{
+		TextureCache::Get().Release(Texture.ID);
+	}
+}
+
 void Model::Draw(Shader& InShader)
 {
 	for (auto& Mesh : Meshes)
@@ -68,11 +137,69 @@ void Model::Draw(Shader& InShader)
 	}
 }
 
+void Model::Draw(Shader& InShader, const glm::mat4& modelMatrix, const std::function<void(const glm::mat4&)>& bindTransform, const Frustum* frustum)
+{
+	if (frustum && !MeshTree.IsEmpty())
+	{
+		// draw in mesh order, not tree order, so the result matches the unculled path
+		std::vector<uint32_t> Visible;
+		GetVisibleMeshes(*frustum, modelMatrix, Visible);
+		std::sort(Visible.begin(), Visible.end());
+		for (uint32_t i : Visible)
+		{
+			bindTransform(modelMatrix * Hierarchy.GetWorld(MeshNodes[i]));
+			Meshes[i].Draw(InShader);
+		}
+		return;
+	}
+	for (size_t i = 0; i < Meshes.size(); i++)
+	{
+		bindTransform(i < MeshNodes.size() ? modelMatrix * Hierarchy.GetWorld(MeshNodes[i]) : modelMatrix);
+		Meshes[i].Draw(InShader);
+	}
+}
+
+void Model::DrawLayered(Shader& InShader, const glm::mat4& modelMatrix, const std::function<void(const glm::mat4&)>& bindTransform,
+	const std::function<unsigned int(const glm::vec3&, const glm::vec3&)>& selectLayers)
+{
+	for (size_t i = 0; i < Meshes.size(); i++)
+	{
+		glm::vec3 WorldMin, WorldMax;
+		if (i < MeshBounds.size())
+		{
+			TransformAABB(MeshBounds[i].Min, MeshBounds[i].Max, modelMatrix, WorldMin, WorldMax);
+		}
+		else
+		{
+			TransformAABB(BoundsMin, BoundsMax, modelMatrix, WorldMin, WorldMax);
+		}
+		const unsigned int Layers = selectLayers(WorldMin, WorldMax);
+		if (Layers == 0)
+		{
+			continue;
+		}
+		bindTransform(i < MeshNodes.size() ? modelMatrix * Hierarchy.GetWorld(MeshNodes[i]) : modelMatrix);
+		Meshes[i].DrawLayers(InShader, Layers);
+	}
+}
+
+void Model::GetVisibleMeshes(const Frustum& frustum, const glm::mat4& modelMatrix, std::vector<uint32_t>& outMeshes) const
+{
+	// the tree is in model space, so the frustum is brought there instead of moving every box
+	MeshTree.QueryFrustum(frustum.ToLocalSpace(modelMatrix), outMeshes);
+}
+
 void Model::LoadModel(std::string const& path)
 {
+	GENIX_TRACE_ZONE("Load Model");
+
 	// read file via ASSIMP
 	Assimp::Importer Importer;
-	const aiScene* Scene = Importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+	const aiScene* Scene;
+	{
+		GENIX_TRACE_ZONE("Assimp Import");
+		Scene = Importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+	}
 	// check for errors
 	if(!Scene || Scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !Scene->mRootNode) // if is Not Zero
 	{
@@ -82,45 +209,103 @@ void Model::LoadModel(std::string const& path)
 	// retrieve the directory path of the filepath
 	Directory = path.substr(0, path.find_last_of('/'));
 
-	// process ASSIMP's root node recursively
-	ProcessNode(Scene->mRootNode, Scene);
+	// 1. + 2. walk the node tree and convert the meshes on the job threads
+	std::vector<aiMesh*> MeshQueue;
+	std::vector<MeshImportData> ImportData;
+	ImportMeshes(Scene, MeshQueue, ImportData);
+
+	// 3. textures and GL buffers need the context, create them here in one go.
+	// the converted arrays are moved into the meshes, so the geometry is never copied after conversion
+	GENIX_TRACE_ZONE("Create Meshes");
+	Meshes.reserve(Meshes.size() + MeshQueue.size());
+	for (size_t i = 0; i < MeshQueue.size(); i++)
+	{
+		AABB MeshBox;
+		TransformAABB(ImportData[i].BoundsMin, ImportData[i].BoundsMax, Hierarchy.GetWorld(MeshNodes[i]), MeshBox.Min, MeshBox.Max);
+		MeshBounds.push_back(MeshBox);
+		BoundsMin = i == 0 ? MeshBox.Min : glm::min(BoundsMin, MeshBox.Min);
+		BoundsMax = i == 0 ? MeshBox.Max : glm::max(BoundsMax, MeshBox.Max);
+
+		std::vector<Texture> Textures = ProcessMaterial(Scene->mMaterials[MeshQueue[i]->mMaterialIndex]);
+		Meshes.emplace_back(std::move(ImportData[i].Vertices), std::move(ImportData[i].Indices), std::move(Textures), KeepCpuData);
+	}
+	MeshTree.Build(MeshBounds);
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene)
+void Model::ImportMeshes(const aiScene* scene, std::vector<aiMesh*>& outMeshes, std::vector<MeshImportData>& outData, bool parallel)
 {
-	// process each mesh located at the current node
+	// 1. walk ASSIMP's node tree and only collect the meshes to convert
+	ProcessNode(scene->mRootNode, scene, outMeshes, SceneGraph::InvalidNode);
+	Hierarchy.UpdateWorldTransforms();
+
+	// 2. convert every mesh in parallel. Each job writes only to its own slot, so the result order is the node walk order no matter which thread finishes first
+	outData.resize(outMeshes.size());
+	const JobSystem::RangeFunc Convert = [&](size_t Begin, size_t End)
+	{
+		GENIX_TRACE_ZONE("Convert Meshes");
+		for (size_t i = Begin; i < End; i++)
+		{
+			ProcessMesh(outMeshes[i], outData[i]);
+		}
+	};
+	if (parallel)
+	{
+		JobSystem::Get().ParallelFor(outMeshes.size(), Convert);
+	}
+	else
+	{
+		Convert(0, outMeshes.size());
+	}
+}
+
+void Model::ProcessNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& outMeshes, uint32_t parent)
+{
+	// assimp matrices are row major, glm's are column major
+	const aiMatrix4x4& Transform = node->mTransformation;
+	const glm::mat4 Local(
+		Transform.a1, Transform.b1, Transform.c1, Transform.d1,
+		Transform.a2, Transform.b2, Transform.c2, Transform.d2,
+		Transform.a3, Transform.b3, Transform.c3, Transform.d3,
+		Transform.a4, Transform.b4, Transform.c4, Transform.d4);
+	const uint32_t Node = Hierarchy.AddNode(parent, Local);
+
+	// gather each mesh located at the current node
 	for(unsigned int i = 0; i < node->mNumMeshes; i++)
 	{
 		// the node object only contains indices to index the actual objects in the scene. 
 		// the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-		aiMesh* Mesh = scene->mMeshes[node->mMeshes[i]];
-		Meshes.push_back(ProcessMesh(Mesh, scene));
+		outMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+		MeshNodes.push_back(Node);
 	}
-	// after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+	// after we've gathered all of the meshes (if any) we then recursively process each of the children nodes
 	for(unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		ProcessNode(node->mChildren[i], scene);
+		ProcessNode(node->mChildren[i], scene, outMeshes, Node);
 	}
 
 }
 
-Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
+void Model::ProcessMesh(const aiMesh* mesh, MeshImportData& outData)
 {
-	// data to fill
-	std::vector<Vertex> Vertices;
-	std::vector<unsigned int> Indices;
-	std::vector<Texture> Textures;
+	// data to fill, sized up front so the loops below only write
+	std::vector<Vertex>& Vertices = outData.Vertices;
+	std::vector<unsigned int>& Indices = outData.Indices;
+	Vertices.resize(mesh->mNumVertices);
+	outData.BoundsMin = glm::vec3(0.0f);
+	outData.BoundsMax = glm::vec3(0.0f);
 
 	// walk through each of the mesh's vertices
 	for(unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
-		Vertex Vertex;
+		Vertex& Vertex = Vertices[i];
 		glm::vec3 Vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
 		// positions
 		Vector.x = mesh->mVertices[i].x;
 		Vector.y = mesh->mVertices[i].y;
 		Vector.z = mesh->mVertices[i].z;
 		Vertex.Position = Vector;
+		outData.BoundsMin = i == 0 ? Vector : glm::min(outData.BoundsMin, Vector);
+		outData.BoundsMax = i == 0 ? Vector : glm::max(outData.BoundsMax, Vector);
 		// normals
 		if (mesh->HasNormals())
 		{
@@ -151,21 +336,32 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 		}
 		else
 			Vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-		Vertices.push_back(Vertex);
 	}
-	// now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+	// now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+	size_t IndexCount = 0;
+	for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		IndexCount += mesh->mFaces[i].mNumIndices;
+	}
+	Indices.resize(IndexCount);
+	size_t Cursor = 0;
 	for(unsigned int i = 0; i < mesh->mNumFaces; i++)
 	{
-		aiFace Face = mesh->mFaces[i];
+		const aiFace& Face = mesh->mFaces[i];
 		// retrieve all indices of the face and store them in the indices vector
 		for(unsigned int j = 0; j < Face.mNumIndices; j++)
 		{
-			Indices.push_back(Face.mIndices[j]);        
+			Indices[Cursor++] = Face.mIndices[j];
 		}
 	}
-	// process materials
-	aiMaterial* Material = scene->mMaterials[mesh->mMaterialIndex];    
+}
+
+std::vector<Texture> Model::ProcessMaterial(aiMaterial* material)
+{
+	std::vector<Texture> Textures;
+	Textures.reserve(material->GetTextureCount(aiTextureType_DIFFUSE) + material->GetTextureCount(aiTextureType_SPECULAR)
+		+ material->GetTextureCount(aiTextureType_HEIGHT) + material->GetTextureCount(aiTextureType_AMBIENT));
+
 	// we assume a convention for sampler names in the shaders. Each diffuse texture should be named
 	// as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
 	// Same applies to other texture as the following list summarizes:
@@ -174,49 +370,49 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 	// normal: texture_normalN
 
 	// 1. diffuse maps
-	std::vector<Texture> DiffuseMaps = LoadMaterialTextures(Material, aiTextureType_DIFFUSE, "texture_diffuse");
+	std::vector<Texture> DiffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
 	Textures.insert(Textures.end(), DiffuseMaps.begin(), DiffuseMaps.end());
 	// 2. specular maps
-	std::vector<Texture> SpecularMaps = LoadMaterialTextures(Material, aiTextureType_SPECULAR, "texture_specular");
+	std::vector<Texture> SpecularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
 	Textures.insert(Textures.end(), SpecularMaps.begin(), SpecularMaps.end());
 	// 3. normal maps
-	std::vector<Texture> NormalMaps = LoadMaterialTextures(Material, aiTextureType_HEIGHT, "texture_normal");
+	std::vector<Texture> NormalMaps = LoadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
 	Textures.insert(Textures.end(), NormalMaps.begin(), NormalMaps.end());
 	// 4. height maps
-	std::vector<Texture> HeightMaps = LoadMaterialTextures(Material, aiTextureType_AMBIENT, "texture_height");
+	std::vector<Texture> HeightMaps = LoadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
 	Textures.insert(Textures.end(), HeightMaps.begin(), HeightMaps.end());
-        
-	// return a mesh object created from the extracted mesh data
-	return Mesh(Vertices, Indices, Textures);
+
+	return Textures;
 }
 
 std::vector<Texture> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
 {
 	std::vector<Texture> Textures;
+	Textures.reserve(mat->GetTextureCount(type));
 	for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		// check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-		bool Skip = false;
-		for(unsigned int j = 0; j < TexturesLoaded.size(); j++)
+		// color maps are sampled in sRGB when gamma correction is on, so the same file can back two different textures
+		const bool Gamma = GammaCorrection && typeName == "texture_diffuse";
+		const std::string LookupKey = Gamma ? std::string(str.C_Str()) + "|srgb" : std::string(str.C_Str());
+		// check if this model already uses the texture and if so, continue to next iteration: skip acquiring it again
+		auto Loaded = TextureLookup.find(LookupKey);
+		if(Loaded != TextureLookup.end())
 		{
-			if(std::strcmp(TexturesLoaded[j].Path.data(), str.C_Str()) == 0)
-			{
-				Textures.push_back(TexturesLoaded[j]);
-				Skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-				break;
-			}
-		}
-		if(!Skip)
-		{   // if texture hasn't been loaded already, load it
-			Texture Texture;
-			Texture.ID = TextureFromFile(str.C_Str(), this->Directory);
+			Texture Texture = TexturesLoaded[Loaded->second];
 			Texture.Type = typeName;
-			Texture.Path = str.C_Str();
 			Textures.push_back(Texture);
-			TexturesLoaded.push_back(Texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+			continue;
 		}
+		// otherwise get it from the process-wide cache, which only hits the disk if no other model loaded it yet
+		Texture Texture;
+		Texture.ID = TextureCache::Get().Acquire(this->Directory + '/' + str.C_Str(), Gamma, GL_REPEAT, typeName == "texture_normal");
+		Texture.Type = typeName;
+		Texture.Path = str.C_Str();
+		Textures.push_back(Texture);
+		TextureLookup.emplace(LookupKey, TexturesLoaded.size());
+		TexturesLoaded.push_back(Texture);  // store it as texture used by the entire model, the reference is given back in the destructor.
 	}
 	return Textures;
 }
@@ -1,40 +1,121 @@
 ﻿#pragma once
 
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include <glad/glad.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
+#include "BVH.h"
 #include "Mesh.h"
+#include "MipmapBuilder.h"
+#include "SceneGraph.h"
 
 class Shader;
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
+// a texture file decoded into a CPU mip chain, with the GL formats TextureFromFile uploads it as
+struct DecodedTexture
+{
+    std::vector<MipLevel> Levels;
+    GLint InternalFormat = 0;
+    GLenum Format = 0;
+    int Components = 0;
+};
+
+// reads the file and builds its mip chain (see MipmapBuilder.h), false if it couldn't be decoded
+bool DecodeTextureFile(const std::string &filename, bool gamma, DecodedTexture &outTexture);
+
+// loads a 2D texture from disk without any caching. outBytes (optional) receives the estimated video memory of the texture.
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false, GLint wrap = GL_REPEAT, size_t *outBytes = nullptr);
+
+// uploads a CPU built mip chain (see MipmapBuilder.h) into a 2D texture, replaces glGenerateMipmap.
+// when the TextureUploader is running only the storage is allocated here and the pixels stream in over the next frames.
+void UploadMipChain(GLuint texture, GLint internalFormat, GLenum format, int components, std::vector<MipLevel> levels);
 
 class Model 
 {
 public:
     // model data 
-    std::vector<Texture> TexturesLoaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    std::vector<Texture> TexturesLoaded;	// stores all the textures this model holds a TextureCache reference to, one entry per distinct texture.
     std::vector<Mesh>    Meshes;
+    // the file's node hierarchy (aiNode transforms), world matrices are relative to the model's origin
+    SceneGraph Hierarchy;
+    // node of each entry in Meshes
+    std::vector<uint32_t> MeshNodes;
+    // model space box around all meshes (node transforms applied)
+    glm::vec3 BoundsMin = glm::vec3(0.0f);
+    glm::vec3 BoundsMax = glm::vec3(0.0f);
+    // model space box of each entry in Meshes and a tree over them, for culling and picking single meshes
+    std::vector<AABB> MeshBounds;
+    BVH MeshTree;
     std::string Directory;
     bool GammaCorrection;
+    // keep the CPU copy of the vertex/index data after upload (only needed for CPU side queries, e.g. picking)
+    bool KeepCpuData;
 
     // constructor, expects a filepath to a 3D model.
-    Model(std::string const &path, bool gamma = false);
+    Model(std::string const &path, bool gamma = false, bool keepCpuData = true);
+
+    // gives the texture references back to the TextureCache
+    ~Model();
+
+    // the model owns cache references, copies would release them twice
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
     // draws the model, and thus all its meshes
     void Draw(Shader &InShader);
 
+    // draws every mesh with modelMatrix * its node's transform, bindTransform is handed each final matrix before the
+    // mesh is drawn (to set a uniform or fill a per draw buffer). With a (world space) frustum only the meshes
+    // intersecting it are drawn.
+    void Draw(Shader &InShader, const glm::mat4 &modelMatrix, const std::function<void(const glm::mat4&)> &bindTransform, const Frustum *frustum = nullptr);
+
+    // layered version of the above: selectLayers gets each mesh's world space box and returns the number of layers
+    // (instances) to draw it into, 0 skips the mesh. It also sets whatever uniforms map instances to layers.
+    void DrawLayered(Shader &InShader, const glm::mat4 &modelMatrix, const std::function<void(const glm::mat4&)> &bindTransform,
+        const std::function<unsigned int(const glm::vec3 &worldMin, const glm::vec3 &worldMax)> &selectLayers);
+
+    // indices into Meshes of the meshes intersecting a world space frustum when the model is placed at modelMatrix
+    void GetVisibleMeshes(const Frustum &frustum, const glm::mat4 &modelMatrix, std::vector<uint32_t> &outMeshes) const;
+
 private:
+    // the import benchmark runs the CPU side of the import on synthetic scenes
+    friend bool RunImportBenchmark(int meshCount);
+
+    // empty model for ImportMeshes
+    Model() : GammaCorrection(false), KeepCpuData(false) {}
+
+    // CPU side result of converting one aiMesh, filled in by the import jobs.
+    struct MeshImportData
+    {
+        std::vector<Vertex>       Vertices;
+        std::vector<unsigned int> Indices;
+        glm::vec3                 BoundsMin;
+        glm::vec3                 BoundsMax;
+    };
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void LoadModel(std::string const &path);
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void ProcessNode(aiNode *node, const aiScene *scene);
+    // walks the node tree into Hierarchy and converts the meshes found, one outData slot per outMeshes entry, on the
+    // JobSystem if parallel. The result doesn't depend on it. No GL calls.
+    void ImportMeshes(const aiScene *scene, std::vector<aiMesh*> &outMeshes, std::vector<MeshImportData> &outData, bool parallel = true);
+
+    // walks a node in a recursive fashion, adds it to Hierarchy below parent and gathers the meshes located at the node and its children (if any), in draw order.
+    void ProcessNode(aiNode *node, const aiScene *scene, std::vector<aiMesh*> &outMeshes, uint32_t parent);
 
-    Mesh ProcessMesh(aiMesh *mesh, const aiScene *scene);
+    // converts the vertex/index data of a mesh into pre-sized arrays. Touches no GL or model state so it is safe to run on any thread.
+    static void ProcessMesh(const aiMesh *mesh, MeshImportData &outData);
+
+    // loads all textures referenced by a mesh's material. Needs the GL context, so main thread only.
+    std::vector<Texture> ProcessMaterial(aiMaterial *material);
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
     // the required info is returned as a Texture struct.
     std::vector<Texture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+
+    // material texture path (+ color space) -> index into TexturesLoaded
+    std::unordered_map<std::string, size_t> TextureLookup;
 };
@@ -0,0 +1,196 @@
+#include "PointShadowBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "PointShadowMap.h"
+
+namespace
+{
+	const int Resolution = 1024;
+	const float FarPlane = 25.0f;
+	// casters per grid side and their spacing, the grid fills most of the light's range around the light at the origin
+	const int GridSize = 12;
+	const float GridSpacing = 4.0f;
+	const float CasterHalfSize = 0.5f;
+
+	struct PathResult
+	{
+		double GpuMs = 0.0;
+		double WallMs = 0.0;
+		PointShadowMap::Stats Stats;
+		std::vector<float> Depth;
+	};
+
+	GLuint CreateCube(GLuint& VBO)
+	{
+		// 12 triangles, positions only (location 0 of the depth programs)
+		const float Corners[8][3] = { { -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 }, { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } };
+		const int Indices[36] = { 0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5 };
+		std::vector<float> Vertices;
+		for (int Index : Indices)
+		{
+			Vertices.insert(Vertices.end(), Corners[Index], Corners[Index] + 3);
+		}
+		GLuint VAO = 0;
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(float), Vertices.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+		glBindVertexArray(0);
+		return VAO;
+	}
+
+	std::vector<float> ReadCube(GLuint Texture)
+	{
+		const size_t FaceSize = static_cast<size_t>(Resolution) * Resolution;
+		std::vector<float> Depth(FaceSize * 6);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, Texture);
+		for (int Face = 0; Face < 6; Face++)
+		{
+			glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + Face, 0, GL_DEPTH_COMPONENT, GL_FLOAT, Depth.data() + FaceSize * Face);
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		return Depth;
+	}
+}
+
+bool RunPointShadowBenchmark(int iterations)
+{
+	iterations = std::max(iterations, 1);
+	PointShadowMap Shadows;
+	if (!Shadows.Init(Resolution))
+	{
+		return false;
+	}
+	std::cout << "Point shadow benchmark " << Resolution << "x" << Resolution << " cube, " << GridSize * GridSize * GridSize << " casters, "
+		<< iterations << " iterations on " << glGetString(GL_RENDERER)
+		<< (Shadows.IsVertexLayerSupported() ? "" : " (no vertex shader gl_Layer, geometry shader only)") << std::endl;
+
+	// one model matrix per caster, each bound as its own PerDraw range
+	GLint Alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &Alignment);
+	const GLsizeiptr Stride = (static_cast<GLsizeiptr>(sizeof(glm::mat4)) + Alignment - 1) / Alignment * Alignment;
+	std::vector<glm::vec3> Centers;
+	for (int z = 0; z < GridSize; z++)
+	{
+		for (int y = 0; y < GridSize; y++)
+		{
+			for (int x = 0; x < GridSize; x++)
+			{
+				Centers.push_back((glm::vec3(x, y, z) - 0.5f * (GridSize - 1)) * GridSpacing);
+			}
+		}
+	}
+	std::vector<unsigned char> PerDrawData(Centers.size() * Stride);
+	for (size_t i = 0; i < Centers.size(); i++)
+	{
+		const glm::mat4 Model = glm::scale(glm::translate(glm::mat4(1.0f), Centers[i]), glm::vec3(CasterHalfSize));
+		std::copy(reinterpret_cast<const unsigned char*>(&Model), reinterpret_cast<const unsigned char*>(&Model) + sizeof(Model), &PerDrawData[i * Stride]);
+	}
+	GLuint PerDrawBuffer = 0;
+	glGenBuffers(1, &PerDrawBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, PerDrawBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, PerDrawData.size(), PerDrawData.data(), GL_STATIC_DRAW);
+	GLuint CubeVBO = 0;
+	const GLuint Cube = CreateCube(CubeVBO);
+
+	GLuint Query = 0;
+	glGenQueries(1, &Query);
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	Shadows.Update(glm::vec3(0.3f, 0.7f, -0.2f), FarPlane);
+
+	// casters go only to the faces their box touches, an instanced draw per caster on the vertex layer path
+	const auto Render = [&]()
+	{
+		Shadows.Render([&](Shader&, const Frustum& LightBounds)
+		{
+			glBindVertexArray(Cube);
+			for (size_t i = 0; i < Centers.size(); i++)
+			{
+				const glm::vec3 BoxMin = Centers[i] - CasterHalfSize;
+				const glm::vec3 BoxMax = Centers[i] + CasterHalfSize;
+				if (!LightBounds.IntersectsAABB(BoxMin, BoxMax))
+				{
+					continue;
+				}
+				const unsigned int Instances = Shadows.SelectFaces(Shadows.GetFaceMask(BoxMin, BoxMax));
+				if (Instances > 0)
+				{
+					glBindBufferRange(GL_UNIFORM_BUFFER, 0, PerDrawBuffer, i * Stride, sizeof(glm::mat4));
+					glDrawArraysInstanced(GL_TRIANGLES, 0, 36, Instances);
+				}
+			}
+			glBindVertexArray(0);
+		});
+	};
+
+	PathResult Results[2];
+	const PointShadowPath Paths[2] = { POINT_SHADOW_VERTEX_LAYER, POINT_SHADOW_GEOMETRY_SHADER };
+	const char* Names[2] = { "vertex layer", "geometry shader" };
+	for (int i = 0; i < 2; i++)
+	{
+		if (!Shadows.SetPath(Paths[i]))
+		{
+			continue;
+		}
+		PathResult& Result = Results[i];
+		Render();
+		glFinish();
+
+		// software drivers defer rasterization to the flush, so the timer query can read low, the wall clock can't
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		glBeginQuery(GL_TIME_ELAPSED, Query);
+		for (int Iteration = 0; Iteration < iterations; Iteration++)
+		{
+			Render();
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+		glFinish();
+		Result.WallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / iterations;
+		GLuint64 Nanoseconds = 0;
+		glGetQueryObjectui64v(Query, GL_QUERY_RESULT, &Nanoseconds);
+		Result.GpuMs = Nanoseconds / 1e6 / iterations;
+		Result.Stats = Shadows.GetStats();
+		Result.Depth = ReadCube(Shadows.GetTexture());
+
+		std::cout << std::left << std::setw(16) << Names[i] << std::right << std::fixed << std::setprecision(3)
+			<< "gpu " << std::setw(9) << Result.GpuMs << " ms  wall " << std::setw(9) << Result.WallMs << " ms  "
+			<< Result.Stats.Draws << " draws, " << Result.Stats.FaceDraws << " face draws, " << Result.Stats.FacesCulled << " faces culled" << std::endl;
+	}
+
+	// both write the same depth for the same triangles, only the way they get to the faces differs
+	bool bMatched = true;
+	if (!Results[0].Depth.empty() && !Results[1].Depth.empty())
+	{
+		float MaxDifference = 0.0f;
+		size_t Differing = 0;
+		for (size_t i = 0; i < Results[0].Depth.size(); i++)
+		{
+			const float Difference = std::abs(Results[0].Depth[i] - Results[1].Depth[i]);
+			MaxDifference = std::max(MaxDifference, Difference);
+			Differing += Difference > 0.0f ? 1 : 0;
+		}
+		bMatched = MaxDifference <= 1e-5f;
+		std::cout << "depth cube max difference " << std::scientific << std::setprecision(2) << MaxDifference << " (" << Differing
+			<< " of " << Results[0].Depth.size() << " texels differ)" << (bMatched ? "  OK" : "  MISMATCH") << std::endl;
+	}
+
+	glDeleteQueries(1, &Query);
+	glDeleteBuffers(1, &PerDrawBuffer);
+	glDeleteBuffers(1, &CubeVBO);
+	glDeleteVertexArrays(1, &Cube);
+	Shadows.Shutdown();
+	return bMatched;
+}
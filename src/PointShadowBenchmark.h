@@ -0,0 +1,8 @@
+#pragma once
+
+// renders the same point light shadow of a grid of cube casters into a PointShadowMap with both paths, one instance
+// per touched face with gl_Layer from the vertex shader and the geometry shader amplification, and prints for each the
+// GPU time (timer query), the wall clock time up to glFinish, the draws and face draws, then the largest difference
+// between the two depth cube maps. The vertex layer side is skipped where the context lacks
+// ARB_shader_viewport_layer_array / AMD_vertex_shader_layer. Returns false if the cube maps differ.
+bool RunPointShadowBenchmark(int iterations);
@@ -0,0 +1,228 @@
+#include "PointShadowMap.h"
+
+#include <iostream>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "GLExtensions.h"
+#include "Profiler.h"
+
+namespace
+{
+	// GL cube face order (+X, -X, +Y, -Y, +Z, -Z), which is also the layer order of a layered cube map attachment
+	const glm::vec3 FaceDirections[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const glm::vec3 FaceUps[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+
+	const unsigned int AllFaces = 0x3F;
+
+	bool IsLinked(const Shader& Program)
+	{
+		GLint Success = 0;
+		glGetProgramiv(Program.ID, GL_LINK_STATUS, &Success);
+		return Success != 0;
+	}
+
+	void DeleteProgram(std::unique_ptr<Shader>& Program)
+	{
+		if (Program)
+		{
+			glDeleteProgram(Program->ID);
+			Program.reset();
+		}
+	}
+}
+
+PointShadowMap::~PointShadowMap()
+{
+	Shutdown();
+}
+
+bool PointShadowMap::Init(int resolution, bool bForceGeometryShader)
+{
+	Shutdown();
+	Resolution = resolution > 0 ? resolution : 1024;
+	ShadowStats = Stats();
+
+	glGenTextures(1, &DepthCubemap);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, DepthCubemap);
+	for (unsigned int Face = 0; Face < 6; Face++)
+	{
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + Face, 0, GL_DEPTH_COMPONENT32F, Resolution, Resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	// layered attachment, gl_Layer picks the face
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, DepthCubemap, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	const bool bComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!bComplete)
+	{
+		std::cout << "ERROR::POINT_SHADOW_MAP:: Framebuffer is not complete!" << std::endl;
+		Shutdown();
+		return false;
+	}
+
+	GeometryShader.reset(new Shader("Shaders/OmniShadowDepthGS.vert", "Shaders/PointShadowsDepth.frag", "Shaders/OmniShadowDepth.gs"));
+	GeometryShader->SetUniformBlockBinding("PerDraw", 0);
+
+	// writing gl_Layer outside the geometry shader is an extension in GL 3.3 (core in 4.6 as part of ARB_shader_viewport_layer_array)
+	bVertexLayerSupported = HasGLExtension("GL_ARB_shader_viewport_layer_array") || HasGLExtension("GL_AMD_vertex_shader_layer");
+	if (bVertexLayerSupported)
+	{
+		VertexLayerShader.reset(new Shader("Shaders/OmniShadowDepth.vert", "Shaders/PointShadowsDepth.frag"));
+		bVertexLayerSupported = IsLinked(*VertexLayerShader);
+		if (bVertexLayerSupported)
+		{
+			VertexLayerShader->SetUniformBlockBinding("PerDraw", 0);
+		}
+		else
+		{
+			DeleteProgram(VertexLayerShader);
+		}
+	}
+	Path = bVertexLayerSupported && !bForceGeometryShader ? POINT_SHADOW_VERTEX_LAYER : POINT_SHADOW_GEOMETRY_SHADER;
+	return true;
+}
+
+void PointShadowMap::Shutdown()
+{
+	DeleteProgram(VertexLayerShader);
+	DeleteProgram(GeometryShader);
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		Framebuffer = 0;
+	}
+	if (DepthCubemap)
+	{
+		glDeleteTextures(1, &DepthCubemap);
+		DepthCubemap = 0;
+	}
+	bVertexLayerSupported = false;
+}
+
+bool PointShadowMap::SetPath(PointShadowPath path)
+{
+	if (path == POINT_SHADOW_VERTEX_LAYER && !bVertexLayerSupported)
+	{
+		return false;
+	}
+	Path = path;
+	return true;
+}
+
+void PointShadowMap::Update(const glm::vec3& lightPosition, float farPlane)
+{
+	LightPosition = lightPosition;
+	FarPlane = farPlane;
+	const glm::mat4 Projection = glm::perspective(glm::radians(90.0f), 1.0f, NearPlane, FarPlane);
+	for (int Face = 0; Face < 6; Face++)
+	{
+		FaceMatrices[Face] = Projection * glm::lookAt(LightPosition, LightPosition + FaceDirections[Face], FaceUps[Face]);
+		FaceFrusta[Face] = Frustum::FromMatrix(FaceMatrices[Face]);
+	}
+}
+
+void PointShadowMap::Render(const std::function<void(Shader& depthShader, const Frustum& lightBounds)>& drawCasters)
+{
+	ShadowStats = Stats();
+	Shader* DepthShader = Path == POINT_SHADOW_VERTEX_LAYER ? VertexLayerShader.get() : GeometryShader.get();
+	if (!Framebuffer || !DepthShader)
+	{
+		return;
+	}
+
+	GENIX_PROFILE_GPU("Point Shadows");
+	GLint PreviousViewport[4];
+	GLint PreviousFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glViewport(0, 0, Resolution, Resolution);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	DepthShader->Use();
+	for (int Face = 0; Face < 6; Face++)
+	{
+		DepthShader->SetMat4("shadowMatrices[" + std::to_string(Face) + "]", FaceMatrices[Face]);
+	}
+	DepthShader->SetVec3("lightPos", LightPosition);
+	DepthShader->SetFloat("far_plane", FarPlane);
+
+	// the light's range as a box, the six faces together cover exactly the inside of it
+	Frustum LightBounds;
+	LightBounds.Planes[0] = glm::vec4(1, 0, 0, FarPlane - LightPosition.x);
+	LightBounds.Planes[1] = glm::vec4(-1, 0, 0, FarPlane + LightPosition.x);
+	LightBounds.Planes[2] = glm::vec4(0, 1, 0, FarPlane - LightPosition.y);
+	LightBounds.Planes[3] = glm::vec4(0, -1, 0, FarPlane + LightPosition.y);
+	LightBounds.Planes[4] = glm::vec4(0, 0, 1, FarPlane - LightPosition.z);
+	LightBounds.Planes[5] = glm::vec4(0, 0, -1, FarPlane + LightPosition.z);
+	drawCasters(*DepthShader, LightBounds);
+	ShadowStats.FacesCulled = ShadowStats.Draws * 6 - ShadowStats.FaceDraws;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+}
+
+unsigned int PointShadowMap::GetFaceMask(const glm::vec3& worldMin, const glm::vec3& worldMax) const
+{
+	unsigned int Mask = 0;
+	for (int Face = 0; Face < 6; Face++)
+	{
+		if (FaceFrusta[Face].IntersectsAABB(worldMin, worldMax))
+		{
+			Mask |= 1u << Face;
+		}
+	}
+	return Mask;
+}
+
+unsigned int PointShadowMap::SelectFaces(unsigned int faceMask)
+{
+	faceMask &= AllFaces;
+	if (faceMask == 0)
+	{
+		return 0;
+	}
+
+	unsigned int FaceCount = 0;
+	if (Path == POINT_SHADOW_VERTEX_LAYER)
+	{
+		// instance i renders into faceIndices[i]
+		for (int Face = 0; Face < 6; Face++)
+		{
+			if (faceMask & (1u << Face))
+			{
+				VertexLayerShader->SetInt("faceIndices[" + std::to_string(FaceCount) + "]", Face);
+				FaceCount++;
+			}
+		}
+	}
+	else
+	{
+		GeometryShader->SetInt("faceMask", static_cast<int>(faceMask));
+		for (unsigned int Bits = faceMask; Bits; Bits &= Bits - 1)
+		{
+			FaceCount++;
+		}
+	}
+	ShadowStats.Draws++;
+	ShadowStats.FaceDraws += FaceCount;
+	return Path == POINT_SHADOW_VERTEX_LAYER ? FaceCount : 1;
+}
+
+void PointShadowMap::Bind(int textureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, DepthCubemap);
+}
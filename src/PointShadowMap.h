@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+#include "Shader.h"
+
+// how the six cube faces are rendered in one pass
+enum PointShadowPath
+{
+    POINT_SHADOW_VERTEX_LAYER,      // one instance per face, the vertex shader writes gl_Layer (ARB_shader_viewport_layer_array / AMD_vertex_shader_layer)
+    POINT_SHADOW_GEOMETRY_SHADER    // the geometry shader amplifies each triangle into the faces, works everywhere
+};
+
+// omnidirectional shadow map of a point light: a depth cube map holding the linear light distance / far plane
+// (sampled like PointShadows.frag). Casters only go to the faces their box touches: the vertex layer path draws one
+// instance per touched face, the geometry shader path skips the untouched faces and every triangle outside a face.
+class PointShadowMap
+{
+public:
+
+    struct Stats
+    {
+        size_t Draws = 0;           // caster draws of the last Render
+        size_t FaceDraws = 0;       // faces those draws went to
+        size_t FacesCulled = 0;     // Draws * 6 - FaceDraws
+    };
+
+    PointShadowMap() = default;
+    ~PointShadowMap();
+
+    PointShadowMap(const PointShadowMap&) = delete;
+    PointShadowMap& operator=(const PointShadowMap&) = delete;
+
+    // creates the cube map and both depth programs. The vertex layer path is used when the context supports it and
+    // its program links, unless bForceGeometryShader is set.
+    bool Init(int resolution = 1024, bool bForceGeometryShader = false);
+    void Shutdown();
+
+    // switches between the paths at runtime, for comparing them. Fails for an unsupported path.
+    bool SetPath(PointShadowPath path);
+    PointShadowPath GetPath() const { return Path; }
+    bool IsVertexLayerSupported() const { return bVertexLayerSupported; }
+
+    // face matrices and frusta for a light at lightPosition whose shadows reach farPlane
+    void Update(const glm::vec3& lightPosition, float farPlane);
+
+    // renders all faces under the "Point Shadows" GPU profiler marker. drawCasters gets the depth program (already
+    // in use) and the box around the light's range to cull against, and draws every caster after selecting its
+    // faces with SelectFaces. Casters expect the PerDraw block (binding 0) for their model matrix.
+    // Leaves the framebuffer and viewport as they were.
+    void Render(const std::function<void(Shader& depthShader, const Frustum& lightBounds)>& drawCasters);
+
+    // bit i set for every face frustum intersecting the world space box
+    unsigned int GetFaceMask(const glm::vec3& worldMin, const glm::vec3& worldMax) const;
+
+    // points the next draw at the faces in faceMask and returns the instance count it has to be drawn with, 0 if
+    // it can be skipped
+    unsigned int SelectFaces(unsigned int faceMask);
+
+    // binds the cube map to the texture unit
+    void Bind(int textureUnit) const;
+
+    GLuint GetTexture() const { return DepthCubemap; }
+    float GetFarPlane() const { return FarPlane; }
+    const Stats& GetStats() const { return ShadowStats; }
+
+    float NearPlane = 0.1f;
+
+private:
+
+    GLuint DepthCubemap = 0;
+    GLuint Framebuffer = 0;
+    int Resolution = 0;
+    PointShadowPath Path = POINT_SHADOW_GEOMETRY_SHADER;
+    bool bVertexLayerSupported = false;
+    std::unique_ptr<Shader> VertexLayerShader;
+    std::unique_ptr<Shader> GeometryShader;
+    glm::vec3 LightPosition = glm::vec3(0.0f);
+    float FarPlane = 25.0f;
+    glm::mat4 FaceMatrices[6];
+    Frustum FaceFrusta[6];
+    Stats ShadowStats;
+};
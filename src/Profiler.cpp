@@ -0,0 +1,301 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+
+#include "Trace.h"
+#include "imgui.h"
+
+Profiler& Profiler::Get()
+{
+	static Profiler Instance;
+	return Instance;
+}
+
+void Profiler::Init(unsigned int frameLatency)
+{
+	Shutdown();
+	Slots.resize(std::max(2u, frameLatency));
+	for (FrameSlot& Slot : Slots)
+	{
+		glGenQueries(1, &Slot.FrameQuery);
+	}
+	Current = 0;
+	FrameIndex = 0;
+	DroppedFrames = 0;
+	LastFrame = Frame();
+	History.clear();
+
+	// GL_TIMESTAMP read without queries is the GPU clock right now, good enough to line both clocks up in a trace
+	GLint64 GpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &GpuNow);
+	GpuToTraceOffsetNs = static_cast<long long>(TraceRecorder::Now()) - static_cast<long long>(GpuNow);
+}
+
+void Profiler::Shutdown()
+{
+	for (FrameSlot& Slot : Slots)
+	{
+		if (!Slot.Queries.empty())
+		{
+			glDeleteQueries(static_cast<GLsizei>(Slot.Queries.size()), Slot.Queries.data());
+		}
+		glDeleteQueries(1, &Slot.FrameQuery);
+	}
+	Slots.clear();
+	Stack.clear();
+	bInFrame = false;
+}
+
+void Profiler::BeginFrame()
+{
+	if (Slots.empty())
+	{
+		return;
+	}
+
+	// the slot about to be reused holds the oldest frame still waiting for results
+	Current = (Current + 1) % Slots.size();
+	FrameSlot& Slot = Slots[Current];
+	if (Slot.bPending)
+	{
+		Resolve(Slot);
+	}
+
+	Slot.Markers.clear();
+	Slot.QueriesUsed = 0;
+	Slot.Index = FrameIndex++;
+	Slot.CpuBegin = Clock::now();
+	Slot.bPending = true;
+	Stack.clear();
+	glBeginQuery(GL_TIME_ELAPSED, Slot.FrameQuery);
+	bInFrame = true;
+}
+
+void Profiler::EndFrame()
+{
+	if (!bInFrame)
+	{
+		return;
+	}
+	while (!Stack.empty())
+	{
+		PopMarker();
+	}
+	FrameSlot& Slot = Slots[Current];
+	glEndQuery(GL_TIME_ELAPSED);
+	Slot.CpuMs = std::chrono::duration<double, std::milli>(Clock::now() - Slot.CpuBegin).count();
+	bInFrame = false;
+}
+
+void Profiler::PushMarker(const char* name, bool bGpu)
+{
+	if (!bInFrame)
+	{
+		return;
+	}
+	FrameSlot& Slot = Slots[Current];
+	PendingMarker Marker;
+	Marker.Name = name;
+	Marker.Depth = static_cast<int>(Stack.size());
+	Marker.bGpu = bGpu;
+	Marker.BeginQuery = 0;
+	Marker.EndQuery = 0;
+	Marker.CpuMs = 0.0;
+	if (bGpu)
+	{
+		Marker.BeginQuery = AllocateQuery(Slot);
+		Marker.EndQuery = AllocateQuery(Slot);
+		glQueryCounter(Marker.BeginQuery, GL_TIMESTAMP);
+	}
+	TraceRecorder::Get().BeginZone(name);
+	Marker.CpuBegin = Clock::now();
+	Stack.push_back(Slot.Markers.size());
+	Slot.Markers.push_back(std::move(Marker));
+}
+
+void Profiler::PopMarker()
+{
+	if (!bInFrame || Stack.empty())
+	{
+		return;
+	}
+	PendingMarker& Marker = Slots[Current].Markers[Stack.back()];
+	Stack.pop_back();
+	Marker.CpuMs = std::chrono::duration<double, std::milli>(Clock::now() - Marker.CpuBegin).count();
+	TraceRecorder::Get().EndZone(Marker.Name);
+	if (Marker.bGpu)
+	{
+		glQueryCounter(Marker.EndQuery, GL_TIMESTAMP);
+	}
+}
+
+GLuint Profiler::AllocateQuery(FrameSlot& Slot)
+{
+	if (Slot.QueriesUsed == Slot.Queries.size())
+	{
+		GLuint Query;
+		glGenQueries(1, &Query);
+		Slot.Queries.push_back(Query);
+	}
+	return Slot.Queries[Slot.QueriesUsed++];
+}
+
+void Profiler::Resolve(FrameSlot& Slot)
+{
+	Slot.bPending = false;
+
+	// the frame query ended last, once it is done all timestamps before it are too
+	GLint bAvailable = 0;
+	glGetQueryObjectiv(Slot.FrameQuery, GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	for (size_t i = 0; bAvailable && i < Slot.QueriesUsed; i++)
+	{
+		glGetQueryObjectiv(Slot.Queries[i], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+	}
+	if (!bAvailable)
+	{
+		DroppedFrames++;
+		return;
+	}
+
+	Frame Result;
+	Result.Index = Slot.Index;
+	Result.CpuMs = Slot.CpuMs;
+	GLuint64 Elapsed = 0;
+	glGetQueryObjectui64v(Slot.FrameQuery, GL_QUERY_RESULT, &Elapsed);
+	Result.GpuMs = Elapsed / 1000000.0;
+
+	Result.Markers.reserve(Slot.Markers.size());
+	for (const PendingMarker& Pending : Slot.Markers)
+	{
+		Marker Marker;
+		Marker.Name = Pending.Name;
+		Marker.Depth = Pending.Depth;
+		Marker.CpuMs = Pending.CpuMs;
+		if (Pending.bGpu)
+		{
+			GLuint64 Begin = 0, End = 0;
+			glGetQueryObjectui64v(Pending.BeginQuery, GL_QUERY_RESULT, &Begin);
+			glGetQueryObjectui64v(Pending.EndQuery, GL_QUERY_RESULT, &End);
+			Marker.GpuMs = End > Begin ? (End - Begin) / 1000000.0 : 0.0;
+			TraceRecorder::Get().GpuZone(Pending.Name, Begin + GpuToTraceOffsetNs, End + GpuToTraceOffsetNs);
+		}
+		Result.Markers.push_back(std::move(Marker));
+	}
+
+	LastFrame = Result;
+	History.push_back(std::move(Result));
+	while (History.size() > HistorySize)
+	{
+		History.pop_front();
+	}
+}
+
+double Profiler::GetAverageMs(const std::string& name, int depth, bool bGpu) const
+{
+	double Sum = 0.0;
+	size_t Count = 0;
+	for (const Frame& Frame : History)
+	{
+		for (const Marker& Marker : Frame.Markers)
+		{
+			if (Marker.Depth == depth && Marker.Name == name)
+			{
+				Sum += bGpu ? Marker.GpuMs : Marker.CpuMs;
+				Count++;
+				break;
+			}
+		}
+	}
+	return Count > 0 ? Sum / Count : -1.0;
+}
+
+bool Profiler::ExportCSV(const std::string& path) const
+{
+	std::ofstream File(path);
+	if (!File)
+	{
+		std::cout << "Failed to write profile: " << path << std::endl;
+		return false;
+	}
+	// the frame itself is the depth 0 row, markers are one level below it
+	File << "frame,marker,depth,cpu_ms,gpu_ms\n";
+	for (const Frame& Frame : History)
+	{
+		File << Frame.Index << ",Frame,0," << Frame.CpuMs << "," << Frame.GpuMs << "\n";
+		for (const Marker& Marker : Frame.Markers)
+		{
+			File << Frame.Index << "," << Marker.Name << "," << Marker.Depth + 1 << "," << Marker.CpuMs << ",";
+			if (Marker.GpuMs >= 0.0)
+			{
+				File << Marker.GpuMs;
+			}
+			File << "\n";
+		}
+	}
+	return true;
+}
+
+void Profiler::DrawPanel()
+{
+	ImGui::Begin("Profiler");
+
+	ImGui::Text("Frame %llu: CPU %.2f ms, GPU %.2f ms", LastFrame.Index, LastFrame.CpuMs, LastFrame.GpuMs);
+
+	// GPU frame time over the history
+	std::vector<float> GpuTimes;
+	GpuTimes.reserve(History.size());
+	for (const Frame& Frame : History)
+	{
+		GpuTimes.push_back(static_cast<float>(Frame.GpuMs));
+	}
+	if (!GpuTimes.empty())
+	{
+		ImGui::PlotLines("GPU ms", GpuTimes.data(), static_cast<int>(GpuTimes.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+	}
+
+	if (ImGui::BeginTable("Markers", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Marker");
+		ImGui::TableSetupColumn("CPU ms");
+		ImGui::TableSetupColumn("CPU avg");
+		ImGui::TableSetupColumn("GPU ms");
+		ImGui::TableSetupColumn("GPU avg");
+		ImGui::TableHeadersRow();
+		for (const Marker& Marker : LastFrame.Markers)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%*s%s", Marker.Depth * 2, "", Marker.Name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", Marker.CpuMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", GetAverageMs(Marker.Name, Marker.Depth, false));
+			ImGui::TableNextColumn();
+			if (Marker.GpuMs >= 0.0)
+			{
+				ImGui::Text("%.3f", Marker.GpuMs);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", GetAverageMs(Marker.Name, Marker.Depth, true));
+			}
+			else
+			{
+				ImGui::TextUnformatted("-");
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted("-");
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::Button("Export CSV"))
+	{
+		ExportCSV(ExportPath);
+	}
+	ImGui::SameLine();
+	ImGui::Text("%s (%zu frames, %zu dropped)", ExportPath.c_str(), History.size(), DroppedFrames);
+
+	ImGui::End();
+}
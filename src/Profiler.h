@@ -0,0 +1,134 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+// per pass CPU and GPU timings. Markers nest, every marker measures its CPU time and, unless it is CPU only, its GPU
+// time from a pair of GL_TIMESTAMP queries (timestamps nest, GL_TIME_ELAPSED queries don't, that one only wraps the
+// whole frame). Queries are read back FrameLatency frames later, so reading them never stalls the pipeline.
+// markers also show up as zones in a TraceRecorder capture, their GPU times on the trace's GPU track.
+// main thread only, markers are a stack. Marker names must be string literals.
+class Profiler
+{
+public:
+
+    struct Marker
+    {
+        std::string Name;
+        int Depth = 0;
+        double CpuMs = 0.0;
+        double GpuMs = -1.0;    // negative for CPU only markers
+    };
+
+    struct Frame
+    {
+        unsigned long long Index = 0;
+        double CpuMs = 0.0;
+        double GpuMs = 0.0;
+        std::vector<Marker> Markers;    // in begin order
+    };
+
+    static Profiler& Get();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void Init(unsigned int frameLatency = 3);
+
+    // deletes all queries, call while the context is alive
+    void Shutdown();
+
+    // starts the frame and collects the results of the frame issued FrameLatency frames ago
+    void BeginFrame();
+    void EndFrame();
+
+    void PushMarker(const char* name, bool bGpu = true);
+    void PopMarker();
+
+    // the newest frame with results, empty before the first one arrived
+    const Frame& GetLastFrame() const { return LastFrame; }
+
+    const std::deque<Frame>& GetHistory() const { return History; }
+
+    // average GPU (or CPU) time of a marker over the history, negative if it never showed up
+    double GetAverageMs(const std::string& name, int depth, bool bGpu) const;
+
+    // writes the whole history, one row per frame and marker
+    bool ExportCSV(const std::string& path) const;
+
+    // imgui window with the last frame's breakdown. Needs an imgui frame in progress.
+    void DrawPanel();
+
+    // frames kept for averages, the panel graph and the CSV export
+    size_t HistorySize = 300;
+
+    // frames whose queries weren't finished after FrameLatency frames, their results are dropped
+    size_t DroppedFrames = 0;
+
+private:
+
+    Profiler() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingMarker
+    {
+        const char* Name;
+        int Depth;
+        bool bGpu;
+        GLuint BeginQuery;
+        GLuint EndQuery;
+        Clock::time_point CpuBegin;
+        double CpuMs;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<PendingMarker> Markers;
+        std::vector<GLuint> Queries;        // pool, grows to the largest marker count seen
+        size_t QueriesUsed = 0;
+        GLuint FrameQuery = 0;              // GL_TIME_ELAPSED around the whole frame
+        bool bPending = false;
+        unsigned long long Index = 0;
+        Clock::time_point CpuBegin;
+        double CpuMs = 0.0;
+    };
+
+    GLuint AllocateQuery(FrameSlot& Slot);
+
+    // reads the queries of a slot if the GPU is done with them
+    void Resolve(FrameSlot& Slot);
+
+    std::vector<FrameSlot> Slots;
+    size_t Current = 0;
+    bool bInFrame = false;
+    unsigned long long FrameIndex = 0;
+    std::vector<size_t> Stack;              // open markers, indices into the current slot
+    Frame LastFrame;
+    std::deque<Frame> History;
+    std::string ExportPath = "profile.csv";
+    long long GpuToTraceOffsetNs = 0;       // GL_TIMESTAMP time + offset = TraceRecorder::Now() time
+};
+
+// times the enclosing scope
+class ScopedProfileMarker
+{
+public:
+    ScopedProfileMarker(const char* name, bool bGpu) { Profiler::Get().PushMarker(name, bGpu); }
+    ~ScopedProfileMarker() { Profiler::Get().PopMarker(); }
+
+    ScopedProfileMarker(const ScopedProfileMarker&) = delete;
+    ScopedProfileMarker& operator=(const ScopedProfileMarker&) = delete;
+};
+
+#define GENIX_PROFILE_CONCAT_INNER(A, B) A##B
+#define GENIX_PROFILE_CONCAT(A, B) GENIX_PROFILE_CONCAT_INNER(A, B)
+
+// CPU and GPU time of the enclosing scope
+#define GENIX_PROFILE_GPU(Name) ScopedProfileMarker GENIX_PROFILE_CONCAT(ProfileMarker, __LINE__)(Name, true)
+// CPU time only, for scopes issuing no GL work
+#define GENIX_PROFILE_CPU(Name) ScopedProfileMarker GENIX_PROFILE_CONCAT(ProfileMarker, __LINE__)(Name, false)
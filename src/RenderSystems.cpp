@@ -0,0 +1,171 @@
+#include "RenderSystems.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "Trace.h"
+
+void SyncSceneTransforms(EntityRegistry& registry, const SceneGraph& scene)
+{
+	GENIX_TRACE_ZONE("Sync Scene Transforms");
+	registry.ParallelForEach<Transform>([&](Entity, Transform& Placement)
+	{
+		Placement.PreviousWorld = Placement.World;
+		if (Placement.SceneNode < scene.GetNodeCount())
+		{
+			Placement.World = scene.GetWorld(Placement.SceneNode);
+		}
+	});
+}
+
+void UpdateWorldBounds(EntityRegistry& registry)
+{
+	GENIX_TRACE_ZONE("Update World Bounds");
+	registry.ParallelForEach<Bounds, Transform>([](Entity, Bounds& Box, Transform& Placement)
+	{
+		glm::vec3 NewMin, NewMax;
+		TransformAABB(Box.LocalMin, Box.LocalMax, Placement.World, NewMin, NewMax);
+		Box.bMoved = NewMin != Box.WorldMin || NewMax != Box.WorldMax;
+		if (Box.bMoved)
+		{
+			Box.SweptMin = glm::min(Box.WorldMin, NewMin);
+			Box.SweptMax = glm::max(Box.WorldMax, NewMax);
+			Box.WorldMin = NewMin;
+			Box.WorldMax = NewMax;
+		}
+	});
+}
+
+void CollectMovedBounds(EntityRegistry& registry, std::vector<AABB>& outBoxes)
+{
+	outBoxes.clear();
+	registry.ForEach<Bounds>([&](Entity, Bounds& Box)
+	{
+		if (Box.bMoved)
+		{
+			outBoxes.push_back({ Box.SweptMin, Box.SweptMax });
+		}
+	});
+}
+
+void BuildSceneBVH(EntityRegistry& registry, SceneBVH& outTree)
+{
+	GENIX_TRACE_ZONE("Build Scene BVH");
+	outTree.Entities.clear();
+	outTree.Unbounded.clear();
+	outTree.Boxes.clear();
+	registry.ForEach<MeshRef>([&](Entity Current, MeshRef&)
+	{
+		const Bounds* Box = registry.Get<Bounds>(Current);
+		if (Box)
+		{
+			outTree.Entities.push_back(Current);
+			outTree.Boxes.push_back({ Box->WorldMin, Box->WorldMax });
+		}
+		else
+		{
+			outTree.Unbounded.push_back(Current);
+		}
+	});
+	outTree.Tree.Build(outTree.Boxes);
+	outTree.BuiltFrom = registry.GetPool<MeshRef>().Size();
+}
+
+void RefitSceneBVH(EntityRegistry& registry, SceneBVH& tree)
+{
+	GENIX_TRACE_ZONE("Refit Scene BVH");
+	if (tree.BuiltFrom != registry.GetPool<MeshRef>().Size())
+	{
+		BuildSceneBVH(registry, tree);
+		return;
+	}
+	for (size_t i = 0; i < tree.Entities.size(); i++)
+	{
+		const Bounds* Box = registry.Get<Bounds>(tree.Entities[i]);
+		if (!Box)
+		{
+			BuildSceneBVH(registry, tree);
+			return;
+		}
+		tree.Boxes[i] = { Box->WorldMin, Box->WorldMax };
+	}
+	tree.Tree.Refit(tree.Boxes);
+}
+
+size_t BuildDrawList(EntityRegistry& registry, const Frustum& frustum, std::vector<DrawItem>& outItems, const SceneBVH* sceneTree)
+{
+	GENIX_TRACE_ZONE("Build Draw List");
+	ComponentPool<MeshRef>& Meshes = registry.GetPool<MeshRef>();
+
+	// with a tree only its survivors are candidates and need no further frustum test
+	std::vector<Entity> Candidates;
+	if (sceneTree)
+	{
+		std::vector<uint32_t> Visible;
+		sceneTree->Tree.QueryFrustum(frustum, Visible);
+		Candidates.reserve(Visible.size() + sceneTree->Unbounded.size());
+		for (uint32_t Item : Visible)
+		{
+			Candidates.push_back(sceneTree->Entities[Item]);
+		}
+		Candidates.insert(Candidates.end(), sceneTree->Unbounded.begin(), sceneTree->Unbounded.end());
+	}
+	const std::vector<Entity>& Entities = sceneTree ? Candidates : Meshes.GetEntities();
+	const bool bTestFrustum = sceneTree == nullptr;
+
+	// every job writes only the slots of its own range, culled ones are marked with NullEntity and compacted below
+	outItems.resize(Entities.size());
+	JobSystem::Get().ParallelFor(Entities.size(), [&](size_t Begin, size_t End)
+	{
+		for (size_t i = Begin; i < End; i++)
+		{
+			const Entity Current = Entities[i];
+			DrawItem& Item = outItems[i];
+			Item.Id = NullEntity;
+			const Transform* Placement = registry.GetPool<Transform>().Get(Current);
+			const MeshRef* Mesh = Meshes.Get(Current);
+			if (!Placement || !Mesh)
+			{
+				continue;
+			}
+			const Bounds* Box = registry.GetPool<Bounds>().Get(Current);
+			if (bTestFrustum && Box && !frustum.IntersectsAABB(Box->WorldMin, Box->WorldMax))
+			{
+				continue;
+			}
+			const Material* Surface = registry.GetPool<Material>().Get(Current);
+			Item.Id = Current;
+			Item.SortKey = Surface ? Surface->SortKey : 0;
+			Item.Placement = Placement;
+			Item.Mesh = Mesh;
+			Item.Surface = Surface;
+		}
+	}, 1024);
+
+	outItems.erase(std::remove_if(outItems.begin(), outItems.end(), [](const DrawItem& Item) { return Item.Id == NullEntity; }), outItems.end());
+	std::sort(outItems.begin(), outItems.end(), [](const DrawItem& A, const DrawItem& B)
+	{
+		if (A.SortKey != B.SortKey)
+		{
+			return A.SortKey < B.SortKey;
+		}
+		// plain < between unrelated pointers is unspecified, std::less gives a total order
+		return std::less<const Model*>()(A.Mesh->SourceModel, B.Mesh->SourceModel);
+	});
+	return Meshes.Size() - outItems.size();
+}
+
+Entity PickEntity(const SceneBVH& sceneTree, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* outDistance)
+{
+	uint32_t Item = 0;
+	float Distance = maxDistance;
+	if (!sceneTree.Tree.Raycast(origin, direction, maxDistance, Item, Distance))
+	{
+		return NullEntity;
+	}
+	if (outDistance)
+	{
+		*outDistance = Distance;
+	}
+	return sceneTree.Entities[Item];
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BVH.h"
+#include "Culling.h"
+#include "EntityRegistry.h"
+
+// one visible entity, pointers stay valid until the registry's next structural change
+struct DrawItem
+{
+    Entity Id;
+    uint32_t SortKey;
+    const Transform* Placement;
+    const MeshRef* Mesh;
+    const Material* Surface;
+};
+
+// copies world matrices of entities tied to a scene node (Transform::SceneNode) out of the graph, the old ones of
+// all entities move to Transform::PreviousWorld. Call once per frame.
+void SyncSceneTransforms(EntityRegistry& registry, const SceneGraph& scene);
+
+// recomputes Bounds::World* from the local box and the entity's Transform and flags the boxes that changed
+void UpdateWorldBounds(EntityRegistry& registry);
+
+// the swept boxes of the entities whose bounds changed in the last UpdateWorldBounds, e.g. to invalidate cached shadows
+void CollectMovedBounds(EntityRegistry& registry, std::vector<AABB>& outBoxes);
+
+// BVH over the world bounds of the entities with a MeshRef and Bounds, for large mostly static scenes where testing
+// every entity against the frustum gets expensive. Entities without Bounds are kept aside and always drawn.
+struct SceneBVH
+{
+    BVH Tree;
+    std::vector<Entity> Entities;       // item i of the tree
+    std::vector<Entity> Unbounded;
+    std::vector<AABB> Boxes;
+    size_t BuiltFrom = 0;               // MeshRef count at build time
+};
+
+void BuildSceneBVH(EntityRegistry& registry, SceneBVH& outTree);
+
+// pulls the current world bounds into the tree (call after UpdateWorldBounds). Rebuilds instead when entities were
+// added or removed since the last build.
+void RefitSceneBVH(EntityRegistry& registry, SceneBVH& tree);
+
+// frustum culls every entity with a MeshRef (entities without Bounds are always kept) and returns the survivors
+// sorted by material, then mesh. Without a tree every entity is tested on the JobSystem, with one only the entities
+// the tree returns are considered. Returns the number of culled entities.
+size_t BuildDrawList(EntityRegistry& registry, const Frustum& frustum, std::vector<DrawItem>& outItems, const SceneBVH* sceneTree = nullptr);
+
+// nearest entity whose world bounds the ray hits, NullEntity for none
+Entity PickEntity(const SceneBVH& sceneTree, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* outDistance = nullptr);
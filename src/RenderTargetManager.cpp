@@ -0,0 +1,191 @@
+#include "RenderTargetManager.h"
+
+#include <algorithm>
+
+namespace
+{
+	size_t BytesPerPixel(GLint InternalFormat)
+	{
+		switch (InternalFormat)
+		{
+		case GL_RED:
+		case GL_R8:
+			return 1;
+		case GL_R16F:
+			return 2;
+		case GL_RG16F:
+		case GL_RGBA:
+		case GL_RGBA8:
+		case GL_R11F_G11F_B10F:
+		case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32F:
+			return 4;
+		case GL_RGBA16F:
+			return 8;
+		case GL_RGBA32F:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	size_t TextureBytes(const RenderTargetDesc& Desc, int Width, int Height)
+	{
+		return BytesPerPixel(Desc.InternalFormat) * static_cast<size_t>(Width) * Height;
+	}
+
+	bool SameDesc(const RenderTargetDesc& A, const RenderTargetDesc& B)
+	{
+		return A.InternalFormat == B.InternalFormat && A.Format == B.Format && A.Type == B.Type && A.Filter == B.Filter && A.Wrap == B.Wrap;
+	}
+}
+
+RenderTargetManager::~RenderTargetManager()
+{
+	Shutdown();
+}
+
+void RenderTargetManager::Init(int outputWidth, int outputHeight, int renderWidth, int renderHeight)
+{
+	Shutdown();
+	OutputWidth = std::max(1, outputWidth);
+	OutputHeight = std::max(1, outputHeight);
+	RenderWidth = std::max(1, renderWidth);
+	RenderHeight = std::max(1, renderHeight);
+}
+
+void RenderTargetManager::Shutdown()
+{
+	for (const Target& Current : Targets)
+	{
+		glDeleteTextures(1, &Current.Texture);
+	}
+	for (const PooledTexture& Pooled : Pool)
+	{
+		glDeleteTextures(1, &Pooled.Texture);
+	}
+	Targets.clear();
+	Pool.clear();
+	TargetStats = Stats();
+}
+
+const GLuint& RenderTargetManager::Create(const RenderTargetDesc& desc, RenderTargetSize size, GLuint framebuffer, GLenum attachment)
+{
+	Target Created;
+	Created.Desc = desc;
+	Created.Size = size;
+	Created.Framebuffer = framebuffer;
+	Created.Attachment = attachment;
+	Created.Width = size == TARGET_OUTPUT_SIZE ? OutputWidth : RenderWidth;
+	Created.Height = size == TARGET_OUTPUT_SIZE ? OutputHeight : RenderHeight;
+	Created.Texture = Acquire(desc, Created.Width, Created.Height);
+	TargetStats.LiveBytes += TextureBytes(desc, Created.Width, Created.Height);
+	if (framebuffer)
+	{
+		GLint PreviousFramebuffer = 0;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, Created.Texture, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	}
+	Targets.push_back(Created);
+	return Targets.back().Texture;
+}
+
+bool RenderTargetManager::Resize(int outputWidth, int outputHeight, int renderWidth, int renderHeight)
+{
+	if (outputWidth < 1 || outputHeight < 1 || renderWidth < 1 || renderHeight < 1)
+	{
+		return false;
+	}
+	OutputWidth = outputWidth;
+	OutputHeight = outputHeight;
+	RenderWidth = renderWidth;
+	RenderHeight = renderHeight;
+
+	bool bChanged = false;
+	for (Target& Current : Targets)
+	{
+		const int Width = Current.Size == TARGET_OUTPUT_SIZE ? OutputWidth : RenderWidth;
+		const int Height = Current.Size == TARGET_OUTPUT_SIZE ? OutputHeight : RenderHeight;
+		if (Width == Current.Width && Height == Current.Height)
+		{
+			continue;
+		}
+		// acquire before releasing, the pool must not hand the old texture straight back
+		const GLuint Texture = Acquire(Current.Desc, Width, Height);
+		Release(Current);
+		Current.Texture = Texture;
+		Current.Width = Width;
+		Current.Height = Height;
+		TargetStats.LiveBytes += TextureBytes(Current.Desc, Width, Height);
+		if (Current.Framebuffer)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, Current.Framebuffer);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, Current.Attachment, GL_TEXTURE_2D, Texture, 0);
+		}
+		bChanged = true;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return bChanged;
+}
+
+void RenderTargetManager::EndFrame()
+{
+	for (size_t i = 0; i < Pool.size();)
+	{
+		if (++Pool[i].IdleFrames > PoolFrames)
+		{
+			glDeleteTextures(1, &Pool[i].Texture);
+			TargetStats.PooledBytes -= TextureBytes(Pool[i].Desc, Pool[i].Width, Pool[i].Height);
+			Pool[i] = Pool.back();
+			Pool.pop_back();
+			continue;
+		}
+		i++;
+	}
+	TargetStats.PooledTextures = Pool.size();
+}
+
+GLuint RenderTargetManager::Acquire(const RenderTargetDesc& Desc, int Width, int Height)
+{
+	for (size_t i = 0; i < Pool.size(); i++)
+	{
+		if (Pool[i].Width == Width && Pool[i].Height == Height && SameDesc(Pool[i].Desc, Desc))
+		{
+			const GLuint Texture = Pool[i].Texture;
+			TargetStats.PooledBytes -= TextureBytes(Desc, Width, Height);
+			Pool[i] = Pool.back();
+			Pool.pop_back();
+			TargetStats.PooledTextures = Pool.size();
+			TargetStats.PoolHits++;
+			return Texture;
+		}
+	}
+
+	GLuint Texture = 0;
+	glGenTextures(1, &Texture);
+	glBindTexture(GL_TEXTURE_2D, Texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, Desc.InternalFormat, Width, Height, 0, Desc.Format, Desc.Type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Desc.Filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, Desc.Filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, Desc.Wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, Desc.Wrap);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	TargetStats.Allocations++;
+	return Texture;
+}
+
+void RenderTargetManager::Release(const Target& Released)
+{
+	PooledTexture Pooled;
+	Pooled.Texture = Released.Texture;
+	Pooled.Desc = Released.Desc;
+	Pooled.Width = Released.Width;
+	Pooled.Height = Released.Height;
+	Pool.push_back(Pooled);
+	const size_t Bytes = TextureBytes(Released.Desc, Released.Width, Released.Height);
+	TargetStats.LiveBytes -= Bytes;
+	TargetStats.PooledBytes += Bytes;
+	TargetStats.PooledTextures = Pool.size();
+}
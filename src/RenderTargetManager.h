@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <glad/glad.h>
+
+// which size a target follows
+enum RenderTargetSize
+{
+    TARGET_OUTPUT_SIZE,     // the window's framebuffer
+    TARGET_RENDER_SIZE      // the internal resolution, the output scaled by DynamicResolution
+};
+
+struct RenderTargetDesc
+{
+    GLint InternalFormat = GL_RGBA8;
+    GLenum Format = GL_RGBA;
+    GLenum Type = GL_UNSIGNED_BYTE;
+    GLint Filter = GL_NEAREST;
+    GLint Wrap = GL_CLAMP_TO_EDGE;
+};
+
+// owns the screen sized textures and keeps them, and the framebuffer attachments they are bound to, at the current
+// output or render size. Textures left behind by a resize go into a pool and are handed out again when a target of
+// the same description and size is needed, so going back and forth between sizes (dynamic resolution steps, a drag
+// resize coming back) doesn't reallocate; pooled textures unused for PoolFrames frames are deleted. Only full output
+// or render size targets are handled, fractions of them (BloomRenderer's mip chain) are left to their owners.
+class RenderTargetManager
+{
+public:
+
+    struct Stats
+    {
+        size_t Allocations = 0;     // textures created since Init
+        size_t PoolHits = 0;        // targets served from the pool instead
+        size_t LiveBytes = 0;       // of the targets in use
+        size_t PooledBytes = 0;
+        size_t PooledTextures = 0;
+    };
+
+    RenderTargetManager() = default;
+    ~RenderTargetManager();
+
+    RenderTargetManager(const RenderTargetManager&) = delete;
+    RenderTargetManager& operator=(const RenderTargetManager&) = delete;
+
+    // sizes for the targets created next
+    void Init(int outputWidth, int outputHeight, int renderWidth, int renderHeight);
+    void Shutdown();
+
+    // a target at the current size of its kind, attached to framebuffer at attachment unless framebuffer is 0. The
+    // texture name changes when the target is resized: keep the returned reference, not a copy of it.
+    const GLuint& Create(const RenderTargetDesc& desc, RenderTargetSize size, GLuint framebuffer = 0, GLenum attachment = GL_COLOR_ATTACHMENT0);
+
+    // reallocates the targets whose size changed and re-attaches them. Sizes below 1 (minimized window) are ignored.
+    // False if nothing changed. Leaves the framebuffer binding at 0.
+    bool Resize(int outputWidth, int outputHeight, int renderWidth, int renderHeight);
+
+    // ages the pool, once per frame
+    void EndFrame();
+
+    int GetOutputWidth() const { return OutputWidth; }
+    int GetOutputHeight() const { return OutputHeight; }
+    int GetRenderWidth() const { return RenderWidth; }
+    int GetRenderHeight() const { return RenderHeight; }
+
+    const Stats& GetStats() const { return TargetStats; }
+
+    // frames a pooled texture is kept without being reused
+    unsigned int PoolFrames = 120;
+
+private:
+
+    struct Target
+    {
+        GLuint Texture = 0;
+        RenderTargetDesc Desc;
+        RenderTargetSize Size = TARGET_OUTPUT_SIZE;
+        GLuint Framebuffer = 0;
+        GLenum Attachment = GL_COLOR_ATTACHMENT0;
+        int Width = 0;
+        int Height = 0;
+    };
+
+    struct PooledTexture
+    {
+        GLuint Texture = 0;
+        RenderTargetDesc Desc;
+        int Width = 0;
+        int Height = 0;
+        unsigned int IdleFrames = 0;
+    };
+
+    GLuint Acquire(const RenderTargetDesc& Desc, int Width, int Height);
+    void Release(const Target& Released);
+
+    int OutputWidth = 1;
+    int OutputHeight = 1;
+    int RenderWidth = 1;
+    int RenderHeight = 1;
+    std::deque<Target> Targets;         // deque: Create hands out references to the texture names
+    std::vector<PooledTexture> Pool;
+    Stats TargetStats;
+};
@@ -0,0 +1,330 @@
+#include "SSAOBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <initializer_list>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "RenderTargetManager.h"
+#include "Shader.h"
+#include "TemporalSSAO.h"
+
+namespace
+{
+	const int ReferenceRotations = 32;
+	// strafing speed in world units per frame, about 1.5 pixels per frame at 1080p on the far wall
+	const float StrafeStep = 0.01f;
+
+	struct SyntheticGBuffer
+	{
+		std::vector<float> Position;    // view space, RGB
+		std::vector<float> Normal;      // view space, RGB
+		std::vector<float> Velocity;    // RG, in texture coordinates like SSAO_Geometry.frag writes it
+	};
+
+	// the room is the inside of the box [-3, 3] x [-1, 2] x [-7, 1] with a sphere on its floor
+	bool TraceRoom(const glm::vec3& Origin, const glm::vec3& Direction, glm::vec3& Hit, glm::vec3& Normal)
+	{
+		const glm::vec3 RoomMin(-3.0f, -1.0f, -7.0f);
+		const glm::vec3 RoomMax(3.0f, 2.0f, 1.0f);
+		float Nearest = 1e30f;
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			if (Direction[Axis] == 0.0f)
+			{
+				continue;
+			}
+			// from inside only the wall in the direction of travel can be hit
+			const bool bPositive = Direction[Axis] > 0.0f;
+			const float T = ((bPositive ? RoomMax[Axis] : RoomMin[Axis]) - Origin[Axis]) / Direction[Axis];
+			if (T > 0.0f && T < Nearest)
+			{
+				Nearest = T;
+				Normal = glm::vec3(0.0f);
+				Normal[Axis] = bPositive ? -1.0f : 1.0f;
+			}
+		}
+
+		const glm::vec3 SphereCenter(0.5f, -0.4f, -4.0f);
+		const float SphereRadius = 0.6f;
+		const glm::vec3 ToOrigin = Origin - SphereCenter;
+		const float B = glm::dot(ToOrigin, Direction);
+		const float Discriminant = B * B - (glm::dot(ToOrigin, ToOrigin) - SphereRadius * SphereRadius);
+		if (Discriminant >= 0.0f)
+		{
+			const float T = -B - std::sqrt(Discriminant);
+			if (T > 0.0f && T < Nearest)
+			{
+				Nearest = T;
+				Normal = (Origin + Direction * T - SphereCenter) / SphereRadius;
+			}
+		}
+		Hit = Origin + Direction * Nearest;
+		return Nearest < 1e30f;
+	}
+
+	glm::mat4 CameraView(float Strafe)
+	{
+		const glm::vec3 Eye(Strafe, 0.3f, 0.0f);
+		return glm::lookAt(Eye, Eye + glm::vec3(0.0f, -0.15f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	void BuildGBuffer(const glm::mat4& Projection, const glm::mat4& View, const glm::mat4& PreviousViewProjection, int Width, int Height, SyntheticGBuffer& Out)
+	{
+		const size_t PixelCount = static_cast<size_t>(Width) * Height;
+		Out.Position.assign(PixelCount * 3, 0.0f);
+		Out.Normal.assign(PixelCount * 3, 0.0f);
+		Out.Velocity.assign(PixelCount * 2, 0.0f);
+		const glm::mat4 ViewProjection = Projection * View;
+		const glm::mat4 InverseViewProjection = glm::inverse(ViewProjection);
+		const glm::vec3 Eye = glm::vec3(glm::inverse(View)[3]);
+		for (int y = 0; y < Height; y++)
+		{
+			for (int x = 0; x < Width; x++)
+			{
+				const glm::vec2 Ndc((x + 0.5f) / Width * 2.0f - 1.0f, (y + 0.5f) / Height * 2.0f - 1.0f);
+				const glm::vec4 Far = InverseViewProjection * glm::vec4(Ndc, 1.0f, 1.0f);
+				const glm::vec3 Direction = glm::normalize(glm::vec3(Far) / Far.w - Eye);
+				glm::vec3 Hit, Normal;
+				if (!TraceRoom(Eye, Direction, Hit, Normal))
+				{
+					continue;
+				}
+				const size_t i = static_cast<size_t>(y) * Width + x;
+				const glm::vec3 ViewPosition = glm::vec3(View * glm::vec4(Hit, 1.0f));
+				const glm::vec3 ViewNormal = glm::mat3(View) * Normal;
+				const glm::vec4 Current = ViewProjection * glm::vec4(Hit, 1.0f);
+				const glm::vec4 Previous = PreviousViewProjection * glm::vec4(Hit, 1.0f);
+				const glm::vec2 Velocity = (glm::vec2(Current) / Current.w - glm::vec2(Previous) / Previous.w) * 0.5f;
+				for (int c = 0; c < 3; c++)
+				{
+					Out.Position[i * 3 + c] = ViewPosition[c];
+					Out.Normal[i * 3 + c] = ViewNormal[c];
+				}
+				Out.Velocity[i * 2] = Velocity.x;
+				Out.Velocity[i * 2 + 1] = Velocity.y;
+			}
+		}
+	}
+
+	GLuint CreateTarget(GLint internalFormat, GLenum format, int Width, int Height, const void* Pixels, GLenum type)
+	{
+		GLuint Texture = 0;
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, Width, Height, 0, format, type, Pixels);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return Texture;
+	}
+
+	// same timing as the blur benchmark: wall clock up to glFinish, software drivers defer draws to the flush
+	double TimeRuns(int iterations, const std::function<void()>& Run)
+	{
+		Run();
+		glFinish();
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			Run();
+		}
+		glFinish();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / std::max(iterations, 1);
+	}
+
+	float RootMeanSquareError(const std::vector<float>& Reference, const std::vector<float>& Result)
+	{
+		double Sum = 0.0;
+		for (size_t i = 0; i < Reference.size(); i++)
+		{
+			const double Difference = Reference[i] - Result[i];
+			Sum += Difference * Difference;
+		}
+		return static_cast<float>(std::sqrt(Sum / std::max<size_t>(Reference.size(), 1)));
+	}
+}
+
+bool RunSSAOBenchmark(int width, int height, int frames, void (*drawQuad)())
+{
+	frames = std::max(frames, 1);
+	std::cout << "SSAO benchmark " << width << "x" << height << ", " << frames << " frames accumulated on " << glGetString(GL_RENDERER) << std::endl;
+
+	// the kernel and noise of the renderer
+	std::default_random_engine Generator;
+	std::vector<glm::vec3> Kernel = BuildSSAOKernel(Generator);
+	const std::vector<glm::vec3> Noise = BuildSSAONoise(Generator);
+
+	const glm::mat4 Projection = glm::perspective(glm::radians(45.0f), static_cast<float>(width) / height, 0.1f, 50.0f);
+	SyntheticGBuffer Scene;
+	const GLuint Position = CreateTarget(GL_RGBA16F, GL_RGB, width, height, nullptr, GL_FLOAT);
+	const GLuint Normal = CreateTarget(GL_RGBA16F, GL_RGB, width, height, nullptr, GL_FLOAT);
+	const GLuint Velocity = CreateTarget(GL_RG16F, GL_RG, width, height, nullptr, GL_FLOAT);
+	const GLuint NoiseTexture = CreateTarget(GL_RGBA32F, GL_RGB, 4, 4, Noise.data(), GL_FLOAT);
+	glBindTexture(GL_TEXTURE_2D, NoiseTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	const GLuint Occlusion = CreateTarget(GL_RED, GL_RED, width, height, nullptr, GL_FLOAT);
+	const GLuint Blurred = CreateTarget(GL_R16F, GL_RED, width, height, nullptr, GL_FLOAT);
+	const auto UploadScene = [&](float Strafe, float PreviousStrafe)
+	{
+		BuildGBuffer(Projection, CameraView(Strafe), Projection * CameraView(PreviousStrafe), width, height, Scene);
+		glBindTexture(GL_TEXTURE_2D, Position);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, Scene.Position.data());
+		glBindTexture(GL_TEXTURE_2D, Normal);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, Scene.Normal.data());
+		glBindTexture(GL_TEXTURE_2D, Velocity);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RG, GL_FLOAT, Scene.Velocity.data());
+	};
+
+	GLuint Framebuffer = 0;
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glViewport(0, 0, width, height);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	Shader SSAOShader("Shaders/SSAO.vert", "Shaders/SSAO.frag");
+	SSAOShader.Use();
+	SSAOShader.SetInt("gPosition", 0);
+	SSAOShader.SetInt("gNormal", 1);
+	SSAOShader.SetInt("texNoise", 2);
+	for (int i = 0; i < TemporalSSAO::KernelSize; ++i)
+	{
+		SSAOShader.SetVec3("samples[" + std::to_string(i) + "]", Kernel[i]);
+	}
+	glm::mat4 SSAOProjection = Projection;
+	SSAOShader.SetMat4("projection", SSAOProjection);
+	SSAOShader.SetVec2("noiseScale", width / 4.0f, height / 4.0f);
+	Shader BlurShader("Shaders/SSAO.vert", "Shaders/SSAO_Blur.frag");
+	BlurShader.Use();
+	BlurShader.SetInt("ssaoInput", 0);
+
+	// the passes of main's SSAO stage; the kernel uniforms are set by the caller
+	const auto RenderOcclusion = [&]()
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Occlusion, 0);
+		SSAOShader.Use();
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, Position);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, Normal);
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, NoiseTexture);
+		drawQuad();
+		glActiveTexture(GL_TEXTURE0);
+	};
+	const auto BlurAndReadBack = [&](GLuint Input)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Blurred, 0);
+		BlurShader.Use();
+		glBindTexture(GL_TEXTURE_2D, Input);
+		drawQuad();
+		std::vector<float> Pixels(static_cast<size_t>(width) * height);
+		glBindTexture(GL_TEXTURE_2D, Blurred);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, Pixels.data());
+		return Pixels;
+	};
+
+	// reference: the full kernel under evenly spread noise rotations, averaged
+	UploadScene(0.0f, 0.0f);
+	std::vector<float> Reference(static_cast<size_t>(width) * height, 0.0f);
+	for (int Rotation = 0; Rotation < ReferenceRotations; Rotation++)
+	{
+		SSAOShader.Use();
+		SSAOShader.SetInt("kernelSize", TemporalSSAO::KernelSize);
+		SSAOShader.SetInt("kernelStride", 1);
+		SSAOShader.SetInt("kernelPhase", 0);
+		SSAOShader.SetFloat("noiseAngle", 6.28318531f * Rotation / ReferenceRotations);
+		RenderOcclusion();
+		const std::vector<float> Pixels = BlurAndReadBack(Occlusion);
+		for (size_t i = 0; i < Reference.size(); i++)
+		{
+			Reference[i] += Pixels[i] / ReferenceRotations;
+		}
+	}
+
+	RenderTargetManager Targets;
+	Targets.Init(width, height, width, height);
+	TemporalSSAO Temporal;
+	Temporal.Init(Targets);
+	Temporal.Mode = SSAO_FULL_KERNEL;
+	SSAOShader.Use();
+	Temporal.SetKernelUniforms(SSAOShader);
+	RenderOcclusion();
+	const float FullKernelError = RootMeanSquareError(Reference, BlurAndReadBack(Occlusion));
+	const double FullKernelMs = TimeRuns(frames, RenderOcclusion);
+	std::cout << std::fixed << std::left << std::setw(30) << "full kernel, 64 samples" << std::right
+		<< "  ssao " << std::setprecision(3) << std::setw(9) << FullKernelMs << " ms  rmse " << std::setprecision(5) << FullKernelError << std::endl;
+
+	float Temporal16Error = 0.0f;
+	Temporal.Mode = SSAO_TEMPORAL;
+	for (int Samples : { 16, 8 })
+	{
+		Temporal.SamplesPerFrame = Samples;
+		float StillError = 0.0f;
+		for (bool bStrafing : { false, true })
+		{
+			// both end on the reference's camera
+			Temporal.Reset();
+			GLuint Accumulated = 0;
+			for (int Frame = 0; Frame < frames; Frame++)
+			{
+				const float Strafe = bStrafing ? (Frame - frames + 1) * StrafeStep : 0.0f;
+				const float PreviousStrafe = bStrafing ? Strafe - StrafeStep : 0.0f;
+				if (bStrafing || Frame == 0)
+				{
+					UploadScene(Strafe, PreviousStrafe);
+				}
+				const glm::mat4 CurrentToPreviousView = CameraView(PreviousStrafe) * glm::inverse(CameraView(Strafe));
+				SSAOShader.Use();
+				Temporal.SetKernelUniforms(SSAOShader);
+				RenderOcclusion();
+				Accumulated = Temporal.Accumulate(Occlusion, Velocity, Position, CurrentToPreviousView, drawQuad);
+			}
+			const float Error = RootMeanSquareError(Reference, BlurAndReadBack(Accumulated));
+			if (!bStrafing)
+			{
+				StillError = Error;
+				continue;
+			}
+			const double OcclusionMs = TimeRuns(frames, [&]()
+			{
+				SSAOShader.Use();
+				Temporal.SetKernelUniforms(SSAOShader);
+				RenderOcclusion();
+			});
+			const double AccumulateMs = TimeRuns(frames, [&]()
+			{
+				Temporal.Accumulate(Occlusion, Velocity, Position, glm::mat4(1.0f), drawQuad);
+			});
+			const std::string Name = "temporal, " + std::to_string(Temporal.GetSamplesPerFrame()) + " samples";
+			std::cout << std::left << std::setw(30) << Name << std::right << "  ssao " << std::setprecision(3) << std::setw(9) << OcclusionMs
+				<< " ms  accumulate " << std::setw(9) << AccumulateMs << " ms  rmse " << std::setprecision(5) << StillError << " still, "
+				<< Error << " strafing" << std::endl;
+		}
+		if (Samples == 16)
+		{
+			Temporal16Error = StillError;
+		}
+	}
+
+	Temporal.Shutdown();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &Framebuffer);
+	const GLuint Textures[] = { Position, Normal, Velocity, NoiseTexture, Occlusion, Blurred };
+	glDeleteTextures(6, Textures);
+	glDeleteProgram(SSAOShader.ID);
+	glDeleteProgram(BlurShader.ID);
+	return Temporal16Error <= FullKernelError;
+}
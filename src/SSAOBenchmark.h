@@ -0,0 +1,10 @@
+#pragma once
+
+// measures the temporal SSAO modes against the full 64 sample kernel on a ray traced test room (floor, walls and a
+// sphere resting on the floor) instead of the G-buffer of the scene, so it needs no assets and runs on software
+// drivers (LIBGL_ALWAYS_SOFTWARE=1 on Mesa's llvmpipe). The reference is the full kernel averaged over many noise
+// rotations. Prints the RMSE of the blurred occlusion of a single full kernel frame and of the temporal modes after
+// frames accumulated frames, with the camera still and strafing, and the time of each pass. drawQuad draws a full
+// screen quad (renderQuad). Returns false if accumulating 16 samples ends up further from the reference than one full
+// kernel frame.
+bool RunSSAOBenchmark(int width, int height, int frames, void (*drawQuad)());
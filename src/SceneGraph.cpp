@@ -0,0 +1,126 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define GENIX_SCENE_GRAPH_SSE 1
+#else
+#define GENIX_SCENE_GRAPH_SSE 0
+#endif
+
+namespace
+{
+	// Out = Parent * Local, column major like glm. Each output column is a linear combination of the parent's columns,
+	// so with SSE it is four broadcast multiply-adds per column.
+	inline void MultiplyTransforms(const glm::mat4& Parent, const glm::mat4& Local, glm::mat4& Out)
+	{
+#if GENIX_SCENE_GRAPH_SSE
+		const __m128 P0 = _mm_loadu_ps(&Parent[0][0]);
+		const __m128 P1 = _mm_loadu_ps(&Parent[1][0]);
+		const __m128 P2 = _mm_loadu_ps(&Parent[2][0]);
+		const __m128 P3 = _mm_loadu_ps(&Parent[3][0]);
+		for (int Column = 0; Column < 4; Column++)
+		{
+			__m128 Result = _mm_mul_ps(P0, _mm_set1_ps(Local[Column][0]));
+			Result = _mm_add_ps(Result, _mm_mul_ps(P1, _mm_set1_ps(Local[Column][1])));
+			Result = _mm_add_ps(Result, _mm_mul_ps(P2, _mm_set1_ps(Local[Column][2])));
+			Result = _mm_add_ps(Result, _mm_mul_ps(P3, _mm_set1_ps(Local[Column][3])));
+			_mm_storeu_ps(&Out[Column][0], Result);
+		}
+#else
+		Out = Parent * Local;
+#endif
+	}
+}
+
+const uint32_t SceneGraph::InvalidNode;
+
+uint32_t SceneGraph::AddNode(uint32_t parent, const glm::mat4& local)
+{
+	const uint32_t Node = static_cast<uint32_t>(Parents.size());
+	// parents before children is what makes the single pass update work
+	Parents.push_back(parent < Node ? parent : InvalidNode);
+	Local.push_back(local);
+	World.push_back(local);
+	Dirty.push_back(1);
+	if (!bAnyDirty || Node < FirstDirty)
+	{
+		FirstDirty = Node;
+	}
+	bAnyDirty = true;
+	return Node;
+}
+
+void SceneGraph::Reserve(size_t nodeCount)
+{
+	Parents.reserve(nodeCount);
+	Local.reserve(nodeCount);
+	World.reserve(nodeCount);
+	Dirty.reserve(nodeCount);
+}
+
+void SceneGraph::Clear()
+{
+	Parents.clear();
+	Local.clear();
+	World.clear();
+	Dirty.clear();
+	FirstDirty = 0;
+	bAnyDirty = false;
+	LastUpdateCount = 0;
+}
+
+void SceneGraph::SetLocal(uint32_t node, const glm::mat4& local)
+{
+	Local[node] = local;
+	Dirty[node] = 1;
+	if (!bAnyDirty || node < FirstDirty)
+	{
+		FirstDirty = node;
+	}
+	bAnyDirty = true;
+}
+
+size_t SceneGraph::UpdateWorldTransforms()
+{
+	LastUpdateCount = 0;
+	if (!bAnyDirty)
+	{
+		return 0;
+	}
+
+	const size_t Count = Parents.size();
+	const uint32_t* ParentData = Parents.data();
+	const glm::mat4* LocalData = Local.data();
+	glm::mat4* WorldData = World.data();
+	uint8_t* DirtyData = Dirty.data();
+
+	// a node is dirty if it was changed or its parent was recomputed in this pass. The flags are cleared only after
+	// the pass, children further down still need to see their parent's flag.
+	size_t Updated = 0;
+	for (size_t i = FirstDirty; i < Count; i++)
+	{
+		const uint32_t Parent = ParentData[i];
+		if (Parent != InvalidNode)
+		{
+			DirtyData[i] |= DirtyData[Parent];
+			if (DirtyData[i])
+			{
+				MultiplyTransforms(WorldData[Parent], LocalData[i], WorldData[i]);
+				Updated++;
+			}
+		}
+		else if (DirtyData[i])
+		{
+			WorldData[i] = LocalData[i];
+			Updated++;
+		}
+	}
+	std::fill(Dirty.begin() + FirstDirty, Dirty.end(), static_cast<uint8_t>(0));
+
+	FirstDirty = Count;
+	bAnyDirty = false;
+	LastUpdateCount = Updated;
+	return Updated;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// transform hierarchy stored as flat arrays, one entry per node, every parent before its children. That order lets
+// UpdateWorldTransforms resolve the whole tree in a single forward pass without recursion or a stack: when a node is
+// reached its parent's world matrix is already final. Only nodes whose local matrix changed, and their descendants,
+// are recomputed.
+class SceneGraph
+{
+public:
+
+    static const uint32_t InvalidNode = 0xFFFFFFFFu;
+
+    // appends a node, parent must already exist (or be InvalidNode for a root)
+    uint32_t AddNode(uint32_t parent, const glm::mat4& local = glm::mat4(1.0f));
+
+    void Reserve(size_t nodeCount);
+    void Clear();
+
+    void SetLocal(uint32_t node, const glm::mat4& local);
+    const glm::mat4& GetLocal(uint32_t node) const { return Local[node]; }
+
+    // valid after UpdateWorldTransforms
+    const glm::mat4& GetWorld(uint32_t node) const { return World[node]; }
+
+    uint32_t GetParent(uint32_t node) const { return Parents[node]; }
+    size_t GetNodeCount() const { return Parents.size(); }
+
+    // recomputes the world matrices of dirty nodes and their subtrees, returns how many were recomputed
+    size_t UpdateWorldTransforms();
+
+    // nodes recomputed by the last update
+    size_t GetLastUpdateCount() const { return LastUpdateCount; }
+
+private:
+
+    std::vector<uint32_t> Parents;
+    std::vector<glm::mat4> Local;
+    std::vector<glm::mat4> World;
+    std::vector<uint8_t> Dirty;
+
+    // lowest dirty index, the update pass starts here
+    size_t FirstDirty = 0;
+    bool bAnyDirty = false;
+    size_t LastUpdateCount = 0;
+};
@@ -0,0 +1,106 @@
+#include "SceneGraphBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "SceneGraph.h"
+
+namespace
+{
+	const uint32_t Arity = 4;
+
+	glm::mat4 RandomLocal(std::default_random_engine& Generator)
+	{
+		std::uniform_real_distribution<float> Offset(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> Angle(-0.5f, 0.5f);
+		const glm::mat4 Translation = glm::translate(glm::mat4(1.0f), glm::vec3(Offset(Generator), Offset(Generator), Offset(Generator)));
+		return glm::rotate(Translation, Angle(Generator), glm::normalize(glm::vec3(Offset(Generator), 1.0f, Offset(Generator))));
+	}
+
+	// largest element difference between the graph's world matrices and a straightforward recomputation
+	float MaxWorldDifference(const SceneGraph& Graph)
+	{
+		std::vector<glm::mat4> Reference(Graph.GetNodeCount());
+		float MaxDifference = 0.0f;
+		for (uint32_t i = 0; i < Graph.GetNodeCount(); i++)
+		{
+			const uint32_t Parent = Graph.GetParent(i);
+			Reference[i] = Parent == SceneGraph::InvalidNode ? Graph.GetLocal(i) : Reference[Parent] * Graph.GetLocal(i);
+			for (int Column = 0; Column < 4; Column++)
+			{
+				for (int Row = 0; Row < 4; Row++)
+				{
+					MaxDifference = std::max(MaxDifference, std::abs(Reference[i][Column][Row] - Graph.GetWorld(i)[Column][Row]));
+				}
+			}
+		}
+		return MaxDifference;
+	}
+}
+
+bool RunSceneGraphBenchmark(int nodeCount, int iterations)
+{
+	nodeCount = std::max(nodeCount, 32);
+	iterations = std::max(iterations, 1);
+	std::cout << "Scene graph benchmark, " << nodeCount << " nodes (" << Arity << "-ary tree), " << iterations << " iterations" << std::endl;
+
+	// breadth first, so node i's parent is (i - 1) / Arity and parents come before their children
+	std::default_random_engine Generator;
+	SceneGraph Graph;
+	Graph.Reserve(nodeCount);
+	Graph.AddNode(SceneGraph::InvalidNode, RandomLocal(Generator));
+	for (uint32_t i = 1; i < static_cast<uint32_t>(nodeCount); i++)
+	{
+		Graph.AddNode((i - 1) / Arity, RandomLocal(Generator));
+	}
+	Graph.UpdateWorldTransforms();
+
+	// node 5 is the first of the root's sixteen grandchildren, the leftmost one so its subtree reaches the deepest level
+	struct Case
+	{
+		const char* Name;
+		uint32_t Node;
+	};
+	const Case Cases[] =
+	{
+		{ "full", 0 },
+		{ "subtree", 1 + Arity },
+		{ "leaf", static_cast<uint32_t>(nodeCount - 1) },
+		{ "clean", SceneGraph::InvalidNode },
+	};
+
+	float MaxDifference = 0.0f;
+	for (const Case& Test : Cases)
+	{
+		std::vector<glm::mat4> Locals(iterations);
+		std::generate(Locals.begin(), Locals.end(), [&]() { return RandomLocal(Generator); });
+
+		double TotalMs = 0.0;
+		for (int i = 0; i < iterations; i++)
+		{
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+			if (Test.Node != SceneGraph::InvalidNode)
+			{
+				Graph.SetLocal(Test.Node, Locals[i]);
+			}
+			Graph.UpdateWorldTransforms();
+			TotalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		}
+		const float Difference = MaxWorldDifference(Graph);
+		MaxDifference = std::max(MaxDifference, Difference);
+		std::cout << std::left << std::setw(9) << Test.Name << std::right << std::fixed << std::setprecision(3) << std::setw(10)
+			<< TotalMs / iterations << " ms" << std::setw(10) << Graph.GetLastUpdateCount() << " nodes recomputed"
+			<< "  max difference " << std::scientific << std::setprecision(2) << Difference << std::endl;
+	}
+
+	// same products as the reference, only the SSE path may round differently
+	const bool bMatched = MaxDifference < 1e-3f;
+	std::cout << "world transforms " << (bMatched ? "match" : "DIFFER") << std::endl;
+	return bMatched;
+}
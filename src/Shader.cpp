@@ -1,209 +1,439 @@
 #include "Shader.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
+#include "GLExtensions.h"
+
+namespace
+{
+    // the shader files are saved with a UTF-8 byte order mark, which Mesa's GLSL preprocessor rejects
+    const char* SkipByteOrderMark(const std::string& Code)
+    {
+        return Code.compare(0, 3, "\xEF\xBB\xBF") == 0 ? Code.c_str() + 3 : Code.c_str();
+    }
+
+    std::string ReadShaderFile(const std::string& Path)
+    {
+        std::ifstream ShaderFile;
+        // ensure ifstream objects can throw exceptions:
+        ShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            ShaderFile.open(Path);
+            std::stringstream ShaderStream;
+            ShaderStream << ShaderFile.rdbuf();
+            ShaderFile.close();
+            return ShaderStream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << Path << ": " << e.what() << std::endl;
+        }
+        return std::string();
+    }
+
+    const char* StageName(GLenum Type)
+    {
+        switch (Type)
+        {
+        case GL_VERTEX_SHADER: return "VERTEX";
+        case GL_GEOMETRY_SHADER: return "GEOMETRY";
+        case GL_FRAGMENT_SHADER: return "FRAGMENT";
+        default: return "COMPUTE";
+        }
+    }
+
+    std::vector<Shader*>& LiveShaders()
+    {
+        static std::vector<Shader*> Shaders;
+        return Shaders;
+    }
+
+    // true where the driver compiles and links on its own threads, GL_COMPLETION_STATUS then tells when it's done
+    bool HasParallelCompile()
+    {
+        static int bSupported = -1;
+        if (bSupported < 0)
+        {
+            const bool bKHR = HasGLExtension("GL_KHR_parallel_shader_compile");
+            const bool bARB = HasGLExtension("GL_ARB_parallel_shader_compile");
+            PFNGLMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+                LoadGLFunction(bKHR ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+            // as many threads as the driver wants, the ARB version may start out with none
+            if ((bKHR || bARB) && MaxShaderCompilerThreads)
+            {
+                MaxShaderCompilerThreads(0xFFFFFFFF);
+            }
+            bSupported = bKHR || bARB ? 1 : 0;
+        }
+        return bSupported == 1;
+    }
+
+    bool IsFloatType(GLenum Type)
+    {
+        switch (Type)
+        {
+        case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool IsUnsignedType(GLenum Type)
+    {
+        return Type == GL_UNSIGNED_INT || Type == GL_UNSIGNED_INT_VEC2 || Type == GL_UNSIGNED_INT_VEC3 || Type == GL_UNSIGNED_INT_VEC4;
+    }
+
+    // one element of a default block uniform, location From of program From to location To of the current program
+    void CopyUniformValue(GLuint From, GLint FromLocation, GLint ToLocation, GLenum Type)
+    {
+        GLfloat Floats[16];
+        GLint Ints[4];
+        GLuint Uints[4];
+        switch (Type)
+        {
+        case GL_FLOAT: glGetUniformfv(From, FromLocation, Floats); glUniform1fv(ToLocation, 1, Floats); return;
+        case GL_FLOAT_VEC2: glGetUniformfv(From, FromLocation, Floats); glUniform2fv(ToLocation, 1, Floats); return;
+        case GL_FLOAT_VEC3: glGetUniformfv(From, FromLocation, Floats); glUniform3fv(ToLocation, 1, Floats); return;
+        case GL_FLOAT_VEC4: glGetUniformfv(From, FromLocation, Floats); glUniform4fv(ToLocation, 1, Floats); return;
+        case GL_FLOAT_MAT2: glGetUniformfv(From, FromLocation, Floats); glUniformMatrix2fv(ToLocation, 1, GL_FALSE, Floats); return;
+        case GL_FLOAT_MAT3: glGetUniformfv(From, FromLocation, Floats); glUniformMatrix3fv(ToLocation, 1, GL_FALSE, Floats); return;
+        case GL_FLOAT_MAT4: glGetUniformfv(From, FromLocation, Floats); glUniformMatrix4fv(ToLocation, 1, GL_FALSE, Floats); return;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glGetUniformiv(From, FromLocation, Ints); glUniform2iv(ToLocation, 1, Ints); return;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glGetUniformiv(From, FromLocation, Ints); glUniform3iv(ToLocation, 1, Ints); return;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glGetUniformiv(From, FromLocation, Ints); glUniform4iv(ToLocation, 1, Ints); return;
+        case GL_UNSIGNED_INT: glGetUniformuiv(From, FromLocation, Uints); glUniform1uiv(ToLocation, 1, Uints); return;
+        case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(From, FromLocation, Uints); glUniform2uiv(ToLocation, 1, Uints); return;
+        case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(From, FromLocation, Uints); glUniform3uiv(ToLocation, 1, Uints); return;
+        case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(From, FromLocation, Uints); glUniform4uiv(ToLocation, 1, Uints); return;
+        default:
+            // the non square matrices aren't used by any shader here; everything else is one int: int, bool, samplers
+            if (!IsFloatType(Type) && !IsUnsignedType(Type))
+            {
+                glGetUniformiv(From, FromLocation, Ints);
+                glUniform1iv(ToLocation, 1, Ints);
+            }
+            return;
+        }
+    }
+
+    // carries the state a program keeps over to its replacement, matched by name: values of the default block
+    // uniforms both have with the same type, and uniform block bindings
+    void CopyProgramState(GLuint From, GLuint To)
+    {
+        GLint PreviousProgram = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &PreviousProgram);
+        glUseProgram(To);
+
+        std::unordered_map<std::string, GLenum> ToTypes;
+        GLint Count = 0;
+        char Name[256];
+        GLint Size = 0;
+        GLenum Type = 0;
+        glGetProgramiv(To, GL_ACTIVE_UNIFORMS, &Count);
+        for (GLint i = 0; i < Count; i++)
+        {
+            glGetActiveUniform(To, static_cast<GLuint>(i), sizeof(Name), nullptr, &Size, &Type, Name);
+            ToTypes[Name] = Type;
+        }
+        glGetProgramiv(From, GL_ACTIVE_UNIFORMS, &Count);
+        for (GLint i = 0; i < Count; i++)
+        {
+            glGetActiveUniform(From, static_cast<GLuint>(i), sizeof(Name), nullptr, &Size, &Type, Name);
+            const auto Match = ToTypes.find(Name);
+            if (Match == ToTypes.end() || Match->second != Type)
+            {
+                continue;
+            }
+            // arrays are listed once as "name[0]", their elements have a location each
+            std::string Base = Name;
+            const bool bArray = Base.size() > 3 && Base.compare(Base.size() - 3, 3, "[0]") == 0;
+            if (bArray)
+            {
+                Base.resize(Base.size() - 3);
+            }
+            for (GLint Element = 0; Element < Size; Element++)
+            {
+                const std::string ElementName = bArray ? Base + "[" + std::to_string(Element) + "]" : Base;
+                const GLint FromLocation = glGetUniformLocation(From, ElementName.c_str());
+                const GLint ToLocation = glGetUniformLocation(To, ElementName.c_str());
+                // members of uniform blocks have no location, their values live in buffers
+                if (FromLocation >= 0 && ToLocation >= 0)
+                {
+                    CopyUniformValue(From, FromLocation, ToLocation, Type);
+                }
+            }
+        }
+
+        glGetProgramiv(From, GL_ACTIVE_UNIFORM_BLOCKS, &Count);
+        for (GLint i = 0; i < Count; i++)
+        {
+            GLint Binding = 0;
+            glGetActiveUniformBlockName(From, static_cast<GLuint>(i), sizeof(Name), nullptr, Name);
+            glGetActiveUniformBlockiv(From, static_cast<GLuint>(i), GL_UNIFORM_BLOCK_BINDING, &Binding);
+            const GLuint Index = glGetUniformBlockIndex(To, Name);
+            if (Index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(To, Index, static_cast<GLuint>(Binding));
+            }
+        }
+
+        glUseProgram(static_cast<GLuint>(PreviousProgram) == From ? To : static_cast<GLuint>(PreviousProgram));
+    }
+}
+
 Shader::Shader(const char* InVertexPath, const char* InFragmentPath)
+    : Stages{ { GL_VERTEX_SHADER, InVertexPath }, { GL_FRAGMENT_SHADER, InFragmentPath } }
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string VertexCode;
-    std::string FragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        // open files
-        vShaderFile.open(InVertexPath);
-        fShaderFile.open(InFragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        VertexCode = vShaderStream.str();
-        FragmentCode = fShaderStream.str();
-    }
-    catch (std::ifstream::failure& e)
-    {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-    }
-    const char* vShaderCode = VertexCode.c_str();
-    const char* fShaderCode = FragmentCode.c_str();
-
-    // 2. compile shaders
-    unsigned int Vertex, Fragment;
-
-    // vertex shader
-    Vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(Vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(Vertex);
-    CheckCompileErrors(Vertex, "VERTEX");
-
-    // fragment Shader
-    Fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(Fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(Fragment);
-    CheckCompileErrors(Fragment, "FRAGMENT");
-
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, Vertex);
-    glAttachShader(ID, Fragment);
-    glLinkProgram(ID);
+    // compile and link, then check every step: a failed stage still gets attached, its log shows what went wrong
+    std::vector<unsigned int> Shaders;
+    ID = CompileStages(Shaders);
+    for (size_t i = 0; i < Shaders.size(); i++)
+    {
+        CheckCompileErrors(Shaders[i], StageName(Stages[i].Type));
+    }
     CheckCompileErrors(ID, "PROGRAM");
 
     // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(Vertex);
-    glDeleteShader(Fragment);
+    for (unsigned int Object : Shaders)
+    {
+        glDeleteShader(Object);
+    }
+    LiveShaders().push_back(this);
 }
 
 Shader::Shader(const char* InVertexPath, const char* InFragmentPath, const char* InGeometryPath)
+    : Stages{ { GL_VERTEX_SHADER, InVertexPath }, { GL_GEOMETRY_SHADER, InGeometryPath }, { GL_FRAGMENT_SHADER, InFragmentPath } }
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string VertexCode;
-    std::string GeometryCode;
-    std::string FragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream gShaderFile;
-    std::ifstream fShaderFile;
-
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        // open files
-        vShaderFile.open(InVertexPath);
-        gShaderFile.open(InGeometryPath);
-        fShaderFile.open(InFragmentPath);
-        std::stringstream vShaderStream, gShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        gShaderStream << gShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        gShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        VertexCode = vShaderStream.str();
-        GeometryCode = gShaderStream.str();
-        FragmentCode = fShaderStream.str();
-    }
-    catch (std::ifstream::failure& e)
-    {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-    }
-    const char* vShaderCode = VertexCode.c_str();
-    const char* gShaderCode = GeometryCode.c_str();
-    const char* fShaderCode = FragmentCode.c_str();
-
-    // 2. compile shaders
-    unsigned int Vertex, Geometry, Fragment;
-
-    // vertex shader
-    Vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(Vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(Vertex);
-    CheckCompileErrors(Vertex, "VERTEX");
-
-    // geometry shader
-    Geometry = glCreateShader(GL_GEOMETRY_SHADER);
-    glShaderSource(Geometry, 1, &gShaderCode, nullptr);
-    glCompileShader(Geometry);
-    CheckCompileErrors(Geometry, "GEOMETRY");
-    
-    // fragment Shader
-    Fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(Fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(Fragment);
-    CheckCompileErrors(Fragment, "FRAGMENT");
-
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, Vertex);
-    glAttachShader(ID, Geometry);
-    glAttachShader(ID, Fragment);
-    glLinkProgram(ID);
+    std::vector<unsigned int> Shaders;
+    ID = CompileStages(Shaders);
+    for (size_t i = 0; i < Shaders.size(); i++)
+    {
+        CheckCompileErrors(Shaders[i], StageName(Stages[i].Type));
+    }
     CheckCompileErrors(ID, "PROGRAM");
+    for (unsigned int Object : Shaders)
+    {
+        glDeleteShader(Object);
+    }
+    LiveShaders().push_back(this);
+}
 
-    // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(Vertex);
-    glDeleteShader(Geometry);
-    glDeleteShader(Fragment);
+Shader::Shader(const char* InComputePath)
+    : Stages{ { GL_COMPUTE_SHADER, InComputePath } }
+{
+    std::vector<unsigned int> Shaders;
+    ID = CompileStages(Shaders);
+    CheckCompileErrors(Shaders[0], "COMPUTE");
+    CheckCompileErrors(ID, "PROGRAM");
+    glDeleteShader(Shaders[0]);
+    LiveShaders().push_back(this);
+}
+
+Shader::~Shader()
+{
+    if (PendingID)
+    {
+        for (unsigned int Object : PendingShaders)
+        {
+            glDeleteShader(Object);
+        }
+        glDeleteProgram(PendingID);
+    }
+    std::vector<Shader*>& Shaders = LiveShaders();
+    Shaders.erase(std::remove(Shaders.begin(), Shaders.end(), this), Shaders.end());
+}
+
+const std::vector<Shader*>& Shader::GetLiveShaders()
+{
+    return LiveShaders();
+}
+
+bool Shader::UsesFile(const std::string& path) const
+{
+    for (const Stage& Source : Stages)
+    {
+        if (Source.Path == path)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> Shader::GetFiles() const
+{
+    std::vector<std::string> Files;
+    for (const Stage& Source : Stages)
+    {
+        Files.push_back(Source.Path);
+    }
+    return Files;
+}
+
+unsigned int Shader::CompileStages(std::vector<unsigned int>& OutShaders) const
+{
+    const unsigned int Program = glCreateProgram();
+    for (const Stage& Source : Stages)
+    {
+        const std::string Code = ReadShaderFile(Source.Path);
+        const char* ShaderCode = SkipByteOrderMark(Code);
+        const unsigned int Object = glCreateShader(Source.Type);
+        glShaderSource(Object, 1, &ShaderCode, nullptr);
+        glCompileShader(Object);
+        glAttachShader(Program, Object);
+        OutShaders.push_back(Object);
+    }
+    glLinkProgram(Program);
+    return Program;
+}
+
+void Shader::BeginReload()
+{
+    if (PendingID)
+    {
+        for (unsigned int Object : PendingShaders)
+        {
+            glDeleteShader(Object);
+        }
+        glDeleteProgram(PendingID);
+        PendingShaders.clear();
+    }
+    // queries the extension before the first compile, so the driver already knows how many threads it may use
+    HasParallelCompile();
+    PendingID = CompileStages(PendingShaders);
+}
+
+bool Shader::PollReload()
+{
+    if (!PendingID)
+    {
+        return true;
+    }
+    if (HasParallelCompile())
+    {
+        GLint bCompleted = GL_FALSE;
+        glGetProgramiv(PendingID, GL_COMPLETION_STATUS_KHR, &bCompleted);
+        if (!bCompleted)
+        {
+            return false;
+        }
+    }
+
+    bool bSucceeded = true;
+    for (size_t i = 0; i < PendingShaders.size(); i++)
+    {
+        bSucceeded &= CheckCompileErrors(PendingShaders[i], StageName(Stages[i].Type));
+        glDeleteShader(PendingShaders[i]);
+    }
+    bSucceeded = CheckCompileErrors(PendingID, "PROGRAM") && bSucceeded;
+    PendingShaders.clear();
+    if (!bSucceeded)
+    {
+        std::cout << "ERROR::SHADER::RELOAD_FAILED: " << Stages.back().Path << " keeps its previous program" << std::endl;
+        glDeleteProgram(PendingID);
+        PendingID = 0;
+        return true;
+    }
+
+    CopyProgramState(ID, PendingID);
+    glDeleteProgram(ID);
+    ID = PendingID;
+    PendingID = 0;
+    UniformLocations.clear();
+    return true;
+}
+
+GLint Shader::GetUniformLocation(const std::string& InName) const
+{
+    const auto Cached = UniformLocations.find(InName);
+    if (Cached != UniformLocations.end())
+    {
+        return Cached->second;
+    }
+    const GLint Location = glGetUniformLocation(ID, InName.c_str());
+    UniformLocations.emplace(InName, Location);
+    return Location;
 }
 
 void Shader::SetBool(const std::string& InName, const bool InValue) const
 {
-    glUniform1i(glGetUniformLocation(ID, InName.c_str()), (int)InValue);
+    glUniform1i(GetUniformLocation(InName), (int)InValue);
 }
 
 void Shader::SetInt(const std::string& InName, const int InValue) const
 {
-    glUniform1i(glGetUniformLocation(ID, InName.c_str()), InValue);
+    glUniform1i(GetUniformLocation(InName), InValue);
 }
 
 void Shader::SetFloat(const std::string& InName, float InValue) const
 {
-    glUniform1f(glGetUniformLocation(ID, InName.c_str()), InValue);
+    glUniform1f(GetUniformLocation(InName), InValue);
 }
 
 void Shader::SetVec2(const std::string& InName, glm::vec2& Value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, InName.c_str()), 1, &Value[0]);
+    glUniform2fv(GetUniformLocation(InName), 1, &Value[0]);
 }
 
 void Shader::SetVec2(const std::string& InName, const float X, const float Y) const
 {
-    glUniform2f(glGetUniformLocation(ID, InName.c_str()), X, Y);
+    glUniform2f(GetUniformLocation(InName), X, Y);
 }
 
 void Shader::SetVec3(const std::string& InName, glm::vec3& Value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, InName.c_str()), 1, &Value[0]);
+    glUniform3fv(GetUniformLocation(InName), 1, &Value[0]);
 }
 
 void Shader::SetVec3(const std::string& InName, const float X, const float Y, const float Z) const
 {
-    glUniform3f(glGetUniformLocation(ID, InName.c_str()), X, Y, Z);
+    glUniform3f(GetUniformLocation(InName), X, Y, Z);
 }
 
 void Shader::SetVec4(const std::string& InName, glm::vec4& Value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, InName.c_str()), 1, &Value[0]);
+    glUniform4fv(GetUniformLocation(InName), 1, &Value[0]);
 }
 
 void Shader::SetVec4(const std::string& InName, const float X, const float Y, const float Z, const float W) const
 {
-    glUniform4f(glGetUniformLocation(ID, InName.c_str()), X, Y, Z, W);
+    glUniform4f(GetUniformLocation(InName), X, Y, Z, W);
 }
 
 void Shader::SetMat2(const std::string& InName, glm::mat2& Mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, InName.c_str()), 1, GL_FALSE, &Mat[0][0]);
+    glUniformMatrix2fv(GetUniformLocation(InName), 1, GL_FALSE, &Mat[0][0]);
 }
 
 void Shader::SetMat3(const std::string& InName, glm::mat3& Mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, InName.c_str()), 1, GL_FALSE, &Mat[0][0]);
+    glUniformMatrix3fv(GetUniformLocation(InName), 1, GL_FALSE, &Mat[0][0]);
 }
 
 void Shader::SetMat4(const std::string& InName, glm::mat4& Mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, InName.c_str()), 1, GL_FALSE, &Mat[0][0]);
+    glUniformMatrix4fv(GetUniformLocation(InName), 1, GL_FALSE, &Mat[0][0]);
+}
+
+void Shader::SetUniformBlockBinding(const std::string& InName, unsigned int InBinding) const
+{
+    const unsigned int Index = glGetUniformBlockIndex(ID, InName.c_str());
+    if (Index != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(ID, Index, InBinding);
+    }
 }
 
 
-void Shader::CheckCompileErrors(unsigned InShader, const std::string& Type)
+bool Shader::CheckCompileErrors(unsigned InShader, const std::string& Type)
 {
     int Success;
     char InfoLog[1024];
@@ -225,4 +455,5 @@ void Shader::CheckCompileErrors(unsigned InShader, const std::string& Type)
             std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << Type << "\n" << InfoLog << "\n -- --------------------------------------------------- -- " << std::endl;
         }
     }
+    return Success != 0;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -16,6 +18,14 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* InVertexPath, const char* InFragmentPath);
     Shader(const char* InVertexPath, const char* InFragmentPath, const char* InGeometryPath);
+    // compute program, the context has to support GL 4.3 or ARB_compute_shader
+    explicit Shader(const char* InComputePath);
+    // leaves the program alive, owners delete ID themselves
+    ~Shader();
+
+    // registered for hot reloading by address
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
 
     // activate the shader
     // ------------------------------------------------------------------------
@@ -35,10 +45,47 @@ public:
     void SetMat2(const std::string& InName, glm::mat2& Mat) const;
     void SetMat3(const std::string& InName, glm::mat3& Mat) const;
     void SetMat4(const std::string& InName, glm::mat4& Mat) const;
+    // connects a uniform block to a binding point (glBindBufferRange index), GL 3.3 has no layout(binding = N)
+    void SetUniformBlockBinding(const std::string& InName, unsigned int InBinding) const;
+
+    // hot reloading (ShaderHotReload)
+    // ------------------------------------------------------------------------
+    // compiles the files again into a new program next to the current one, dropping a reload still in flight. Where the
+    // driver compiles in parallel (KHR/ARB_parallel_shader_compile) this returns without waiting for the compiler.
+    void BeginReload();
+    // finishes a reload once the compiler is done, false while it still runs. A program that linked takes over ID,
+    // with the uniform values and block bindings of the old one (the ones set once at startup, like sampler units);
+    // the old program is deleted. A failed compile or link prints the log and keeps the old program.
+    bool PollReload();
+    bool IsReloading() const { return PendingID != 0; }
+    // true if one of the program's stages is compiled from path, as passed to the constructor
+    bool UsesFile(const std::string& path) const;
+    // paths of the stages, vertex first and fragment last
+    std::vector<std::string> GetFiles() const;
+
+    // every Shader currently constructed
+    static const std::vector<Shader*>& GetLiveShaders();
 
 private:
 
+    struct Stage
+    {
+        GLenum Type;
+        std::string Path;
+    };
+
+    // reads and compiles every stage and links them, without checking the results
+    unsigned int CompileStages(std::vector<unsigned int>& OutShaders) const;
+
+    // glGetUniformLocation, cached per name until the program is swapped
+    GLint GetUniformLocation(const std::string& InName) const;
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void CheckCompileErrors(unsigned int InShader, const std::string& Type);
+    bool CheckCompileErrors(unsigned int InShader, const std::string& Type);
+
+    std::vector<Stage> Stages;
+    unsigned int PendingID = 0;                 // reload in flight
+    std::vector<unsigned int> PendingShaders;   // its stages, kept for their logs until it finished
+    mutable std::unordered_map<std::string, GLint> UniformLocations;
 };
@@ -0,0 +1,180 @@
+#include "ShaderHotReload.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Shader.h"
+
+namespace
+{
+	// st_mtime only has whole seconds, two saves within one would look the same. The size catches most of those,
+	// and the finer timestamps are used where the platform has them.
+	ShaderHotReload::FileStamp GetFileStamp(const std::string& Path)
+	{
+		ShaderHotReload::FileStamp Stamp;
+#ifdef _WIN32
+		// 100 ns FILETIME
+		WIN32_FILE_ATTRIBUTE_DATA Data;
+		if (GetFileAttributesExA(Path.c_str(), GetFileExInfoStandard, &Data))
+		{
+			Stamp.Time = static_cast<long long>((static_cast<unsigned long long>(Data.ftLastWriteTime.dwHighDateTime) << 32) | Data.ftLastWriteTime.dwLowDateTime);
+			Stamp.Size = static_cast<long long>((static_cast<unsigned long long>(Data.nFileSizeHigh) << 32) | Data.nFileSizeLow);
+		}
+#else
+		struct stat Status;
+		if (stat(Path.c_str(), &Status) == 0)
+		{
+#ifdef __linux__
+			Stamp.Time = static_cast<long long>(Status.st_mtim.tv_sec) * 1000000000LL + Status.st_mtim.tv_nsec;
+#else
+			Stamp.Time = static_cast<long long>(Status.st_mtime);
+#endif
+			Stamp.Size = static_cast<long long>(Status.st_size);
+		}
+#endif
+		return Stamp;
+	}
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+	Shutdown();
+}
+
+bool ShaderHotReload::Init(const std::string& directory)
+{
+	Shutdown();
+	Directory = directory;
+	bInitialized = true;
+#ifdef __linux__
+	WatchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	// close write is the end of a save in place, moved to catches editors writing a temporary file and renaming it
+	if (WatchDescriptor >= 0 && inotify_add_watch(WatchDescriptor, Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+	{
+		return true;
+	}
+	std::cout << "ERROR::SHADER_HOT_RELOAD:: can't watch " << Directory << ", polling instead" << std::endl;
+	if (WatchDescriptor >= 0)
+	{
+		close(WatchDescriptor);
+		WatchDescriptor = -1;
+	}
+#endif
+	NextPoll = std::chrono::steady_clock::now();
+	return true;
+}
+
+void ShaderHotReload::Shutdown()
+{
+#ifdef __linux__
+	if (WatchDescriptor >= 0)
+	{
+		close(WatchDescriptor);
+	}
+#endif
+	WatchDescriptor = -1;
+	FileStamps.clear();
+	bInitialized = false;
+}
+
+void ShaderHotReload::CollectChanges(std::vector<std::string>& OutPaths)
+{
+#ifdef __linux__
+	if (WatchDescriptor >= 0)
+	{
+		alignas(inotify_event) char Buffer[4096];
+		ssize_t Length;
+		while ((Length = read(WatchDescriptor, Buffer, sizeof(Buffer))) > 0)
+		{
+			for (ssize_t Offset = 0; Offset < Length;)
+			{
+				const inotify_event* Event = reinterpret_cast<const inotify_event*>(Buffer + Offset);
+				if (Event->len > 0)
+				{
+					OutPaths.push_back(Directory + "/" + Event->name);
+				}
+				Offset += sizeof(inotify_event) + Event->len;
+			}
+		}
+		return;
+	}
+#endif
+	const std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+	if (Now < NextPoll)
+	{
+		return;
+	}
+	NextPoll = Now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(PollIntervalSeconds));
+	for (const Shader* Program : Shader::GetLiveShaders())
+	{
+		for (const std::string& Path : Program->GetFiles())
+		{
+			const FileStamp Stamp = GetFileStamp(Path);
+			const auto Known = FileStamps.find(Path);
+			if (Known == FileStamps.end())
+			{
+				// first sight, changes count from here
+				FileStamps.emplace(Path, Stamp);
+			}
+			else if (Known->second.Time != Stamp.Time || Known->second.Size != Stamp.Size)
+			{
+				Known->second = Stamp;
+				OutPaths.push_back(Path);
+			}
+		}
+	}
+}
+
+void ShaderHotReload::Tick()
+{
+	if (!bInitialized)
+	{
+		return;
+	}
+
+	std::vector<std::string> Changed;
+	CollectChanges(Changed);
+	std::sort(Changed.begin(), Changed.end());
+	Changed.erase(std::unique(Changed.begin(), Changed.end()), Changed.end());
+	for (const std::string& Path : Changed)
+	{
+		for (Shader* Program : Shader::GetLiveShaders())
+		{
+			if (Program->UsesFile(Path))
+			{
+				Program->BeginReload();
+			}
+		}
+	}
+
+	// the live list rather than pointers kept from BeginReload, a shader may have been destroyed since
+	for (Shader* Program : Shader::GetLiveShaders())
+	{
+		if (!Program->IsReloading())
+		{
+			continue;
+		}
+		const unsigned int PreviousID = Program->ID;
+		if (!Program->PollReload())
+		{
+			continue;
+		}
+		if (Program->ID != PreviousID)
+		{
+			ReloadStats.Reloads++;
+			std::cout << "Reloaded " << Program->GetFiles().back() << std::endl;
+		}
+		else
+		{
+			ReloadStats.Failures++;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// recompiles shaders whose files change on disk while the program runs. On Linux an inotify watch on the shader
+// directory reports files as they're saved, elsewhere the write time and size of the live shaders' stages are
+// checked every PollIntervalSeconds. Changed files start a reload of every Shader that uses them (Shader::BeginReload), later Ticks
+// swap the new programs in once the driver finished compiling them, so nothing waits on the compiler where it
+// compiles in parallel and a shader that doesn't compile keeps drawing with its previous program. Everything runs on
+// the thread of the GL context, in Tick.
+class ShaderHotReload
+{
+public:
+
+    struct Stats
+    {
+        int Reloads = 0;    // programs swapped
+        int Failures = 0;   // reloads that didn't compile or link
+    };
+
+    ShaderHotReload() = default;
+    ~ShaderHotReload();
+
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // directory as the shader paths start with, "Shaders" for "Shaders/SSAO.frag"
+    bool Init(const std::string& directory = "Shaders");
+    void Shutdown();
+
+    // once per frame, outside any pass: starts the reloads of changed files and finishes the ones compiled
+    void Tick();
+
+    const Stats& GetStats() const { return ReloadStats; }
+
+    // what polling compares, -1 for a file that can't be read
+    struct FileStamp
+    {
+        long long Time = -1;    // last write, in the platform's finest unit
+        long long Size = -1;
+    };
+
+    // polling interval where there's no inotify
+    double PollIntervalSeconds = 0.5;
+
+private:
+
+    // paths of the files changed since the last Tick, as the shaders name them
+    void CollectChanges(std::vector<std::string>& OutPaths);
+
+    std::string Directory;
+    bool bInitialized = false;
+    int WatchDescriptor = -1;       // inotify instance, -1 when polling
+    std::unordered_map<std::string, FileStamp> FileStamps;
+    std::chrono::steady_clock::time_point NextPoll;
+    Stats ReloadStats;
+};
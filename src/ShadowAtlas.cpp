@@ -0,0 +1,553 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "DynamicRingBuffer.h"
+#include "Profiler.h"
+#include "Shader.h"
+
+constexpr int ShadowAtlas::MaxLights;
+constexpr int ShadowAtlas::MaxViews;
+
+namespace
+{
+	// GL cube face order, the lighting shader picks the face by the major axis in the same order
+	const glm::vec3 FaceDirections[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const glm::vec3 FaceUps[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+
+	// std140 mirror of the ShadowAtlasLights block
+	struct GPULight
+	{
+		glm::vec4 PositionRange;
+		glm::vec4 ColorType;            // w: 0 point, 1 spot
+		glm::vec4 DirectionCosOuter;
+		glm::vec4 ShadowInfo;           // x first view, y view count (0 = unshadowed), z cos of the inner angle
+	};
+
+	struct GPUView
+	{
+		glm::mat4 ViewProjection;
+		glm::vec4 Rect;                 // tile origin and size in atlas UVs
+	};
+
+	struct GPULightBlock
+	{
+		glm::ivec4 LightCount;
+		GPULight Lights[ShadowAtlas::MaxLights];
+		GPUView Views[ShadowAtlas::MaxViews];
+	};
+
+	int FloorLog2(int Value)
+	{
+		int Result = 0;
+		while (Value > 1)
+		{
+			Value >>= 1;
+			Result++;
+		}
+		return Result;
+	}
+
+	bool SphereIntersectsAABB(const glm::vec3& Center, float Radius, const AABB& Box)
+	{
+		const glm::vec3 Closest = glm::clamp(Center, Box.Min, Box.Max);
+		const glm::vec3 Delta = Closest - Center;
+		return glm::dot(Delta, Delta) <= Radius * Radius;
+	}
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	Shutdown();
+}
+
+bool ShadowAtlas::Init(int size, int minTile, int maxTile)
+{
+	Shutdown();
+	Size = 1 << FloorLog2(std::max(size, 64));
+	maxTile = std::min(std::max(maxTile, 1), Size);
+	minTile = std::min(std::max(minTile, 1), maxTile);
+	MinLevel = FloorLog2(Size / maxTile);
+	MaxLevel = FloorLog2(Size / minTile);
+	FreeTiles.assign(MaxLevel + 1, std::vector<glm::ivec2>());
+	FreeTiles[0].push_back(glm::ivec2(0));
+	Entries.clear();
+	AtlasStats = Stats();
+
+	glGenTextures(1, &DepthTexture);
+	glBindTexture(GL_TEXTURE_2D, DepthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, Size, Size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, DepthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	const bool bComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!bComplete)
+	{
+		std::cout << "ERROR::SHADOW_ATLAS:: Framebuffer is not complete!" << std::endl;
+		Shutdown();
+		return false;
+	}
+
+	glGenBuffers(1, &FallbackBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, FallbackBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(GPULightBlock), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
+
+void ShadowAtlas::Shutdown()
+{
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		Framebuffer = 0;
+	}
+	if (DepthTexture)
+	{
+		glDeleteTextures(1, &DepthTexture);
+		DepthTexture = 0;
+	}
+	if (FallbackBuffer)
+	{
+		glDeleteBuffers(1, &FallbackBuffer);
+		FallbackBuffer = 0;
+	}
+	Entries.clear();
+	FreeTiles.clear();
+}
+
+bool ShadowAtlas::AllocateTile(int level, Tile& outTile)
+{
+	// the closest level above with a free tile, then split it down, the unused quarters go to the free lists
+	int Found = level;
+	while (Found >= 0 && FreeTiles[Found].empty())
+	{
+		Found--;
+	}
+	if (Found < 0)
+	{
+		return false;
+	}
+	glm::ivec2 Origin = FreeTiles[Found].back();
+	FreeTiles[Found].pop_back();
+	for (int Level = Found + 1; Level <= level; Level++)
+	{
+		const int Half = GetTileSize(Level);
+		FreeTiles[Level].push_back(Origin + glm::ivec2(Half, 0));
+		FreeTiles[Level].push_back(Origin + glm::ivec2(0, Half));
+		FreeTiles[Level].push_back(Origin + glm::ivec2(Half, Half));
+	}
+	outTile.Level = level;
+	outTile.Origin = Origin;
+	return true;
+}
+
+void ShadowAtlas::FreeTile(const Tile& tile)
+{
+	// merge with the three buddies while they are all free
+	int Level = tile.Level;
+	glm::ivec2 Origin = tile.Origin;
+	while (Level > 0)
+	{
+		const int Edge = GetTileSize(Level);
+		const glm::ivec2 Parent = (Origin / (Edge * 2)) * (Edge * 2);
+		std::vector<glm::ivec2>& Free = FreeTiles[Level];
+		int Buddies = 0;
+		for (const glm::ivec2& Candidate : Free)
+		{
+			if (Candidate != Origin && (Candidate / (Edge * 2)) * (Edge * 2) == Parent)
+			{
+				Buddies++;
+			}
+		}
+		if (Buddies < 3)
+		{
+			break;
+		}
+		Free.erase(std::remove_if(Free.begin(), Free.end(), [&](const glm::ivec2& Candidate)
+		{
+			return (Candidate / (Edge * 2)) * (Edge * 2) == Parent;
+		}), Free.end());
+		Origin = Parent;
+		Level--;
+	}
+	FreeTiles[Level].push_back(Origin);
+}
+
+void ShadowAtlas::FreeViews(Entry& light)
+{
+	for (const View& LightView : light.Views)
+	{
+		FreeTile(LightView.Region);
+	}
+	light.Views.clear();
+	light.Level = -1;
+}
+
+bool ShadowAtlas::LightChanged(const AtlasLight& a, const AtlasLight& b)
+{
+	return a.bSpot != b.bSpot || a.Position != b.Position || a.Range != b.Range ||
+		(a.bSpot && (a.Direction != b.Direction || a.OuterAngle != b.OuterAngle));
+}
+
+void ShadowAtlas::UpdateViewMatrices(Entry& light)
+{
+	const AtlasLight& Source = light.Source;
+	const float Near = std::max(0.05f, Source.Range * 0.005f);
+	if (Source.bSpot)
+	{
+		const glm::vec3 Direction = glm::normalize(Source.Direction);
+		const glm::vec3 Up = std::abs(Direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		const float FovY = glm::radians(std::min(2.0f * Source.OuterAngle + 2.0f, 170.0f));
+		light.Views[0].ViewProjection = glm::perspective(FovY, 1.0f, Near, Source.Range) * glm::lookAt(Source.Position, Source.Position + Direction, Up);
+		return;
+	}
+	const glm::mat4 Projection = glm::perspective(glm::radians(90.0f), 1.0f, Near, Source.Range);
+	for (int Face = 0; Face < 6; Face++)
+	{
+		light.Views[Face].ViewProjection = Projection * glm::lookAt(Source.Position, Source.Position + FaceDirections[Face], FaceUps[Face]);
+	}
+}
+
+void ShadowAtlas::Update(const std::vector<AtlasLight>& lights, const glm::vec3& cameraPosition, float fovY, int screenHeight)
+{
+	if (!DepthTexture)
+	{
+		return;
+	}
+
+	// screen coverage of each light's range sphere decides its tile level, the most important lights come first
+	struct Candidate
+	{
+		const AtlasLight* Source;
+		float Importance;
+		int Level;
+	};
+	std::vector<Candidate> Candidates;
+	Candidates.reserve(lights.size());
+	const float TanHalfFov = std::tan(fovY * 0.5f);
+	for (const AtlasLight& Light : lights)
+	{
+		const float Distance = glm::length(Light.Position - cameraPosition);
+		const float Coverage = Distance <= Light.Range ? 1.0f : std::min(1.0f, Light.Range / (Distance * TanHalfFov));
+		const float Edge = std::max(1.0f, Coverage * screenHeight * ResolutionScale);
+		const int Level = std::min(MaxLevel, std::max(MinLevel, FloorLog2(static_cast<int>(Size / Edge))));
+		Candidates.push_back({ &Light, Coverage, Level });
+	}
+	std::stable_sort(Candidates.begin(), Candidates.end(), [](const Candidate& A, const Candidate& B) { return A.Importance > B.Importance; });
+	if (Candidates.size() > static_cast<size_t>(MaxLights))
+	{
+		Candidates.resize(MaxLights);
+	}
+
+	// when the wanted tiles add up to more than the atlas, everyone steps down a size until they fit
+	for (;;)
+	{
+		double WantedArea = 0.0;
+		bool bCanShrink = false;
+		for (const Candidate& Current : Candidates)
+		{
+			if (Current.Source->bCastShadows)
+			{
+				const double Edge = static_cast<double>(GetTileSize(Current.Level));
+				WantedArea += Edge * Edge * (Current.Source->bSpot ? 1 : 6);
+				bCanShrink = bCanShrink || Current.Level < MaxLevel;
+			}
+		}
+		if (WantedArea <= static_cast<double>(Size) * Size || !bCanShrink)
+		{
+			break;
+		}
+		for (Candidate& Current : Candidates)
+		{
+			Current.Level = std::min(Current.Level + 1, MaxLevel);
+		}
+	}
+
+	// match the lights to last frame's entries, the tiles of lights that are gone go back to the allocator
+	std::vector<Entry> Previous;
+	Previous.swap(Entries);
+	Entries.reserve(Candidates.size());
+	for (const Candidate& Current : Candidates)
+	{
+		auto Found = std::find_if(Previous.begin(), Previous.end(), [&](const Entry& Old) { return !Old.bSeen && Old.Source.Id == Current.Source->Id; });
+		Entry Light;
+		if (Found != Previous.end())
+		{
+			Found->bSeen = true;
+			Light = std::move(*Found);
+		}
+		const bool bChanged = Found == Previous.end() || LightChanged(Light.Source, *Current.Source);
+		Light.Source = *Current.Source;
+		Light.Importance = Current.Importance;
+
+		// grow as soon as the bigger tiles fit, shrink only once the light has wanted less for a while
+		int TargetLevel = Current.Level;
+		if (!Light.Source.bCastShadows)
+		{
+			FreeViews(Light);
+		}
+		else if (Light.Views.empty())
+		{
+			Light.Level = TargetLevel;
+		}
+		else if (TargetLevel < Light.Level)
+		{
+			std::vector<View> Grown(Light.Views.size());
+			size_t Count = 0;
+			while (Count < Grown.size() && AllocateTile(TargetLevel, Grown[Count].Region))
+			{
+				Count++;
+			}
+			if (Count == Grown.size())
+			{
+				FreeViews(Light);
+				Light.Views.swap(Grown);
+				Light.Level = TargetLevel;
+				UpdateViewMatrices(Light);
+			}
+			else
+			{
+				for (size_t i = 0; i < Count; i++)
+				{
+					FreeTile(Grown[i].Region);
+				}
+			}
+			Light.ShrinkFrames = 0;
+		}
+		else if (TargetLevel > Light.Level && ++Light.ShrinkFrames >= ShrinkDelayFrames)
+		{
+			FreeViews(Light);
+			Light.Level = TargetLevel;
+			Light.ShrinkFrames = 0;
+		}
+		else if (TargetLevel == Light.Level)
+		{
+			Light.ShrinkFrames = 0;
+		}
+
+		if (!Light.Views.empty() && (bChanged || !Light.Source.bStatic))
+		{
+			UpdateViewMatrices(Light);
+			for (View& LightView : Light.Views)
+			{
+				LightView.bDirty = true;
+			}
+		}
+		Entries.push_back(std::move(Light));
+	}
+	for (Entry& Old : Previous)
+	{
+		if (!Old.bSeen)
+		{
+			FreeViews(Old);
+		}
+	}
+	for (Entry& Light : Entries)
+	{
+		Light.bSeen = false;
+	}
+
+	// tiles for the lights that lost or never had them, in importance order. When the wanted size doesn't fit the
+	// light tries smaller ones before it goes unshadowed.
+	size_t UsedViews = 0;
+	for (const Entry& Light : Entries)
+	{
+		UsedViews += Light.Views.size();
+	}
+	AtlasStats.FailedAllocations = 0;
+	for (Entry& Light : Entries)
+	{
+		if (!Light.Source.bCastShadows || !Light.Views.empty())
+		{
+			continue;
+		}
+		const int ViewCount = Light.Source.bSpot ? 1 : 6;
+		bool bAllocated = false;
+		for (int Level = Light.Level; Level <= MaxLevel && !bAllocated && UsedViews + ViewCount <= static_cast<size_t>(MaxViews); Level++)
+		{
+			Light.Views.resize(ViewCount);
+			int Count = 0;
+			while (Count < ViewCount && AllocateTile(Level, Light.Views[Count].Region))
+			{
+				Count++;
+			}
+			bAllocated = Count == ViewCount;
+			if (!bAllocated)
+			{
+				for (int i = 0; i < Count; i++)
+				{
+					FreeTile(Light.Views[i].Region);
+				}
+			}
+			else
+			{
+				Light.Level = Level;
+			}
+		}
+		if (!bAllocated)
+		{
+			Light.Views.clear();
+			Light.Level = -1;
+			AtlasStats.FailedAllocations++;
+			continue;
+		}
+		UsedViews += ViewCount;
+		UpdateViewMatrices(Light);
+	}
+
+	AtlasStats.Lights = lights.size();
+	AtlasStats.ShadowedLights = 0;
+	AtlasStats.Views = UsedViews;
+	double UsedArea = 0.0;
+	for (const Entry& Light : Entries)
+	{
+		AtlasStats.ShadowedLights += Light.Views.empty() ? 0 : 1;
+		for (const View& LightView : Light.Views)
+		{
+			const double Edge = static_cast<double>(GetTileSize(LightView.Region.Level)) / Size;
+			UsedArea += Edge * Edge;
+		}
+	}
+	AtlasStats.Occupancy = static_cast<float>(UsedArea);
+}
+
+void ShadowAtlas::Invalidate(const AABB& box)
+{
+	for (Entry& Light : Entries)
+	{
+		if (Light.Views.empty() || !SphereIntersectsAABB(Light.Source.Position, Light.Source.Range, box))
+		{
+			continue;
+		}
+		for (View& LightView : Light.Views)
+		{
+			LightView.bDirty = true;
+		}
+	}
+}
+
+void ShadowAtlas::Render(const std::function<size_t(const glm::mat4& lightViewProjection, const Frustum& viewFrustum)>& drawCasters)
+{
+	AtlasStats.ViewsRendered = 0;
+	AtlasStats.ViewsCached = 0;
+	AtlasStats.ViewsDeferred = 0;
+	AtlasStats.DrawCalls = 0;
+	if (!Framebuffer)
+	{
+		return;
+	}
+
+	GENIX_PROFILE_GPU("Shadow Atlas");
+	GLint PreviousViewport[4];
+	GLint PreviousScissor[4];
+	GLint PreviousFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_SCISSOR_BOX, PreviousScissor);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+	const GLboolean bScissorWasEnabled = glIsEnabled(GL_SCISSOR_TEST);
+
+	// the scissor keeps the clear inside the tile
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glEnable(GL_SCISSOR_TEST);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(DepthBiasFactor, DepthBiasUnits);
+	for (Entry& Light : Entries)
+	{
+		for (View& LightView : Light.Views)
+		{
+			if (!LightView.bDirty)
+			{
+				AtlasStats.ViewsCached++;
+				continue;
+			}
+			if (AtlasStats.ViewsRendered >= static_cast<size_t>(MaxViewsPerFrame))
+			{
+				AtlasStats.ViewsDeferred++;
+				continue;
+			}
+			const int Edge = GetTileSize(LightView.Region.Level);
+			glViewport(LightView.Region.Origin.x, LightView.Region.Origin.y, Edge, Edge);
+			glScissor(LightView.Region.Origin.x, LightView.Region.Origin.y, Edge, Edge);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			AtlasStats.DrawCalls += drawCasters(LightView.ViewProjection, Frustum::FromMatrix(LightView.ViewProjection));
+			LightView.RenderedViewProjection = LightView.ViewProjection;
+			LightView.bDirty = false;
+			LightView.bValid = true;
+			AtlasStats.ViewsRendered++;
+		}
+	}
+	glDisable(GL_POLYGON_OFFSET_FILL);
+
+	if (!bScissorWasEnabled)
+	{
+		glDisable(GL_SCISSOR_TEST);
+	}
+	glScissor(PreviousScissor[0], PreviousScissor[1], PreviousScissor[2], PreviousScissor[3]);
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+}
+
+void ShadowAtlas::Bind(Shader& shader, int textureUnit, DynamicRingBuffer& ringBuffer, GLuint blockBinding) const
+{
+	// lights whose tiles haven't all been rendered yet are lit without shadow. Deferred tiles of moving lights are
+	// sampled with the matrix they were rendered with, not the one they will be rendered with.
+	GPULightBlock Block;
+	int ViewCount = 0;
+	Block.LightCount = glm::ivec4(static_cast<int>(Entries.size()), 0, 0, 0);
+	for (size_t i = 0; i < Entries.size(); i++)
+	{
+		const AtlasLight& Source = Entries[i].Source;
+		GPULight& Light = Block.Lights[i];
+		Light.PositionRange = glm::vec4(Source.Position, Source.Range);
+		Light.ColorType = glm::vec4(Source.Color, Source.bSpot ? 1.0f : 0.0f);
+		Light.DirectionCosOuter = glm::vec4(glm::normalize(Source.Direction), std::cos(glm::radians(Source.OuterAngle)));
+		Light.ShadowInfo = glm::vec4(0.0f, 0.0f, std::cos(glm::radians(Source.InnerAngle)), 0.0f);
+
+		const std::vector<View>& Views = Entries[i].Views;
+		const bool bReady = !Views.empty() && std::all_of(Views.begin(), Views.end(), [](const View& LightView) { return LightView.bValid; });
+		if (!bReady)
+		{
+			continue;
+		}
+		Light.ShadowInfo.x = static_cast<float>(ViewCount);
+		Light.ShadowInfo.y = static_cast<float>(Views.size());
+		for (const View& LightView : Views)
+		{
+			const float InvSize = 1.0f / Size;
+			Block.Views[ViewCount].ViewProjection = LightView.RenderedViewProjection;
+			Block.Views[ViewCount].Rect = glm::vec4(glm::vec2(LightView.Region.Origin) * InvSize, glm::vec2(static_cast<float>(GetTileSize(LightView.Region.Level)) * InvSize));
+			ViewCount++;
+		}
+	}
+
+	const DynamicRingBuffer::Allocation Allocation = ringBuffer.Upload(&Block, sizeof(Block), ringBuffer.GetUniformAlignment());
+	if (Allocation.IsValid())
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, blockBinding, Allocation.Buffer, Allocation.Offset, Allocation.Size);
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, FallbackBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &Block);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, blockBinding, FallbackBuffer);
+	}
+	shader.SetInt("shadowAtlas", textureUnit);
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D, DepthTexture);
+}
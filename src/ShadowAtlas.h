@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+
+class DynamicRingBuffer;
+class Shader;
+
+// a light as the atlas sees it, Id has to stay the same across frames for its shadow to be cached (e.g. the entity)
+struct AtlasLight
+{
+    uint32_t Id = 0;
+    bool bSpot = false;             // spot light (one view), otherwise point light (six cube face views)
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 Color = glm::vec3(1.0f);
+    float Range = 10.0f;
+    float InnerAngle = 20.0f;       // degrees
+    float OuterAngle = 30.0f;
+    bool bCastShadows = true;
+    bool bStatic = true;            // keeps its shadow until the light changes or something moves in its range
+};
+
+// one depth texture shared by the shadows of many point and spot lights. Every light gets square tiles (one per
+// view) out of a quadtree allocator, sized by how much of the screen the light's range covers. Tiles stay where they
+// are while their size doesn't change, so a static light's tiles are only re-rendered when the light changes or
+// Invalidate reports something moving inside its range. Also uploads the light list the lighting shader loops over
+// (the ShadowAtlasLights block).
+class ShadowAtlas
+{
+public:
+
+    // limits of the ShadowAtlasLights block, keep in sync with the lighting shader (about 12 KB, under the 16 KB a
+    // uniform block is guaranteed)
+    static constexpr int MaxLights = 32;
+    static constexpr int MaxViews = 128;
+
+    struct Stats
+    {
+        size_t Lights = 0;              // lights handed to the last Update
+        size_t ShadowedLights = 0;      // of those, the ones with tiles
+        size_t Views = 0;               // tiles in use
+        size_t ViewsRendered = 0;       // by the last Render
+        size_t ViewsCached = 0;         // valid tiles the last Render skipped
+        size_t ViewsDeferred = 0;       // dirty tiles left for later frames (MaxViewsPerFrame)
+        size_t FailedAllocations = 0;   // lights left unshadowed by the last Update for lack of space
+        size_t DrawCalls = 0;           // by the last Render
+        float Occupancy = 0.0f;         // fraction of the atlas area in use
+    };
+
+    ShadowAtlas() = default;
+    ~ShadowAtlas();
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    // size is the atlas edge in texels, tiles are powers of two between minTile and maxTile
+    bool Init(int size = 4096, int minTile = 64, int maxTile = 1024);
+    void Shutdown();
+
+    // sizes and allocates the tiles of this frame's lights (at most MaxLights, extra ones are dropped) and works out
+    // which views need rendering. cameraPosition, fovY (radians) and screenHeight estimate the screen coverage.
+    void Update(const std::vector<AtlasLight>& lights, const glm::vec3& cameraPosition, float fovY, int screenHeight);
+
+    // marks the cached views of lights whose range intersects the world space box as dirty (call before Render)
+    void Invalidate(const AABB& box);
+
+    // renders the dirty views, each into its own tile. drawCasters draws the casters inside the view frustum with
+    // lightViewProjection and returns its draw calls. GPU profiler marker "Shadow Atlas". Leaves the framebuffer,
+    // viewport and scissor test as they were.
+    void Render(const std::function<size_t(const glm::mat4& lightViewProjection, const Frustum& viewFrustum)>& drawCasters);
+
+    // binds the atlas to the texture unit and the light list to the uniform block binding. The list goes into
+    // ringBuffer, or into a buffer of the atlas' own if the ring is full this frame.
+    void Bind(Shader& shader, int textureUnit, DynamicRingBuffer& ringBuffer, GLuint blockBinding) const;
+
+    GLuint GetTexture() const { return DepthTexture; }
+    int GetSize() const { return Size; }
+    const Stats& GetStats() const { return AtlasStats; }
+
+    // tile edge per unit of screen coverage (the light's range sphere height / screen height)
+    float ResolutionScale = 1.0f;
+    // frames a light has to want a smaller tile before it gives up its current one (growing is immediate)
+    int ShrinkDelayFrames = 30;
+    // caps the tiles rendered per frame, the rest wait (unshadowed if never rendered, else with their old contents)
+    int MaxViewsPerFrame = 24;
+    // glPolygonOffset during the depth pass
+    float DepthBiasFactor = 2.0f;
+    float DepthBiasUnits = 4.0f;
+
+private:
+
+    // a square tile, Level 0 is the whole atlas, every level down halves the edge
+    struct Tile
+    {
+        int Level = -1;
+        glm::ivec2 Origin = glm::ivec2(0);
+    };
+
+    struct View
+    {
+        Tile Region;
+        glm::mat4 ViewProjection = glm::mat4(1.0f);
+        glm::mat4 RenderedViewProjection = glm::mat4(1.0f);    // what the tile holds, lags behind while deferred
+        bool bDirty = true;
+        bool bValid = false;        // holds a rendered shadow
+    };
+
+    // what the atlas keeps per light between frames
+    struct Entry
+    {
+        AtlasLight Source;
+        int Level = -1;             // tile level of its views
+        int ShrinkFrames = 0;       // frames in a row it wanted a smaller tile
+        float Importance = 0.0f;
+        bool bSeen = false;         // in this frame's light list
+        std::vector<View> Views;
+    };
+
+    bool AllocateTile(int level, Tile& outTile);
+    void FreeTile(const Tile& tile);
+    void FreeViews(Entry& light);
+    int GetTileSize(int level) const { return Size >> level; }
+    static bool LightChanged(const AtlasLight& a, const AtlasLight& b);
+    void UpdateViewMatrices(Entry& light);
+
+    GLuint DepthTexture = 0;
+    GLuint Framebuffer = 0;
+    GLuint FallbackBuffer = 0;      // light list when the ring buffer has no room
+    int Size = 0;
+    int MinLevel = 0;               // level of the largest tile handed out
+    int MaxLevel = 0;               // level of the smallest tile
+    std::vector<std::vector<glm::ivec2>> FreeTiles;    // per level
+    std::vector<Entry> Entries;     // in importance order after Update
+    Stats AtlasStats;
+};
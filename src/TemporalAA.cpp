@@ -0,0 +1,120 @@
+#include "TemporalAA.h"
+
+#include "Profiler.h"
+#include "RenderTargetManager.h"
+
+namespace
+{
+	// linear, the history is fetched at reprojected sub-pixel positions
+	const RenderTargetDesc ColorTarget = { GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_LINEAR, GL_CLAMP_TO_EDGE };
+
+	void DeleteProgram(std::unique_ptr<Shader>& Program)
+	{
+		if (Program)
+		{
+			glDeleteProgram(Program->ID);
+			Program.reset();
+		}
+	}
+}
+
+TemporalAA::~TemporalAA()
+{
+	Shutdown();
+}
+
+bool TemporalAA::Init(RenderTargetManager& targets)
+{
+	Shutdown();
+	Targets = &targets;
+	Width = targets.GetOutputWidth();
+	Height = targets.GetOutputHeight();
+	glGenFramebuffers(1, &Framebuffer);
+	History[0] = &targets.Create(ColorTarget, TARGET_OUTPUT_SIZE);
+	History[1] = &targets.Create(ColorTarget, TARGET_OUTPUT_SIZE);
+	Output = &targets.Create(ColorTarget, TARGET_OUTPUT_SIZE);
+
+	ResolveShader.reset(new Shader("Shaders/SSAO.vert", "Shaders/TAA.frag"));
+	ResolveShader->Use();
+	ResolveShader->SetInt("currentColor", 0);
+	ResolveShader->SetInt("historyColor", 1);
+	ResolveShader->SetInt("velocityBuffer", 2);
+	ResolveShader->SetInt("gPosition", 3);
+	SharpenShader.reset(new Shader("Shaders/SSAO.vert", "Shaders/TAASharpen.frag"));
+	SharpenShader->Use();
+	SharpenShader->SetInt("image", 0);
+	bHistoryValid = false;
+	return true;
+}
+
+void TemporalAA::Shutdown()
+{
+	DeleteProgram(ResolveShader);
+	DeleteProgram(SharpenShader);
+	// the textures belong to the target manager
+	History[0] = nullptr;
+	History[1] = nullptr;
+	Output = nullptr;
+	Targets = nullptr;
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		Framebuffer = 0;
+	}
+	bHistoryValid = false;
+}
+
+GLuint TemporalAA::Resolve(GLuint color, GLuint velocity, GLuint position, void (*drawQuad)())
+{
+	if (!Framebuffer)
+	{
+		return color;
+	}
+
+	GENIX_PROFILE_GPU("TAA");
+	if (Targets->GetOutputWidth() != Width || Targets->GetOutputHeight() != Height)
+	{
+		Width = Targets->GetOutputWidth();
+		Height = Targets->GetOutputHeight();
+		bHistoryValid = false;
+	}
+	GLint PreviousViewport[4];
+	GLint PreviousFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glViewport(0, 0, Width, Height);
+
+	// current + reprojected history -> the other history texture
+	const GLuint PreviousHistory = *History[HistoryIndex];
+	HistoryIndex = 1 - HistoryIndex;
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *History[HistoryIndex], 0);
+	ResolveShader->Use();
+	ResolveShader->SetBool("historyValid", bHistoryValid);
+	ResolveShader->SetFloat("feedbackMin", FeedbackMin);
+	ResolveShader->SetFloat("feedbackMax", FeedbackMax);
+	ResolveShader->SetFloat("varianceGamma", VarianceGamma);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, color);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, PreviousHistory);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, velocity);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, position);
+	drawQuad();
+	bHistoryValid = true;
+
+	// sharpen and undo the history's tone map
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *Output, 0);
+	SharpenShader->Use();
+	SharpenShader->SetFloat("sharpness", Sharpness);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, *History[HistoryIndex]);
+	drawQuad();
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+	return *Output;
+}
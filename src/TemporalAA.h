@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+class RenderTargetManager;
+
+// temporal anti-aliasing for the deferred pipeline, where MSAA would multiply every G-buffer target. The camera
+// jitters its projection by a sub-pixel offset every frame (Camera::UpdateJitter) and this blends each frame into a
+// history reprojected with the G-buffer motion vectors, so edges converge to a supersampled average over
+// JITTER_PHASES frames at the cost of one extra full screen target. History that no longer matches the current
+// neighbourhood is clipped to its colour range (disocclusion, lighting changes), then a sharpening pass counters the
+// blur of resampling the history. GPU time is reported under the "TAA" profiler marker.
+class TemporalAA
+{
+public:
+
+    TemporalAA() = default;
+    ~TemporalAA();
+
+    TemporalAA(const TemporalAA&) = delete;
+    TemporalAA& operator=(const TemporalAA&) = delete;
+
+    // the history and output are targets of targets at the output size, they follow its resizes (dropping the
+    // history) and stay owned by it
+    bool Init(RenderTargetManager& targets);
+    void Shutdown();
+
+    // drops the history, the next Resolve outputs the current frame as is (camera cuts, resizes, TAA toggled on)
+    void Reset() { bHistoryValid = false; }
+
+    // blends color (HDR) into the history and returns the sharpened result, valid until the next Resolve. velocity is
+    // the G-buffer motion target (RG, in texture coordinates), position the view space positions (closest surface
+    // search). drawQuad draws a full screen quad (renderQuad). Leaves the framebuffer and viewport as they were.
+    GLuint Resolve(GLuint color, GLuint velocity, GLuint position, void (*drawQuad)());
+
+    // history weight between moving fast and standing still
+    float FeedbackMin = 0.8f;
+    float FeedbackMax = 0.94f;
+    // clamp box half size in standard deviations of the current 3x3 neighbourhood
+    float VarianceGamma = 1.25f;
+    // unsharp mask strength of the output pass, 0 only converts the history back to linear HDR
+    float Sharpness = 0.15f;
+
+private:
+
+    const RenderTargetManager* Targets = nullptr;
+    int Width = 0;                  // of the history, a different output size drops it
+    int Height = 0;
+    GLuint Framebuffer = 0;
+    // texture names of the targets, they change on resizes. Ping-pong, the one written last frame is read.
+    // Reversibly tone mapped (TAA.frag)
+    const GLuint* History[2] = { nullptr, nullptr };
+    const GLuint* Output = nullptr; // sharpened linear HDR, kept out of the history so sharpening doesn't accumulate
+    int HistoryIndex = 0;
+    bool bHistoryValid = false;
+    std::unique_ptr<Shader> ResolveShader;
+    std::unique_ptr<Shader> SharpenShader;
+};
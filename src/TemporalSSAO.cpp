@@ -0,0 +1,175 @@
+#include "TemporalSSAO.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.h"
+#include "RenderTargetManager.h"
+
+namespace
+{
+	// successive noise rotations stay evenly spread however many frames are averaged
+	const float GoldenAngle = 2.39996323f;
+
+	void DeleteProgram(std::unique_ptr<Shader>& Program)
+	{
+		if (Program)
+		{
+			glDeleteProgram(Program->ID);
+			Program.reset();
+		}
+	}
+}
+
+std::vector<glm::vec3> BuildSSAOKernel(std::default_random_engine& generator)
+{
+	std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
+	std::vector<glm::vec3> Kernel;
+	for (int i = 0; i < TemporalSSAO::KernelSize; ++i)
+	{
+		glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
+		sample = glm::normalize(sample);
+		sample *= randomFloats(generator);
+		float scale = float(i) / float(TemporalSSAO::KernelSize);
+
+		// scale samples s.t. they're more aligned to center of kernel
+		scale = 0.1f + scale * scale * (1.0f - 0.1f);
+		sample *= scale;
+		Kernel.push_back(sample);
+	}
+	return Kernel;
+}
+
+std::vector<glm::vec3> BuildSSAONoise(std::default_random_engine& generator)
+{
+	std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
+	std::vector<glm::vec3> Noise;
+	for (unsigned int i = 0; i < 16; i++)
+	{
+		glm::vec3 noise(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f); // rotate around z-axis (in tangent space)
+		Noise.push_back(noise);
+	}
+	return Noise;
+}
+
+TemporalSSAO::~TemporalSSAO()
+{
+	Shutdown();
+}
+
+bool TemporalSSAO::Init(RenderTargetManager& targets)
+{
+	Shutdown();
+	Targets = &targets;
+	Width = targets.GetRenderWidth();
+	Height = targets.GetRenderHeight();
+	glGenFramebuffers(1, &Framebuffer);
+	// linear, the history is fetched at reprojected sub-pixel positions
+	const RenderTargetDesc HistoryTarget = { GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_LINEAR, GL_CLAMP_TO_EDGE };
+	History[0] = &targets.Create(HistoryTarget, TARGET_RENDER_SIZE);
+	History[1] = &targets.Create(HistoryTarget, TARGET_RENDER_SIZE);
+
+	AccumulateShader.reset(new Shader("Shaders/SSAO.vert", "Shaders/SSAO_Temporal.frag"));
+	AccumulateShader->Use();
+	AccumulateShader->SetInt("ssaoInput", 0);
+	AccumulateShader->SetInt("history", 1);
+	AccumulateShader->SetInt("velocityBuffer", 2);
+	AccumulateShader->SetInt("gPosition", 3);
+	bHistoryValid = false;
+	FrameIndex = 0;
+	return true;
+}
+
+void TemporalSSAO::Shutdown()
+{
+	DeleteProgram(AccumulateShader);
+	// the textures belong to the target manager
+	History[0] = nullptr;
+	History[1] = nullptr;
+	Targets = nullptr;
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		Framebuffer = 0;
+	}
+	bHistoryValid = false;
+}
+
+int TemporalSSAO::GetStride() const
+{
+	if (Mode == SSAO_FULL_KERNEL)
+	{
+		return 1;
+	}
+	// the divisors of 64 are its powers of two, so every phase indexes inside the kernel and together they cover it
+	int Stride = 1;
+	while (KernelSize / Stride > std::max(SamplesPerFrame, 1))
+	{
+		Stride *= 2;
+	}
+	return Stride;
+}
+
+int TemporalSSAO::GetSamplesPerFrame() const
+{
+	return KernelSize / GetStride();
+}
+
+void TemporalSSAO::SetKernelUniforms(const Shader& ssaoShader) const
+{
+	const int Stride = GetStride();
+	const bool bTemporal = Mode == SSAO_TEMPORAL;
+	ssaoShader.SetInt("kernelSize", KernelSize / Stride);
+	ssaoShader.SetInt("kernelStride", Stride);
+	ssaoShader.SetInt("kernelPhase", bTemporal ? static_cast<int>(FrameIndex % Stride) : 0);
+	ssaoShader.SetFloat("noiseAngle", bTemporal ? std::fmod(FrameIndex * GoldenAngle, 6.28318531f) : 0.0f);
+}
+
+GLuint TemporalSSAO::Accumulate(GLuint occlusion, GLuint velocity, GLuint position, const glm::mat4& currentToPreviousView, void (*drawQuad)())
+{
+	if (Mode != SSAO_TEMPORAL || !Framebuffer)
+	{
+		bHistoryValid = false;
+		return occlusion;
+	}
+
+	GENIX_PROFILE_GPU("SSAO Accumulate");
+	if (Targets->GetRenderWidth() != Width || Targets->GetRenderHeight() != Height)
+	{
+		Width = Targets->GetRenderWidth();
+		Height = Targets->GetRenderHeight();
+		bHistoryValid = false;
+	}
+	GLint PreviousViewport[4];
+	GLint PreviousFramebuffer = 0;
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glViewport(0, 0, Width, Height);
+
+	const GLuint PreviousHistory = *History[HistoryIndex];
+	HistoryIndex = 1 - HistoryIndex;
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *History[HistoryIndex], 0);
+	AccumulateShader->Use();
+	glm::mat4 CurrentToPreviousView = currentToPreviousView;
+	AccumulateShader->SetMat4("currentToPreviousView", CurrentToPreviousView);
+	AccumulateShader->SetBool("historyValid", bHistoryValid);
+	AccumulateShader->SetFloat("maxHistoryFrames", std::max(MaxHistoryFrames, 1.0f));
+	AccumulateShader->SetFloat("depthTolerance", DepthTolerance);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, occlusion);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, PreviousHistory);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, velocity);
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, position);
+	drawQuad();
+	bHistoryValid = true;
+	FrameIndex++;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+	return *History[HistoryIndex];
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+class RenderTargetManager;
+
+enum SSAOMode
+{
+    SSAO_FULL_KERNEL,   // all 64 kernel samples every frame
+    SSAO_TEMPORAL       // an interleaved subset of the kernel per frame, averaged over the last frames
+};
+
+// the hemisphere kernel of SSAO.frag, samples[64]: random directions, scaled to cluster near the origin
+std::vector<glm::vec3> BuildSSAOKernel(std::default_random_engine& generator);
+// the 4x4 tile of random rotations around the normal (texNoise)
+std::vector<glm::vec3> BuildSSAONoise(std::default_random_engine& generator);
+
+// temporal accumulation of SSAO. Each frame samples every Stride'th kernel sample starting at a rotating phase, with
+// the noise rotated by the golden angle, and SSAO_Temporal.frag blends the result into a history reprojected with the
+// G-buffer motion vectors. After Stride frames every pixel has seen the whole kernel, at SamplesPerFrame samples of
+// cost per frame. History whose depth doesn't match where the surface was last frame (disocclusion, moving objects)
+// is dropped, those pixels fall back to the noisier single frame until they accumulate again.
+// GPU time of the blend is reported under the "SSAO Accumulate" profiler marker.
+class TemporalSSAO
+{
+public:
+
+    static constexpr int KernelSize = 64;
+
+    TemporalSSAO() = default;
+    ~TemporalSSAO();
+
+    TemporalSSAO(const TemporalSSAO&) = delete;
+    TemporalSSAO& operator=(const TemporalSSAO&) = delete;
+
+    // the history is a pair of targets of targets at the render size, they follow its resizes (dropping the history)
+    // and stay owned by it
+    bool Init(RenderTargetManager& targets);
+    void Shutdown();
+
+    // drops the history (camera cuts, resizes, mode switches)
+    void Reset() { bHistoryValid = false; }
+
+    // kernelSize, kernelStride, kernelPhase and noiseAngle of SSAO.frag for this frame and Mode
+    void SetKernelUniforms(const Shader& ssaoShader) const;
+
+    // kernel samples evaluated per frame: KernelSize, or SamplesPerFrame rounded down to a divisor of it
+    int GetSamplesPerFrame() const;
+
+    // in temporal mode blends occlusion (the SSAO pass output) into the history and returns it, occlusion in red, valid
+    // until the next Accumulate. velocity is the G-buffer motion target, position the view space positions and
+    // currentToPreviousView maps this frame's view space to the last one's. In full kernel mode returns occlusion.
+    // Leaves the framebuffer and viewport as they were.
+    GLuint Accumulate(GLuint occlusion, GLuint velocity, GLuint position, const glm::mat4& currentToPreviousView, void (*drawQuad)());
+
+    SSAOMode Mode = SSAO_TEMPORAL;
+    int SamplesPerFrame = 16;
+    // the running average turns into an exponential one after this many frames, so stale history fades out. Longer
+    // histories also pile up the blur of resampling them under motion
+    float MaxHistoryFrames = 8.0f;
+    // history depth mismatch, relative to the depth, at which a pixel counts as disoccluded
+    float DepthTolerance = 0.05f;
+
+private:
+
+    int GetStride() const;
+
+    const RenderTargetManager* Targets = nullptr;
+    int Width = 0;                  // of the history, a different render size drops it
+    int Height = 0;
+    GLuint Framebuffer = 0;
+    // texture names of the targets, they change on resizes. RGBA16F: occlusion, view depth, frames accumulated
+    const GLuint* History[2] = { nullptr, nullptr };
+    int HistoryIndex = 0;
+    bool bHistoryValid = false;
+    unsigned int FrameIndex = 0;
+    std::unique_ptr<Shader> AccumulateShader;
+};
@@ -0,0 +1,164 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+#include "CompressedTexture.h"
+#include "Model.h"
+#include "TextureStreamer.h"
+#include "TextureUploader.h"
+
+TextureCache& TextureCache::Get()
+{
+	static TextureCache Instance;
+	return Instance;
+}
+
+unsigned int TextureCache::Acquire(const std::string& path, bool gamma, GLint wrap, bool normalMap)
+{
+	const std::string Canonical = CanonicalPath(path);
+	const std::string Key = Canonical + '|' + (gamma ? '1' : '0') + '|' + std::to_string(wrap) + '|' + (normalMap ? 'n' : 'c');
+
+	auto It = Entries.find(Key);
+	if (It != Entries.end())
+	{
+		It->second.RefCount++;
+		CacheStats.ReferenceCount++;
+		CacheStats.Hits++;
+		return It->second.ID;
+	}
+
+	// not resident yet, load it from disk
+	const size_t Slash = Canonical.find_last_of('/');
+	const std::string Directory = Slash == std::string::npos ? "." : Canonical.substr(0, Slash);
+	const std::string Filename = Slash == std::string::npos ? Canonical : Canonical.substr(Slash + 1);
+
+	Entry NewEntry;
+	DecodedTexture Decoded;
+	if (Streamer && DecodeTextureFile(Canonical, gamma, Decoded))
+	{
+		for (const MipLevel& Level : Decoded.Levels)
+		{
+			// drivers pad RGB to 4 bytes per texel, same as the streamer's accounting
+			NewEntry.Bytes += static_cast<size_t>(Level.Width) * Level.Height * (Decoded.Components == 3 ? 4 : Decoded.Components);
+		}
+		NewEntry.StreamingHandle = Streamer->Register(std::move(Decoded.Levels), Decoded.InternalFormat, Decoded.Format, Decoded.Components);
+		NewEntry.ID = Streamer->GetTexture(NewEntry.StreamingHandle);
+		glBindTexture(GL_TEXTURE_2D, NewEntry.ID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	}
+	if (NewEntry.ID == 0 && bCompressionEnabled && !Streamer)
+	{
+		NewEntry.ID = CompressedTextureFromFile(Canonical, gamma, normalMap, wrap, &NewEntry.Bytes);
+		NewEntry.bCompressed = NewEntry.ID != 0;
+	}
+	if (NewEntry.ID == 0)
+	{
+		NewEntry.ID = TextureFromFile(Filename.c_str(), Directory, gamma, wrap, &NewEntry.Bytes);
+	}
+	NewEntry.RefCount = 1;
+
+	Entries.emplace(Key, NewEntry);
+	KeysById.emplace(NewEntry.ID, Key);
+
+	CacheStats.TextureCount++;
+	CacheStats.ReferenceCount++;
+	CacheStats.GpuBytes += NewEntry.Bytes;
+	CacheStats.CompressedCount += NewEntry.bCompressed ? 1 : 0;
+	CacheStats.StreamedCount += NewEntry.StreamingHandle >= 0 ? 1 : 0;
+	CacheStats.Misses++;
+	return NewEntry.ID;
+}
+
+void TextureCache::Release(unsigned int id)
+{
+	auto KeyIt = KeysById.find(id);
+	if (KeyIt == KeysById.end())
+	{
+		return;
+	}
+	auto It = Entries.find(KeyIt->second);
+
+	CacheStats.ReferenceCount--;
+	if (--It->second.RefCount > 0)
+	{
+		return;
+	}
+
+	// last reference gone, free the video memory
+	if (It->second.StreamingHandle >= 0)
+	{
+		Streamer->Unregister(It->second.StreamingHandle);
+	}
+	else
+	{
+		TextureUploader::Get().CancelTexture(It->second.ID);
+		glDeleteTextures(1, &It->second.ID);
+	}
+	CacheStats.TextureCount--;
+	CacheStats.GpuBytes -= It->second.Bytes;
+	CacheStats.CompressedCount -= It->second.bCompressed ? 1 : 0;
+	CacheStats.StreamedCount -= It->second.StreamingHandle >= 0 ? 1 : 0;
+	Entries.erase(It);
+	KeysById.erase(KeyIt);
+}
+
+int TextureCache::GetStreamingHandle(unsigned int id) const
+{
+	auto KeyIt = KeysById.find(id);
+	return KeyIt != KeysById.end() ? Entries.at(KeyIt->second).StreamingHandle : -1;
+}
+
+std::string TextureCache::CanonicalPath(const std::string& path)
+{
+	std::string Path = path;
+	std::replace(Path.begin(), Path.end(), '\\', '/');
+#ifdef _WIN32
+	// NTFS is case insensitive, "Rock.png" and "rock.png" are the same file
+	std::transform(Path.begin(), Path.end(), Path.begin(), [](unsigned char C) { return static_cast<char>(std::tolower(C)); });
+#endif
+
+	const bool bAbsolute = !Path.empty() && Path[0] == '/';
+
+	// split into components and fold "." and ".."
+	std::vector<std::string> Parts;
+	size_t Begin = 0;
+	while (Begin <= Path.size())
+	{
+		size_t End = Path.find('/', Begin);
+		if (End == std::string::npos)
+		{
+			End = Path.size();
+		}
+		const std::string Part = Path.substr(Begin, End - Begin);
+		if (Part == "..")
+		{
+			if (!Parts.empty() && Parts.back() != "..")
+			{
+				Parts.pop_back();
+			}
+			else if (!bAbsolute)
+			{
+				Parts.push_back(Part);
+			}
+		}
+		else if (!Part.empty() && Part != ".")
+		{
+			Parts.push_back(Part);
+		}
+		Begin = End + 1;
+	}
+
+	std::string Result = bAbsolute ? "/" : "";
+	for (size_t i = 0; i < Parts.size(); i++)
+	{
+		if (i > 0)
+		{
+			Result += '/';
+		}
+		Result += Parts[i];
+	}
+	return Result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+
+class TextureStreamer;
+
+// process-wide, reference counted cache of 2D textures loaded from disk.
+// textures are keyed by their canonical path and the load parameters, so every Model asking for the same file
+// with the same settings shares one GL texture. The GL texture is deleted when the last reference is released.
+// all functions need the GL context and must be called from the render thread.
+class TextureCache
+{
+public:
+
+    struct Stats
+    {
+        size_t TextureCount = 0;    // textures currently resident
+        size_t ReferenceCount = 0;  // outstanding references over all textures
+        size_t GpuBytes = 0;        // estimated video memory of all resident textures (mip chain included)
+        size_t CompressedCount = 0; // resident textures using a block compressed format
+        size_t StreamedCount = 0;   // resident textures whose mip levels are managed by the TextureStreamer
+        size_t Hits = 0;            // Acquire calls served from the cache
+        size_t Misses = 0;          // Acquire calls that had to load from disk
+    };
+
+    static TextureCache& Get();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // returns the texture for the file, loading it the first time. Every call adds a reference that has to be given back with Release.
+    // normalMap picks the two channel compressed format when compression is on.
+    unsigned int Acquire(const std::string& path, bool gamma = false, GLint wrap = GL_REPEAT, bool normalMap = false);
+
+    // gives back one reference, the texture is deleted once nobody holds it anymore
+    void Release(unsigned int id);
+
+    const Stats& GetStats() const { return CacheStats; }
+
+    // load new textures through the block compressed KTX2 path (see CompressedTexture.h), falling back to raw RGBA if that fails. On by default.
+    void SetCompressionEnabled(bool bEnabled) { bCompressionEnabled = bEnabled; }
+    bool IsCompressionEnabled() const { return bCompressionEnabled; }
+
+    // textures loaded from now on are registered with the streamer, which keeps only the mip levels their draws ask for
+    // resident (see TextureStreamer.h). The streamer holds uncompressed levels, so streamed loads skip the compressed path.
+    // The streamer has to outlive every texture it got, nullptr turns streaming off again for later loads.
+    void SetStreamer(TextureStreamer* streamer) { Streamer = streamer; }
+
+    // the streamer handle of a texture from Acquire, -1 if it isn't streamed
+    int GetStreamingHandle(unsigned int id) const;
+
+    // lexically normalized path ('\' -> '/', "." and ".." folded, lower case on Windows) used as the cache key
+    static std::string CanonicalPath(const std::string& path);
+
+private:
+
+    TextureCache() = default;
+
+    struct Entry
+    {
+        unsigned int ID = 0;
+        unsigned int RefCount = 0;
+        size_t Bytes = 0;
+        bool bCompressed = false;
+        int StreamingHandle = -1;
+    };
+
+    // key (canonical path + load parameters) -> texture
+    std::unordered_map<std::string, Entry> Entries;
+    // texture id -> key, so Release doesn't need the path
+    std::unordered_map<unsigned int, std::string> KeysById;
+
+    Stats CacheStats;
+    bool bCompressionEnabled = true;
+    TextureStreamer* Streamer = nullptr;
+};
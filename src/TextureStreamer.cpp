@@ -0,0 +1,294 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+GLuint GLTextureStreamingBackend::CreateTexture(int levelCount)
+{
+	GLuint Texture;
+	glGenTextures(1, &Texture);
+	glBindTexture(GL_TEXTURE_2D, Texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return Texture;
+}
+
+void GLTextureStreamingBackend::DeleteTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+}
+
+void GLTextureStreamingBackend::UploadLevel(GLuint texture, int level, GLint internalFormat, GLenum format, const MipLevel& data)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, level, internalFormat, data.Width, data.Height, 0, format, GL_UNSIGNED_BYTE, data.Data.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void GLTextureStreamingBackend::ReleaseLevel(GLuint texture, int level, GLint internalFormat, GLenum format)
+{
+	// levels below GL_TEXTURE_BASE_LEVEL don't take part in completeness, an empty image frees the old storage
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, level, internalFormat, 0, 0, 0, format, GL_UNSIGNED_BYTE, nullptr);
+}
+
+void GLTextureStreamingBackend::SetBaseLevel(GLuint texture, int level)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+TextureStreamer::TextureStreamer(TextureStreamingBackend& backend, size_t budgetBytes)
+	: Backend(backend), Budget(budgetBytes)
+{
+	StreamerStats.BudgetBytes = budgetBytes;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	for (StreamedTexture& Texture : Textures)
+	{
+		if (Texture.bInUse)
+		{
+			Backend.DeleteTexture(Texture.Texture);
+		}
+	}
+}
+
+int TextureStreamer::Register(std::vector<MipLevel> levels, GLint internalFormat, GLenum format, int components)
+{
+	if (levels.empty())
+	{
+		return -1;
+	}
+
+	int Handle;
+	if (!FreeHandles.empty())
+	{
+		Handle = FreeHandles.back();
+		FreeHandles.pop_back();
+	}
+	else
+	{
+		Handle = static_cast<int>(Textures.size());
+		Textures.emplace_back();
+	}
+
+	StreamedTexture& Texture = Textures[Handle];
+	Texture.bInUse = true;
+	Texture.InternalFormat = internalFormat;
+	Texture.Format = format;
+	Texture.Components = components;
+	Texture.Levels = std::move(levels);
+	Texture.LastRequestFrame = 0;
+
+	const int LevelCount = static_cast<int>(Texture.Levels.size());
+	Texture.TailLevel = LevelCount - 1;
+	for (int Level = 0; Level < LevelCount; Level++)
+	{
+		if (std::max(Texture.Levels[Level].Width, Texture.Levels[Level].Height) <= TailSize)
+		{
+			Texture.TailLevel = Level;
+			break;
+		}
+	}
+
+	// the tail is small and always there, so the texture can be sampled from the first frame on
+	Texture.Texture = Backend.CreateTexture(LevelCount);
+	for (int Level = LevelCount - 1; Level >= Texture.TailLevel; Level--)
+	{
+		Backend.UploadLevel(Texture.Texture, Level, internalFormat, format, Texture.Levels[Level]);
+		StreamerStats.ResidentBytes += GetLevelBytes(Texture, Level);
+	}
+	Backend.SetBaseLevel(Texture.Texture, Texture.TailLevel);
+	Texture.ResidentLevel = Texture.TailLevel;
+	Texture.RequestedLevel = Texture.TailLevel;
+
+	StreamerStats.TextureCount++;
+	return Handle;
+}
+
+void TextureStreamer::Unregister(int handle)
+{
+	if (handle < 0 || handle >= static_cast<int>(Textures.size()) || !Textures[handle].bInUse)
+	{
+		return;
+	}
+	StreamedTexture& Texture = Textures[handle];
+	for (int Level = Texture.ResidentLevel; Level < static_cast<int>(Texture.Levels.size()); Level++)
+	{
+		StreamerStats.ResidentBytes -= GetLevelBytes(Texture, Level);
+	}
+	Backend.DeleteTexture(Texture.Texture);
+	Texture = StreamedTexture();
+	FreeHandles.push_back(handle);
+	StreamerStats.TextureCount--;
+}
+
+GLuint TextureStreamer::GetTexture(int handle) const
+{
+	return handle >= 0 && handle < static_cast<int>(Textures.size()) ? Textures[handle].Texture : 0;
+}
+
+int TextureStreamer::GetResidentLevel(int handle) const
+{
+	return handle >= 0 && handle < static_cast<int>(Textures.size()) ? Textures[handle].ResidentLevel : -1;
+}
+
+void TextureStreamer::RequestLevel(int handle, int level)
+{
+	if (handle < 0 || handle >= static_cast<int>(Textures.size()) || !Textures[handle].bInUse)
+	{
+		return;
+	}
+	StreamedTexture& Texture = Textures[handle];
+	level = std::max(0, std::min(level, Texture.TailLevel));
+	if (Texture.LastRequestFrame != Frame)
+	{
+		Texture.LastRequestFrame = Frame;
+		Texture.RequestedLevel = level;
+	}
+	else
+	{
+		Texture.RequestedLevel = std::min(Texture.RequestedLevel, level);
+	}
+}
+
+void TextureStreamer::RequestByDistance(int handle, float distance, float worldSize, float fovY, int viewportHeight)
+{
+	if (handle < 0 || handle >= static_cast<int>(Textures.size()) || !Textures[handle].bInUse)
+	{
+		return;
+	}
+	if (distance <= 0.0f)
+	{
+		RequestLevel(handle, 0);
+		return;
+	}
+
+	// pixels the object covers on screen against texels the full size level has across it
+	const float ScreenPixels = worldSize / (2.0f * distance * std::tan(fovY * 0.5f)) * viewportHeight;
+	const MipLevel& Top = Textures[handle].Levels[0];
+	const float Texels = static_cast<float>(std::max(Top.Width, Top.Height));
+	const int Level = ScreenPixels > 0.0f ? static_cast<int>(std::floor(std::log2(std::max(1.0f, Texels / ScreenPixels)))) : Textures[handle].TailLevel;
+	RequestLevel(handle, Level);
+}
+
+void TextureStreamer::Update()
+{
+	StreamerStats.UploadsLastUpdate = 0;
+	StreamerStats.EvictionsLastUpdate = 0;
+	StreamerStats.BudgetBytes = Budget;
+
+	// textures asked for this frame that are missing levels, furthest behind first
+	std::vector<int> Candidates;
+	StreamerStats.WantedBytes = 0;
+	for (int Handle = 0; Handle < static_cast<int>(Textures.size()); Handle++)
+	{
+		StreamedTexture& Texture = Textures[Handle];
+		if (!Texture.bInUse)
+		{
+			continue;
+		}
+		if (Texture.LastRequestFrame != Frame)
+		{
+			Texture.RequestedLevel = Texture.TailLevel;
+		}
+		for (int Level = Texture.RequestedLevel; Level < static_cast<int>(Texture.Levels.size()); Level++)
+		{
+			StreamerStats.WantedBytes += GetLevelBytes(Texture, Level);
+		}
+		if (Texture.RequestedLevel < Texture.ResidentLevel)
+		{
+			Candidates.push_back(Handle);
+		}
+	}
+	std::sort(Candidates.begin(), Candidates.end(), [this](int A, int B)
+	{
+		return Textures[A].ResidentLevel - Textures[A].RequestedLevel > Textures[B].ResidentLevel - Textures[B].RequestedLevel;
+	});
+
+	// one level per texture and Update, coarse to fine, so everything on screen sharpens evenly
+	for (int Handle : Candidates)
+	{
+		if (static_cast<int>(StreamerStats.UploadsLastUpdate) >= MaxUploadsPerUpdate)
+		{
+			break;
+		}
+		StreamedTexture& Texture = Textures[Handle];
+		const int Level = Texture.ResidentLevel - 1;
+		const size_t Bytes = GetLevelBytes(Texture, Level);
+		while (StreamerStats.ResidentBytes + Bytes > Budget && EvictOne(Handle))
+		{
+		}
+		if (StreamerStats.ResidentBytes + Bytes > Budget)
+		{
+			continue;
+		}
+
+		Backend.UploadLevel(Texture.Texture, Level, Texture.InternalFormat, Texture.Format, Texture.Levels[Level]);
+		Backend.SetBaseLevel(Texture.Texture, Level);
+		Texture.ResidentLevel = Level;
+		StreamerStats.ResidentBytes += Bytes;
+		StreamerStats.UploadsLastUpdate++;
+		StreamerStats.LevelsUploaded++;
+	}
+
+	// the budget may have been lowered since the last Update
+	while (StreamerStats.ResidentBytes > Budget && EvictOne(-1))
+	{
+	}
+
+	Frame++;
+}
+
+size_t TextureStreamer::GetLevelBytes(const StreamedTexture& Texture, int Level) const
+{
+	// drivers pad 3 component texels to 4
+	const size_t TexelBytes = Texture.Components == 3 ? 4 : static_cast<size_t>(Texture.Components);
+	return static_cast<size_t>(Texture.Levels[Level].Width) * Texture.Levels[Level].Height * TexelBytes;
+}
+
+bool TextureStreamer::EvictOne(int keepHandle)
+{
+	// least recently requested first, among those that have a level this frame can do without
+	int Victim = -1;
+	for (int Handle = 0; Handle < static_cast<int>(Textures.size()); Handle++)
+	{
+		const StreamedTexture& Texture = Textures[Handle];
+		if (!Texture.bInUse || Handle == keepHandle || Texture.ResidentLevel >= Texture.TailLevel)
+		{
+			continue;
+		}
+		const bool bNeeded = Texture.LastRequestFrame == Frame && Texture.ResidentLevel >= Texture.RequestedLevel;
+		if (bNeeded)
+		{
+			continue;
+		}
+		if (Victim < 0 || Texture.LastRequestFrame < Textures[Victim].LastRequestFrame ||
+			(Texture.LastRequestFrame == Textures[Victim].LastRequestFrame && Texture.ResidentLevel < Textures[Victim].ResidentLevel))
+		{
+			Victim = Handle;
+		}
+	}
+	if (Victim < 0)
+	{
+		return false;
+	}
+
+	// stop sampling the level before its storage goes away
+	StreamedTexture& Texture = Textures[Victim];
+	const int Level = Texture.ResidentLevel;
+	Backend.SetBaseLevel(Texture.Texture, Level + 1);
+	Backend.ReleaseLevel(Texture.Texture, Level, Texture.InternalFormat, Texture.Format);
+	Texture.ResidentLevel = Level + 1;
+	StreamerStats.ResidentBytes -= GetLevelBytes(Texture, Level);
+	StreamerStats.EvictionsLastUpdate++;
+	StreamerStats.LevelsEvicted++;
+	return true;
+}
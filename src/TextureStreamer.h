@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+#include "MipmapBuilder.h"
+
+// the GPU side operations the streamer needs. The GL implementation is GLTextureStreamingBackend, tests (or tools
+// that run without a context) can plug in a fake one that only records what happened (see TextureStreamerTest.cpp).
+class TextureStreamingBackend
+{
+public:
+    virtual ~TextureStreamingBackend() = default;
+
+    // creates a texture with room for levelCount levels but no level storage yet
+    virtual GLuint CreateTexture(int levelCount) = 0;
+    virtual void DeleteTexture(GLuint texture) = 0;
+    // allocates and fills one level
+    virtual void UploadLevel(GLuint texture, int level, GLint internalFormat, GLenum format, const MipLevel& data) = 0;
+    // frees the storage of one level again
+    virtual void ReleaseLevel(GLuint texture, int level, GLint internalFormat, GLenum format) = 0;
+    // finest level the sampler may use
+    virtual void SetBaseLevel(GLuint texture, int level) = 0;
+};
+
+// talks to the current GL context. Freed levels are respecified as 0x0 images, which releases their memory.
+class GLTextureStreamingBackend : public TextureStreamingBackend
+{
+public:
+    GLuint CreateTexture(int levelCount) override;
+    void DeleteTexture(GLuint texture) override;
+    void UploadLevel(GLuint texture, int level, GLint internalFormat, GLenum format, const MipLevel& data) override;
+    void ReleaseLevel(GLuint texture, int level, GLint internalFormat, GLenum format) override;
+    void SetBaseLevel(GLuint texture, int level) override;
+};
+
+// keeps only the mip levels that are actually needed resident, within a video memory budget.
+// textures are registered with their full CPU mip chain. The small tail (levels of at most TailSize texels) is uploaded
+// right away, finer levels are streamed in one level per texture per Update, coarse to fine, once something asks for them
+// (screen space UV density feedback via RequestLevel, or RequestByDistance). GL_TEXTURE_BASE_LEVEL always points at the
+// finest resident level. When the budget is exceeded the finest levels of the least recently requested textures go first.
+class TextureStreamer
+{
+public:
+
+    struct Stats
+    {
+        size_t TextureCount = 0;
+        size_t ResidentBytes = 0;       // video memory of all resident levels
+        size_t WantedBytes = 0;         // what the resident bytes would be if every request were satisfied
+        size_t BudgetBytes = 0;
+        size_t LevelsUploaded = 0;      // total since creation
+        size_t LevelsEvicted = 0;       // total since creation
+        size_t UploadsLastUpdate = 0;
+        size_t EvictionsLastUpdate = 0;
+    };
+
+    TextureStreamer(TextureStreamingBackend& backend, size_t budgetBytes);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // takes over a mip chain (level 0 = full size) and returns a handle. The tail is uploaded immediately.
+    int Register(std::vector<MipLevel> levels, GLint internalFormat, GLenum format, int components);
+
+    // frees the texture and its CPU copy
+    void Unregister(int handle);
+
+    GLuint GetTexture(int handle) const;
+
+    // finest level currently resident
+    int GetResidentLevel(int handle) const;
+
+    // asks for a level for this frame (e.g. from a UV density feedback pass). Several requests keep the finest.
+    void RequestLevel(int handle, int level);
+
+    // derives the level from how big the texture appears on screen: an object of worldSize at distance seen
+    // with a vertical field of view fovY (radians) on a viewportHeight pixel tall viewport.
+    void RequestByDistance(int handle, float distance, float worldSize, float fovY, int viewportHeight);
+
+    // call once per frame: uploads/evicts levels to move toward the requested levels within the budget
+    void Update();
+
+    void SetBudget(size_t bytes) { Budget = bytes; }
+
+    const Stats& GetStats() const { return StreamerStats; }
+
+    // levels with at most this many texels along their larger side are always resident
+    int TailSize = 64;
+    // upper limit of level uploads per Update, spreads bursts over several frames
+    int MaxUploadsPerUpdate = 8;
+
+private:
+
+    struct StreamedTexture
+    {
+        bool bInUse = false;
+        GLuint Texture = 0;
+        GLint InternalFormat = 0;
+        GLenum Format = 0;
+        int Components = 0;
+        std::vector<MipLevel> Levels;
+        int TailLevel = 0;              // finest level of the always resident tail
+        int ResidentLevel = 0;          // finest resident level
+        int RequestedLevel = 0;         // finest level asked for this frame (TailLevel if none)
+        unsigned long long LastRequestFrame = 0;
+    };
+
+    size_t GetLevelBytes(const StreamedTexture& Texture, int Level) const;
+
+    // drops the finest level of the least recently used texture that isn't needed this frame, false if nothing can go
+    bool EvictOne(int keepHandle);
+
+    TextureStreamingBackend& Backend;
+    std::vector<StreamedTexture> Textures;
+    std::vector<int> FreeHandles;
+    size_t Budget;
+    unsigned long long Frame = 0;
+    Stats StreamerStats;
+};
@@ -0,0 +1,322 @@
+#include "TextureStreamerTest.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "TextureStreamer.h"
+
+namespace
+{
+	const int TextureSize = 256;
+	// frames a phase may take to settle, MaxUploadsPerUpdate spreads the uploads over several
+	const int MaxFrames = 64;
+
+	// mirrors what GL would hold, without a context
+	class FakeStreamingBackend : public TextureStreamingBackend
+	{
+	public:
+
+		struct Release
+		{
+			GLuint Texture;
+			int Level;
+		};
+
+		GLuint CreateTexture(int levelCount) override
+		{
+			FakeTexture& Texture = Textures[NextTexture];
+			Texture.BaseLevel = levelCount - 1;
+			Texture.Bytes.assign(levelCount, 0);
+			return NextTexture++;
+		}
+
+		void DeleteTexture(GLuint texture) override
+		{
+			if (Textures.erase(texture) == 0)
+			{
+				Fail("deleted unknown texture", texture, 0);
+			}
+		}
+
+		void UploadLevel(GLuint texture, int level, GLint /*internalFormat*/, GLenum format, const MipLevel& data) override
+		{
+			FakeTexture* Texture = Find(texture, level);
+			if (!Texture)
+			{
+				return;
+			}
+			const int Components = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
+			if (data.Data.size() != static_cast<size_t>(data.Width) * data.Height * Components)
+			{
+				Fail("level data doesn't match its size and format", texture, level);
+			}
+			if (Texture->Bytes[level] != 0)
+			{
+				Fail("uploaded a level twice", texture, level);
+			}
+			// drivers pad 3 component texels to 4, same as the streamer's accounting
+			Texture->Bytes[level] = static_cast<size_t>(data.Width) * data.Height * (Components == 3 ? 4 : Components);
+		}
+
+		void ReleaseLevel(GLuint texture, int level, GLint /*internalFormat*/, GLenum /*format*/) override
+		{
+			FakeTexture* Texture = Find(texture, level);
+			if (!Texture)
+			{
+				return;
+			}
+			if (level >= Texture->BaseLevel)
+			{
+				Fail("freed a level the sampler can still reach", texture, level);
+			}
+			if (Texture->Bytes[level] == 0)
+			{
+				Fail("freed a level that wasn't resident", texture, level);
+			}
+			Texture->Bytes[level] = 0;
+			Releases.push_back({ texture, level });
+		}
+
+		void SetBaseLevel(GLuint texture, int level) override
+		{
+			FakeTexture* Texture = Find(texture, level);
+			if (!Texture)
+			{
+				return;
+			}
+			for (int Level = level; Level < static_cast<int>(Texture->Bytes.size()); Level++)
+			{
+				if (Texture->Bytes[Level] == 0)
+				{
+					Fail("base level makes a level without storage reachable", texture, Level);
+				}
+			}
+			Texture->BaseLevel = level;
+		}
+
+		int GetBaseLevel(GLuint texture) const
+		{
+			const std::map<GLuint, FakeTexture>::const_iterator It = Textures.find(texture);
+			return It != Textures.end() ? It->second.BaseLevel : -1;
+		}
+
+		size_t GetResidentBytes() const
+		{
+			size_t Bytes = 0;
+			for (const std::pair<const GLuint, FakeTexture>& Texture : Textures)
+			{
+				for (size_t LevelBytes : Texture.second.Bytes)
+				{
+					Bytes += LevelBytes;
+				}
+			}
+			return Bytes;
+		}
+
+		size_t GetTextureCount() const { return Textures.size(); }
+
+		std::vector<Release> Releases;
+		int Errors = 0;
+
+	private:
+
+		struct FakeTexture
+		{
+			int BaseLevel = 0;
+			std::vector<size_t> Bytes;      // 0 for levels without storage
+		};
+
+		FakeTexture* Find(GLuint texture, int level)
+		{
+			std::map<GLuint, FakeTexture>::iterator It = Textures.find(texture);
+			if (It == Textures.end() || level < 0 || level >= static_cast<int>(It->second.Bytes.size()))
+			{
+				Fail("unknown texture or level", texture, level);
+				return nullptr;
+			}
+			return &It->second;
+		}
+
+		void Fail(const char* what, GLuint texture, int level)
+		{
+			std::cout << "ERROR::STREAMER_TEST::" << what << " (texture " << texture << ", level " << level << ")" << std::endl;
+			Errors++;
+		}
+
+		std::map<GLuint, FakeTexture> Textures;
+		GLuint NextTexture = 1;
+	};
+
+	std::vector<MipLevel> CreateMipChain(int size, unsigned char value)
+	{
+		std::vector<MipLevel> Levels;
+		for (int Size = size; Size >= 1; Size /= 2)
+		{
+			MipLevel Level;
+			Level.Width = Size;
+			Level.Height = Size;
+			Level.Data.assign(static_cast<size_t>(Size) * Size * 4, value);
+			Levels.push_back(std::move(Level));
+		}
+		return Levels;
+	}
+
+	size_t GetChainBytes(int size, int firstLevel)
+	{
+		size_t Bytes = 0;
+		for (int Size = size >> firstLevel; Size >= 1; Size /= 2)
+		{
+			Bytes += static_cast<size_t>(Size) * Size * 4;
+		}
+		return Bytes;
+	}
+
+	class StreamerTest
+	{
+	public:
+
+		StreamerTest(TextureStreamer& streamer, FakeStreamingBackend& backend, const std::vector<int>& handles)
+			: Streamer(streamer), Backend(backend), Handles(handles)
+		{
+		}
+
+		// runs Updates with the same requests until nothing moves any more, checking the budget every frame
+		void Settle(const std::vector<int>& requested)
+		{
+			for (int Frame = 0; Frame < MaxFrames; Frame++)
+			{
+				for (int Handle : requested)
+				{
+					Streamer.RequestLevel(Handle, 0);
+				}
+				Streamer.Update();
+				const TextureStreamer::Stats& Stats = Streamer.GetStats();
+				Check(Stats.ResidentBytes <= Stats.BudgetBytes, "resident bytes over the budget");
+				Check(Stats.ResidentBytes == Backend.GetResidentBytes(), "resident bytes differ from the backend's");
+				if (Stats.UploadsLastUpdate == 0 && Stats.EvictionsLastUpdate == 0)
+				{
+					return;
+				}
+			}
+			Check(false, "requests didn't settle");
+		}
+
+		void ExpectLevel(int index, int level)
+		{
+			const int Handle = Handles[index];
+			if (Streamer.GetResidentLevel(Handle) != level || Backend.GetBaseLevel(Streamer.GetTexture(Handle)) != level)
+			{
+				std::cout << "ERROR::STREAMER_TEST::texture " << index << " is at level " << Streamer.GetResidentLevel(Handle)
+					<< " (base level " << Backend.GetBaseLevel(Streamer.GetTexture(Handle)) << "), expected " << level << std::endl;
+				bPassed = false;
+			}
+		}
+
+		void Check(bool bCondition, const char* what)
+		{
+			if (!bCondition)
+			{
+				std::cout << "ERROR::STREAMER_TEST::" << what << std::endl;
+				bPassed = false;
+			}
+		}
+
+		void Report(const char* phase)
+		{
+			const TextureStreamer::Stats& Stats = Streamer.GetStats();
+			std::cout << std::left << std::setw(12) << phase << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(9) << Stats.ResidentBytes / 1024.0 << " KB resident" << std::setw(5) << Stats.LevelsUploaded << " uploads"
+				<< std::setw(5) << Stats.LevelsEvicted << " evictions  " << (bPassed && Backend.Errors == 0 ? "ok" : "FAILED") << std::endl;
+		}
+
+		bool Passed() const { return bPassed && Backend.Errors == 0; }
+
+	private:
+		TextureStreamer& Streamer;
+		FakeStreamingBackend& Backend;
+		const std::vector<int>& Handles;
+		bool bPassed = true;
+	};
+}
+
+bool RunTextureStreamerTest(int textureCount)
+{
+	const int Count = std::max(textureCount, 4);
+	const int Half = Count / 2;
+
+	FakeStreamingBackend Backend;
+	// room for the tails of all textures and the two finest levels of half of them
+	const int TailLevel = 2;
+	const size_t TailBytes = GetChainBytes(TextureSize, TailLevel);
+	const size_t StreamedBytes = GetChainBytes(TextureSize, 0) - TailBytes;
+	const size_t Budget = Count * TailBytes + Half * StreamedBytes;
+	std::cout << "Texture streamer test, " << Count << " textures " << TextureSize << "x" << TextureSize << " RGBA, budget "
+		<< Budget / 1024 << " KB" << std::endl;
+
+	std::vector<int> Handles;
+	{
+		TextureStreamer Streamer(Backend, Budget);
+		StreamerTest Test(Streamer, Backend, Handles);
+		Test.Check(Streamer.TailSize == TextureSize >> TailLevel, "the test expects a 64 texel tail");
+
+		// only the tail is uploaded and sampled at first
+		for (int i = 0; i < Count; i++)
+		{
+			Handles.push_back(Streamer.Register(CreateMipChain(TextureSize, static_cast<unsigned char>(i)), GL_RGBA8, GL_RGBA, 4));
+			Test.ExpectLevel(i, TailLevel);
+		}
+		Test.Check(Streamer.GetStats().ResidentBytes == Count * TailBytes, "registering uploaded more than the tails");
+		Test.Check(Streamer.GetStats().ResidentBytes == Backend.GetResidentBytes(), "resident bytes differ from the backend's");
+		Test.Report("register");
+
+		// the first half fits the budget completely, the rest keeps its tail
+		std::vector<int> Requested(Handles.begin(), Handles.begin() + Half);
+		Test.Settle(Requested);
+		for (int i = 0; i < Count; i++)
+		{
+			Test.ExpectLevel(i, i < Half ? 0 : TailLevel);
+		}
+		Test.Check(Streamer.GetStats().LevelsEvicted == 0, "evicted although everything fit");
+		Test.Report("stream in");
+
+		// texture 0 is skipped for a frame, so it is the least recently requested once texture Half needs room
+		Requested.erase(Requested.begin());
+		Test.Settle(Requested);
+		Requested.push_back(Handles[Half]);
+		Test.Settle(Requested);
+		for (int i = 0; i < Count; i++)
+		{
+			Test.ExpectLevel(i, i == 0 || i > Half ? TailLevel : 0);
+		}
+		// texture Half needs levels 1 and 0, which takes both of texture 0's streamed levels
+		Test.Check(Backend.Releases.size() == 2, "evicted more levels than the new texture needed");
+		for (const FakeStreamingBackend::Release& Release : Backend.Releases)
+		{
+			Test.Check(Release.Texture == Streamer.GetTexture(Handles[0]), "evicted a texture other than the least recently requested");
+		}
+		Test.Report("evict LRU");
+
+		// a lower budget drops everything back to the tails, finest levels first
+		Streamer.SetBudget(Count * TailBytes);
+		Test.Settle(std::vector<int>());
+		for (int i = 0; i < Count; i++)
+		{
+			Test.ExpectLevel(i, TailLevel);
+		}
+		Test.Check(Streamer.GetStats().ResidentBytes == Count * TailBytes, "lowering the budget didn't drop back to the tails");
+		Test.Report("budget");
+
+		for (int Handle : Handles)
+		{
+			Streamer.Unregister(Handle);
+		}
+		Test.Check(Streamer.GetStats().ResidentBytes == 0 && Streamer.GetStats().TextureCount == 0, "unregistering left resident bytes");
+		Test.Check(Backend.GetTextureCount() == 0, "unregistering left textures behind");
+		Test.Report("unregister");
+
+		return Test.Passed();
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// drives a TextureStreamer over textureCount synthetic 256x256 textures with a backend that only records what it is
+// asked to do, and checks the tail upload on Register, coarse to fine streaming, least recently requested eviction under
+// the budget, lowering the budget and Unregister. The fake backend also checks that GL_TEXTURE_BASE_LEVEL never points at
+// a level without storage and that no level is freed while it can still be sampled. Needs no GL context.
+// Returns false if any check failed.
+bool RunTextureStreamerTest(int textureCount);
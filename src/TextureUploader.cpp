@@ -0,0 +1,236 @@
+#include "TextureUploader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	// lowest finished level of every 2D texture that is still streaming in, one past its smallest level while none is
+	std::unordered_map<GLuint, GLint> StreamingBaseLevels;
+}
+
+TextureUploader& TextureUploader::Get()
+{
+	static TextureUploader Instance;
+	return Instance;
+}
+
+void TextureUploader::Init(size_t slotBytes, unsigned int slotCount, size_t frameBudgetBytes)
+{
+	Shutdown();
+
+	SlotBytes = slotBytes;
+	FrameBudget = frameBudgetBytes;
+	Slots.resize(std::max(1u, slotCount));
+	for (Slot& Slot : Slots)
+	{
+		glGenBuffers(1, &Slot.Buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Slot.Buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(SlotBytes), nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	NextSlot = 0;
+	UploadStats = Stats();
+}
+
+void TextureUploader::Shutdown()
+{
+	for (Slot& Slot : Slots)
+	{
+		if (Slot.Fence)
+		{
+			glDeleteSync(Slot.Fence);
+		}
+		glDeleteBuffers(1, &Slot.Buffer);
+	}
+	Slots.clear();
+	Queue.clear();
+	StreamingBaseLevels.clear();
+}
+
+void TextureUploader::QueueLevel(GLuint texture, GLenum bindTarget, GLenum imageTarget, GLint level, GLsizei width, GLsizei height,
+	GLenum format, int components, std::vector<unsigned char> pixels)
+{
+	Request NewRequest;
+	NewRequest.Texture = texture;
+	NewRequest.BindTarget = bindTarget;
+	NewRequest.ImageTarget = imageTarget;
+	NewRequest.Level = level;
+	NewRequest.Width = width;
+	NewRequest.Height = height;
+	NewRequest.Format = format;
+	NewRequest.RowBytes = static_cast<size_t>(width) * components;
+	NewRequest.RowsDone = 0;
+	NewRequest.Pixels = std::move(pixels);
+
+	// the first level queued for a 2D texture is the smallest one (its GL_TEXTURE_MAX_LEVEL). A base level past it
+	// leaves the texture incomplete, so it samples as black instead of the undefined storage until a level is done.
+	if (bindTarget == GL_TEXTURE_2D && StreamingBaseLevels.find(texture) == StreamingBaseLevels.end())
+	{
+		StreamingBaseLevels[texture] = level + 1;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	}
+
+	UploadStats.PendingRequests++;
+	UploadStats.PendingBytes += NewRequest.Pixels.size();
+	Queue.push_back(std::move(NewRequest));
+}
+
+void TextureUploader::CancelTexture(GLuint texture)
+{
+	for (auto It = Queue.begin(); It != Queue.end();)
+	{
+		if (It->Texture == texture)
+		{
+			UploadStats.PendingRequests--;
+			UploadStats.PendingBytes -= (It->Height - It->RowsDone) * It->RowBytes;
+			It = Queue.erase(It);
+		}
+		else
+		{
+			++It;
+		}
+	}
+	StreamingBaseLevels.erase(texture);
+}
+
+void TextureUploader::Tick()
+{
+	const auto Start = std::chrono::steady_clock::now();
+
+	size_t Sent = 0;
+	while (IsEnabled() && !Queue.empty() && Sent < FrameBudget)
+	{
+		const size_t Bytes = UploadThroughSlot(FrameBudget - Sent, false);
+		if (Bytes == 0)
+		{
+			break;
+		}
+		Sent += Bytes;
+	}
+
+	UploadStats.BytesLastFrame = Sent;
+	UploadStats.LastTickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+	UploadStats.WorstTickMs = std::max(UploadStats.WorstTickMs, UploadStats.LastTickMs);
+	if (UploadStats.LastTickMs > SpikeThresholdMs)
+	{
+		UploadStats.TickSpikes++;
+	}
+}
+
+void TextureUploader::Flush()
+{
+	while (IsEnabled() && !Queue.empty())
+	{
+		if (UploadThroughSlot(SlotBytes, true) == 0)
+		{
+			break;
+		}
+	}
+}
+
+size_t TextureUploader::UploadThroughSlot(size_t maxBytes, bool bWait)
+{
+	Slot& Slot = Slots[NextSlot];
+	if (Slot.Fence)
+	{
+		// the GPU may still be reading the copies issued from this slot last time around
+		const GLenum Result = glClientWaitSync(Slot.Fence, bWait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, bWait ? 1000000000ull : 0);
+		if (Result == GL_TIMEOUT_EXPIRED)
+		{
+			UploadStats.SlotStalls++;
+			return 0;
+		}
+		glDeleteSync(Slot.Fence);
+		Slot.Fence = nullptr;
+	}
+
+	// plan which rows of which requests go into this slot
+	struct Piece
+	{
+		Request* Source;
+		GLsizei FirstRow;
+		GLsizei Rows;
+		size_t Offset;
+	};
+	std::vector<Piece> Pieces;
+	const size_t Capacity = std::min(SlotBytes, maxBytes);
+	size_t Used = 0;
+	for (Request& Request : Queue)
+	{
+		const GLsizei RowsLeft = Request.Height - Request.RowsDone;
+		const GLsizei RowsFitting = static_cast<GLsizei>(std::min<size_t>(RowsLeft, (Capacity - Used) / std::max<size_t>(Request.RowBytes, 1)));
+		if (RowsFitting == 0)
+		{
+			break;
+		}
+		Pieces.push_back({ &Request, Request.RowsDone, RowsFitting, Used });
+		Used += RowsFitting * Request.RowBytes;
+		if (RowsFitting < RowsLeft)
+		{
+			break;
+		}
+	}
+	if (Pieces.empty())
+	{
+		return 0;
+	}
+
+	// the fence guarantees the slot is idle, no need for the driver to synchronize the mapping
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Slot.Buffer);
+	unsigned char* Mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(Used),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if (!Mapped)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return 0;
+	}
+	for (const Piece& Piece : Pieces)
+	{
+		std::memcpy(Mapped + Piece.Offset, Piece.Source->Pixels.data() + Piece.FirstRow * Piece.Source->RowBytes, Piece.Rows * Piece.Source->RowBytes);
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	// the copies read from the bound PBO, the pointer argument is an offset into it
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (const Piece& Piece : Pieces)
+	{
+		Request& Source = *Piece.Source;
+		glBindTexture(Source.BindTarget, Source.Texture);
+		glTexSubImage2D(Source.ImageTarget, Source.Level, 0, Piece.FirstRow, Source.Width, Piece.Rows, Source.Format, GL_UNSIGNED_BYTE,
+			reinterpret_cast<const void*>(Piece.Offset));
+		Source.RowsDone += Piece.Rows;
+
+		if (Source.RowsDone == Source.Height && Source.BindTarget == GL_TEXTURE_2D)
+		{
+			// a finer level is complete, let the sampler use it (the first one makes the texture complete)
+			auto BaseLevel = StreamingBaseLevels.find(Source.Texture);
+			if (BaseLevel != StreamingBaseLevels.end() && Source.Level < BaseLevel->second)
+			{
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, Source.Level);
+				BaseLevel->second = Source.Level;
+			}
+			if (BaseLevel != StreamingBaseLevels.end() && Source.Level == 0)
+			{
+				StreamingBaseLevels.erase(BaseLevel);
+			}
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	Slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	NextSlot = (NextSlot + 1) % Slots.size();
+
+	while (!Queue.empty() && Queue.front().RowsDone == Queue.front().Height)
+	{
+		UploadStats.PendingRequests--;
+		Queue.pop_front();
+	}
+	UploadStats.PendingBytes -= Used;
+	UploadStats.UploadedBytes += Used;
+	return Used;
+}
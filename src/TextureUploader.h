@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <glad/glad.h>
+
+// streams texture data to the GPU through a ring of pixel buffer objects instead of blocking glTexImage2D calls.
+// texture storage is allocated up front by the caller, the pixels are copied into the next free PBO once per frame (Tick)
+// and glTexSubImage2D sources them from there. A fence per ring slot tells when a slot can be written again, and a per frame
+// byte budget keeps a burst of big textures from turning into a frame time spike.
+// must only be used from the thread owning the GL context.
+class TextureUploader
+{
+public:
+
+    struct Stats
+    {
+        size_t PendingRequests = 0;     // levels still waiting (completely or partially) in the queue
+        size_t PendingBytes = 0;        // bytes of those levels not uploaded yet
+        size_t UploadedBytes = 0;       // total bytes sent since Init
+        size_t BytesLastFrame = 0;      // bytes sent by the last Tick
+        size_t SlotStalls = 0;          // Ticks that stopped early because the next ring slot was still in flight
+        // CPU time the render thread spends in Tick (mapping, copying, issuing the copies). The GPU side of the copies
+        // isn't included, frame time hitches show in FramePacer's present intervals.
+        double LastTickMs = 0.0;        // last Tick
+        double WorstTickMs = 0.0;       // longest Tick so far
+        size_t TickSpikes = 0;          // Ticks whose CPU time exceeded SpikeThresholdMs
+    };
+
+    static TextureUploader& Get();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    // creates the PBO ring. Until this is called (or after Shutdown) IsEnabled is false and callers upload synchronously.
+    void Init(size_t slotBytes = 4 * 1024 * 1024, unsigned int slotCount = 3, size_t frameBudgetBytes = 8 * 1024 * 1024);
+
+    // drops whatever is still queued and deletes the PBOs and fences
+    void Shutdown();
+
+    bool IsEnabled() const { return !Slots.empty(); }
+
+    // queues a level of a texture whose storage already exists (glTexImage2D with null data). The pixels are taken over.
+    // bindTarget is what the texture is bound to (GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP), imageTarget the image to write
+    // (GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face). Rows have to be tightly packed.
+    // for 2D textures queued smallest level first, GL_TEXTURE_BASE_LEVEL follows the finished levels so the texture is
+    // sampled at the best resolution available while the rest streams in. Until the smallest level is done the texture
+    // is left incomplete (samples black).
+    void QueueLevel(GLuint texture, GLenum bindTarget, GLenum imageTarget, GLint level, GLsizei width, GLsizei height,
+        GLenum format, int components, std::vector<unsigned char> pixels);
+
+    // forgets the queued data of a texture that is about to be deleted
+    void CancelTexture(GLuint texture);
+
+    // call once per frame: fills free ring slots with queued data, at most the frame budget worth of bytes
+    void Tick();
+
+    // uploads everything still queued right away, e.g. before a loading screen goes away
+    void Flush();
+
+    void SetFrameBudget(size_t bytes) { FrameBudget = bytes; }
+
+    const Stats& GetStats() const { return UploadStats; }
+
+    // Ticks taking more CPU time than this are counted in TickSpikes
+    double SpikeThresholdMs = 2.0;
+
+private:
+
+    TextureUploader() = default;
+
+    struct Request
+    {
+        GLuint Texture;
+        GLenum BindTarget;
+        GLenum ImageTarget;
+        GLint Level;
+        GLsizei Width;
+        GLsizei Height;
+        GLenum Format;
+        size_t RowBytes;
+        GLsizei RowsDone;
+        std::vector<unsigned char> Pixels;
+    };
+
+    struct Slot
+    {
+        GLuint Buffer = 0;
+        GLsync Fence = nullptr;
+    };
+
+    // moves up to MaxBytes of queued rows through the next ring slot, returns the number of bytes sent
+    size_t UploadThroughSlot(size_t maxBytes, bool bWait);
+
+    std::vector<Slot> Slots;
+    unsigned int NextSlot = 0;
+    size_t SlotBytes = 0;
+    size_t FrameBudget = 0;
+    std::deque<Request> Queue;
+    Stats UploadStats;
+};
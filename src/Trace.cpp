@@ -0,0 +1,220 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// the calling thread's buffer, registered on its first event
+	thread_local void* CurrentThreadBuffer = nullptr;
+
+	// JSON string body, names are plain identifiers in practice but quotes and backslashes must not break the file
+	void WriteEscaped(std::ofstream& File, const char* Text)
+	{
+		for (const char* Char = Text; *Char; Char++)
+		{
+			if (*Char == '"' || *Char == '\\')
+			{
+				File << '\\';
+			}
+			File << *Char;
+		}
+	}
+}
+
+TraceRecorder& TraceRecorder::Get()
+{
+	static TraceRecorder Instance;
+	return Instance;
+}
+
+uint64_t TraceRecorder::Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::GetThreadBuffer()
+{
+	if (!CurrentThreadBuffer)
+	{
+		std::lock_guard<std::mutex> Lock(RegistryMutex);
+		std::unique_ptr<ThreadBuffer> Buffer(new ThreadBuffer());
+		Buffer->ThreadId = static_cast<unsigned int>(Buffers.size()) + 1;
+		CurrentThreadBuffer = Buffer.get();
+		Buffers.push_back(std::move(Buffer));
+	}
+	return *static_cast<ThreadBuffer*>(CurrentThreadBuffer);
+}
+
+void TraceRecorder::Push(ThreadBuffer& Buffer, const char* Name, char Phase, uint64_t TimeNs, double Value)
+{
+	// only the owning thread writes and WriteJSON only reads once the capture stopped, so no lock is needed for either
+	if (Buffer.Events.empty())
+	{
+		Buffer.Events.resize(EventsPerThread > 0 ? EventsPerThread : 1);
+	}
+	const size_t Head = Buffer.Head.load(std::memory_order_relaxed);
+	Buffer.Events[Head % Buffer.Events.size()] = { Name, TimeNs, Value, Phase };
+	Buffer.Head.store(Head + 1, std::memory_order_release);
+}
+
+void TraceRecorder::BeginZone(const char* name)
+{
+	if (IsCapturing())
+	{
+		Push(GetThreadBuffer(), name, 'B', Now(), 0.0);
+	}
+}
+
+void TraceRecorder::EndZone(const char* name)
+{
+	if (IsCapturing())
+	{
+		Push(GetThreadBuffer(), name, 'E', Now(), 0.0);
+	}
+}
+
+void TraceRecorder::Counter(const char* name, double value)
+{
+	if (IsCapturing())
+	{
+		Push(GetThreadBuffer(), name, 'C', Now(), value);
+	}
+}
+
+void TraceRecorder::GpuZone(const char* name, uint64_t beginNs, uint64_t endNs)
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+	if (!GpuBuffer)
+	{
+		std::lock_guard<std::mutex> Lock(RegistryMutex);
+		GpuBuffer.reset(new ThreadBuffer());
+		GpuBuffer->ThreadId = 0;
+		GpuBuffer->Name = "GPU";
+	}
+	Push(*GpuBuffer, name, 'B', beginNs, 0.0);
+	Push(*GpuBuffer, name, 'E', endNs, 0.0);
+}
+
+void TraceRecorder::SetThreadName(const char* name)
+{
+	ThreadBuffer& Buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> Lock(RegistryMutex);
+	Buffer.Name = name;
+}
+
+void TraceRecorder::StartCapture(const std::string& path, unsigned int frameCount)
+{
+	if (IsCapturing())
+	{
+		return;
+	}
+	{
+		// nobody records while no capture is running, so the heads can be reset safely
+		std::lock_guard<std::mutex> Lock(RegistryMutex);
+		for (std::unique_ptr<ThreadBuffer>& Buffer : Buffers)
+		{
+			Buffer->Head.store(0, std::memory_order_relaxed);
+		}
+		if (GpuBuffer)
+		{
+			GpuBuffer->Head.store(0, std::memory_order_relaxed);
+		}
+	}
+	CapturePath = path;
+	FramesLeft = frameCount;
+	bCapturing.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::MarkFrame()
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+	Push(GetThreadBuffer(), "Frame", 'i', Now(), 0.0);
+	if (FramesLeft > 0 && --FramesLeft == 0)
+	{
+		bCapturing.store(false, std::memory_order_release);
+		if (WriteJSON(CapturePath))
+		{
+			std::cout << "Trace written: " << CapturePath << std::endl;
+		}
+	}
+}
+
+bool TraceRecorder::WriteJSON(const std::string& Path)
+{
+	std::ofstream File(Path);
+	if (!File)
+	{
+		std::cout << "Failed to write trace: " << Path << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> Lock(RegistryMutex);
+	std::vector<ThreadBuffer*> All;
+	if (GpuBuffer)
+	{
+		All.push_back(GpuBuffer.get());
+	}
+	for (std::unique_ptr<ThreadBuffer>& Buffer : Buffers)
+	{
+		All.push_back(Buffer.get());
+	}
+
+	File << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool bFirst = true;
+	auto Separator = [&]()
+	{
+		if (!bFirst)
+		{
+			File << ",\n";
+		}
+		bFirst = false;
+	};
+
+	File.precision(15);
+	for (ThreadBuffer* Buffer : All)
+	{
+		if (!Buffer->Name.empty())
+		{
+			Separator();
+			File << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Buffer->ThreadId << ",\"args\":{\"name\":\"";
+			WriteEscaped(File, Buffer->Name.c_str());
+			File << "\"}}";
+		}
+
+		// a buffer that wrapped only holds its newest events
+		const size_t Head = Buffer->Head.load(std::memory_order_acquire);
+		const size_t Size = Buffer->Events.size();
+		const size_t First = Head > Size ? Head - Size : 0;
+		if (Size == 0)
+		{
+			continue;
+		}
+		for (size_t i = First; i < Head; i++)
+		{
+			const Event& Event = Buffer->Events[i % Size];
+			Separator();
+			File << "{\"name\":\"";
+			WriteEscaped(File, Event.Name);
+			File << "\",\"ph\":\"" << Event.Phase << "\",\"ts\":" << Event.TimeNs / 1000.0 << ",\"pid\":1,\"tid\":" << Buffer->ThreadId;
+			if (Event.Phase == 'C')
+			{
+				File << ",\"args\":{\"value\":" << Event.Value << "}";
+			}
+			else if (Event.Phase == 'i')
+			{
+				File << ",\"s\":\"g\"";
+			}
+			File << "}";
+		}
+	}
+	File << "\n]}\n";
+	return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// set to 0 to compile all GENIX_TRACE_* macros out
+#ifndef GENIX_TRACE_ENABLED
+#define GENIX_TRACE_ENABLED 1
+#endif
+
+// records zones and counters into per thread ring buffers and dumps a captured frame range as Chrome trace_event JSON
+// (chrome://tracing, ui.perfetto.dev). Outside a capture a zone costs one relaxed atomic load; during a capture every
+// thread only writes to its own buffer, no locks. Names must be string literals (or otherwise outlive the capture),
+// only the pointer is stored.
+class TraceRecorder
+{
+public:
+
+    static TraceRecorder& Get();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // nanoseconds on the clock all events use
+    static uint64_t Now();
+
+    void BeginZone(const char* name);
+    void EndZone(const char* name);
+    void Counter(const char* name, double value);
+
+    // a zone on the separate GPU track, timestamps already converted to Now() time (see Profiler)
+    void GpuZone(const char* name, uint64_t beginNs, uint64_t endNs);
+
+    // label of the calling thread in the trace
+    void SetThreadName(const char* name);
+
+    // records from now on and writes path after frameCount more MarkFrame calls
+    void StartCapture(const std::string& path, unsigned int frameCount);
+
+    // call once per frame, marks the frame boundary and finishes the capture when its frames are done
+    void MarkFrame();
+
+    bool IsCapturing() const { return bCapturing.load(std::memory_order_relaxed); }
+
+    // events each thread keeps, older ones are overwritten. A thread's ring is allocated on its first recorded event.
+    size_t EventsPerThread = 1 << 16;
+
+private:
+
+    TraceRecorder() = default;
+
+    struct Event
+    {
+        const char* Name;
+        uint64_t TimeNs;
+        double Value;
+        char Phase;         // trace_event phase: B, E, C, i
+    };
+
+    struct ThreadBuffer
+    {
+        std::vector<Event> Events;
+        std::atomic<size_t> Head{ 0 };      // total events written, the ring index is Head % size
+        unsigned int ThreadId = 0;
+        std::string Name;
+    };
+
+    ThreadBuffer& GetThreadBuffer();
+
+    void Push(ThreadBuffer& Buffer, const char* Name, char Phase, uint64_t TimeNs, double Value);
+
+    bool WriteJSON(const std::string& Path);
+
+    std::atomic<bool> bCapturing{ false };
+    std::mutex RegistryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+    std::unique_ptr<ThreadBuffer> GpuBuffer;
+    std::string CapturePath;
+    unsigned int FramesLeft = 0;
+};
+
+// begins a zone on construction and ends it on destruction
+class TraceZone
+{
+public:
+    explicit TraceZone(const char* name) : Name(name) { TraceRecorder::Get().BeginZone(Name); }
+    ~TraceZone() { TraceRecorder::Get().EndZone(Name); }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* Name;
+};
+
+#if GENIX_TRACE_ENABLED
+#define GENIX_TRACE_CONCAT_INNER(A, B) A##B
+#define GENIX_TRACE_CONCAT(A, B) GENIX_TRACE_CONCAT_INNER(A, B)
+// traces the enclosing scope
+#define GENIX_TRACE_ZONE(Name) TraceZone GENIX_TRACE_CONCAT(TraceZone, __LINE__)(Name)
+// records a counter sample (shows up as a graph)
+#define GENIX_TRACE_COUNTER(Name, Value) TraceRecorder::Get().Counter(Name, static_cast<double>(Value))
+#define GENIX_TRACE_THREAD_NAME(Name) TraceRecorder::Get().SetThreadName(Name)
+#else
+#define GENIX_TRACE_ZONE(Name)
+#define GENIX_TRACE_COUNTER(Name, Value)
+#define GENIX_TRACE_THREAD_NAME(Name)
+#endif
@@ -1,8 +1,14 @@
+#include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -12,8 +18,34 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <random>
 
+#include "Benchmarks.h"
+#include "BloomRenderer.h"
+#include "CascadedShadowMap.h"
+#include "ComputeBlur.h"
+#include "DynamicResolution.h"
+#include "DynamicRingBuffer.h"
+#include "EntityRegistry.h"
+#include "FramePacer.h"
+#include "GLCapture.h"
+#include "GLReplay.h"
 #include "Model.h"
+#include "PointShadowMap.h"
+#include "Profiler.h"
+#include "RenderSystems.h"
+#include "SceneGraph.h"
+#include "RenderTargetManager.h"
+#include "ShaderHotReload.h"
+#include "ShadowAtlas.h"
+#include "TemporalAA.h"
+#include "TemporalSSAO.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "TextureUploader.h"
+#include "Trace.h"
 #include "stb_image.h"
+#include "imgui.h"
+#include "imgui_impl_glfw.h"
+#include "imgui_impl_opengl3.h"
 
 void FramebufferSizeCallback(GLFWwindow* Window, int Width, int Height);
 void MouseCallback(GLFWwindow* Window, double Xpos, double Ypos);
@@ -25,6 +57,18 @@ unsigned int LoadCubemap(std::vector<std::string> faces);
 void renderScene(const Shader &shader);
 void renderCube();
 void renderQuad();
+void BindPerDrawTransform(DynamicRingBuffer& RingBuffer, const glm::mat4& Model);
+void BindPerDrawTransform(DynamicRingBuffer& RingBuffer, const glm::mat4& Model, const glm::mat4& PreviousModel);
+void BindPerDrawData(DynamicRingBuffer& RingBuffer, const void* Data, size_t Bytes);
+void DrawFrameStatsPanel(const FramePacer& Pacer);
+void DrawShadowStatsPanel(const CascadedShadowMap& Shadows, const PointShadowMap& PointShadows, const ShadowAtlas& Atlas);
+void DrawBloomPanel(BloomRenderer& Bloom);
+void DrawTemporalAAPanel(TemporalAA& Taa);
+void DrawSSAOPanel(TemporalSSAO& TemporalAO);
+void DrawResolutionPanel(DynamicResolution& Resolution, const RenderTargetManager& Targets);
+void DrawTextureStreamingPanel(TextureStreamer& Streamer);
+void RequestTextureLevels(TextureStreamer& Streamer, EntityRegistry& Registry, const std::vector<DrawItem>& DrawList, const glm::vec3& ViewPosition,
+	float FovY, int ViewportHeight);
 
 constexpr GLint WIDTH = 1920;
 constexpr GLint HEIGHT = 1080;
@@ -34,10 +78,28 @@ bool gammaEnabled = false;
 bool gammaKeyPressed = false;
 bool shadows = true;
 bool shadowsKeyPressed = false;
+bool pointShadowPathKeyPressed = false;
+bool pointShadowPathToggled = false;
 bool hdr = true;
 bool hdrKeyPressed = false;
 bool bloom = true;
 bool bloomKeyPressed = false;
+bool bloomModeKeyPressed = false;
+bool bloomModeToggled = false;
+bool computeBlur = true;
+bool computeBlurKeyPressed = false;
+bool taa = true;
+bool taaKeyPressed = false;
+bool ssaoModeKeyPressed = false;
+bool ssaoModeToggled = false;
+bool dynamicResolution = true;
+// the window's framebuffer size, from FramebufferSizeCallback
+int FramebufferWidth = WIDTH;
+int FramebufferHeight = HEIGHT;
+bool dynamicResolutionKeyPressed = false;
+bool traceKeyPressed = false;
+bool cursorEnabled = false;
+bool cursorKeyPressed = false;
 float heightScale = 0.1f;
 float exposure = 1.0f;
 
@@ -51,16 +113,70 @@ float LastY = HEIGHT / 2.0f;
 bool FirstMouse = true;
 
 // Timing
-float DeltaTime = 0.0f;	// Current - Last
-float LastFrame = 0.0f;
+float DeltaTime = 0.0f;	// length of one simulation step
 
-float ourLerp(float a, float b, float f)
+int main(int argc, char** argv)
 {
-	return a + f * (b - a);
-}
+	// --trace <frames>: capture a Chrome trace (trace.json) from startup, model loading included, over the first frames
+	// --uploader <on|off>: stream textures through the PBO ring (default) or upload them synchronously, to compare the
+	//     frame time spikes of both (Frame panel, printed at exit)
+	// --texture-streaming <on|off>: keep only the mip levels the draws need resident (default), or load every texture
+	//     completely (block compressed where supported)
+	// --capture <frames>: record every GL call from startup into capture.gltrace over the first frames
+	// --replay <a.gltrace> [b.gltrace]: replay a GL capture and print its timings, or the difference between two
+	// --blur-bench <iterations>, --ecs-bench <entities>, ...: run one benchmark or self test instead of the renderer and
+	//     exit with its result, the flags are listed in Benchmarks.cpp
+	unsigned int StartupTraceFrames = 0;
+	unsigned int CaptureFrames = 0;
+	std::vector<std::string> ReplayPaths;
+	bool bStreamTextures = true;
+	bool bStreamMipLevels = true;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--trace") == 0)
+		{
+			StartupTraceFrames = static_cast<unsigned int>(std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "--uploader") == 0)
+		{
+			bStreamTextures = std::strcmp(argv[i + 1], "off") != 0;
+		}
+		else if (std::strcmp(argv[i], "--texture-streaming") == 0)
+		{
+			bStreamMipLevels = std::strcmp(argv[i + 1], "off") != 0;
+		}
+		else if (std::strcmp(argv[i], "--capture") == 0)
+		{
+			CaptureFrames = static_cast<unsigned int>(std::atoi(argv[i + 1]));
+		}
+		else if (std::strcmp(argv[i], "--replay") == 0)
+		{
+			ReplayPaths.push_back(argv[i + 1]);
+			if (i + 2 < argc && argv[i + 2][0] != '-')
+			{
+				ReplayPaths.push_back(argv[i + 2]);
+			}
+		}
+	}
+	const char* BenchmarkArgument = nullptr;
+	const CommandLineBenchmark* Benchmark = FindCommandLineBenchmark(argc, argv, &BenchmarkArgument);
+	BenchmarkEnvironment BenchmarkEnv;
+	BenchmarkEnv.Width = WIDTH;
+	BenchmarkEnv.Height = HEIGHT;
+	BenchmarkEnv.DrawQuad = renderQuad;
+	GENIX_TRACE_THREAD_NAME("Main");
+
+	// CPU only benchmarks, no window or context needed
+	if (Benchmark && !Benchmark->bNeedsContext)
+	{
+		return Benchmark->Run(BenchmarkArgument, BenchmarkEnv) ? 0 : 1;
+	}
+
+	if (StartupTraceFrames > 0)
+	{
+		TraceRecorder::Get().StartCapture("trace.json", StartupTraceFrames);
+	}
 
-int main()
-{
 	// --------------------------------Initialization Phase---------------------------------------
 	// -------------------------------------------------------------------------------------------
 
@@ -79,6 +195,12 @@ int main()
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+	// replays and benchmarks render offscreen, nothing is presented
+	if (!ReplayPaths.empty() || Benchmark)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	GLFWwindow* MainWindow = glfwCreateWindow(WIDTH, HEIGHT, "Genix", nullptr, nullptr);
 	if (MainWindow == nullptr)
 	{
@@ -107,9 +229,57 @@ int main()
 		return -1;
 	}
 
+	if (!ReplayPaths.empty())
+	{
+		// each trace gets a fresh context so object names and state start out the same as when it was captured
+		std::vector<GLReplayReport> Reports(ReplayPaths.size());
+		for (size_t i = 0; i < ReplayPaths.size(); i++)
+		{
+			GLFWwindow* ReplayWindow = MainWindow;
+			if (i > 0)
+			{
+				ReplayWindow = glfwCreateWindow(WIDTH, HEIGHT, "Genix Replay", nullptr, nullptr);
+				glfwMakeContextCurrent(ReplayWindow);
+				gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+			}
+			if (!ReplayGLTrace(ReplayPaths[i], Reports[i]))
+			{
+				glfwTerminate();
+				return 1;
+			}
+			PrintGLReplayReport(Reports[i]);
+		}
+		if (Reports.size() == 2)
+		{
+			PrintGLReplayDiff(Reports[0], Reports[1]);
+		}
+		glfwTerminate();
+		return 0;
+	}
+
+	if (Benchmark)
+	{
+		const bool bPassed = Benchmark->Run(BenchmarkArgument, BenchmarkEnv);
+		glfwTerminate();
+		return bPassed ? 0 : 1;
+	}
+
+	// before any GL object exists, the trace has to see every resource being created
+	if (CaptureFrames > 0)
+	{
+		GLCapture::Get().Start("capture.gltrace", CaptureFrames);
+	}
+
 	// Setup viewport size
 	glViewport(0, 0, BufferWidth, BufferHeight);
 
+	// imgui: installs its GLFW callbacks on top of ours
+	// -------------------------------------------------
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGui_ImplGlfw_InitForOpenGL(MainWindow, true);
+	ImGui_ImplOpenGL3_Init("#version 330");
+
 	// configure global opengl state
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
@@ -117,6 +287,33 @@ int main()
 	// tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
 	stbi_set_flip_vertically_on_load(true);
 
+	// stream texture pixels through a PBO ring instead of blocking glTexImage2D calls. Without Init the loaders fall
+	// back to the synchronous uploads.
+	if (bStreamTextures)
+	{
+		TextureUploader::Get().Init();
+	}
+
+	// the cache registers the textures it loads with the streamer, which only keeps the mip levels the draw list asks
+	// for resident. Declared before the models, it has to outlive their textures.
+	GLTextureStreamingBackend StreamingBackend;
+	TextureStreamer Streamer(StreamingBackend, 256 * 1024 * 1024);
+	if (bStreamMipLevels)
+	{
+		TextureCache::Get().SetStreamer(&Streamer);
+	}
+
+	// per draw transforms are sub-allocated from a fenced ring instead of one glUniform call per draw
+	DynamicRingBuffer PerDrawBuffer;
+	PerDrawBuffer.Init(GL_UNIFORM_BUFFER, 1024 * 1024);
+
+	// at most 2 frames queued on the GPU, simulation in fixed 1/120 s steps
+	FramePacer Pacer;
+	Pacer.Init(2, 1.0 / 120.0);
+
+	// per pass CPU/GPU timings, shown in the overlay
+	Profiler::Get().Init();
+
 	// --------------------------------End Of Initialization Phase--------------------------------
 	// -------------------------------------------------------------------------------------------
 
@@ -126,48 +323,162 @@ int main()
 	Shader shaderLightingPass("Shaders/SSAO.vert", "Shaders/SSAO_Lighting.frag");
 	Shader shaderSSAO("Shaders/SSAO.vert", "Shaders/SSAO.frag");
 	Shader shaderSSAOBlur("Shaders/SSAO.vert", "Shaders/SSAO_Blur.frag");
+	Shader shaderShadowDepth("Shaders/CascadedShadowDepth.vert", "Shaders/CascadedShadowDepth.frag");
+	Shader shaderBloomComposite("Shaders/SSAO.vert", "Shaders/BloomComposite.frag");
+	shaderGeometryPass.SetUniformBlockBinding("PerDraw", 0);
+	shaderShadowDepth.SetUniformBlockBinding("PerDraw", 0);
+	shaderLightingPass.SetUniformBlockBinding("ShadowAtlasLights", 1);
 
 	// load models
 	// -----------
-	Model backpack("Resources/Models/Backpack/backpack.obj");
+	// owned through a pointer so it can be destroyed while the context is still alive, its destructor releases textures
+	std::unique_ptr<Model> backpack(new Model("Resources/Models/Backpack/backpack.obj", false, false));
+
+	// scene hierarchy, world matrices are only recomputed when a local transform changes
+	SceneGraph Scene;
+	const uint32_t SceneRoot = Scene.AddNode(SceneGraph::InvalidNode);
+	const uint32_t RoomNode = Scene.AddNode(SceneRoot, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 7.0f, 0.0f)), glm::vec3(7.5f)));
+	const uint32_t BackpackNode = Scene.AddNode(SceneRoot,
+		glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.0f)), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)));
+
+	// renderable objects and lights, drawn from a culled and sorted draw list
+	EntityRegistry Registry;
+	{
+		const Entity Room = Registry.Create();
+		Transform RoomTransform;
+		RoomTransform.SceneNode = RoomNode;
+		Registry.Add<Transform>(Room, RoomTransform);
+		MeshRef RoomMesh;
+		RoomMesh.DrawPrimitive = renderCube;
+		Registry.Add<MeshRef>(Room, RoomMesh);
+		Material RoomMaterial;
+		RoomMaterial.bInvertedNormals = true; // invert normals as we're inside the cube
+		RoomMaterial.bCastShadows = false; // the closed room would shadow everything inside it
+		Registry.Add<Material>(Room, RoomMaterial);
+		Registry.Add<Bounds>(Room);
+
+		const Entity Backpack = Registry.Create();
+		Transform BackpackTransform;
+		BackpackTransform.SceneNode = BackpackNode;
+		Registry.Add<Transform>(Backpack, BackpackTransform);
+		MeshRef BackpackMesh;
+		BackpackMesh.SourceModel = backpack.get();
+		Registry.Add<MeshRef>(Backpack, BackpackMesh);
+		Material BackpackMaterial;
+		BackpackMaterial.SortKey = 1;
+		Registry.Add<Material>(Backpack, BackpackMaterial);
+		Bounds BackpackBounds;
+		BackpackBounds.LocalMin = backpack->BoundsMin;
+		BackpackBounds.LocalMax = backpack->BoundsMax;
+		Registry.Add<Bounds>(Backpack, BackpackBounds);
+
+		Light SceneLight;
+		SceneLight.Position = glm::vec3(2.0, 4.0, -2.0);
+		SceneLight.Color = glm::vec3(0.2, 0.2, 0.7);
+		SceneLight.bCastShadows = true;
+		Registry.Add<Light>(Registry.Create(), SceneLight);
+
+		Light Sun;
+		Sun.Type = LIGHT_DIRECTIONAL;
+		Sun.Direction = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
+		Sun.Color = glm::vec3(0.5f, 0.45f, 0.4f);
+		Sun.bCastShadows = true;
+		Registry.Add<Light>(Registry.Create(), Sun);
+
+		// a ring of small point lights and a few spot lights around the backpack, all shadowed through the atlas
+		for (int i = 0; i < 12; i++)
+		{
+			const float Angle = glm::two_pi<float>() * i / 12.0f;
+			Light RingLight;
+			RingLight.Position = glm::vec3(std::cos(Angle) * 4.0f, 1.5f, std::sin(Angle) * 4.0f);
+			RingLight.Color = 0.6f * glm::vec3(0.5f + 0.5f * std::cos(Angle), 0.5f + 0.5f * std::cos(Angle + 2.1f), 0.5f + 0.5f * std::cos(Angle + 4.2f));
+			RingLight.Range = 6.0f;
+			RingLight.bInAtlas = true;
+			RingLight.bCastShadows = true;
+			Registry.Add<Light>(Registry.Create(), RingLight);
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			const float Angle = glm::half_pi<float>() * i + glm::quarter_pi<float>();
+			Light SpotLight;
+			SpotLight.Type = LIGHT_SPOT;
+			SpotLight.Position = glm::vec3(std::cos(Angle) * 3.0f, 6.0f, std::sin(Angle) * 3.0f);
+			SpotLight.Direction = glm::normalize(glm::vec3(0.0f, 0.5f, 0.0f) - SpotLight.Position);
+			SpotLight.Color = glm::vec3(1.0f, 0.9f, 0.7f);
+			SpotLight.Range = 12.0f;
+			SpotLight.bInAtlas = true;
+			SpotLight.bCastShadows = true;
+			Registry.Add<Light>(Registry.Create(), SpotLight);
+		}
+	}
+	// this one circles the backpack, so its shadow is re-rendered every frame while the others stay cached
+	const Entity OrbitingLight = Registry.Create();
+	{
+		Light SpotLight;
+		SpotLight.Type = LIGHT_SPOT;
+		SpotLight.Color = glm::vec3(0.6f, 1.0f, 0.6f);
+		SpotLight.Range = 10.0f;
+		SpotLight.bInAtlas = true;
+		SpotLight.bCastShadows = true;
+		SpotLight.bStatic = false;
+		Registry.Add<Light>(OrbitingLight, SpotLight);
+	}
+	std::vector<DrawItem> DrawList;
+	std::vector<DrawItem> ShadowDrawList;
+
+	// sun shadows, the far cascades are only re-rendered every few frames
+	CascadedShadowMap SunShadows;
+	SunShadows.Init(2048, 4);
+
+	// point light shadows, all six faces in one pass (G switches between the vertex layer and geometry shader paths)
+	PointShadowMap PointShadows;
+	PointShadows.Init(1024);
+
+	// shadows of the many point and spot lights, packed into one texture and cached while nothing moves
+	ShadowAtlas Atlas;
+	Atlas.Init(4096, 64, 1024);
+	std::vector<AtlasLight> AtlasLights;
+	std::vector<AABB> MovedBounds;
+
+	// the scene is static, so its BVH is built once and only refit each frame
+	SceneBVH SceneTree;
+	Scene.UpdateWorldTransforms();
+	SyncSceneTransforms(Registry, Scene);
+	UpdateWorldBounds(Registry);
+	BuildSceneBVH(Registry, SceneTree);
+
+	// the screen sized textures, TAA and temporal SSAO history included, are owned by the render target manager, which
+	// reallocates them when the window or the dynamic resolution changes size. The bloom mip chain (half size and
+	// down) is the exception, BloomRenderer reallocates it itself once a window resize settled. The G-buffer, SSAO and
+	// lighting targets run at the dynamic resolution (R toggles it), which keeps the GPU frame time in its budget;
+	// below the output size the lit image is upscaled.
+	// -------------------------------------------------------------------------------------------------------------
+	int OutputWidth = std::max(BufferWidth, 1);
+	int OutputHeight = std::max(BufferHeight, 1);
+	DynamicResolution Resolution;
+	RenderTargetManager Targets;
+	Targets.Init(OutputWidth, OutputHeight, Resolution.GetScaledSize(OutputWidth), Resolution.GetScaledSize(OutputHeight));
+	RenderTargetDesc NearestHalf4 = { GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_NEAREST, GL_CLAMP_TO_EDGE };
+	RenderTargetDesc LinearHalf4 = { GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_LINEAR, GL_CLAMP_TO_EDGE };
+
 	// configure g-buffer framebuffer
     // ------------------------------
     unsigned int gBuffer;
     glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    unsigned int gPosition, gNormal, gAlbedo;
     // position color buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
+    const GLuint& gPosition = Targets.Create(NearestHalf4, TARGET_RENDER_SIZE, gBuffer, GL_COLOR_ATTACHMENT0);
     // normal color buffer
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, WIDTH, HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
+    const GLuint& gNormal = Targets.Create(NearestHalf4, TARGET_RENDER_SIZE, gBuffer, GL_COLOR_ATTACHMENT1);
     // color + specular color buffer
-    glGenTextures(1, &gAlbedo);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
+    const GLuint& gAlbedo = Targets.Create({ GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, GL_NEAREST, GL_CLAMP_TO_EDGE }, TARGET_RENDER_SIZE, gBuffer, GL_COLOR_ATTACHMENT2);
+    // screen space motion buffer, for reprojecting last frame's pixels
+    const GLuint& gVelocity = Targets.Create({ GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST, GL_CLAMP_TO_EDGE }, TARGET_RENDER_SIZE, gBuffer, GL_COLOR_ATTACHMENT3);
+    // depth, a texture rather than a renderbuffer so the manager treats it like the others
+    Targets.Create({ GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, GL_NEAREST, GL_CLAMP_TO_EDGE }, TARGET_RENDER_SIZE, gBuffer, GL_DEPTH_ATTACHMENT);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
     // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, WIDTH, HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+    unsigned int attachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+    glDrawBuffers(4, attachments);
     // finally check if framebuffer is complete
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
@@ -177,55 +488,75 @@ int main()
     // -----------------------------------------------------
     unsigned int ssaoFBO, ssaoBlurFBO;
     glGenFramebuffers(1, &ssaoFBO);  glGenFramebuffers(1, &ssaoBlurFBO);
+    // SSAO color buffer. The blur reads past the borders, clamp instead of wrapping in occlusion from the other side
+    // (the compute blur clamps too)
+    const GLuint& ssaoColorBuffer = Targets.Create({ GL_RED, GL_RED, GL_FLOAT, GL_NEAREST, GL_CLAMP_TO_EDGE }, TARGET_RENDER_SIZE, ssaoFBO);
+    // and blur stage, sized: the compute blur writes it as an r16f image
+    const GLuint& ssaoColorBufferBlur = Targets.Create({ GL_R16F, GL_RED, GL_FLOAT, GL_NEAREST, GL_CLAMP_TO_EDGE }, TARGET_RENDER_SIZE, ssaoBlurFBO);
     glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-    unsigned int ssaoColorBuffer, ssaoColorBufferBlur;
-    // SSAO color buffer
-    glGenTextures(1, &ssaoColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, WIDTH, HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "SSAO Framebuffer not complete!" << std::endl;
-    // and blur stage
     glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-    glGenTextures(1, &ssaoColorBufferBlur);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, WIDTH, HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "SSAO Blur Framebuffer not complete!" << std::endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // HDR target of the lighting pass, bloomed and tone mapped onto the screen afterwards, and the output sized one
+    // it is upscaled into below the output size
+    // ---------------------------------------------------------------------------------------------------------------
+    unsigned int hdrFBO, upscaleFBO;
+    glGenFramebuffers(1, &hdrFBO);
+    glGenFramebuffers(1, &upscaleFBO);
+    const GLuint& hdrColorBuffer = Targets.Create(LinearHalf4, TARGET_RENDER_SIZE, hdrFBO);
+    const GLuint& upscaledColorBuffer = Targets.Create(LinearHalf4, TARGET_OUTPUT_SIZE, upscaleFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "HDR Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, upscaleFBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Upscale Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Shader shaderUpscale("Shaders/SSAO.vert", "Shaders/Upscale.frag");
+    shaderUpscale.Use();
+    shaderUpscale.SetInt("image", 0);
+    // a drag resize reports a new size every few pixels, the targets follow once it held still for this many frames
+    // (the pool catches the churn that is left)
+    const int ResizeSettleFrames = 4;
+    int FramesSinceResize = 0;
+    FramebufferWidth = OutputWidth;
+    FramebufferHeight = OutputHeight;
+    int RequestedWidth = OutputWidth;
+    int RequestedHeight = OutputHeight;
+
+    // bloom as a half resolution mip chain (M switches to the old full resolution Gaussian for comparison)
+    BloomRenderer Bloom;
+    Bloom.Init(OutputWidth, OutputHeight, 6);
+
+    // shared memory tile versions of the SSAO blur and the Gaussian where GL 4.3 is available (C switches back to
+    // the fragment passes)
+    ComputeBlur Compute;
+    Compute.Init();
+
+    // temporal anti-aliasing of the lit HDR image (T toggles it), the camera jitters while it is on
+    TemporalAA Taa;
+    Taa.Init(Targets);
+    unsigned int FrameIndex = 0;
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
+    glm::mat4 previousView = glm::mat4(1.0f);
+    bool bHasPreviousFrame = false;
+
+    // SSAO with a rotating subset of the kernel accumulated over frames (O switches to the full kernel every frame)
+    TemporalSSAO TemporalAO;
+    TemporalAO.Init(Targets);
+
     // generate sample kernel
     // ----------------------
-    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
     std::default_random_engine generator;
-    std::vector<glm::vec3> ssaoKernel;
-    for (unsigned int i = 0; i < 64; ++i)
-    {
-        glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
-        sample = glm::normalize(sample);
-        sample *= randomFloats(generator);
-        float scale = float(i) / 64.0f;
-
-        // scale samples s.t. they're more aligned to center of kernel
-        scale = ourLerp(0.1f, 1.0f, scale * scale);
-        sample *= scale;
-        ssaoKernel.push_back(sample);
-    }
+    std::vector<glm::vec3> ssaoKernel = BuildSSAOKernel(generator);
 
     // generate noise texture
     // ----------------------
-    std::vector<glm::vec3> ssaoNoise;
-    for (unsigned int i = 0; i < 16; i++)
-    {
-        glm::vec3 noise(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f); // rotate around z-axis (in tangent space)
-        ssaoNoise.push_back(noise);
-    }
+    std::vector<glm::vec3> ssaoNoise = BuildSSAONoise(generator);
     unsigned int noiseTexture; glGenTextures(1, &noiseTexture);
     glBindTexture(GL_TEXTURE_2D, noiseTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
@@ -234,11 +565,6 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    // lighting info
-    // -------------
-    glm::vec3 lightPos = glm::vec3(2.0, 4.0, -2.0);
-    glm::vec3 lightColor = glm::vec3(0.2, 0.2, 0.7);
-
     // shader configuration
     // --------------------
     shaderLightingPass.Use();
@@ -246,63 +572,323 @@ int main()
     shaderLightingPass.SetInt("gNormal", 1);
     shaderLightingPass.SetInt("gAlbedo", 2);
     shaderLightingPass.SetInt("ssao", 3);
+    shaderLightingPass.SetInt("pointShadowMap", 5);
     shaderSSAO.Use();
     shaderSSAO.SetInt("gPosition", 0);
     shaderSSAO.SetInt("gNormal", 1);
     shaderSSAO.SetInt("texNoise", 2);
     shaderSSAOBlur.Use();
     shaderSSAOBlur.SetInt("ssaoInput", 0);
+    shaderBloomComposite.Use();
+    shaderBloomComposite.SetInt("scene", 0);
+    shaderBloomComposite.SetInt("bloomBlur", 1);
+
+    // shaders saved while running are recompiled and swapped in, keeping the values set above
+    ShaderHotReload HotReload;
+    HotReload.Init("Shaders");
 	
 	// Loop until window closed
 	while (!glfwWindowShouldClose(MainWindow))
 	{
-		// Delta-time
-		const float CurrentFrame = static_cast<float>(glfwGetTime());
-		DeltaTime = CurrentFrame - LastFrame;
-		LastFrame = CurrentFrame;
+		// simulation: as many fixed steps as real time has passed, independent of the render rate
+		const int SimulationSteps = Pacer.BeginFrame();
+		DeltaTime = static_cast<float>(Pacer.GetSimulationStep());
+		for (int Step = 0; Step < SimulationSteps; Step++)
+		{
+			ProcessInput(MainWindow);
+		}
+
+		Profiler::Get().BeginFrame();
+		HotReload.Tick();
 
-		ProcessInput(MainWindow);
+		// push this frame's share of pending texture data to the GPU
+		{
+			GENIX_PROFILE_GPU("Texture Uploads");
+			TextureUploader::Get().Tick();
+		}
+		PerDrawBuffer.BeginFrame();
+
+		// follow the window size once it settled, and scale the internal resolution by the GPU time of the newest
+		// frame the profiler has back
+		if (FramebufferWidth != RequestedWidth || FramebufferHeight != RequestedHeight)
+		{
+			RequestedWidth = FramebufferWidth;
+			RequestedHeight = FramebufferHeight;
+			FramesSinceResize = 0;
+		}
+		else
+		{
+			FramesSinceResize++;
+		}
+		const bool bOutputResized = FramesSinceResize >= ResizeSettleFrames && RequestedWidth > 0 && RequestedHeight > 0
+			&& (RequestedWidth != OutputWidth || RequestedHeight != OutputHeight);
+		Resolution.bEnabled = dynamicResolution;
+		const bool bScaleChanged = Resolution.Update(Profiler::Get().GetLastFrame());
+		if (bOutputResized || bScaleChanged)
+		{
+			if (bOutputResized)
+			{
+				OutputWidth = RequestedWidth;
+				OutputHeight = RequestedHeight;
+				Bloom.Init(OutputWidth, OutputHeight, Bloom.GetMipCount());
+			}
+			Targets.Resize(OutputWidth, OutputHeight, Resolution.GetScaledSize(OutputWidth), Resolution.GetScaledSize(OutputHeight));
+		}
+		const int RenderWidth = Targets.GetRenderWidth();
+		const int RenderHeight = Targets.GetRenderHeight();
 	
 		// Clear window
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        if (taa)
+        {
+            Camera.UpdateJitter(FrameIndex);
+        }
+        else
+        {
+            Camera.ResetJitter();
+        }
+        // rasterization uses the jittered projection, culling and motion vectors the real one
+        glm::mat4 projection = Camera.GetProjectionMatrix((float)RenderWidth, (float)RenderHeight, 0.1f, 50.0f, taa);
+        glm::mat4 unjitteredProjection = Camera.GetProjectionMatrix((float)RenderWidth, (float)RenderHeight, 0.1f, 50.0f);
+        glm::mat4 view = Camera.GetViewMatrix();
+        glm::mat4 viewProjection = unjitteredProjection * view;
+        if (!bHasPreviousFrame)
+        {
+            previousViewProjection = viewProjection;
+            previousView = view;
+        }
+        Scene.UpdateWorldTransforms();
+        SyncSceneTransforms(Registry, Scene);
+        UpdateWorldBounds(Registry);
+        RefitSceneBVH(Registry, SceneTree);
+
+        // 0. shadow pass: sun depth into the cascades that are due, casters culled per cascade
+        // ------------------------------------------------------------------------------------
+        if (Light* Orbiting = Registry.Get<Light>(OrbitingLight))
+        {
+            const float Angle = static_cast<float>(glfwGetTime()) * 0.5f;
+            Orbiting->Position = glm::vec3(std::cos(Angle) * 5.0f, 4.0f, std::sin(Angle) * 5.0f);
+            Orbiting->Direction = glm::normalize(glm::vec3(0.0f, 0.5f, 0.0f) - Orbiting->Position);
+        }
+
+        const Light* ShadowCaster = nullptr;
+        const Light* PointShadowCaster = nullptr;
+        AtlasLights.clear();
+        Registry.ForEach<Light>([&](Entity Id, Light& SceneLight)
+        {
+            if (SceneLight.bInAtlas)
+            {
+                AtlasLight Entry;
+                Entry.Id = Id;
+                Entry.bSpot = SceneLight.Type == LIGHT_SPOT;
+                Entry.Position = SceneLight.Position;
+                Entry.Direction = SceneLight.Direction;
+                Entry.Color = SceneLight.Color;
+                Entry.Range = SceneLight.Range;
+                Entry.InnerAngle = SceneLight.InnerAngle;
+                Entry.OuterAngle = SceneLight.OuterAngle;
+                Entry.bCastShadows = SceneLight.bCastShadows;
+                Entry.bStatic = SceneLight.bStatic;
+                AtlasLights.push_back(Entry);
+                return;
+            }
+            if (!SceneLight.bCastShadows)
+            {
+                return;
+            }
+            if (!ShadowCaster && SceneLight.Type == LIGHT_DIRECTIONAL)
+            {
+                ShadowCaster = &SceneLight;
+            }
+            else if (!PointShadowCaster && SceneLight.Type == LIGHT_POINT)
+            {
+                PointShadowCaster = &SceneLight;
+            }
+        });
+        if (shadows && ShadowCaster)
+        {
+            Profiler::Get().PushMarker("Shadows");
+            SunShadows.Update(view, glm::radians(Camera.Zoom), (float)OutputWidth / (float)OutputHeight, 0.1f, 50.0f, ShadowCaster->Direction);
+            SunShadows.Render([&](int, const glm::mat4& LightViewProjection, const Frustum& CascadeFrustum)
+            {
+                size_t DrawCalls = 0;
+                BuildDrawList(Registry, CascadeFrustum, ShadowDrawList, &SceneTree);
+                shaderShadowDepth.Use();
+                glm::mat4 LightSpaceMatrix = LightViewProjection;
+                shaderShadowDepth.SetMat4("lightSpaceMatrix", LightSpaceMatrix);
+                for (const DrawItem& Item : ShadowDrawList)
+                {
+                    if (Item.Surface && !Item.Surface->bCastShadows)
+                    {
+                        continue;
+                    }
+                    if (Item.Mesh->SourceModel)
+                    {
+                        Item.Mesh->SourceModel->Draw(shaderShadowDepth, Item.Placement->World, [&](const glm::mat4& MeshTransform)
+                        {
+                            BindPerDrawTransform(PerDrawBuffer, MeshTransform);
+                            DrawCalls++;
+                        }, &CascadeFrustum);
+                    }
+                    else if (Item.Mesh->DrawPrimitive)
+                    {
+                        BindPerDrawTransform(PerDrawBuffer, Item.Placement->World);
+                        Item.Mesh->DrawPrimitive();
+                        DrawCalls++;
+                    }
+                }
+                return DrawCalls;
+            });
+            Profiler::Get().PopMarker();
+        }
+        if (pointShadowPathToggled)
+        {
+            PointShadows.SetPath(PointShadows.GetPath() == POINT_SHADOW_VERTEX_LAYER ? POINT_SHADOW_GEOMETRY_SHADER : POINT_SHADOW_VERTEX_LAYER);
+            pointShadowPathToggled = false;
+        }
+        if (shadows && PointShadowCaster)
+        {
+            PointShadows.Update(PointShadowCaster->Position, 25.0f);
+            PointShadows.Render([&](Shader& DepthShader, const Frustum& LightBounds)
+            {
+                BuildDrawList(Registry, LightBounds, ShadowDrawList, &SceneTree);
+                for (const DrawItem& Item : ShadowDrawList)
+                {
+                    if (Item.Surface && !Item.Surface->bCastShadows)
+                    {
+                        continue;
+                    }
+                    if (Item.Mesh->SourceModel)
+                    {
+                        Item.Mesh->SourceModel->DrawLayered(DepthShader, Item.Placement->World, [&](const glm::mat4& MeshTransform)
+                        {
+                            BindPerDrawTransform(PerDrawBuffer, MeshTransform);
+                        }, [&](const glm::vec3& WorldMin, const glm::vec3& WorldMax)
+                        {
+                            return PointShadows.SelectFaces(PointShadows.GetFaceMask(WorldMin, WorldMax));
+                        });
+                    }
+                    else if (Item.Mesh->DrawPrimitive)
+                    {
+                        // primitives can't be instanced, they get one draw per face
+                        const Bounds* Box = Registry.Get<Bounds>(Item.Id);
+                        const unsigned int FaceMask = Box ? PointShadows.GetFaceMask(Box->WorldMin, Box->WorldMax) : 0x3F;
+                        BindPerDrawTransform(PerDrawBuffer, Item.Placement->World);
+                        for (int Face = 0; Face < 6; Face++)
+                        {
+                            if ((FaceMask & (1u << Face)) && PointShadows.SelectFaces(1u << Face))
+                            {
+                                Item.Mesh->DrawPrimitive();
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        Atlas.Update(AtlasLights, Camera.Position, glm::radians(Camera.Zoom), OutputHeight);
+        CollectMovedBounds(Registry, MovedBounds);
+        for (const AABB& Moved : MovedBounds)
+        {
+            Atlas.Invalidate(Moved);
+        }
+        if (shadows)
+        {
+            Atlas.Render([&](const glm::mat4& LightViewProjection, const Frustum& ViewFrustum)
+            {
+                size_t DrawCalls = 0;
+                BuildDrawList(Registry, ViewFrustum, ShadowDrawList, &SceneTree);
+                shaderShadowDepth.Use();
+                glm::mat4 LightSpaceMatrix = LightViewProjection;
+                shaderShadowDepth.SetMat4("lightSpaceMatrix", LightSpaceMatrix);
+                for (const DrawItem& Item : ShadowDrawList)
+                {
+                    if (Item.Surface && !Item.Surface->bCastShadows)
+                    {
+                        continue;
+                    }
+                    if (Item.Mesh->SourceModel)
+                    {
+                        Item.Mesh->SourceModel->Draw(shaderShadowDepth, Item.Placement->World, [&](const glm::mat4& MeshTransform)
+                        {
+                            BindPerDrawTransform(PerDrawBuffer, MeshTransform);
+                            DrawCalls++;
+                        }, &ViewFrustum);
+                    }
+                    else if (Item.Mesh->DrawPrimitive)
+                    {
+                        BindPerDrawTransform(PerDrawBuffer, Item.Placement->World);
+                        Item.Mesh->DrawPrimitive();
+                        DrawCalls++;
+                    }
+                }
+                return DrawCalls;
+            });
+        }
+
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
+        GLint OutputViewport[4];
+        glGetIntegerv(GL_VIEWPORT, OutputViewport);
+        glViewport(0, 0, RenderWidth, RenderHeight);
+        Profiler::Get().PushMarker("Geometry");
         glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glm::mat4 projection = glm::perspective(glm::radians(Camera.Zoom), (float)WIDTH / (float)HEIGHT, 0.1f, 50.0f);
-            glm::mat4 view = Camera.GetViewMatrix();
-            glm::mat4 model = glm::mat4(1.0f);
+            const GLfloat NoMotion[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 3, NoMotion);
+            const Frustum ViewFrustum = Frustum::FromMatrix(viewProjection);
+            BuildDrawList(Registry, ViewFrustum, DrawList, &SceneTree);
+            // the levels requested now are uploaded before the draws below sample them
+            RequestTextureLevels(Streamer, Registry, DrawList, Camera.Position, glm::radians(Camera.Zoom), RenderHeight);
+            Streamer.Update();
             shaderGeometryPass.Use();
             shaderGeometryPass.SetMat4("projection", projection);
             shaderGeometryPass.SetMat4("view", view);
-            // room cube
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0, 7.0f, 0.0f));
-            model = glm::scale(model, glm::vec3(7.5f, 7.5f, 7.5f));
-            shaderGeometryPass.SetMat4("model", model);
-            shaderGeometryPass.SetInt("invertedNormals", 1); // invert normals as we're inside the cube
-            renderCube();
-            shaderGeometryPass.SetInt("invertedNormals", 0); 
-            // backpack model on the floor
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0f, 0.5f, 0.0));
-            model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0, 0.0, 0.0));
-            model = glm::scale(model, glm::vec3(1.0f));
-            shaderGeometryPass.SetMat4("model", model);
-            backpack.Draw(shaderGeometryPass);
+            shaderGeometryPass.SetMat4("viewProjection", viewProjection);
+            shaderGeometryPass.SetMat4("previousViewProjection", previousViewProjection);
+            for (const DrawItem& Item : DrawList)
+            {
+                shaderGeometryPass.SetInt("invertedNormals", Item.Surface && Item.Surface->bInvertedNormals ? 1 : 0);
+                // maps this frame's world matrix to last frame's, the same for every mesh of a model
+                const bool bMoved = Item.Placement->PreviousWorld != Item.Placement->World;
+                const glm::mat4 Motion = bMoved ? Item.Placement->PreviousWorld * glm::inverse(Item.Placement->World) : glm::mat4(1.0f);
+                if (Item.Mesh->SourceModel)
+                {
+                    Item.Mesh->SourceModel->Draw(shaderGeometryPass, Item.Placement->World, [&](const glm::mat4& MeshTransform)
+                    {
+                        BindPerDrawTransform(PerDrawBuffer, MeshTransform, Motion * MeshTransform);
+                    }, &ViewFrustum);
+                }
+                else if (Item.Mesh->DrawPrimitive)
+                {
+                    BindPerDrawTransform(PerDrawBuffer, Item.Placement->World, Item.Placement->PreviousWorld);
+                    Item.Mesh->DrawPrimitive();
+                }
+            }
+            shaderGeometryPass.SetInt("invertedNormals", 0);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Profiler::Get().PopMarker();
 
 
         // 2. generate SSAO texture
         // ------------------------
+        Profiler::Get().PushMarker("SSAO");
         glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
             glClear(GL_COLOR_BUFFER_BIT);
             shaderSSAO.Use();
             // Send kernel + rotation 
             for (unsigned int i = 0; i < 64; ++i)
                 shaderSSAO.SetVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+            if (ssaoModeToggled)
+            {
+                TemporalAO.Mode = TemporalAO.Mode == SSAO_TEMPORAL ? SSAO_FULL_KERNEL : SSAO_TEMPORAL;
+                ssaoModeToggled = false;
+            }
+            TemporalAO.SetKernelUniforms(shaderSSAO);
+            // tile the 4x4 noise texture over the screen
+            shaderSSAO.SetVec2("noiseScale", RenderWidth / 4.0f, RenderHeight / 4.0f);
             shaderSSAO.SetMat4("projection", projection);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, gPosition);
@@ -312,32 +898,57 @@ int main()
             glBindTexture(GL_TEXTURE_2D, noiseTexture);
             renderQuad();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Profiler::Get().PopMarker();
+        // the temporal mode averages this frame's subset with the earlier ones, reprojected
+        const GLuint ssaoResult = TemporalAO.Accumulate(ssaoColorBuffer, gVelocity, gPosition, previousView * glm::inverse(view), renderQuad);
 
 
         // 3. blur SSAO texture to remove noise
         // ------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-            glClear(GL_COLOR_BUFFER_BIT);
-            shaderSSAOBlur.Use();
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-            renderQuad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Profiler::Get().PushMarker("SSAO Blur");
+        if (computeBlur && Compute.IsSupported())
+        {
+            Compute.BlurSSAO(ssaoResult, ssaoColorBufferBlur, RenderWidth, RenderHeight);
+        }
+        else
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
+                glClear(GL_COLOR_BUFFER_BIT);
+                shaderSSAOBlur.Use();
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, ssaoResult);
+                renderQuad();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        Profiler::Get().PopMarker();
 
 
         // 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
         // -----------------------------------------------------------------------------------------------------
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        Profiler::Get().PushMarker("Lighting");
+        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+        glClear(GL_COLOR_BUFFER_BIT);
         shaderLightingPass.Use();
-        // send light relevant uniforms
-        glm::vec3 lightPosView = glm::vec3(Camera.GetViewMatrix() * glm::vec4(lightPos, 1.0));
-        shaderLightingPass.SetVec3("light.Position", lightPosView);
-        shaderLightingPass.SetVec3("light.Color", lightColor);
-        // Update attenuation parameters
-        const float linear    = 0.09f;
-        const float quadratic = 0.032f;
-        shaderLightingPass.SetFloat("light.Linear", linear);
-        shaderLightingPass.SetFloat("light.Quadratic", quadratic);
+        // send light relevant uniforms, the shader takes a single point light and a single directional light
+        Registry.ForEach<Light>([&](Entity, Light& SceneLight)
+        {
+            if (SceneLight.bInAtlas)
+            {
+                return;
+            }
+            if (SceneLight.Type == LIGHT_DIRECTIONAL)
+            {
+                glm::vec3 sunDirView = glm::mat3(view) * SceneLight.Direction;
+                shaderLightingPass.SetVec3("sun.Direction", sunDirView);
+                shaderLightingPass.SetVec3("sun.Color", SceneLight.Color);
+                return;
+            }
+            glm::vec3 lightPosView = glm::vec3(Camera.GetViewMatrix() * glm::vec4(SceneLight.Position, 1.0));
+            shaderLightingPass.SetVec3("light.Position", lightPosView);
+            shaderLightingPass.SetVec3("light.Color", SceneLight.Color);
+            shaderLightingPass.SetFloat("light.Linear", SceneLight.Linear);
+            shaderLightingPass.SetFloat("light.Quadratic", SceneLight.Quadratic);
+        });
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, gPosition);
         glActiveTexture(GL_TEXTURE1);
@@ -346,19 +957,132 @@ int main()
         glBindTexture(GL_TEXTURE_2D, gAlbedo);
         glActiveTexture(GL_TEXTURE3); // add extra SSAO texture to lighting pass
         glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
+        shaderLightingPass.SetBool("shadowsEnabled", shadows && ShadowCaster != nullptr);
+        SunShadows.Bind(shaderLightingPass, 4, view);
+        glm::mat4 inverseView = glm::inverse(view);
+        shaderLightingPass.SetMat4("inverseView", inverseView);
+        shaderLightingPass.SetBool("pointShadowsEnabled", shadows && PointShadowCaster != nullptr);
+        shaderLightingPass.SetFloat("pointShadowFar", PointShadows.GetFarPlane());
+        PointShadows.Bind(5);
+        Atlas.Bind(shaderLightingPass, 6, PerDrawBuffer, 1);
         renderQuad();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Profiler::Get().PopMarker();
+        glViewport(OutputViewport[0], OutputViewport[1], OutputViewport[2], OutputViewport[3]);
+        GLuint SceneColor = hdrColorBuffer;
+        if (RenderWidth != OutputWidth || RenderHeight != OutputHeight)
+        {
+            GENIX_PROFILE_GPU("Upscale");
+            glBindFramebuffer(GL_FRAMEBUFFER, upscaleFBO);
+            glViewport(0, 0, OutputWidth, OutputHeight);
+            shaderUpscale.Use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, hdrColorBuffer);
+            renderQuad();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(OutputViewport[0], OutputViewport[1], OutputViewport[2], OutputViewport[3]);
+            SceneColor = upscaledColorBuffer;
+        }
+
+
+        // 5. bloom the HDR image, then tone map it onto the screen
+        // ---------------------------------------------------------
+        if (bloomModeToggled)
+        {
+            Bloom.Mode = Bloom.Mode == BLOOM_MIP_CHAIN ? BLOOM_GAUSSIAN : BLOOM_MIP_CHAIN;
+            bloomModeToggled = false;
+        }
+        if (taa)
+        {
+            SceneColor = Taa.Resolve(SceneColor, gVelocity, gPosition, renderQuad);
+        }
+        else
+        {
+            // the history goes stale while off
+            Taa.Reset();
+        }
+        Bloom.Compute = computeBlur ? &Compute : nullptr;
+        const GLuint BloomTexture = bloom ? Bloom.Render(SceneColor, renderQuad) : 0;
+        Profiler::Get().PushMarker("Composite");
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shaderBloomComposite.Use();
+        shaderBloomComposite.SetBool("bloom", BloomTexture != 0);
+        shaderBloomComposite.SetFloat("bloomStrength", Bloom.Strength);
+        shaderBloomComposite.SetFloat("bloomScale", Bloom.GetIntensityScale());
+        shaderBloomComposite.SetBool("hdr", hdr);
+        shaderBloomComposite.SetFloat("exposure", exposure);
+        shaderBloomComposite.SetBool("gammaEnabled", gammaEnabled);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, SceneColor);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, BloomTexture);
+        renderQuad();
+        Profiler::Get().PopMarker();
+        previousViewProjection = viewProjection;
+        previousView = view;
+        bHasPreviousFrame = true;
+        FrameIndex++;
 
+		// overlay: profiler and frame pacing stats, TAB frees the cursor to click into it
+		// -------------------------------------------------------------------------------
+		{
+			GENIX_PROFILE_GPU("Overlay");
+			ImGui_ImplOpenGL3_NewFrame();
+			ImGui_ImplGlfw_NewFrame();
+			ImGui::NewFrame();
+			Profiler::Get().DrawPanel();
+			DrawFrameStatsPanel(Pacer);
+			DrawShadowStatsPanel(SunShadows, PointShadows, Atlas);
+			DrawBloomPanel(Bloom);
+			DrawTemporalAAPanel(Taa);
+			DrawSSAOPanel(TemporalAO);
+			DrawResolutionPanel(Resolution, Targets);
+			DrawTextureStreamingPanel(Streamer);
+			ImGui::Render();
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
+		Profiler::Get().EndFrame();
 
-		
 		// Glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
+		PerDrawBuffer.EndFrame();
+		Targets.EndFrame();
+		Pacer.EndFrame();
 		glfwSwapBuffers(MainWindow);
+		Pacer.MarkPresent();
+
+		GENIX_TRACE_COUNTER("Present Interval (ms)", Pacer.GetStats().PresentIntervalMs);
+		GENIX_TRACE_COUNTER("Pending Upload Bytes", TextureUploader::Get().GetStats().PendingBytes);
+		TraceRecorder::Get().MarkFrame();
+		GLCapture::Get().MarkFrame();
 		glfwPollEvents();
 	}
 
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
 	glDeleteVertexArrays(1, &planeVAO);
+	ImGui_ImplOpenGL3_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+	SunShadows.Shutdown();
+	PointShadows.Shutdown();
+	Atlas.Shutdown();
+	Bloom.Shutdown();
+	Compute.Shutdown();
+	Taa.Shutdown();
+	TemporalAO.Shutdown();
+	HotReload.Shutdown();
+	Targets.Shutdown();
+	// the models give their textures back to the cache, which deletes them and cancels their pending uploads
+	backpack.reset();
+	TextureCache::Get().SetStreamer(nullptr);
+	Profiler::Get().Shutdown();
+	std::cout << "Frame time spikes with the texture uploader " << (bStreamTextures ? "on" : "off") << ": "
+		<< Pacer.GetStats().Spikes << ", worst " << Pacer.GetStats().WorstSpikeMs << " ms" << std::endl;
+	Pacer.Shutdown();
+	PerDrawBuffer.Shutdown();
+	TextureUploader::Get().Shutdown();
+	GLCapture::Get().Stop();
 	
 	// Glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -374,6 +1098,9 @@ void FramebufferSizeCallback(GLFWwindow* Window, int Width, int Height)
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
 	glViewport(0, 0, Width, Height);
+	// the render targets follow in the render loop
+	FramebufferWidth = Width;
+	FramebufferHeight = Height;
 }
 
 // GlFW: whenever the mouse moves, this callback is called
@@ -396,6 +1123,12 @@ void MouseCallback(GLFWwindow* Window, double Xpos, double Ypos)
 	LastX = X;
 	LastY = Y;
 
+	// the cursor is being used for the overlay
+	if (cursorEnabled)
+	{
+		return;
+	}
+
 	Camera.ProcessMouseMovement(Xoffset, Yoffset);
 }
 
@@ -432,6 +1165,17 @@ void ProcessInput(GLFWwindow* Window)
 		Camera.ProcessKeyboard(RIGHT, DeltaTime);
 	}
 	
+	if (glfwGetKey(Window, GLFW_KEY_TAB) == GLFW_PRESS && !cursorKeyPressed)
+	{
+		cursorEnabled = !cursorEnabled;
+		glfwSetInputMode(Window, GLFW_CURSOR, cursorEnabled ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+		cursorKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_TAB) == GLFW_RELEASE)
+	{
+		cursorKeyPressed = false;
+	}
+
 	if (glfwGetKey(Window, GLFW_KEY_B) == GLFW_PRESS && !blinnKeyPressed) 
 	{
 		blinn = !blinn;
@@ -442,6 +1186,37 @@ void ProcessInput(GLFWwindow* Window)
 		blinnKeyPressed = false;
 	}
 
+	// F2 captures a trace of the next 120 frames
+	if (glfwGetKey(Window, GLFW_KEY_F2) == GLFW_PRESS && !traceKeyPressed)
+	{
+		TraceRecorder::Get().StartCapture("trace.json", 120);
+		traceKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_F2) == GLFW_RELEASE)
+	{
+		traceKeyPressed = false;
+	}
+
+	if (glfwGetKey(Window, GLFW_KEY_F) == GLFW_PRESS && !shadowsKeyPressed)
+	{
+		shadows = !shadows;
+		shadowsKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_F) == GLFW_RELEASE)
+	{
+		shadowsKeyPressed = false;
+	}
+
+	if (glfwGetKey(Window, GLFW_KEY_G) == GLFW_PRESS && !pointShadowPathKeyPressed)
+	{
+		pointShadowPathToggled = true;
+		pointShadowPathKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_G) == GLFW_RELEASE)
+	{
+		pointShadowPathKeyPressed = false;
+	}
+
 	if (glfwGetKey(Window, GLFW_KEY_SPACE) == GLFW_PRESS && !bloomKeyPressed)
 	{
 		bloom = !bloom;
@@ -452,6 +1227,56 @@ void ProcessInput(GLFWwindow* Window)
 		bloomKeyPressed = false;
 	}
 
+	if (glfwGetKey(Window, GLFW_KEY_M) == GLFW_PRESS && !bloomModeKeyPressed)
+	{
+		bloomModeToggled = true;
+		bloomModeKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_M) == GLFW_RELEASE)
+	{
+		bloomModeKeyPressed = false;
+	}
+
+	if (glfwGetKey(Window, GLFW_KEY_C) == GLFW_PRESS && !computeBlurKeyPressed)
+	{
+		computeBlur = !computeBlur;
+		computeBlurKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_C) == GLFW_RELEASE)
+	{
+		computeBlurKeyPressed = false;
+	}
+
+	if (glfwGetKey(Window, GLFW_KEY_T) == GLFW_PRESS && !taaKeyPressed)
+	{
+		taa = !taa;
+		taaKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_T) == GLFW_RELEASE)
+	{
+		taaKeyPressed = false;
+	}
+
+	if (glfwGetKey(Window, GLFW_KEY_O) == GLFW_PRESS && !ssaoModeKeyPressed)
+	{
+		ssaoModeToggled = true;
+		ssaoModeKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_O) == GLFW_RELEASE)
+	{
+		ssaoModeKeyPressed = false;
+	}
+
+	if (glfwGetKey(Window, GLFW_KEY_R) == GLFW_PRESS && !dynamicResolutionKeyPressed)
+	{
+		dynamicResolution = !dynamicResolution;
+		dynamicResolutionKeyPressed = true;
+	}
+	if (glfwGetKey(Window, GLFW_KEY_R) == GLFW_RELEASE)
+	{
+		dynamicResolutionKeyPressed = false;
+	}
+
 	if (glfwGetKey(Window, GLFW_KEY_Q) == GLFW_PRESS)
 	{
 		if (exposure > 0.0f)
@@ -480,7 +1305,7 @@ unsigned int LoadTexture(char const * path, bool gammaCorrection)
 		GLenum Format;
 		if (NrComponents == 1)
 		{
-			Format = GL_RED;
+			internalFormat = Format = GL_RED;
 		}
 		else if (NrComponents == 3)
 		{
@@ -493,9 +1318,12 @@ unsigned int LoadTexture(char const * path, bool gammaCorrection)
 			Format = GL_RGBA;
 		}
 
-		glBindTexture(GL_TEXTURE_2D, TextureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, Width, Height, 0, Format, GL_UNSIGNED_BYTE, Data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// gamma corrected textures are filtered in linear space, which glGenerateMipmap doesn't do on every driver
+		MipChainSettings Settings;
+		Settings.Filter = MIP_FILTER_KAISER;
+		Settings.bSRGB = gammaCorrection;
+
+		UploadMipChain(TextureId, internalFormat, Format, NrComponents, BuildMipChain(Data, Width, Height, NrComponents, Settings));
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, Format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT); // for this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, Format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
@@ -531,10 +1359,22 @@ unsigned int LoadCubemap(std::vector<std::string> faces)
 	int width, height, nrChannels;
 	for (unsigned int i = 0; i < faces.size(); i++)
 	{
-		unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+		unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 3);
 		if (data)
 		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+			if (TextureUploader::Get().IsEnabled())
+			{
+				// allocate the face now, the pixels go through the PBO ring
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+				TextureUploader::Get().QueueLevel(textureID, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, width, height, GL_RGB, 3,
+					std::vector<unsigned char>(data, data + static_cast<size_t>(width) * height * 3));
+			}
+			else
+			{
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			}
 			stbi_image_free(data);
 		}
 		else
@@ -552,6 +1392,218 @@ unsigned int LoadCubemap(std::vector<std::string> faces)
 	return textureID;
 }
 
+// writes a model matrix into this frame's region of the ring and binds it to the PerDraw block (binding 0)
+// ---------------------------------------------------------------------------------------------------------
+void BindPerDrawTransform(DynamicRingBuffer& RingBuffer, const glm::mat4& Model)
+{
+	BindPerDrawData(RingBuffer, &Model, sizeof(glm::mat4));
+}
+
+void BindPerDrawTransform(DynamicRingBuffer& RingBuffer, const glm::mat4& Model, const glm::mat4& PreviousModel)
+{
+	// PerDraw block of the geometry pass, the previous model matrix feeds its motion vectors
+	const glm::mat4 Transforms[2] = { Model, PreviousModel };
+	BindPerDrawData(RingBuffer, Transforms, sizeof(Transforms));
+}
+
+// once the ring's frame region is full the PerDraw data goes through a plain uniform buffer instead, updated with
+// glBufferSubData for every draw (the driver keeps the older contents alive for draws still in flight)
+unsigned int perDrawFallbackUBO = 0;
+const size_t PerDrawFallbackBytes = 2 * sizeof(glm::mat4);
+void BindPerDrawData(DynamicRingBuffer& RingBuffer, const void* Data, size_t Bytes)
+{
+	const DynamicRingBuffer::Allocation Allocation = RingBuffer.Upload(Data, Bytes, RingBuffer.GetUniformAlignment());
+	if (Allocation.IsValid())
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, 0, Allocation.Buffer, Allocation.Offset, Allocation.Size);
+		return;
+	}
+	if (perDrawFallbackUBO == 0)
+	{
+		glGenBuffers(1, &perDrawFallbackUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, perDrawFallbackUBO);
+		glBufferData(GL_UNIFORM_BUFFER, PerDrawFallbackBytes, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, perDrawFallbackUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, std::min(Bytes, PerDrawFallbackBytes), Data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, perDrawFallbackUBO, 0, std::min(Bytes, PerDrawFallbackBytes));
+}
+
+// imgui window with the frame pacing and streaming statistics
+// -----------------------------------------------------------
+void DrawFrameStatsPanel(const FramePacer& Pacer)
+{
+	const FramePacer::Stats& PacerStats = Pacer.GetStats();
+	const TextureUploader::Stats& UploadStats = TextureUploader::Get().GetStats();
+
+	ImGui::Begin("Frame");
+	ImGui::Text("Present interval: %.2f ms (avg %.2f, worst %.2f)", PacerStats.PresentIntervalMs, PacerStats.AveragePresentIntervalMs, PacerStats.WorstPresentIntervalMs);
+	ImGui::Text("Jitter: %.2f ms", PacerStats.JitterMs);
+	ImGui::Text("Latency: %.2f ms, frames in flight: %zu", PacerStats.LatencyMs, PacerStats.FramesInFlight);
+	ImGui::Text("Fence waits: %zu (last %.2f ms)", PacerStats.FenceWaits, PacerStats.WaitMs);
+	ImGui::Text("Spikes (over %.1fx the average): %zu, worst %.2f ms", Pacer.SpikeFactor, PacerStats.Spikes, PacerStats.WorstSpikeMs);
+	ImGui::Text("Texture uploader: %s (--uploader)", TextureUploader::Get().IsEnabled() ? "on" : "off");
+	ImGui::Text("Texture uploads pending: %zu (%zu KB)", UploadStats.PendingRequests, UploadStats.PendingBytes / 1024);
+	ImGui::End();
+}
+
+// imgui window with the cascaded shadow map statistics, GPU times come from the profiler markers
+// ---------------------------------------------------------------------------------------------
+void DrawShadowStatsPanel(const CascadedShadowMap& Shadows, const PointShadowMap& PointShadows, const ShadowAtlas& Atlas)
+{
+	const CascadedShadowMap::Stats& ShadowStats = Shadows.GetStats();
+
+	ImGui::Begin("Shadows");
+	ImGui::Text("Cascades rendered: %d, cached: %d (cache hits %zu)", ShadowStats.CascadesRendered, ShadowStats.CascadesCached, ShadowStats.CacheHits);
+	ImGui::Text("Draw calls: %zu", ShadowStats.TotalDrawCalls);
+	for (int i = 0; i < Shadows.GetCascadeCount(); i++)
+	{
+		const double GpuMs = Profiler::Get().GetAverageMs("Shadow Cascade " + std::to_string(i), 1, true);
+		ImGui::Text("Cascade %d: up to %.1f, %zu draws, %.3f ms GPU", i, Shadows.GetSplitDistance(i), ShadowStats.DrawCalls[i], GpuMs > 0.0 ? GpuMs : 0.0);
+	}
+
+	// both paths report under the same marker, switch with G and compare
+	const PointShadowMap::Stats& PointStats = PointShadows.GetStats();
+	const double PointGpuMs = Profiler::Get().GetAverageMs("Point Shadows", 0, true);
+	ImGui::Separator();
+	ImGui::Text("Point shadows: %s%s", PointShadows.GetPath() == POINT_SHADOW_VERTEX_LAYER ? "vertex gl_Layer" : "geometry shader",
+		PointShadows.IsVertexLayerSupported() ? "" : " (vertex gl_Layer unsupported)");
+	ImGui::Text("Draws: %zu, faces drawn %zu, faces culled %zu", PointStats.Draws, PointStats.FaceDraws, PointStats.FacesCulled);
+	ImGui::Text("GPU: %.3f ms", PointGpuMs > 0.0 ? PointGpuMs : 0.0);
+
+	const ShadowAtlas::Stats& AtlasStats = Atlas.GetStats();
+	const double AtlasGpuMs = Profiler::Get().GetAverageMs("Shadow Atlas", 0, true);
+	ImGui::Separator();
+	ImGui::Text("Atlas: %zu of %zu lights shadowed, %zu tiles, %.0f%% used, %zu failed", AtlasStats.ShadowedLights, AtlasStats.Lights, AtlasStats.Views,
+		AtlasStats.Occupancy * 100.0f, AtlasStats.FailedAllocations);
+	ImGui::Text("Tiles rendered %zu, cached %zu, deferred %zu, %zu draws", AtlasStats.ViewsRendered, AtlasStats.ViewsCached, AtlasStats.ViewsDeferred, AtlasStats.DrawCalls);
+	ImGui::Text("GPU: %.3f ms", AtlasGpuMs > 0.0 ? AtlasGpuMs : 0.0);
+	ImGui::End();
+}
+
+void DrawBloomPanel(BloomRenderer& Bloom)
+{
+	// both modes report under the same marker, switch with M and compare
+	const BloomRenderer::Stats& BloomStats = Bloom.GetStats();
+	const double BloomGpuMs = Profiler::Get().GetAverageMs("Bloom", 0, true);
+
+	ImGui::Begin("Bloom");
+	ImGui::Text("Mode: %s", Bloom.Mode == BLOOM_MIP_CHAIN ? "mip chain" : "full resolution Gaussian");
+	if (Bloom.Mode == BLOOM_GAUSSIAN)
+	{
+		ImGui::Text("Blur: %s", Bloom.Compute && Bloom.Compute->IsSupported() ? "compute (shared memory tiles)" : "fragment");
+	}
+	ImGui::Text("Passes: %d, %.2f full resolution passes written", BloomStats.Passes, BloomStats.FullResolutionPasses);
+	ImGui::Text("GPU: %.3f ms", BloomGpuMs > 0.0 ? BloomGpuMs : 0.0);
+	int MipCount = Bloom.GetMipCount();
+	if (ImGui::SliderInt("Mips", &MipCount, 1, BloomRenderer::MaxMips))
+	{
+		Bloom.SetMipCount(MipCount);
+	}
+	ImGui::SliderFloat("Filter radius", &Bloom.FilterRadius, 0.001f, 0.02f);
+	ImGui::SliderFloat("Strength", &Bloom.Strength, 0.0f, 0.2f);
+	ImGui::End();
+}
+
+void DrawTemporalAAPanel(TemporalAA& Taa)
+{
+	const double TaaGpuMs = Profiler::Get().GetAverageMs("TAA", 0, true);
+
+	ImGui::Begin("Anti-aliasing");
+	ImGui::Text("TAA: %s (T), jitter %.2f, %.2f px", taa ? "on" : "off", Camera.Jitter.x, Camera.Jitter.y);
+	ImGui::Text("GPU: %.3f ms", TaaGpuMs > 0.0 ? TaaGpuMs : 0.0);
+	ImGui::SliderFloat("Feedback min", &Taa.FeedbackMin, 0.0f, 1.0f);
+	ImGui::SliderFloat("Feedback max", &Taa.FeedbackMax, 0.0f, 1.0f);
+	ImGui::SliderFloat("Clamp gamma", &Taa.VarianceGamma, 0.5f, 3.0f);
+	ImGui::SliderFloat("Sharpness", &Taa.Sharpness, 0.0f, 0.5f);
+	ImGui::End();
+}
+
+void DrawSSAOPanel(TemporalSSAO& TemporalAO)
+{
+	// the accumulation has its own marker, the sampling pass is "SSAO" in both modes
+	const double SSAOGpuMs = Profiler::Get().GetAverageMs("SSAO", 0, true);
+	const double AccumulateGpuMs = Profiler::Get().GetAverageMs("SSAO Accumulate", 0, true);
+
+	ImGui::Begin("SSAO");
+	ImGui::Text("Mode: %s (O), %d samples per frame", TemporalAO.Mode == SSAO_TEMPORAL ? "temporal" : "full kernel", TemporalAO.GetSamplesPerFrame());
+	ImGui::Text("GPU: %.3f ms sampling, %.3f ms accumulating", SSAOGpuMs > 0.0 ? SSAOGpuMs : 0.0,
+		TemporalAO.Mode == SSAO_TEMPORAL && AccumulateGpuMs > 0.0 ? AccumulateGpuMs : 0.0);
+	ImGui::SliderInt("Samples", &TemporalAO.SamplesPerFrame, 8, 32);
+	ImGui::SliderFloat("History frames", &TemporalAO.MaxHistoryFrames, 1.0f, 32.0f);
+	ImGui::SliderFloat("Depth tolerance", &TemporalAO.DepthTolerance, 0.01f, 0.2f);
+	ImGui::End();
+}
+
+void DrawResolutionPanel(DynamicResolution& Resolution, const RenderTargetManager& Targets)
+{
+	const DynamicResolution::Stats& ResolutionStats = Resolution.GetStats();
+	const RenderTargetManager::Stats& TargetStats = Targets.GetStats();
+	const double UpscaleGpuMs = Profiler::Get().GetAverageMs("Upscale", 0, true);
+
+	ImGui::Begin("Resolution");
+	ImGui::Text("Output %dx%d, rendering %dx%d", Targets.GetOutputWidth(), Targets.GetOutputHeight(), Targets.GetRenderWidth(), Targets.GetRenderHeight());
+	ImGui::Text("Dynamic resolution: %s (R), scale %.2f", dynamicResolution ? "on" : "off", Resolution.GetScale());
+	ImGui::Text("GPU frame: %.2f ms of %.2f ms, %d changes", ResolutionStats.AverageGpuMs, Resolution.BudgetMs, ResolutionStats.ScaleChanges);
+	ImGui::Text("Upscale: %.3f ms", Resolution.GetScale() < 1.0f && UpscaleGpuMs > 0.0 ? UpscaleGpuMs : 0.0);
+	float BudgetMs = static_cast<float>(Resolution.BudgetMs);
+	if (ImGui::SliderFloat("Budget (ms)", &BudgetMs, 4.0f, 50.0f))
+	{
+		Resolution.BudgetMs = BudgetMs;
+	}
+	ImGui::SliderFloat("Min scale", &Resolution.MinScale, 0.25f, 1.0f);
+	ImGui::Text("Targets: %.1f MB, pool %.1f MB in %zu textures", TargetStats.LiveBytes / (1024.0 * 1024.0),
+		TargetStats.PooledBytes / (1024.0 * 1024.0), TargetStats.PooledTextures);
+	ImGui::Text("Allocations %zu, pool hits %zu", TargetStats.Allocations, TargetStats.PoolHits);
+	ImGui::End();
+}
+
+// imgui window with the mip streaming residency against its budget
+// -----------------------------------------------------------------
+void DrawTextureStreamingPanel(TextureStreamer& Streamer)
+{
+	const TextureStreamer::Stats& StreamerStats = Streamer.GetStats();
+	const TextureCache::Stats& CacheStats = TextureCache::Get().GetStats();
+	const double MB = 1024.0 * 1024.0;
+
+	ImGui::Begin("Texture Streaming");
+	ImGui::Text("Cache: %zu textures, %zu streamed, %zu compressed (--texture-streaming)", CacheStats.TextureCount, CacheStats.StreamedCount,
+		CacheStats.CompressedCount);
+	ImGui::Text("Resident: %.1f MB of %.1f MB, wanted %.1f MB", StreamerStats.ResidentBytes / MB, StreamerStats.BudgetBytes / MB, StreamerStats.WantedBytes / MB);
+	ImGui::Text("Levels uploaded %zu, evicted %zu (last frame %zu, %zu)", StreamerStats.LevelsUploaded, StreamerStats.LevelsEvicted,
+		StreamerStats.UploadsLastUpdate, StreamerStats.EvictionsLastUpdate);
+	int BudgetMB = static_cast<int>(StreamerStats.BudgetBytes / (1024 * 1024));
+	if (ImGui::SliderInt("Budget (MB)", &BudgetMB, 1, 1024))
+	{
+		Streamer.SetBudget(static_cast<size_t>(BudgetMB) * 1024 * 1024);
+	}
+	ImGui::End();
+}
+
+// asks the streamer for the levels of the drawn models' textures, from how large their world bounds appear on screen
+// ------------------------------------------------------------------------------------------------------------------
+void RequestTextureLevels(TextureStreamer& Streamer, EntityRegistry& Registry, const std::vector<DrawItem>& DrawList, const glm::vec3& ViewPosition,
+	float FovY, int ViewportHeight)
+{
+	for (const DrawItem& Item : DrawList)
+	{
+		const Bounds* Box = Item.Mesh->SourceModel ? Registry.Get<Bounds>(Item.Id) : nullptr;
+		if (!Box)
+		{
+			continue;
+		}
+		// distance to the closest point of the box, 0 from inside it
+		const float Distance = glm::length(ViewPosition - glm::clamp(ViewPosition, Box->WorldMin, Box->WorldMax));
+		const glm::vec3 Extent = Box->WorldMax - Box->WorldMin;
+		const float WorldSize = std::max(Extent.x, std::max(Extent.y, Extent.z));
+		for (const Texture& Loaded : Item.Mesh->SourceModel->TexturesLoaded)
+		{
+			Streamer.RequestByDistance(TextureCache::Get().GetStreamingHandle(Loaded.ID), Distance, WorldSize, FovY, ViewportHeight);
+		}
+	}
+}
+
 // renders the 3D scene
 // --------------------
 void renderScene(const Shader &shader)